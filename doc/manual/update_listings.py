@@ -23,7 +23,7 @@ list_of_examples = {
     "HID"       : [["hid_keyboard_demo"], ["hid_mouse_demo"], ["hog_keyboard_demo"], ["hog_mouse_demo"]],
     "LE Pairing": [["sm_pairing_central"], ["sm_pairing_peripheral"]],
     "Phone Book Access" : [["pbap_client_demo"]],
-    "Performance" : [["gatt_streamer_server"], ["le_streamer_client"], ["spp_streamer"], ["spp_streamer_client"]],
+    "Performance" : [["gatt_streamer_server"], ["gatt_notify_benchmark"], ["le_streamer_client"], ["spp_streamer"], ["spp_streamer_client"]],
     "Testing"     : [["dut_mode_classic"]]
 }
 
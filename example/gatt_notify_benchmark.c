@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "gatt_notify_benchmark.c"
+
+// *****************************************************************************
+/* EXAMPLE_START(gatt_notify_benchmark): GATT Notify Benchmark - Batched notifications of small values.
+ *
+ * @text Sensor hubs often update many small characteristic values at the same time.
+ * This example provides eight characteristics with a 4 byte value each and sends updates
+ * for all characteristics with enabled notifications via att_server_notify_batch:
+ * - send whenever possible,
+ * - combine several values into a single Multiple Handle Value Notification if the client
+ *   has indicated support in the Client Supported Features characteristic.
+ *
+ * @text The number of notified values per second is printed every REPORT_INTERVAL_MS.
+ *
+ * @text Note: To start the benchmark, run the example and enable notifications on the
+ * test characteristics with a GATT Explorer, e.g. LightBlue, BLExplr.
+ */
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack.h"
+
+// gatt_notify_benchmark.gatt contains the declaration of the provided GATT Services + Characteristics
+// gatt_notify_benchmark.h    contains the binary representation of gatt_notify_benchmark.gatt
+// it is generated by the build system by calling: $BTSTACK_ROOT/tool/compile_gatt.py gatt_notify_benchmark.gatt gatt_notify_benchmark.h
+// it needs to be regenerated when the GATT Database declared in gatt_notify_benchmark.gatt file is modified
+#include "gatt_notify_benchmark.h"
+
+#define REPORT_INTERVAL_MS 3000
+#define NUM_CHARACTERISTICS 8
+
+static void  hci_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+static void  att_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+static int   att_write_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size);
+static void  benchmark_send(void);
+
+const uint8_t adv_data[] = {
+    // Flags general discoverable, BR/EDR not supported
+    0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06, 
+    // Name
+    0x0d, BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME, 'N', 'o', 't', 'i', 'f', 'y', ' ', 'B', 'e', 'n', 'c', 'h',
+    // Incomplete List of 16-bit Service Class UUIDs -- FF20 - only valid for testing!
+    0x03, BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS, 0x20, 0xff,
+};
+const uint8_t adv_data_len = sizeof(adv_data);
+
+static const uint16_t value_handles[NUM_CHARACTERISTICS] = {
+    ATT_CHARACTERISTIC_0000FF21_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF22_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF23_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF24_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF25_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF26_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF27_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+    ATT_CHARACTERISTIC_0000FF28_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+};
+
+static const uint16_t client_configuration_handles[NUM_CHARACTERISTICS] = {
+    ATT_CHARACTERISTIC_0000FF21_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF22_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF23_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF24_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF25_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF26_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF27_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+    ATT_CHARACTERISTIC_0000FF28_0000_1000_8000_00805F9B34FB_01_CLIENT_CONFIGURATION_HANDLE,
+};
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+// single client
+static hci_con_handle_t connection_handle = HCI_CON_HANDLE_INVALID;
+static uint8_t  notifications_enabled[NUM_CHARACTERISTICS];
+static uint8_t  sensor_values[NUM_CHARACTERISTICS][4];
+static uint32_t sensor_counter;
+
+// pending batch, values not sent yet are sent on next can send now
+static att_server_notification_t notifications[NUM_CHARACTERISTICS];
+static uint16_t num_notifications;
+static uint16_t num_notifications_sent;
+
+// statistics
+static uint32_t test_start_ms;
+static uint32_t test_values_sent;
+
+/* @section Main Application Setup
+ *
+ * @text Listing MainConfiguration shows main application code.
+ * It initializes L2CAP, the Security Manager, and configures the ATT Server with the pre-compiled
+ * ATT Database generated from $gatt_notify_benchmark.gatt$. Finally, it configures the advertisements
+ * and boots the Bluetooth stack. 
+ */
+ 
+/* LISTING_START(MainConfiguration): Init L2CAP, SM, ATT Server, and enable advertisements */
+
+static void gatt_notify_benchmark_setup(void){
+
+    l2cap_init();
+
+    // setup le device db
+    le_device_db_init();
+
+    // setup SM: Display only
+    sm_init();
+
+    // setup ATT server
+    att_server_init(profile_data, NULL, att_write_callback);    
+    
+    // register for HCI events
+    hci_event_callback_registration.callback = &hci_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    // register for ATT events
+    att_server_register_packet_handler(att_packet_handler);
+
+    // setup advertisements
+    uint16_t adv_int_min = 0x0030;
+    uint16_t adv_int_max = 0x0030;
+    uint8_t adv_type = 0;
+    bd_addr_t null_addr;
+    memset(null_addr, 0, 6);
+    gap_advertisements_set_params(adv_int_min, adv_int_max, adv_type, 0, null_addr, 0x07, 0x00);
+    gap_advertisements_set_data(adv_data_len, (uint8_t*) adv_data);
+    gap_advertisements_enable(1);
+}
+/* LISTING_END */
+
+/*
+ * @section Track notifications
+ * @text We count the number of values sent since the start time. After a configurable
+ * REPORT_INTERVAL_MS, we print the notification rate and reset the counter.
+ */
+
+/* LISTING_START(tracking): Tracking notifications per second */
+
+static void test_reset(void){
+    test_start_ms    = btstack_run_loop_get_time_ms();
+    test_values_sent = 0;
+}
+
+static void test_track_sent(uint16_t values_sent){
+    test_values_sent += values_sent;
+    // evaluate
+    uint32_t now = btstack_run_loop_get_time_ms();
+    uint32_t time_passed = now - test_start_ms;
+    if (time_passed < REPORT_INTERVAL_MS) return;
+    // print rate
+    uint32_t values_per_second = test_values_sent * 1000 / time_passed;
+    printf("%"PRIu32" values sent -> %"PRIu32" notifications/s\n", test_values_sent, values_per_second);
+
+    // restart
+    test_start_ms    = now;
+    test_values_sent = 0;
+}
+/* LISTING_END(tracking): Tracking notifications per second */
+
+/* 
+ * @section HCI Packet Handler
+ *
+ * @text The packet handler is used to request a short connection interval.
+ */
+
+/* LISTING_START(hciPacketHandler): Packet Handler */
+static void hci_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    
+    hci_con_handle_t con_handle;
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)) {
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING) {
+                printf("To start the benchmark, please enable notifications with some GATT Explorer, e.g. LightBlue, BLExplr.\n");
+            } 
+            break;
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)) {
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    // request min con interval 15 ms for iOS 11+ 
+                    con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet); 
+                    printf("- LE Connection %04x: request 15 ms connection interval\n", con_handle);
+                    gap_request_connection_parameter_update(con_handle, 12, 12, 0, 0x0048);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+/* LISTING_END */
+
+/* 
+ * @section ATT Packet Handler
+ *
+ * @text The packet handler is used to track the ATT connection and trigger ATT send.
+ */
+
+/* LISTING_START(attPacketHandler): Packet Handler */
+static void att_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)) {
+        case ATT_EVENT_CONNECTED:
+            if (connection_handle != HCI_CON_HANDLE_INVALID) break;
+            connection_handle = att_event_connected_get_handle(packet);
+            memset(notifications_enabled, 0, sizeof(notifications_enabled));
+            num_notifications = 0;
+            num_notifications_sent = 0;
+            printf("ATT connected, handle %04x\n", connection_handle);
+            break;
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            printf("ATT MTU = %u\n", att_event_mtu_exchange_complete_get_MTU(packet));
+            break;
+        case ATT_EVENT_CAN_SEND_NOW:
+            benchmark_send();
+            break;
+        case ATT_EVENT_DISCONNECTED:
+            if (att_event_disconnected_get_handle(packet) != connection_handle) break;
+            printf("ATT disconnected, handle %04x\n", connection_handle);
+            connection_handle = HCI_CON_HANDLE_INVALID;
+            break;
+        default:
+            break;
+    }
+}
+/* LISTING_END */
+
+/*
+ * @section Benchmark
+ *
+ * @text If the previous batch has been sent completely, a new batch is created with updated sensor
+ * values for all characteristics with enabled notifications. att_server_notify_batch sends as many
+ * values as possible. Remaining values are sent on the next ATT_EVENT_CAN_SEND_NOW.
+ */
+
+ /* LISTING_START(benchmark): Benchmark code */
+static void benchmark_create_batch(void){
+    num_notifications = 0;
+    num_notifications_sent = 0;
+    sensor_counter++;
+    int i;
+    for (i=0;i<NUM_CHARACTERISTICS;i++){
+        if (!notifications_enabled[i]) continue;
+        little_endian_store_32(sensor_values[i], 0, sensor_counter);
+        notifications[num_notifications].attribute_handle = value_handles[i];
+        notifications[num_notifications].value            = sensor_values[i];
+        notifications[num_notifications].value_len        = sizeof(sensor_values[i]);
+        num_notifications++;
+    }
+}
+
+static void benchmark_send(void){
+    if (connection_handle == HCI_CON_HANDLE_INVALID) return;
+
+    if (num_notifications_sent == num_notifications){
+        benchmark_create_batch();
+    }
+    if (num_notifications == 0) return;
+
+    // send as many values as possible
+    uint16_t values_sent = att_server_notify_batch(connection_handle, &notifications[num_notifications_sent], num_notifications - num_notifications_sent);
+    num_notifications_sent += values_sent;
+    test_track_sent(values_sent);
+
+    // request next send event
+    att_server_request_can_send_now_event(connection_handle);
+} 
+/* LISTING_END */
+
+/*
+ * @section ATT Write
+ *
+ * @text The only valid ATT writes in this example are to the Client Characteristic Configurations of the
+ * test characteristics. If notifications get enabled, an ATT_EVENT_CAN_SEND_NOW is requested. 
+ */
+
+/* LISTING_START(attWrite): ATT Write */
+static int att_write_callback(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(offset);
+
+    if (transaction_mode != ATT_TRANSACTION_MODE_NONE) return 0;
+    if (con_handle != connection_handle) return 0;
+    if (buffer_size < 2) return 0;
+
+    int i;
+    for (i=0;i<NUM_CHARACTERISTICS;i++){
+        if (client_configuration_handles[i] != att_handle) continue;
+        notifications_enabled[i] = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
+        printf("Characteristic %u: notifications enabled %u\n", i + 1, notifications_enabled[i]);
+        if (notifications_enabled[i]){
+            att_server_request_can_send_now_event(connection_handle);
+        }
+        test_reset();
+        break;
+    }
+    return 0;
+}
+/* LISTING_END */
+
+int btstack_main(void);
+int btstack_main(void)
+{
+    gatt_notify_benchmark_setup();
+
+    // turn on!
+	hci_power_control(HCI_POWER_ON);
+	    
+    return 0;
+}
+/* EXAMPLE_END */
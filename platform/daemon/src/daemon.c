@@ -75,6 +75,8 @@
 
 #ifdef _WIN32
 #include "btstack_run_loop_windows.h"
+#elif defined(HAVE_EPOLL)
+#include "btstack_run_loop_epoll.h"
 #else
 #include "btstack_run_loop_posix.h"
 #endif
@@ -122,7 +124,7 @@ const btstack_device_name_db_t * btstack_device_name_db_fs_instance(void);
 const btstack_link_key_db_t * btstack_link_key_db_corefoundation_instance(void);
 const btstack_link_key_db_t * btstack_link_key_db_fs_instance(void);
 
-// use logger: format HCI_DUMP_PACKETLOGGER, HCI_DUMP_BLUEZ or HCI_DUMP_STDOUT
+// use logger: format HCI_DUMP_PACKETLOGGER, HCI_DUMP_BLUEZ, HCI_DUMP_BTSNOOP, HCI_DUMP_PCAPNG or HCI_DUMP_STDOUT
 #ifndef BTSTACK_LOG_TYPE
 #define BTSTACK_LOG_TYPE HCI_DUMP_PACKETLOGGER 
 #endif
@@ -1402,6 +1404,12 @@ static void daemon_set_logging_enabled(int enabled){
             case HCI_DUMP_BLUEZ:
                 snprintf(string_buffer, sizeof(string_buffer), "%s/hci_dump.snoop", btstack_server_storage_path);
                 break;
+            case HCI_DUMP_BTSNOOP:
+                snprintf(string_buffer, sizeof(string_buffer), "%s/hci_dump.btsnoop", btstack_server_storage_path);
+                break;
+            case HCI_DUMP_PCAPNG:
+                snprintf(string_buffer, sizeof(string_buffer), "%s/hci_dump.pcapng", btstack_server_storage_path);
+                break;
             default:
                 break;
         }
@@ -2069,6 +2077,9 @@ int btstack_server_run(int tcp_flag){
 
 #ifdef _WIN32
     btstack_run_loop_init(btstack_run_loop_windows_get_instance());
+#elif defined(HAVE_EPOLL)
+    // not limited by FD_SETSIZE for many client connections
+    btstack_run_loop_init(btstack_run_loop_epoll_get_instance());
 #else
     btstack_run_loop_init(btstack_run_loop_posix_get_instance());
 #endif
@@ -57,6 +57,7 @@
 
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_embedded.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_linked_list.h"
 #include "btstack_util.h"
 #include "hal_tick.h"
@@ -81,10 +82,6 @@
 // the run loop
 static btstack_linked_list_t data_sources;
 
-#ifdef TIMER_SUPPORT
-static btstack_linked_list_t timers;
-#endif
-
 #ifdef HAVE_EMBEDDED_TICK
 static volatile uint32_t system_ticks;
 #endif
@@ -119,25 +116,13 @@ static void btstack_run_loop_embedded_set_timer(btstack_timer_source_t *ts, uint
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_embedded_add_timer(btstack_timer_source_t *ts){
 #ifdef TIMER_SUPPORT
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        // don't add timer that's already in there
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        if (next == ts){
-            log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
-            return;
-        }
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
+#else
+    UNUSED(ts);
 #endif
 }
 
@@ -146,22 +131,16 @@ static void btstack_run_loop_embedded_add_timer(btstack_timer_source_t *ts){
  */
 static bool btstack_run_loop_embedded_remove_timer(btstack_timer_source_t *ts){
 #ifdef TIMER_SUPPORT
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
+    return btstack_run_loop_base_remove_timer(ts);
 #else
+    UNUSED(ts);
     return 0;
 #endif
 }
 
 static void btstack_run_loop_embedded_dump_timer(void){
 #ifdef TIMER_SUPPORT
-#ifdef ENABLE_LOG_INFO 
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u, timeout %u\n", i, (unsigned int) ts->timeout);
-    }
-#endif
+    btstack_run_loop_base_dump_timer();
 #endif
 }
 
@@ -198,13 +177,11 @@ void btstack_run_loop_embedded_execute_once(void) {
 #endif
 
     // process timers
-    while (timers) {
-        btstack_timer_source_t * ts = (btstack_timer_source_t *) timers;
-        int32_t delta = btstack_time_delta(ts->timeout, now);
-        if (delta > 0) break;
+    btstack_run_loop_base_process_timers(now);
 
-        btstack_run_loop_embedded_remove_timer(ts);
-        ts->process(ts);
+    // timers re-added by a timer handler with an expired timeout are processed in the next iteration
+    if (btstack_run_loop_base_get_time_until_timeout(now) == 0){
+        trigger_event_received = 1;
     }
 #endif
     
@@ -264,7 +241,7 @@ static void btstack_run_loop_embedded_init(void){
     data_sources = NULL;
 
 #ifdef TIMER_SUPPORT
-    timers = NULL;
+    btstack_run_loop_base_init();
 #endif
 
 #ifdef HAVE_EMBEDDED_TICK
@@ -312,16 +312,7 @@ static void btstack_tlv_flash_bank_delete_tag_until_offset(btstack_tlv_flash_ban
 	}
 }
 
-/**
- * Get Value for Tag
- * @param tag
- * @param buffer
- * @param buffer_size
- * @returns size of value
- */
-static int btstack_tlv_flash_bank_get_tag(void * context, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
-
-	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) context;
+static int btstack_tlv_flash_bank_get_tag_from_flash(btstack_tlv_flash_bank_t * self, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
 
 	uint32_t tag_index = 0;
 	uint32_t tag_len   = 0;
@@ -348,15 +339,7 @@ static int btstack_tlv_flash_bank_get_tag(void * context, uint32_t tag, uint8_t
 	return copy_size;
 }
 
-/**
- * Store Tag 
- * @param tag
- * @param data
- * @param data_size
- */
-static int btstack_tlv_flash_bank_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
-
-	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) context;
+static int btstack_tlv_flash_bank_store_tag_in_flash(btstack_tlv_flash_bank_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
 
 	// trigger migration if not enough space
 	uint32_t required_space = 8 + self->delete_tag_len + data_size;
@@ -402,13 +385,148 @@ static int btstack_tlv_flash_bank_store_tag(void * context, uint32_t tag, const
 	return 0;
 }
 
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+
+// Write Cache
+//
+// Store and delete operations are collected in a RAM journal. A new operation on a tag replaces
+// the pending one for the same tag. The journal is written to flash when it is full, when no new
+// operation arrived for TLV_FLASH_BANK_WRITE_CACHE_IDLE_MS, or on btstack_tlv_flash_bank_flush.
+
+#define TLV_FLASH_BANK_WRITE_CACHE_DELETED 0xffffffffu
+
+static uint32_t btstack_tlv_flash_bank_write_cache_entry_size(btstack_tlv_flash_bank_t * self, uint32_t offset){
+	uint32_t len = big_endian_read_32(self->write_cache, offset + 4);
+	if (len == TLV_FLASH_BANK_WRITE_CACHE_DELETED){
+		len = 0;
+	}
+	return 8 + len;
+}
+
+// @returns offset of pending entry for tag or -1
+static int btstack_tlv_flash_bank_write_cache_find(btstack_tlv_flash_bank_t * self, uint32_t tag){
+	uint32_t offset = 0;
+	while (offset < self->write_cache_len){
+		if (big_endian_read_32(self->write_cache, offset) == tag) return (int) offset;
+		offset += btstack_tlv_flash_bank_write_cache_entry_size(self, offset);
+	}
+	return -1;
+}
+
+static void btstack_tlv_flash_bank_write_cache_remove(btstack_tlv_flash_bank_t * self, uint32_t offset){
+	uint32_t entry_size = btstack_tlv_flash_bank_write_cache_entry_size(self, offset);
+	memmove(&self->write_cache[offset], &self->write_cache[offset + entry_size], self->write_cache_len - offset - entry_size);
+	self->write_cache_len -= entry_size;
+}
+
+static void btstack_tlv_flash_bank_write_cache_timeout_handler(btstack_timer_source_t * ts){
+	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) btstack_run_loop_get_timer_context(ts);
+	log_info("write cache idle, flush");
+	btstack_tlv_flash_bank_flush(self);
+}
+
+// queue operation, flushes journal if there's not enough space left
+static void btstack_tlv_flash_bank_write_cache_add(btstack_tlv_flash_bank_t * self, uint32_t tag, uint32_t len, const uint8_t * data, uint32_t data_size){
+	int offset = btstack_tlv_flash_bank_write_cache_find(self, tag);
+	if (offset >= 0){
+		btstack_tlv_flash_bank_write_cache_remove(self, (uint32_t) offset);
+	}
+	if ((self->write_cache_len + 8 + data_size) > TLV_FLASH_BANK_WRITE_CACHE_SIZE){
+		btstack_tlv_flash_bank_flush(self);
+	}
+	big_endian_store_32(self->write_cache, self->write_cache_len, tag);
+	big_endian_store_32(self->write_cache, self->write_cache_len + 4, len);
+	if (data_size > 0){
+		memcpy(&self->write_cache[self->write_cache_len + 8], data, data_size);
+	}
+	self->write_cache_len += 8 + data_size;
+
+	// (re)start idle timer
+	btstack_run_loop_remove_timer(&self->write_cache_timer);
+	btstack_run_loop_set_timer(&self->write_cache_timer, TLV_FLASH_BANK_WRITE_CACHE_IDLE_MS);
+	btstack_run_loop_add_timer(&self->write_cache_timer);
+}
+
+#endif
+
+/**
+ * Get Value for Tag
+ * @param tag
+ * @param buffer
+ * @param buffer_size
+ * @returns size of value
+ */
+static int btstack_tlv_flash_bank_get_tag(void * context, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
+	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) context;
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+	int offset = btstack_tlv_flash_bank_write_cache_find(self, tag);
+	if (offset >= 0){
+		uint32_t tag_len = big_endian_read_32(self->write_cache, offset + 4);
+		if (tag_len == TLV_FLASH_BANK_WRITE_CACHE_DELETED) return 0;
+		if (!buffer) return tag_len;
+		int copy_size = btstack_min(buffer_size, tag_len);
+		memcpy(buffer, &self->write_cache[offset + 8], copy_size);
+		return copy_size;
+	}
+#endif
+	return btstack_tlv_flash_bank_get_tag_from_flash(self, tag, buffer, buffer_size);
+}
+
+/**
+ * Store Tag 
+ * @param tag
+ * @param data
+ * @param data_size
+ */
+static int btstack_tlv_flash_bank_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
+	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) context;
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+	if ((8 + data_size) <= TLV_FLASH_BANK_WRITE_CACHE_SIZE){
+		btstack_tlv_flash_bank_write_cache_add(self, tag, data_size, data, data_size);
+		return 0;
+	}
+	// value too large for journal, write pending operations first to keep order
+	btstack_tlv_flash_bank_flush(self);
+#endif
+	return btstack_tlv_flash_bank_store_tag_in_flash(self, tag, data, data_size);
+}
+
 /**
  * Delete Tag
  * @param tag
  */
 static void btstack_tlv_flash_bank_delete_tag(void * context, uint32_t tag){
 	btstack_tlv_flash_bank_t * self = (btstack_tlv_flash_bank_t *) context;
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+	btstack_tlv_flash_bank_write_cache_add(self, tag, TLV_FLASH_BANK_WRITE_CACHE_DELETED, NULL, 0);
+#else
 	btstack_tlv_flash_bank_delete_tag_until_offset(self, tag, self->write_offset);
+#endif
+}
+
+/**
+ * Flush pending operations
+ */
+void btstack_tlv_flash_bank_flush(btstack_tlv_flash_bank_t * self){
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+	btstack_run_loop_remove_timer(&self->write_cache_timer);
+	if (self->write_cache_len == 0) return;
+	log_info("flush %u bytes from write cache", self->write_cache_len);
+	uint32_t offset = 0;
+	while (offset < self->write_cache_len){
+		uint32_t tag = big_endian_read_32(self->write_cache, offset);
+		uint32_t len = big_endian_read_32(self->write_cache, offset + 4);
+		if (len == TLV_FLASH_BANK_WRITE_CACHE_DELETED){
+			btstack_tlv_flash_bank_delete_tag_until_offset(self, tag, self->write_offset);
+		} else {
+			btstack_tlv_flash_bank_store_tag_in_flash(self, tag, &self->write_cache[offset + 8], len);
+		}
+		offset += btstack_tlv_flash_bank_write_cache_entry_size(self, offset);
+	}
+	self->write_cache_len = 0;
+#else
+	UNUSED(self);
+#endif
 }
 
 static const btstack_tlv_t btstack_tlv_flash_bank = {
@@ -426,6 +544,12 @@ const btstack_tlv_t * btstack_tlv_flash_bank_init_instance(btstack_tlv_flash_ban
 	self->hal_flash_bank_context = hal_flash_bank_context;
 	self->delete_tag_len = 0;
 
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+	self->write_cache_len = 0;
+	btstack_run_loop_set_timer_handler(&self->write_cache_timer, &btstack_tlv_flash_bank_write_cache_timeout_handler);
+	btstack_run_loop_set_timer_context(&self->write_cache_timer, self);
+#endif
+
 #ifdef ENABLE_TLV_FLASH_EXPLICIT_DELETE_FIELD
 	if (hal_flash_bank_impl->get_alignment(hal_flash_bank_context) > 8){
 		log_error("Flash alignment > 8 with ENABLE_TLV_FLASH_EXPLICIT_DELETE_FIELD not supported");
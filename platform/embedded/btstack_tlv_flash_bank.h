@@ -40,19 +40,38 @@
 #define BTSTACK_TLV_FLASH_BANK_H
 
 #include <stdint.h>
+#include "btstack_config.h"
 #include "btstack_tlv.h"
+#include "btstack_run_loop.h"
 #include "hal_flash_bank.h"
 
 #if defined __cplusplus
 extern "C" {
 #endif
 
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+// size of RAM journal for pending store/delete operations, journal is flushed when full
+#ifndef TLV_FLASH_BANK_WRITE_CACHE_SIZE
+#define TLV_FLASH_BANK_WRITE_CACHE_SIZE 256
+#endif
+// journal is flushed if no new operation arrives within this time
+#ifndef TLV_FLASH_BANK_WRITE_CACHE_IDLE_MS
+#define TLV_FLASH_BANK_WRITE_CACHE_IDLE_MS 500
+#endif
+#endif
+
 typedef struct {
 	const hal_flash_bank_t * hal_flash_bank_impl;
 	void * hal_flash_bank_context;
 	int current_bank;
 	int write_offset;
 	int delete_tag_len;
+#ifdef ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+	// journal entries: tag (32), len (32) or TLV_FLASH_BANK_WRITE_CACHE_DELETED, value
+	uint8_t  write_cache[TLV_FLASH_BANK_WRITE_CACHE_SIZE];
+	uint32_t write_cache_len;
+	btstack_timer_source_t write_cache_timer;
+#endif
 } btstack_tlv_flash_bank_t;
 
 /**
@@ -63,6 +82,13 @@ typedef struct {
  */
 const btstack_tlv_t * btstack_tlv_flash_bank_init_instance(btstack_tlv_flash_bank_t * context, const hal_flash_bank_t * hal_flash_bank_impl, void * hal_flash_bank_context);
 
+/**
+ * Write all pending operations to flash, e.g. before shutdown or on power-fail warning
+ * @note only has an effect with ENABLE_TLV_FLASH_BANK_WRITE_CACHE
+ * @param context btstack_tlv_flash_bank_t
+ */
+void btstack_tlv_flash_bank_flush(btstack_tlv_flash_bank_t * context);
+
 #if defined __cplusplus
 }
 #endif
@@ -165,6 +165,14 @@ static struct libusb_transfer *acl_out_transfer;
 static struct libusb_transfer *event_in_transfer[EVENT_IN_BUFFER_COUNT];
 static struct libusb_transfer *acl_in_transfer[ACL_IN_BUFFER_COUNT];
 
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+// outgoing ACL packets of vectored send, submitted as individual bulk transfers
+static struct libusb_transfer *acl_out_vectored_transfer[HCI_ACL_FRAGMENTS_VECTORED_MAX];
+static uint8_t hci_acl_out_vectored_buffer[HCI_ACL_FRAGMENTS_VECTORED_MAX][HCI_ACL_BUFFER_SIZE];
+static int     acl_out_vectored_transfer_in_flight[HCI_ACL_FRAGMENTS_VECTORED_MAX];
+static int     usb_acl_out_vectored_pending;
+#endif
+
 #ifdef ENABLE_SCO_OVER_HCI
 
 #ifdef _WIN32
@@ -302,6 +310,20 @@ LIBUSB_CALL static void async_callback(struct libusb_transfer *transfer){
     }
 #endif
 
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+    // mark vectored ACL OUT transfer as done, free as part of shutdown
+    for (c=0;c<HCI_ACL_FRAGMENTS_VECTORED_MAX;c++){
+        if (transfer == acl_out_vectored_transfer[c]){
+            acl_out_vectored_transfer_in_flight[c] = 0;
+            if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED){
+                libusb_free_transfer(transfer);
+                acl_out_vectored_transfer[c] = 0;
+                return;
+            }
+        }
+    }
+#endif
+
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) {
         for (c=0;c<EVENT_IN_BUFFER_COUNT;c++){
             if (transfer == event_in_transfer[c]){
@@ -457,8 +479,19 @@ static void handle_completed_transfer(struct libusb_transfer *transfer){
         signal_done = 1;
     } else if (transfer->endpoint == acl_out_addr){
         // log_info("acl out done, size %u", transfer->actual_length);
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+        // vectored send is done when all transfers are completed
+        if (usb_acl_out_vectored_pending > 0){
+            usb_acl_out_vectored_pending--;
+        }
+        if (usb_acl_out_vectored_pending == 0){
+            usb_acl_out_active = 0;
+            signal_done = 1;
+        }
+#else
         usb_acl_out_active = 0;
         signal_done = 1;
+#endif
 #ifdef ENABLE_SCO_OVER_HCI
     } else if (transfer->endpoint == sco_in_addr) {
         // log_info("handle_completed_transfer for SCO IN! num packets %u", transfer->NUM_ISO_PACKETS);
@@ -1078,6 +1111,17 @@ static int usb_open(void){
 
     command_out_transfer = libusb_alloc_transfer(0);
     acl_out_transfer     = libusb_alloc_transfer(0);
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+    for (c = 0 ; c < HCI_ACL_FRAGMENTS_VECTORED_MAX ; c++) {
+        acl_out_vectored_transfer[c] = libusb_alloc_transfer(0);
+        acl_out_vectored_transfer_in_flight[c] = 0;
+        if (!acl_out_vectored_transfer[c]) {
+            usb_close();
+            return LIBUSB_ERROR_NO_MEM;
+        }
+    }
+    usb_acl_out_vectored_pending = 0;
+#endif
 
     // TODO check for error
 
@@ -1214,6 +1258,18 @@ static int usb_close(void){
                     sco_out_transfers[c] = 0;
                 }
             }
+#endif
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+            for (c = 0; c < HCI_ACL_FRAGMENTS_VECTORED_MAX ; c++){
+                if (acl_out_vectored_transfer_in_flight[c]) {
+                    log_info("cancel acl_out_vectored_transfer[%u] = %p", c, acl_out_vectored_transfer[c]);
+                    libusb_cancel_transfer(acl_out_vectored_transfer[c]);
+                } else {
+                    libusb_free_transfer(acl_out_vectored_transfer[c]);
+                    acl_out_vectored_transfer[c] = 0;
+                }
+            }
+            usb_acl_out_vectored_pending = 0;
 #endif
             libusb_set_debug(NULL, LIBUSB_LOG_LEVEL_WARNING);
 
@@ -1249,6 +1305,18 @@ static int usb_close(void){
                     }
                 }
 
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+                if (!completed) continue;
+
+                for (c=0; c < HCI_ACL_FRAGMENTS_VECTORED_MAX ; c++){
+                    if (acl_out_vectored_transfer[c]){
+                        log_info("acl_out_vectored_transfer[%u] still active (%p)", c, acl_out_vectored_transfer[c]);
+                        completed = 0;
+                        break;
+                    }
+                }
+#endif
+
 #ifdef ENABLE_SCO_OVER_HCI
                 if (!completed) continue;
 
@@ -1350,6 +1418,62 @@ static int usb_send_acl_packet(uint8_t *packet, int size){
     return 0;
 }
 
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+static int usb_send_packet_vectored(uint8_t packet_type, const btstack_iovec_t * vectors, int num_vectors){
+
+    if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return 0;
+    if (packet_type != HCI_ACL_DATA_PACKET) return 0;
+
+    int num_packets = num_vectors / 2;
+    if ((num_packets == 0) || (num_packets > HCI_ACL_FRAGMENTS_VECTORED_MAX)){
+        log_error("usb_send_packet_vectored: cannot send %u vectors", num_vectors);
+        return 0;
+    }
+
+    // USB requires contiguous buffer per packet, check all packets before submitting any
+    int i;
+    for (i = 0; i < num_packets; i++){
+        int size = vectors[2 * i].len + vectors[2 * i + 1].len;
+        if (size > HCI_ACL_BUFFER_SIZE){
+            log_error("usb_send_packet_vectored: packet size %u too large", size);
+            return 0;
+        }
+    }
+
+    // update state before submitting transfers
+    usb_acl_out_active = 1;
+    usb_acl_out_vectored_pending = num_packets;
+
+    // submit all packets at once
+    for (i = 0; i < num_packets; i++){
+        const btstack_iovec_t * header  = &vectors[2 * i];
+        const btstack_iovec_t * payload = &vectors[2 * i + 1];
+        uint8_t * buffer = hci_acl_out_vectored_buffer[i];
+        memcpy(buffer, header->data, header->len);
+        memcpy(&buffer[header->len], payload->data, payload->len);
+        libusb_fill_bulk_transfer(acl_out_vectored_transfer[i], handle, acl_out_addr, buffer, header->len + payload->len,
+            async_callback, NULL, 0);
+        acl_out_vectored_transfer[i]->type = LIBUSB_TRANSFER_TYPE_BULK;
+        acl_out_vectored_transfer_in_flight[i] = 1;
+        int r = libusb_submit_transfer(acl_out_vectored_transfer[i]);
+        if (r < 0) {
+            log_error("Error submitting acl transfer, %d", r);
+            acl_out_vectored_transfer_in_flight[i] = 0;
+            // only wait for submitted transfers, hci.c sends remaining packets later
+            usb_acl_out_vectored_pending = i;
+            break;
+        }
+    }
+
+    if (i == 0){
+        // nothing submitted
+        usb_acl_out_active = 0;
+    }
+
+    return i;
+}
+#endif
+
 static int usb_can_send_packet_now(uint8_t packet_type){
     switch (packet_type){
         case HCI_COMMAND_DATA_PACKET:
@@ -1423,6 +1547,9 @@ const hci_transport_t * hci_transport_usb_instance(void) {
         hci_transport_usb->register_packet_handler       = usb_register_packet_handler;
         hci_transport_usb->can_send_packet_now           = usb_can_send_packet_now;
         hci_transport_usb->send_packet                   = usb_send_packet;
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+        hci_transport_usb->send_packet_vectored          = usb_send_packet_vectored;
+#endif
 #ifdef ENABLE_SCO_OVER_HCI
         hci_transport_usb->set_sco_config                = usb_set_sco_config;
 #endif
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_run_loop_epoll.c"
+
+/*
+ *  btstack_run_loop_epoll.c
+ *
+ *  Run loop for Linux based on epoll
+ *
+ *  Data sources are registered with the epoll instance when added and their
+ *  read/write interest is updated by enable/disable_data_source_callbacks.
+ *  Timers are managed by btstack_run_loop_base, the next timeout is used as epoll_wait timeout.
+ *  Callbacks from other threads are queued lock-free and signaled via an eventfd data source.
+ */
+
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809
+
+#include "btstack_run_loop_epoll.h"
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+#include "btstack_linked_list.h"
+#include "btstack_debug.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS
+#define BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS 16
+#endif
+
+static int epoll_fd = -1;
+
+// events returned by last epoll_wait, entries of removed data sources are cleared
+static struct epoll_event epoll_events[BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS];
+static int epoll_events_num;
+
+// callbacks from other threads: lock-free stack (push with compare-and-swap, consumer takes all)
+static btstack_linked_item_t * main_thread_callbacks;
+static btstack_data_source_t   main_thread_data_source;
+// eventfd, -1 if not open
+static int main_thread_wakeup_fd = -1;
+
+// start time. tv_nsec = 0
+static struct timespec init_ts;
+
+static uint32_t btstack_run_loop_epoll_events_for_flags(uint16_t flags){
+    uint32_t events = 0;
+    if (flags & DATA_SOURCE_CALLBACK_READ){
+        events |= EPOLLIN;
+    }
+    if (flags & DATA_SOURCE_CALLBACK_WRITE){
+        events |= EPOLLOUT;
+    }
+    // EPOLLHUP and EPOLLERR are always reported. Without callbacks, report them once until callbacks are enabled again
+    if (events == 0u){
+        events = EPOLLONESHOT;
+    }
+    return events;
+}
+
+static void btstack_run_loop_epoll_update_data_source(btstack_data_source_t *ds, int op){
+    if (ds->source.fd < 0) return;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = btstack_run_loop_epoll_events_for_flags(ds->flags);
+    event.data.ptr = ds;
+    int res = epoll_ctl(epoll_fd, op, ds->source.fd, &event);
+    // callbacks can be enabled before data source is added
+    if ((res < 0) && (op == EPOLL_CTL_MOD) && (errno == ENOENT)) return;
+    if (res < 0){
+        log_error("epoll_ctl op %u for fd %u failed, errno %u", op, ds->source.fd, errno);
+    }
+}
+
+/**
+ * Add data_source to run_loop
+ */
+static void btstack_run_loop_epoll_add_data_source(btstack_data_source_t *ds){
+    btstack_run_loop_base_add_data_source(ds);
+    btstack_run_loop_epoll_update_data_source(ds, EPOLL_CTL_ADD);
+}
+
+/**
+ * Remove data_source from run loop
+ */
+static bool btstack_run_loop_epoll_remove_data_source(btstack_data_source_t *ds){
+    if (ds->source.fd >= 0){
+        // fails with EBADF if fd was already closed, which also removed it from the epoll set
+        (void) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, ds->source.fd, NULL);
+    }
+    // drop pending events for this data source
+    int i;
+    for (i = 0; i < epoll_events_num; i++){
+        if (epoll_events[i].data.ptr == ds){
+            epoll_events[i].data.ptr = NULL;
+        }
+    }
+    return btstack_run_loop_base_remove_data_source(ds);
+}
+
+static void btstack_run_loop_epoll_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint32_t events_before = btstack_run_loop_epoll_events_for_flags(ds->flags);
+    btstack_run_loop_base_enable_data_source_callbacks(ds, callback_types);
+    if (btstack_run_loop_epoll_events_for_flags(ds->flags) == events_before) return;
+    btstack_run_loop_epoll_update_data_source(ds, EPOLL_CTL_MOD);
+}
+
+static void btstack_run_loop_epoll_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    uint32_t events_before = btstack_run_loop_epoll_events_for_flags(ds->flags);
+    btstack_run_loop_base_disable_data_source_callbacks(ds, callback_types);
+    if (btstack_run_loop_epoll_events_for_flags(ds->flags) == events_before) return;
+    btstack_run_loop_epoll_update_data_source(ds, EPOLL_CTL_MOD);
+}
+
+/**
+ * @brief Queries the current time in ms since start
+ */
+static uint32_t btstack_run_loop_epoll_get_time_ms(void){
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    uint64_t time_ms = ((uint64_t) (now_ts.tv_sec - init_ts.tv_sec)) * 1000;
+    time_ms += now_ts.tv_nsec / 1000000;
+    return (uint32_t) time_ms;
+}
+
+/**
+ * Execute callback on run loop thread, can be called from any thread
+ */
+static void btstack_run_loop_epoll_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    btstack_linked_item_t * item = (btstack_linked_item_t *) callback_registration;
+    btstack_linked_item_t * head = __atomic_load_n(&main_thread_callbacks, __ATOMIC_RELAXED);
+    do {
+        item->next = head;
+    } while (!__atomic_compare_exchange_n(&main_thread_callbacks, &head, item, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    // wake up run loop only for first pending callback
+    if (head != NULL) return;
+    uint64_t value = 1;
+    ssize_t res = write(main_thread_wakeup_fd, &value, sizeof(value));
+    if (res < 0){
+        log_error("execute_on_main_thread: wakeup failed, errno %u", errno);
+    }
+}
+
+static void btstack_run_loop_epoll_process_main_thread_callbacks(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+
+    // reset wakeup before taking callbacks, a callback added afterwards triggers the next wakeup
+    uint64_t value;
+    ssize_t res = read(ds->source.fd, &value, sizeof(value));
+    if ((res < 0) && (errno != EAGAIN)){
+        log_error("process_main_thread_callbacks: reset wakeup failed, errno %u", errno);
+    }
+
+    btstack_linked_item_t * item = __atomic_exchange_n(&main_thread_callbacks, NULL, __ATOMIC_ACQUIRE);
+
+    // reverse list to execute callbacks in order of submission
+    btstack_linked_item_t * ordered = NULL;
+    while (item != NULL){
+        btstack_linked_item_t * next = item->next;
+        item->next = ordered;
+        ordered = item;
+        item = next;
+    }
+
+    while (ordered != NULL){
+        btstack_context_callback_registration_t * callback_registration = (btstack_context_callback_registration_t *) ordered;
+        ordered = ordered->next;
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_epoll_main_thread_init(void){
+    main_thread_callbacks = NULL;
+
+    // close eventfd from previous init
+    if (main_thread_wakeup_fd >= 0){
+        close(main_thread_wakeup_fd);
+        main_thread_wakeup_fd = -1;
+    }
+
+    main_thread_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (main_thread_wakeup_fd < 0){
+        log_error("eventfd failed, errno %u", errno);
+        return;
+    }
+    btstack_run_loop_set_data_source_fd(&main_thread_data_source, main_thread_wakeup_fd);
+    btstack_run_loop_set_data_source_handler(&main_thread_data_source, &btstack_run_loop_epoll_process_main_thread_callbacks);
+    main_thread_data_source.flags = DATA_SOURCE_CALLBACK_READ;
+    btstack_run_loop_epoll_add_data_source(&main_thread_data_source);
+}
+
+/**
+ * Execute run_loop
+ */
+static void btstack_run_loop_epoll_execute(void) {
+    log_info("epoll run loop");
+
+    while (true) {
+
+        // wait for ready fds or next timeout
+        int32_t timeout_ms = btstack_run_loop_base_get_time_until_timeout(btstack_run_loop_epoll_get_time_ms());
+        log_debug("btstack_run_loop_epoll_execute next timeout in %d ms", timeout_ms);
+        epoll_events_num = epoll_wait(epoll_fd, epoll_events, BTSTACK_RUN_LOOP_EPOLL_MAX_EVENTS, timeout_ms);
+        if (epoll_events_num < 0){
+            if (errno != EINTR){
+                log_error("epoll_wait failed, errno %u", errno);
+            }
+            epoll_events_num = 0;
+        }
+
+        // process ready data sources
+        int i;
+        for (i = 0; i < epoll_events_num; i++){
+            btstack_data_source_t * ds = (btstack_data_source_t *) epoll_events[i].data.ptr;
+            if (ds == NULL) continue;
+            uint32_t events = epoll_events[i].events;
+            if (((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0u) && ((ds->flags & DATA_SOURCE_CALLBACK_READ) != 0u)){
+                log_debug("btstack_run_loop_epoll_execute: process read ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_READ);
+            }
+            // data source might have been removed by read callback
+            if (epoll_events[i].data.ptr == NULL) continue;
+            if (((events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0u) && ((ds->flags & DATA_SOURCE_CALLBACK_WRITE) != 0u)){
+                log_debug("btstack_run_loop_epoll_execute: process write ds %p with fd %u\n", ds, ds->source.fd);
+                ds->process(ds, DATA_SOURCE_CALLBACK_WRITE);
+            }
+        }
+        epoll_events_num = 0;
+
+        // process timers
+        btstack_run_loop_base_process_timers(btstack_run_loop_epoll_get_time_ms());
+    }
+}
+
+// set timer
+static void btstack_run_loop_epoll_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+    uint32_t time_ms = btstack_run_loop_epoll_get_time_ms();
+    a->timeout = time_ms + timeout_in_ms;
+    log_debug("btstack_run_loop_epoll_set_timer to %u ms (now %u, timeout %u)", a->timeout, time_ms, timeout_in_ms);
+}
+
+static void btstack_run_loop_epoll_init(void){
+    btstack_run_loop_base_init();
+    if (epoll_fd >= 0){
+        close(epoll_fd);
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0){
+        log_error("epoll_create1 failed, errno %u", errno);
+    }
+    epoll_events_num = 0;
+    btstack_run_loop_epoll_main_thread_init();
+    clock_gettime(CLOCK_MONOTONIC, &init_ts);
+    init_ts.tv_nsec = 0;
+}
+
+static const btstack_run_loop_t btstack_run_loop_epoll = {
+    &btstack_run_loop_epoll_init,
+    &btstack_run_loop_epoll_add_data_source,
+    &btstack_run_loop_epoll_remove_data_source,
+    &btstack_run_loop_epoll_enable_data_source_callbacks,
+    &btstack_run_loop_epoll_disable_data_source_callbacks,
+    &btstack_run_loop_epoll_set_timer,
+    &btstack_run_loop_base_add_timer,
+    &btstack_run_loop_base_remove_timer,
+    &btstack_run_loop_epoll_execute,
+    &btstack_run_loop_base_dump_timer,
+    &btstack_run_loop_epoll_get_time_ms,
+    &btstack_run_loop_epoll_execute_on_main_thread,
+};
+
+/**
+ * Provide btstack_run_loop_epoll instance
+ */
+const btstack_run_loop_t * btstack_run_loop_epoll_get_instance(void){
+    return &btstack_run_loop_epoll;
+}
@@ -49,10 +49,13 @@
 #include "btstack_run_loop_posix.h"
 
 #include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
 #include "btstack_util.h"
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/select.h>
@@ -60,12 +63,19 @@
 #include <time.h>
 #include <unistd.h>
 
-static void btstack_run_loop_posix_dump_timer(void);
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
 // the run loop
 static btstack_linked_list_t data_sources;
 static int data_sources_modified;
-static btstack_linked_list_t timers;
+
+// callbacks from other threads: lock-free stack (push with compare-and-swap, consumer takes all)
+static btstack_linked_item_t * main_thread_callbacks;
+static btstack_data_source_t   main_thread_data_source;
+// eventfd, or write end of pipe used as fallback. -1 if not open
+static int main_thread_wakeup_fd = -1;
 
 // start time. tv_usec/tv_nsec = 0
 #ifdef _POSIX_MONOTONIC_CLOCK
@@ -95,39 +105,11 @@ static bool btstack_run_loop_posix_remove_data_source(btstack_data_source_t *ds)
 }
 
 /**
- * Add timer to run_loop (keep list sorted)
+ * Add timer to run_loop
  */
 static void btstack_run_loop_posix_add_timer(btstack_timer_source_t *ts){
-    btstack_linked_item_t *it;
-    for (it = (btstack_linked_item_t *) &timers; it->next ; it = it->next){
-        btstack_timer_source_t * next = (btstack_timer_source_t *) it->next;
-        btstack_assert(next != ts);
-        // exit if new timeout before list timeout
-        int32_t delta = btstack_time_delta(ts->timeout, next->timeout);
-        if (delta < 0) break;
-    }
-    ts->item.next = it->next;
-    it->next = (btstack_linked_item_t *) ts;
+    btstack_run_loop_base_add_timer(ts);
     log_debug("Added timer %p at %u\n", ts, ts->timeout);
-    // btstack_run_loop_posix_dump_timer();
-}
-
-/**
- * Remove timer from run loop
- */
-static bool btstack_run_loop_posix_remove_timer(btstack_timer_source_t *ts){
-    // log_info("Removed timer %x at %u\n", (int) ts, (unsigned int) ts->timeout.tv_sec);
-    // btstack_run_loop_posix_dump_timer();
-    return btstack_linked_list_remove(&timers, (btstack_linked_item_t *) ts);
-}
-
-static void btstack_run_loop_posix_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u (%p): timeout %u\n", i, ts, ts->timeout);
-    }
 }
 
 static void btstack_run_loop_posix_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
@@ -174,6 +156,99 @@ static uint64_t timespec_diff_milis(struct timespec* start, struct timespec* sto
 }
 #endif
 
+/**
+ * Execute callback on run loop thread, can be called from any thread
+ */
+static void btstack_run_loop_posix_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    btstack_linked_item_t * item = (btstack_linked_item_t *) callback_registration;
+    btstack_linked_item_t * head = __atomic_load_n(&main_thread_callbacks, __ATOMIC_RELAXED);
+    do {
+        item->next = head;
+    } while (!__atomic_compare_exchange_n(&main_thread_callbacks, &head, item, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    // wake up run loop only for first pending callback
+    if (head != NULL) return;
+#ifdef __linux__
+    uint64_t value = 1;
+#else
+    uint8_t value = 0;
+#endif
+    ssize_t res = write(main_thread_wakeup_fd, &value, sizeof(value));
+    if (res < 0){
+        log_error("execute_on_main_thread: wakeup failed, errno %u", errno);
+    }
+}
+
+static void btstack_run_loop_posix_process_main_thread_callbacks(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+
+    // reset wakeup before taking callbacks, a callback added afterwards triggers the next wakeup
+#ifdef __linux__
+    uint64_t value;
+    ssize_t res = read(ds->source.fd, &value, sizeof(value));
+    if ((res < 0) && (errno != EAGAIN)){
+        log_error("process_main_thread_callbacks: reset wakeup failed, errno %u", errno);
+    }
+#else
+    uint8_t buffer[16];
+    while (read(ds->source.fd, buffer, sizeof(buffer)) > 0);
+#endif
+
+    btstack_linked_item_t * item = __atomic_exchange_n(&main_thread_callbacks, NULL, __ATOMIC_ACQUIRE);
+
+    // reverse list to execute callbacks in order of submission
+    btstack_linked_item_t * ordered = NULL;
+    while (item != NULL){
+        btstack_linked_item_t * next = item->next;
+        item->next = ordered;
+        ordered = item;
+        item = next;
+    }
+
+    while (ordered != NULL){
+        btstack_context_callback_registration_t * callback_registration = (btstack_context_callback_registration_t *) ordered;
+        ordered = ordered->next;
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_posix_main_thread_init(void){
+    int read_fd;
+    main_thread_callbacks = NULL;
+
+    // close fds from previous init
+    if (main_thread_wakeup_fd >= 0){
+#ifndef __linux__
+        close(main_thread_data_source.source.fd);
+#endif
+        close(main_thread_wakeup_fd);
+        main_thread_wakeup_fd = -1;
+    }
+
+#ifdef __linux__
+    read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (read_fd < 0){
+        log_error("eventfd failed, errno %u", errno);
+        return;
+    }
+    main_thread_wakeup_fd = read_fd;
+#else
+    int fds[2];
+    if (pipe(fds) < 0){
+        log_error("pipe failed, errno %u", errno);
+        return;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    read_fd = fds[0];
+    main_thread_wakeup_fd = fds[1];
+#endif
+    btstack_run_loop_set_data_source_fd(&main_thread_data_source, read_fd);
+    btstack_run_loop_set_data_source_handler(&main_thread_data_source, &btstack_run_loop_posix_process_main_thread_callbacks);
+    main_thread_data_source.flags = DATA_SOURCE_CALLBACK_READ;
+    btstack_run_loop_posix_add_data_source(&main_thread_data_source);
+}
+
 /**
  * @brief Queries the current time in ms since start
  */
@@ -198,7 +273,6 @@ static void btstack_run_loop_posix_execute(void) {
     fd_set descriptors_read;
     fd_set descriptors_write;
     
-    btstack_timer_source_t       *ts;
     btstack_linked_list_iterator_t it;
     struct timeval * timeout;
     struct timeval tv;
@@ -237,15 +311,10 @@ static void btstack_run_loop_posix_execute(void) {
         
         // get next timeout
         timeout = NULL;
-        if (timers) {
-            ts = (btstack_timer_source_t *) timers;
+        now_ms = btstack_run_loop_posix_get_time_ms();
+        int32_t delta = btstack_run_loop_base_get_time_until_timeout(now_ms);
+        if (delta >= 0) {
             timeout = &tv;
-            uint32_t list_timeout  = ts->timeout;
-            now_ms = btstack_run_loop_posix_get_time_ms();
-            int32_t delta = btstack_time_delta(list_timeout, now_ms);
-            if (delta < 0){
-                delta = 0;
-            }
             tv.tv_sec  = delta / 1000;
             tv.tv_usec = (int) (delta - (tv.tv_sec * 1000)) * 1000;
             log_debug("btstack_run_loop_execute next timeout in %u ms", delta);
@@ -274,16 +343,7 @@ static void btstack_run_loop_posix_execute(void) {
         
         // process timers
         now_ms = btstack_run_loop_posix_get_time_ms();
-        while (timers) {
-            ts = (btstack_timer_source_t *) timers;
-            int32_t delta = btstack_time_delta(ts->timeout, now_ms);
-            if (delta > 0) break;
-            log_debug("btstack_run_loop_posix_execute: process timer %p\n", ts);
-            
-            // remove timer before processing it to allow handler to re-register with run loop
-            btstack_run_loop_posix_remove_timer(ts);
-            ts->process(ts);
-        }
+        btstack_run_loop_base_process_timers(now_ms);
     }
 }
 
@@ -296,7 +356,8 @@ static void btstack_run_loop_posix_set_timer(btstack_timer_source_t *a, uint32_t
 
 static void btstack_run_loop_posix_init(void){
     data_sources = NULL;
-    timers = NULL;
+    btstack_run_loop_base_init();
+    btstack_run_loop_posix_main_thread_init();
 #ifdef _POSIX_MONOTONIC_CLOCK
     clock_gettime(CLOCK_MONOTONIC, &init_ts);
     init_ts.tv_nsec = 0;
@@ -316,10 +377,11 @@ static const btstack_run_loop_t btstack_run_loop_posix = {
     &btstack_run_loop_posix_disable_data_source_callbacks,
     &btstack_run_loop_posix_set_timer,
     &btstack_run_loop_posix_add_timer,
-    &btstack_run_loop_posix_remove_timer,
+    &btstack_run_loop_base_remove_timer,
     &btstack_run_loop_posix_execute,
-    &btstack_run_loop_posix_dump_timer,
+    &btstack_run_loop_base_dump_timer,
     &btstack_run_loop_posix_get_time_ms,
+    &btstack_run_loop_posix_execute_on_main_thread,
 };
 
 /**
@@ -31,16 +31,22 @@
 
 #define BTSTACK_FILE__ "btstack_tlv_posix.c"
 
+// enable POSIX functions (needed for -std=c99)
+#define _POSIX_C_SOURCE 200809L
+
 #include "btstack_tlv.h"
 #include "btstack_tlv_posix.h"
 #include "btstack_debug.h"
 #include "btstack_util.h"
-#include "btstack_debug.h"
-#include "string.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#ifdef ENABLE_TLV_POSIX_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 // Header:
 // - Magic: 'BTstack'
@@ -53,31 +59,54 @@
 // - Len: 32 bit
 // - Value: Len in bytes
 
+// Updates and deletes are appended to the file. The file is compacted by writing
+// all current entries into a new file which then replaces the old one via rename.
+
 #define BTSTACK_TLV_HEADER_LEN 8
+#define BTSTACK_TLV_ENTRY_HEADER_LEN 8
 static const char * btstack_tlv_header_magic = "BTstack";
 
+// compact file if at least this percentage of it is taken by stale entries
+#ifndef TLV_POSIX_COMPACTION_THRESHOLD_PERCENT
+#define TLV_POSIX_COMPACTION_THRESHOLD_PERCENT 50
+#endif
+
+// don't compact small files
+#ifndef TLV_POSIX_COMPACTION_MIN_FILE_SIZE
+#define TLV_POSIX_COMPACTION_MIN_FILE_SIZE 4096
+#endif
+
 #define DUMMY_SIZE 4
 typedef struct tlv_entry {
 	void   * next;
 	uint32_t tag;
 	uint32_t len;
-	uint8_t  value[DUMMY_SIZE];	// dummy size
+	// points to data or into file mapping
+	const uint8_t * value;
+	uint8_t  data[DUMMY_SIZE];	// dummy size
 } tlv_entry_t;
 
+static btstack_linked_list_t * btstack_tlv_posix_bucket_for_tag(btstack_tlv_posix_t * self, uint32_t tag){
+	uint32_t hash = tag ^ (tag >> 8) ^ (tag >> 16) ^ (tag >> 24);
+	return &self->entry_buckets[hash % TLV_POSIX_HASH_TABLE_SIZE];
+}
+
 static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag, const uint8_t * data, uint32_t data_size){
 
 	if (!self->file) return 1;
 
 	log_info("append tag %04x, len %u", tag, data_size);
 
-	uint8_t header[8];
+	uint8_t header[BTSTACK_TLV_ENTRY_HEADER_LEN];
 	big_endian_store_32(header, 0, tag);
 	big_endian_store_32(header, 4, data_size);
 	size_t written_header = fwrite(header, 1, sizeof(header), self->file);
 	if (written_header != sizeof(header)) return 1;
+	self->file_size += sizeof(header);
 	if (data_size > 0) {
 		size_t written_value = fwrite(data, 1, data_size, self->file);
 		if (written_value != data_size) return 1;
+		self->file_size += data_size;
 	}
 	fflush(self->file);
 	return 1;
@@ -85,7 +114,7 @@ static int btstack_tlv_posix_append_tag(btstack_tlv_posix_t * self, uint32_t tag
 
 static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, uint32_t tag){
 	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
+	btstack_linked_list_iterator_init(&it, btstack_tlv_posix_bucket_for_tag(self, tag));
 	while (btstack_linked_list_iterator_has_next(&it)){
 		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
 		if (entry->tag != tag) continue;
@@ -94,22 +123,109 @@ static tlv_entry_t * btstack_tlv_posix_find_entry(btstack_tlv_posix_t * self, ui
 	return NULL;
 }
 
+static void btstack_tlv_posix_add_entry(btstack_tlv_posix_t * self, tlv_entry_t * entry){
+	btstack_linked_list_add(btstack_tlv_posix_bucket_for_tag(self, entry->tag), (btstack_linked_item_t *) entry);
+	self->live_size += BTSTACK_TLV_ENTRY_HEADER_LEN + entry->len;
+}
+
+static void btstack_tlv_posix_remove_entry(btstack_tlv_posix_t * self, tlv_entry_t * entry){
+	btstack_linked_list_remove(btstack_tlv_posix_bucket_for_tag(self, entry->tag), (btstack_linked_item_t *) entry);
+	self->live_size -= BTSTACK_TLV_ENTRY_HEADER_LEN + entry->len;
+	free(entry);
+}
+
+static int btstack_tlv_posix_write_entries(btstack_tlv_posix_t * self, FILE * file){
+	uint8_t header[BTSTACK_TLV_HEADER_LEN];
+	memset(header, 0, sizeof(header));
+	strcpy((char *)header, btstack_tlv_header_magic);
+	if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) return 1;
+	int i;
+	for (i = 0; i < TLV_POSIX_HASH_TABLE_SIZE; i++){
+		btstack_linked_list_iterator_t it;
+		btstack_linked_list_iterator_init(&it, &self->entry_buckets[i]);
+		while (btstack_linked_list_iterator_has_next(&it)){
+			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
+			uint8_t entry_header[BTSTACK_TLV_ENTRY_HEADER_LEN];
+			big_endian_store_32(entry_header, 0, entry->tag);
+			big_endian_store_32(entry_header, 4, entry->len);
+			if (fwrite(entry_header, 1, sizeof(entry_header), file) != sizeof(entry_header)) return 1;
+			if (fwrite(entry->value, 1, entry->len, file) != entry->len) return 1;
+		}
+	}
+	if (fflush(file) != 0) return 1;
+#ifndef _WIN32
+	if (fsync(fileno(file)) != 0) return 1;
+#endif
+	return 0;
+}
+
+// write all current entries into new file and replace db with it
+static void btstack_tlv_posix_write_db(btstack_tlv_posix_t * self){
+	size_t db_path_len = strlen(self->db_path);
+	char * temp_path = (char *) malloc(db_path_len + 5);
+	if (!temp_path) return;
+	memcpy(temp_path, self->db_path, db_path_len);
+	strcpy(&temp_path[db_path_len], ".tmp");
+
+	log_info("write db %s, %u of %u bytes in use", self->db_path, self->live_size, self->file_size);
+
+	FILE * temp_file = fopen(temp_path, "wb");
+	if (!temp_file){
+		log_error("cannot create %s", temp_path);
+		free(temp_path);
+		return;
+	}
+	int err = btstack_tlv_posix_write_entries(self, temp_file);
+	fclose(temp_file);
+	if (err){
+		log_error("writing %s failed", temp_path);
+		remove(temp_path);
+		free(temp_path);
+		return;
+	}
+
+	// all appends have been flushed. close old file before replacing it as
+	// windows neither renames onto existing nor removes open files
+	if (self->file){
+		fclose(self->file);
+		self->file = NULL;
+	}
+#ifdef _WIN32
+	remove(self->db_path);
+#endif
+	if (rename(temp_path, self->db_path) != 0){
+		log_error("rename %s failed", temp_path);
+		remove(temp_path);
+	} else {
+		self->file_size = self->live_size;
+	}
+	free(temp_path);
+
+	// continue to append to new file
+	self->file = fopen(self->db_path, "r+b");
+	if (self->file){
+		fseek(self->file, 0, SEEK_END);
+	}
+}
+
+static void btstack_tlv_posix_compact_if_needed(btstack_tlv_posix_t * self){
+	if (self->file_size < TLV_POSIX_COMPACTION_MIN_FILE_SIZE) return;
+	uint32_t stale_size = self->file_size - self->live_size;
+	if (((uint64_t) stale_size * 100) < ((uint64_t) self->file_size * TLV_POSIX_COMPACTION_THRESHOLD_PERCENT)) return;
+	btstack_tlv_posix_write_db(self);
+}
+
 /**
  * Delete Tag
  * @param tag
  */
 static void btstack_tlv_posix_delete_tag(void * context, uint32_t tag){
 	btstack_tlv_posix_t * self = (btstack_tlv_posix_t *) context;
-	btstack_linked_list_iterator_t it;
-	btstack_linked_list_iterator_init(&it, &self->entry_list);
-	while (btstack_linked_list_iterator_has_next(&it)){
-		tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-		if (entry->tag != tag) continue;
-		btstack_linked_list_iterator_remove(&it);
-		free(entry);
-		btstack_tlv_posix_append_tag(self, tag, NULL, 0);
-		return;
-	}
+	tlv_entry_t * entry = btstack_tlv_posix_find_entry(self, tag);
+	if (!entry) return;
+	btstack_tlv_posix_remove_entry(self, entry);
+	btstack_tlv_posix_append_tag(self, tag, NULL, 0);
+	btstack_tlv_posix_compact_if_needed(self);
 }
 
 /**
@@ -128,7 +244,7 @@ static int btstack_tlv_posix_get_tag(void * context, uint32_t tag, uint8_t * buf
 	if (!buffer) return entry->len;
 	// otherwise copy data into buffer
 	uint16_t bytes_to_copy = btstack_min(buffer_size, entry->len);
-	memcpy(buffer, &entry->value[0], bytes_to_copy);
+	memcpy(buffer, entry->value, bytes_to_copy);
 	return bytes_to_copy;
 }
 
@@ -144,8 +260,7 @@ static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8
 	// remove old entry
 	tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
 	if (old_entry){
-		btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-		free(old_entry);
+		btstack_tlv_posix_remove_entry(self, old_entry);
 	}
 
 	// create new entry
@@ -155,94 +270,153 @@ static int btstack_tlv_posix_store_tag(void * context, uint32_t tag, const uint8
 	memset(new_entry, 0, entry_size);
 	new_entry->tag = tag;
 	new_entry->len = data_size;
-	memcpy(&new_entry->value[0], data, data_size);
+	new_entry->value = &new_entry->data[0];
+	memcpy(&new_entry->data[0], data, data_size);
 
 	// append new entry
-	btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
+	btstack_tlv_posix_add_entry(self, new_entry);
 
 	// write new tag
 	btstack_tlv_posix_append_tag(self, tag, data, data_size);
 
+	btstack_tlv_posix_compact_if_needed(self);
 	return 0;
 }
 
+// replace entry for tag with new one, new_entry == NULL deletes tag
+static void btstack_tlv_posix_replay_entry(btstack_tlv_posix_t * self, uint32_t tag, tlv_entry_t * new_entry){
+	tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
+	if (old_entry){
+		btstack_tlv_posix_remove_entry(self, old_entry);
+	}
+	if (new_entry){
+		btstack_tlv_posix_add_entry(self, new_entry);
+	}
+}
+
+#ifdef ENABLE_TLV_POSIX_MMAP
+
+// returns 1 if file is valid. entries reference values in file mapping
+static int btstack_tlv_posix_read_entries(btstack_tlv_posix_t * self){
+	struct stat file_stat;
+	if (fstat(fileno(self->file), &file_stat) != 0) return 0;
+	size_t file_len = (size_t) file_stat.st_size;
+	if (file_len < BTSTACK_TLV_HEADER_LEN) return 0;
+
+	void * addr = mmap(NULL, file_len, PROT_READ, MAP_SHARED, fileno(self->file), 0);
+	if (addr == MAP_FAILED){
+		log_error("mmap %s failed", self->db_path);
+		return 0;
+	}
+	self->mmap_addr = addr;
+	self->mmap_len  = file_len;
+
+	const uint8_t * file_data = (const uint8_t *) addr;
+	if (memcmp(file_data, btstack_tlv_header_magic, strlen(btstack_tlv_header_magic)) != 0) return 0;
+	log_info("BTstack Magic Header found");
+
+	size_t pos = BTSTACK_TLV_HEADER_LEN;
+	while (pos < file_len){
+		if ((file_len - pos) < BTSTACK_TLV_ENTRY_HEADER_LEN) return 0;
+		uint32_t tag = big_endian_read_32(file_data, pos);
+		uint32_t len = big_endian_read_32(file_data, pos + 4);
+		pos += BTSTACK_TLV_ENTRY_HEADER_LEN;
+
+		// arbitrary safety check: values < 1000 bytes each
+		if (len > 1000) return 0;
+		if ((file_len - pos) < len) return 0;
+
+		// create new entry for regular tag
+		tlv_entry_t * new_entry = NULL;
+		if (len > 0){
+			new_entry = (tlv_entry_t *) malloc(sizeof(tlv_entry_t));
+			if (!new_entry) return 0;
+			new_entry->tag = tag;
+			new_entry->len = len;
+			new_entry->value = &file_data[pos];
+			pos += len;
+		}
+
+		btstack_tlv_posix_replay_entry(self, tag, new_entry);
+	}
+	self->file_size = (uint32_t) file_len;
+
+	// append at end of file
+	fseek(self->file, 0, SEEK_END);
+	return 1;
+}
+
+#else
+
+// returns 1 if file is valid
+static int btstack_tlv_posix_read_entries(btstack_tlv_posix_t * self){
+	uint8_t header[BTSTACK_TLV_HEADER_LEN];
+	size_t objects_read = fread(header, 1, BTSTACK_TLV_HEADER_LEN, self->file );
+	if (objects_read != BTSTACK_TLV_HEADER_LEN) return 0;
+	if (memcmp(header, btstack_tlv_header_magic, strlen(btstack_tlv_header_magic)) != 0) return 0;
+	log_info("BTstack Magic Header found");
+	self->file_size = BTSTACK_TLV_HEADER_LEN;
+
+	// read entries
+	while (true){
+		uint8_t entry[BTSTACK_TLV_ENTRY_HEADER_LEN];
+		size_t 	entries_read = fread(entry, 1, sizeof(entry), self->file);
+		if (entries_read == 0){
+			// EOF, we're good
+			return 1;
+		}
+		if (entries_read != sizeof(entry)) return 0;
+
+		uint32_t tag = big_endian_read_32(entry, 0);
+		uint32_t len = big_endian_read_32(entry, 4);
+
+		// arbitrary safety check: values < 1000 bytes each
+		if (len > 1000) return 0;
+
+		// create new entry for regular tag
+		tlv_entry_t * new_entry = NULL;
+		if (len > 0) {
+			new_entry = (tlv_entry_t *) malloc(sizeof(tlv_entry_t) - DUMMY_SIZE + len);
+			if (!new_entry) return 0;
+			new_entry->tag = tag;
+			new_entry->len = len;
+			new_entry->value = &new_entry->data[0];
+
+			// read
+			size_t value_read = fread(&new_entry->data[0], 1, len, self->file);
+			if (value_read != len) {
+				free(new_entry);
+				return 0;
+			}
+		}
+		self->file_size += BTSTACK_TLV_ENTRY_HEADER_LEN + len;
+
+		btstack_tlv_posix_replay_entry(self, tag, new_entry);
+	}
+}
+
+#endif
+
 // returns 0 on success
 static int btstack_tlv_posix_read_db(btstack_tlv_posix_t * self){
+	self->live_size = BTSTACK_TLV_HEADER_LEN;
+	self->file_size = 0;
+
 	// open file
 	log_info("open db %s", self->db_path);
-    self->file = fopen(self->db_path,"r+");
-    uint8_t header[BTSTACK_TLV_HEADER_LEN];
-    if (self->file){
-    	// checker header
-	    size_t objects_read = fread(header, 1, BTSTACK_TLV_HEADER_LEN, self->file );
-	    int file_valid = 0;
-	    if (objects_read == BTSTACK_TLV_HEADER_LEN){
-	    	if (memcmp(header, btstack_tlv_header_magic, strlen(btstack_tlv_header_magic)) == 0){
-		    	log_info("BTstack Magic Header found");
-		    	// read entries
-		    	while (true){
-					uint8_t entry[8];
-					size_t 	entries_read = fread(entry, 1, sizeof(entry), self->file);
-					if (entries_read == 0){
-						// EOF, we're good
-						file_valid = 1;
-						break;
-					}
-					if (entries_read != sizeof(entry)) break;
-
-                    uint32_t tag = big_endian_read_32(entry, 0);
-                    uint32_t len = big_endian_read_32(entry, 4);
-
-                    // arbitrary safety check: values < 1000 bytes each
-                    if (len > 1000) break;
-
-                    // create new entry for regular tag
-                    tlv_entry_t * new_entry = NULL;
-                    if (len > 0) {
-                        new_entry = (tlv_entry_t *) malloc(sizeof(tlv_entry_t) - DUMMY_SIZE + len);
-                        if (!new_entry) return 0;
-                        new_entry->tag = tag;
-                        new_entry->len = len;
-
-                        // read
-                        size_t value_read = fread(&new_entry->value[0], 1, len, self->file);
-                        if (value_read != len) break;
-                    }
-
-                    // remove old entry
-                    tlv_entry_t * old_entry = btstack_tlv_posix_find_entry(self, tag);
-                    if (old_entry){
-                        btstack_linked_list_remove(&self->entry_list, (btstack_linked_item_t *) old_entry);
-                        free(old_entry);
-                    }
-
-                    // append new entry
-                    if (new_entry){
-	                    btstack_linked_list_add(&self->entry_list, (btstack_linked_item_t *) new_entry);
-                    }
-		    	}
-	    	}
-	    }
-	    if (!file_valid) {
-	    	log_info("file invalid, re-create");
-    		fclose(self->file);
-    		self->file = NULL;
-	    }
-    }
-    if (!self->file){
-    	// create truncate file
-	    self->file = fopen(self->db_path,"w+");
-	    memset(header, 0, sizeof(header));
-	    strcpy((char *)header, btstack_tlv_header_magic);
-	    fwrite(header, 1, sizeof(header), self->file);
-	    // write out all valid entries (if any)
-		btstack_linked_list_iterator_t it;
-		btstack_linked_list_iterator_init(&it, &self->entry_list);
-		while (btstack_linked_list_iterator_has_next(&it)){
-			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
-			btstack_tlv_posix_append_tag(self, entry->tag, &entry->value[0], entry->len);
-		}
-    }
+	self->file = fopen(self->db_path,"r+b");
+	int file_valid = 0;
+	if (self->file){
+		file_valid = btstack_tlv_posix_read_entries(self);
+	}
+
+	if (!file_valid) {
+		// (re-)create file with all valid entries (if any)
+		log_info("file invalid, re-create");
+		btstack_tlv_posix_write_db(self);
+	} else {
+		btstack_tlv_posix_compact_if_needed(self);
+	}
 	return 0;
 }
 
@@ -264,3 +438,28 @@ const btstack_tlv_t * btstack_tlv_posix_init_instance(btstack_tlv_posix_t * self
 	return &btstack_tlv_posix;
 }
 
+/**
+ * Free all entries, unmap and close file
+ */
+void btstack_tlv_posix_deinit(btstack_tlv_posix_t * self){
+	int i;
+	for (i = 0; i < TLV_POSIX_HASH_TABLE_SIZE; i++){
+		btstack_linked_list_iterator_t it;
+		btstack_linked_list_iterator_init(&it, &self->entry_buckets[i]);
+		while (btstack_linked_list_iterator_has_next(&it)){
+			tlv_entry_t * entry = (tlv_entry_t*) btstack_linked_list_iterator_next(&it);
+			btstack_linked_list_iterator_remove(&it);
+			free(entry);
+		}
+	}
+#ifdef ENABLE_TLV_POSIX_MMAP
+	if (self->mmap_addr){
+		munmap(self->mmap_addr, self->mmap_len);
+		self->mmap_addr = NULL;
+	}
+#endif
+	if (self->file){
+		fclose(self->file);
+		self->file = NULL;
+	}
+}
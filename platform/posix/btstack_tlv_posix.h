@@ -41,6 +41,8 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stddef.h>
+#include "btstack_config.h"
 #include "btstack_tlv.h"
 #include "btstack_linked_list.h"
 
@@ -48,10 +50,22 @@
 extern "C" {
 #endif
 
+// number of hash buckets used to index entries by tag
+#ifndef TLV_POSIX_HASH_TABLE_SIZE
+#define TLV_POSIX_HASH_TABLE_SIZE 32
+#endif
+
 typedef struct {
-	btstack_linked_list_t entry_list;
+	// entries hashed by tag
+	btstack_linked_list_t entry_buckets[TLV_POSIX_HASH_TABLE_SIZE];
 	const char * db_path;
 	FILE * file;
+	// bytes in file vs. bytes required for header and current entries
+	uint32_t file_size;
+	uint32_t live_size;
+	// file mapping used by mmap read path
+	void   * mmap_addr;
+	size_t   mmap_len;
 } btstack_tlv_posix_t;
 
 /**
@@ -61,6 +75,12 @@ typedef struct {
  */
 const btstack_tlv_t * btstack_tlv_posix_init_instance(btstack_tlv_posix_t * context, const char * db_path);
 
+/**
+ * Free all entries, unmap and close file
+ * @param context btstack_tlv_posix_t
+ */
+void btstack_tlv_posix_deinit(btstack_tlv_posix_t * context);
+
 #if defined __cplusplus
 }
 #endif
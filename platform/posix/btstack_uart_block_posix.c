@@ -44,13 +44,16 @@
  *
  */
 
+#include "btstack_config.h"
 #include "btstack_uart_block.h"
 #include "btstack_run_loop.h"
 #include "btstack_debug.h"
+#include "btstack_util.h"
 
 #include <termios.h>  /* POSIX terminal control definitions */
 #include <fcntl.h>    /* File control definitions */
 #include <unistd.h>   /* UNIX standard function definitions */
+#include <sys/uio.h>  /* writev */
 #include <string.h>
 #include <errno.h>
 #ifdef __APPLE__
@@ -68,13 +71,34 @@ static btstack_data_source_t transport_data_source;
 static int             write_bytes_len;
 static const uint8_t * write_bytes_data;
 
+// vectored write
+#define BTSTACK_UART_POSIX_WRITEV_MAX 16
+static const btstack_iovec_t * write_vectors;
+static uint16_t                write_vectors_num;
+static uint16_t                write_vectors_offset;  // offset into first vector
+
 // block read
 static uint16_t  read_bytes_len;
 static uint8_t * read_bytes_data;
+static bool      read_bytes_partial;    // receive_bytes: deliver as soon as some bytes are available
+
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+// read all available bytes with a single read() and serve block reads from buffer
+#ifndef UART_POSIX_READ_AHEAD_BUFFER_SIZE
+#define UART_POSIX_READ_AHEAD_BUFFER_SIZE 2048
+#endif
+static uint8_t  read_ahead_buffer[UART_POSIX_READ_AHEAD_BUFFER_SIZE];
+static uint16_t read_ahead_pos;
+static uint16_t read_ahead_len;
+static bool     read_ahead_delivering;
+// used to deliver buffered data if block read is requested outside of block received callback
+static btstack_timer_source_t read_ahead_timer;
+#endif
 
 // callbacks
 static void (*block_sent)(void);
 static void (*block_received)(void);
+static void (*bytes_received)(uint16_t num_bytes);
 
 
 static int btstack_uart_posix_init(const btstack_uart_config_t * config){
@@ -82,8 +106,56 @@ static int btstack_uart_posix_init(const btstack_uart_config_t * config){
     return 0;
 }
 
+static void btstack_uart_posix_process_write_vectored(btstack_data_source_t *ds) {
+
+    // collect remaining vectors
+    struct iovec iov[BTSTACK_UART_POSIX_WRITEV_MAX];
+    int iov_count = 0;
+    while ((iov_count < BTSTACK_UART_POSIX_WRITEV_MAX) && (iov_count < write_vectors_num)){
+        iov[iov_count].iov_base = (void *) write_vectors[iov_count].data;
+        iov[iov_count].iov_len  = write_vectors[iov_count].len;
+        iov_count++;
+    }
+    iov[0].iov_base = (void *) &write_vectors[0].data[write_vectors_offset];
+    iov[0].iov_len -= write_vectors_offset;
+
+    // write as much as possible with a single system call
+    ssize_t bytes_written = writev(ds->source.fd, iov, iov_count);
+    if (bytes_written < 0) {
+        log_error("writev returned error\n");
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+
+    // skip over written vectors
+    size_t bytes_remaining = (size_t) bytes_written + write_vectors_offset;
+    while ((write_vectors_num > 0u) && (bytes_remaining >= write_vectors[0].len)){
+        bytes_remaining -= write_vectors[0].len;
+        write_vectors++;
+        write_vectors_num--;
+    }
+    write_vectors_offset = (uint16_t) bytes_remaining;
+
+    if (write_vectors_num){
+        btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+        return;
+    }
+
+    btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+
+    // notify done
+    if (block_sent){
+        block_sent();
+    }
+}
+
 static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
     
+    if (write_vectors_num){
+        btstack_uart_posix_process_write_vectored(ds);
+        return;
+    }
+
     if (write_bytes_len == 0) return;
 
     uint32_t start = btstack_run_loop_get_time_ms();
@@ -120,6 +192,73 @@ static void btstack_uart_posix_process_write(btstack_data_source_t *ds) {
     }
 }
 
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+
+// copy buffered bytes into requested blocks as long as possible
+static void btstack_uart_posix_read_ahead_deliver(void){
+    read_ahead_delivering = true;
+    while ((read_bytes_len > 0u) && (read_ahead_pos < read_ahead_len)){
+        uint16_t bytes_to_copy = btstack_min(read_bytes_len, read_ahead_len - read_ahead_pos);
+        (void) memcpy(read_bytes_data, &read_ahead_buffer[read_ahead_pos], bytes_to_copy);
+        read_ahead_pos  += bytes_to_copy;
+        read_bytes_data += bytes_to_copy;
+        read_bytes_len  -= bytes_to_copy;
+        if (read_bytes_partial){
+            read_bytes_partial = false;
+            read_bytes_len = 0;
+            // bytes handler usually requests more bytes
+            if (bytes_received){
+                bytes_received(bytes_to_copy);
+            }
+            continue;
+        }
+        if (read_bytes_len > 0u) break;
+        // block handler usually requests next block
+        if (block_received){
+            block_received();
+        }
+    }
+    read_ahead_delivering = false;
+
+    // wait for more data only if buffer is empty and a block is requested
+    if ((read_bytes_len > 0u) && (transport_data_source.source.fd >= 0)){
+        btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
+    } else {
+        btstack_run_loop_disable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
+    }
+}
+
+static void btstack_uart_posix_read_ahead_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_uart_posix_read_ahead_deliver();
+}
+
+static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
+
+    if (read_bytes_len == 0u) {
+        log_info("called but no read pending");
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+        return;
+    }
+
+    // buffer is empty as pending block would have been served otherwise
+    ssize_t bytes_read = read(ds->source.fd, read_ahead_buffer, sizeof(read_ahead_buffer));
+    if (bytes_read == 0){
+        log_error("read zero bytes\n");
+        return;
+    }
+    if (bytes_read < 0) {
+        log_error("read returned error\n");
+        return;
+    }
+    read_ahead_pos = 0;
+    read_ahead_len = (uint16_t) bytes_read;
+
+    btstack_uart_posix_read_ahead_deliver();
+}
+
+#else
+
 static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
 
     if (read_bytes_len == 0) {
@@ -145,6 +284,16 @@ static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
         return;
     }
 
+    if (read_bytes_partial){
+        read_bytes_partial = false;
+        read_bytes_len = 0;
+        btstack_run_loop_disable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+        if (bytes_received){
+            bytes_received((uint16_t) bytes_read);
+        }
+        return;
+    }
+
     read_bytes_len   -= bytes_read;
     read_bytes_data  += bytes_read;
     if (read_bytes_len > 0) return;
@@ -156,6 +305,8 @@ static void btstack_uart_posix_process_read(btstack_data_source_t *ds) {
     }
 }
 
+#endif
+
 static void hci_uart_posix_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type) {
     if (ds->source.fd < 0) return;
     switch (callback_type){
@@ -382,6 +533,20 @@ static int btstack_uart_posix_close_new(void){
     // then close device 
     close(transport_data_source.source.fd);
     transport_data_source.source.fd = -1;
+
+    // drop pending vectored write
+    write_vectors_num = 0;
+
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+    // drop buffered data
+    btstack_run_loop_remove_timer(&read_ahead_timer);
+    read_ahead_pos = 0;
+    read_ahead_len = 0;
+#endif
+
+    // drop pending read
+    read_bytes_len = 0;
+    read_bytes_partial = false;
     return 0;
 }
 
@@ -403,15 +568,55 @@ static void btstack_uart_posix_send_block(const uint8_t *data, uint16_t size){
     btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
 }
 
-static void btstack_uart_posix_receive_block(uint8_t *buffer, uint16_t len){
-    read_bytes_data = buffer;
-    read_bytes_len = len;
+static void btstack_uart_posix_send_block_vectored(const btstack_iovec_t * vectors, uint16_t num_vectors){
+    // setup async write
+    write_vectors        = vectors;
+    write_vectors_num    = num_vectors;
+    write_vectors_offset = 0;
+
+    // go
+    btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_WRITE);
+}
+
+static void btstack_uart_posix_start_read(void){
+
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+    // served by deliver loop
+    if (read_ahead_delivering) return;
+    if (read_ahead_pos < read_ahead_len){
+        // deliver buffered data from run loop
+        btstack_run_loop_remove_timer(&read_ahead_timer);
+        btstack_run_loop_set_timer_handler(&read_ahead_timer, &btstack_uart_posix_read_ahead_timeout_handler);
+        btstack_run_loop_set_timer(&read_ahead_timer, 0);
+        btstack_run_loop_add_timer(&read_ahead_timer);
+        return;
+    }
+#endif
+
     btstack_run_loop_enable_data_source_callbacks(&transport_data_source, DATA_SOURCE_CALLBACK_READ);
 
     // go
     // btstack_uart_posix_process_read(&transport_data_source);
 }
 
+static void btstack_uart_posix_receive_block(uint8_t *buffer, uint16_t len){
+    read_bytes_data = buffer;
+    read_bytes_len = len;
+    read_bytes_partial = false;
+    btstack_uart_posix_start_read();
+}
+
+static void btstack_uart_posix_set_bytes_received(void (*bytes_handler)(uint16_t num_bytes)){
+    bytes_received = bytes_handler;
+}
+
+static void btstack_uart_posix_receive_bytes(uint8_t *buffer, uint16_t max_len){
+    read_bytes_data = buffer;
+    read_bytes_len = max_len;
+    read_bytes_partial = true;
+    btstack_uart_posix_start_read();
+}
+
 // static void btstack_uart_posix_set_sleep(uint8_t sleep){
 // }
 // static void btstack_uart_posix_set_csr_irq_handler( void (*csr_irq_handler)(void)){
@@ -431,6 +636,9 @@ static const btstack_uart_block_t btstack_uart_posix = {
     /* int (*get_supported_sleep_modes); */                           NULL,
     /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    NULL,
     /* void (*set_wakeup_handler)(void (*handler)(void)); */          NULL,
+    /* void (*send_block_vectored)(const btstack_iovec_t *, uint16_t); */ &btstack_uart_posix_send_block_vectored,
+    /* void (*set_bytes_received)(void (*handler)(uint16_t)); */      &btstack_uart_posix_set_bytes_received,
+    /* void (*receive_bytes)(uint8_t *buffer, uint16_t max_len); */   &btstack_uart_posix_receive_bytes,
 };
 
 const btstack_uart_block_t * btstack_uart_block_posix_instance(void){
@@ -0,0 +1,977 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_virtual.c"
+
+/*
+ *  hci_transport_virtual.c
+ *
+ *  HCI Transport with built-in virtual Controller
+ *
+ *  The virtual Controller answers HCI Commands locally and exchanges connection setup, disconnects
+ *  and ACL packets with a peer virtual Controller over a file descriptor. ACL buffers are released
+ *  via Number Of Completed Packets Event after the peer acknowledged the packet. Outgoing ACL packets
+ *  are delayed according to the configured link bitrate and latency.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hci_transport_virtual.h"
+
+#include "bluetooth_company_id.h"
+#include "btstack_crypto.h"
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+
+// messages between virtual Controllers: type (1), len (2), payload (len)
+typedef enum {
+    VIRTUAL_LINK_PAGE = 1,              // initiator bd_addr, target bd_addr
+    VIRTUAL_LINK_PAGE_RESPONSE,         // status
+    VIRTUAL_LINK_LE_CONNECT,            // initiator bd_addr, target bd_addr, conn interval, conn latency, supervision timeout
+    VIRTUAL_LINK_LE_CONNECT_RESPONSE,   // status
+    VIRTUAL_LINK_CONNECT_CANCEL,        // link
+    VIRTUAL_LINK_DISCONNECT,            // link, reason
+    VIRTUAL_LINK_ACL,                   // link, ACL packet
+    VIRTUAL_LINK_ACL_ACK,               // link, num packets
+} virtual_link_message_t;
+
+#define VIRTUAL_LINK_HEADER_SIZE 3
+
+// one Classic and one LE connection to the peer Controller
+typedef enum {
+    VIRTUAL_LINK_CLASSIC = 0,
+    VIRTUAL_LINK_LE,
+    VIRTUAL_LINK_NUM
+} virtual_link_t;
+
+typedef enum {
+    VIRTUAL_CONNECTION_IDLE = 0,
+    VIRTUAL_CONNECTION_W4_PEER,          // outgoing, waiting for peer response
+    VIRTUAL_CONNECTION_W4_HOST_ACCEPT,   // incoming, waiting for Accept Connection Request
+    VIRTUAL_CONNECTION_OPEN,
+} virtual_connection_state_t;
+
+typedef struct {
+    virtual_connection_state_t state;
+    bd_addr_t address;
+    uint8_t   role;
+    uint16_t  conn_interval;
+    uint16_t  conn_latency;
+    uint16_t  supervision_timeout;
+} virtual_connection_t;
+
+typedef struct {
+    uint16_t size;
+    uint8_t  link;
+    uint32_t due_ms;
+    uint8_t  data[4 + HCI_ACL_PAYLOAD_SIZE];
+} virtual_acl_buffer_t;
+
+typedef struct {
+    uint16_t size;
+    uint8_t  data[2 + 255];
+} virtual_event_t;
+
+// default page timeout, 0x2000 * 0.625 ms
+#define VIRTUAL_PAGE_TIMEOUT_DEFAULT 0x2000
+
+static const hci_transport_config_virtual_t * virtual_config;
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// link to peer Controller
+static btstack_data_source_t virtual_data_source;
+static uint8_t  virtual_rx_buffer[2 * (VIRTUAL_LINK_HEADER_SIZE + 1 + 4 + HCI_ACL_PAYLOAD_SIZE)];
+static uint16_t virtual_rx_len;
+
+// Controller state
+static uint16_t virtual_acl_packet_len;
+static uint8_t  virtual_acl_packets_num;
+static bool     virtual_page_scan_enabled;
+static bool     virtual_advertising_enabled;
+static uint16_t virtual_page_timeout;
+static virtual_connection_t virtual_connections[VIRTUAL_LINK_NUM];
+static bool     virtual_page_pending;
+static bd_addr_t virtual_page_pending_address;
+static bool     virtual_le_connect_pending;
+static uint8_t  virtual_le_connect_pending_params[6 + 6];
+static btstack_timer_source_t virtual_page_timer;
+
+// ACL buffers in transmit order, buffers [0..num_sent) were sent to peer and wait for acknowledgement
+static virtual_acl_buffer_t virtual_acl_buffers[HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX];
+static uint8_t  virtual_acl_order[HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX];
+static uint8_t  virtual_acl_num_queued;
+static uint8_t  virtual_acl_num_sent;
+static uint64_t virtual_link_busy_until_us;
+static btstack_timer_source_t virtual_link_timer;
+
+// events for Host
+static virtual_event_t virtual_events[HCI_TRANSPORT_VIRTUAL_EVENT_QUEUE_SIZE];
+static uint8_t  virtual_events_head;
+static uint8_t  virtual_events_count;
+static bool     virtual_events_timer_active;
+static btstack_timer_source_t virtual_events_timer;
+
+static hci_con_handle_t virtual_handle_for_link(virtual_link_t link){
+    return (hci_con_handle_t) (link + 1u);
+}
+
+static bool virtual_link_for_handle(hci_con_handle_t handle, virtual_link_t * link){
+    if ((handle == 0u) || (handle > VIRTUAL_LINK_NUM)) return false;
+    *link = (virtual_link_t) (handle - 1u);
+    return virtual_connections[*link].state == VIRTUAL_CONNECTION_OPEN;
+}
+
+// Events
+
+static void virtual_events_deliver(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    virtual_events_timer_active = false;
+    while (virtual_events_count > 0u){
+        virtual_event_t * event = &virtual_events[virtual_events_head];
+        virtual_events_head = (virtual_events_head + 1u) % HCI_TRANSPORT_VIRTUAL_EVENT_QUEUE_SIZE;
+        virtual_events_count--;
+        // copy event as host might queue new events while handling this one
+        uint8_t packet[2 + 255];
+        uint16_t size = event->size;
+        (void)memcpy(packet, event->data, size);
+        (*packet_handler)(HCI_EVENT_PACKET, packet, size);
+    }
+}
+
+static void virtual_emit_event(const uint8_t * event, uint16_t size){
+    if (virtual_events_count == HCI_TRANSPORT_VIRTUAL_EVENT_QUEUE_SIZE){
+        log_error("virtual: event queue full, drop event 0x%02x", event[0]);
+        return;
+    }
+    uint8_t pos = (virtual_events_head + virtual_events_count) % HCI_TRANSPORT_VIRTUAL_EVENT_QUEUE_SIZE;
+    virtual_events[pos].size = size;
+    (void)memcpy(virtual_events[pos].data, event, size);
+    virtual_events_count++;
+
+    if (virtual_events_timer_active) return;
+    virtual_events_timer_active = true;
+    btstack_run_loop_set_timer_handler(&virtual_events_timer, &virtual_events_deliver);
+    btstack_run_loop_set_timer(&virtual_events_timer, 0);
+    btstack_run_loop_add_timer(&virtual_events_timer);
+}
+
+static void virtual_emit_command_complete(uint16_t opcode, const uint8_t * params, uint16_t params_len){
+    uint8_t event[2 + 255];
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = (uint8_t) (3u + params_len);
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    (void)memcpy(&event[5], params, params_len);
+    virtual_emit_event(event, 5u + params_len);
+}
+
+static void virtual_emit_command_complete_status(uint16_t opcode, uint8_t status){
+    virtual_emit_command_complete(opcode, &status, 1);
+}
+
+static void virtual_emit_command_status(uint16_t opcode, uint8_t status){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = 4;
+    event[2] = status;
+    event[3] = 1;
+    little_endian_store_16(event, 4, opcode);
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_connection_request(const bd_addr_t address){
+    uint8_t event[12];
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = 10;
+    reverse_bd_addr(address, &event[2]);
+    little_endian_store_24(event, 8, 0);
+    event[11] = 1;  // ACL
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_connection_complete(uint8_t status, const bd_addr_t address){
+    uint8_t event[13];
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = 11;
+    event[2] = status;
+    little_endian_store_16(event, 3, virtual_handle_for_link(VIRTUAL_LINK_CLASSIC));
+    reverse_bd_addr(address, &event[5]);
+    event[11] = 1;  // ACL
+    event[12] = 0;  // encryption disabled
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_le_connection_complete(uint8_t status){
+    const virtual_connection_t * connection = &virtual_connections[VIRTUAL_LINK_LE];
+    uint8_t event[21];
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 19;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = status;
+    little_endian_store_16(event, 4, virtual_handle_for_link(VIRTUAL_LINK_LE));
+    event[6] = connection->role;
+    event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(connection->address, &event[8]);
+    little_endian_store_16(event, 14, connection->conn_interval);
+    little_endian_store_16(event, 16, connection->conn_latency);
+    little_endian_store_16(event, 18, connection->supervision_timeout);
+    event[20] = 0;
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_disconnection_complete(virtual_link_t link, uint8_t reason){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = 4;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, virtual_handle_for_link(link));
+    event[5] = reason;
+    virtual_emit_event(event, sizeof(event));
+}
+
+static void virtual_emit_number_of_completed_packets(virtual_link_t link, uint16_t num_packets){
+    uint8_t event[7];
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 5;
+    event[2] = 1;
+    little_endian_store_16(event, 3, virtual_handle_for_link(link));
+    little_endian_store_16(event, 5, num_packets);
+    virtual_emit_event(event, sizeof(event));
+}
+
+// Link to peer Controller
+
+static void virtual_link_write(const uint8_t * data, uint16_t size){
+    while (size > 0u){
+        ssize_t bytes_written = write(virtual_config->fd_write, data, size);
+        if (bytes_written < 0){
+            if (errno == EINTR) continue;
+            log_error("virtual: write failed, errno %d", errno);
+            return;
+        }
+        data += bytes_written;
+        size -= (uint16_t) bytes_written;
+    }
+}
+
+static void virtual_link_send(virtual_link_message_t type, const uint8_t * payload, uint16_t payload_len){
+    uint8_t header[VIRTUAL_LINK_HEADER_SIZE];
+    header[0] = (uint8_t) type;
+    little_endian_store_16(header, 1, payload_len);
+    virtual_link_write(header, sizeof(header));
+    virtual_link_write(payload, payload_len);
+}
+
+static void virtual_link_send_status(virtual_link_message_t type, uint8_t status){
+    virtual_link_send(type, &status, 1);
+}
+
+static void virtual_link_send_link_and_value(virtual_link_message_t type, virtual_link_t link, uint8_t value){
+    uint8_t payload[2];
+    payload[0] = (uint8_t) link;
+    payload[1] = value;
+    virtual_link_send(type, payload, sizeof(payload));
+}
+
+// ACL buffers
+
+static void virtual_acl_process(btstack_timer_source_t * ts);
+
+static void virtual_acl_set_timer(uint32_t due_ms){
+    btstack_run_loop_remove_timer(&virtual_link_timer);
+    int32_t timeout_ms = (int32_t) (due_ms - btstack_run_loop_get_time_ms());
+    btstack_run_loop_set_timer_handler(&virtual_link_timer, &virtual_acl_process);
+    btstack_run_loop_set_timer(&virtual_link_timer, (timeout_ms > 0) ? (uint32_t) timeout_ms : 0u);
+    btstack_run_loop_add_timer(&virtual_link_timer);
+}
+
+// send ACL packets to peer after their transmission time and latency has passed
+static void virtual_acl_process(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    while (virtual_acl_num_sent < virtual_acl_num_queued){
+        virtual_acl_buffer_t * buffer = &virtual_acl_buffers[virtual_acl_order[virtual_acl_num_sent]];
+        if ((int32_t) (buffer->due_ms - btstack_run_loop_get_time_ms()) > 0){
+            virtual_acl_set_timer(buffer->due_ms);
+            return;
+        }
+        uint8_t header[VIRTUAL_LINK_HEADER_SIZE + 1];
+        header[0] = VIRTUAL_LINK_ACL;
+        little_endian_store_16(header, 1, 1u + buffer->size);
+        header[3] = buffer->link;
+        virtual_link_write(header, sizeof(header));
+        virtual_link_write(buffer->data, buffer->size);
+        virtual_acl_num_sent++;
+    }
+}
+
+static void virtual_acl_queue(virtual_link_t link, const uint8_t * packet, uint16_t size){
+    if (virtual_acl_num_queued == virtual_acl_packets_num){
+        log_error("virtual: no free ACL buffer, drop packet");
+        return;
+    }
+    if (size > (4u + virtual_acl_packet_len)){
+        log_error("virtual: ACL packet too large (%u), drop packet", size);
+        return;
+    }
+
+    // find free buffer
+    uint8_t index;
+    uint8_t i;
+    for (index = 0; index < virtual_acl_packets_num; index++){
+        for (i = 0; i < virtual_acl_num_queued; i++){
+            if (virtual_acl_order[i] == index) break;
+        }
+        if (i == virtual_acl_num_queued) break;
+    }
+    virtual_acl_buffer_t * buffer = &virtual_acl_buffers[index];
+    buffer->size = size;
+    buffer->link = (uint8_t) link;
+    (void)memcpy(buffer->data, packet, size);
+
+    // airtime of previous packets and this one, then latency
+    uint64_t now_us = (uint64_t) btstack_run_loop_get_time_ms() * 1000u;
+    if (virtual_link_busy_until_us < now_us){
+        virtual_link_busy_until_us = now_us;
+    }
+    if (virtual_config->link_bitrate != 0u){
+        virtual_link_busy_until_us += ((uint64_t) size * 8u * 1000000u) / virtual_config->link_bitrate;
+    }
+    uint64_t due_us = virtual_link_busy_until_us + virtual_config->link_latency_us;
+    buffer->due_ms = (uint32_t) ((due_us + 999u) / 1000u);
+
+    virtual_acl_order[virtual_acl_num_queued++] = index;
+    virtual_acl_process(NULL);
+}
+
+// peer acknowledged oldest packets of link
+static void virtual_acl_acknowledged(virtual_link_t link, uint8_t num_packets){
+    uint16_t num_completed = 0;
+    uint8_t i = 0;
+    while ((i < virtual_acl_num_sent) && (num_completed < num_packets)){
+        if (virtual_acl_buffers[virtual_acl_order[i]].link != link){
+            i++;
+            continue;
+        }
+        (void)memmove(&virtual_acl_order[i], &virtual_acl_order[i+1], virtual_acl_num_queued - i - 1u);
+        virtual_acl_num_queued--;
+        virtual_acl_num_sent--;
+        num_completed++;
+    }
+    if (num_completed > 0u){
+        virtual_emit_number_of_completed_packets(link, num_completed);
+    }
+}
+
+// drop all buffered packets for link
+static void virtual_acl_flush(virtual_link_t link){
+    uint8_t i = 0;
+    while (i < virtual_acl_num_queued){
+        if (virtual_acl_buffers[virtual_acl_order[i]].link != link){
+            i++;
+            continue;
+        }
+        if (i < virtual_acl_num_sent){
+            virtual_acl_num_sent--;
+        }
+        (void)memmove(&virtual_acl_order[i], &virtual_acl_order[i+1], virtual_acl_num_queued - i - 1u);
+        virtual_acl_num_queued--;
+    }
+}
+
+// Connections
+
+static void virtual_connection_close(virtual_link_t link, uint8_t reason){
+    virtual_connections[link].state = VIRTUAL_CONNECTION_IDLE;
+    virtual_acl_flush(link);
+    virtual_emit_disconnection_complete(link, reason);
+}
+
+static void virtual_page_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    virtual_connection_t * connection = &virtual_connections[VIRTUAL_LINK_CLASSIC];
+    if (connection->state != VIRTUAL_CONNECTION_W4_PEER) return;
+    connection->state = VIRTUAL_CONNECTION_IDLE;
+    virtual_link_send_link_and_value(VIRTUAL_LINK_CONNECT_CANCEL, VIRTUAL_LINK_CLASSIC, 0);
+    virtual_emit_connection_complete(ERROR_CODE_PAGE_TIMEOUT, connection->address);
+}
+
+static void virtual_handle_page(const bd_addr_t initiator){
+    virtual_connection_t * connection = &virtual_connections[VIRTUAL_LINK_CLASSIC];
+    connection->state = VIRTUAL_CONNECTION_W4_HOST_ACCEPT;
+    connection->role  = HCI_ROLE_SLAVE;
+    bd_addr_copy(connection->address, initiator);
+    virtual_page_pending = false;
+    virtual_emit_connection_request(initiator);
+}
+
+static void virtual_handle_le_connect(const uint8_t * params){
+    virtual_connection_t * connection = &virtual_connections[VIRTUAL_LINK_LE];
+    connection->state = VIRTUAL_CONNECTION_OPEN;
+    connection->role  = HCI_ROLE_SLAVE;
+    bd_addr_copy(connection->address, params);
+    connection->conn_interval       = little_endian_read_16(params, 6);
+    connection->conn_latency        = little_endian_read_16(params, 8);
+    connection->supervision_timeout = little_endian_read_16(params, 10);
+    virtual_le_connect_pending  = false;
+    // advertising stops on connection
+    virtual_advertising_enabled = false;
+    virtual_link_send_status(VIRTUAL_LINK_LE_CONNECT_RESPONSE, ERROR_CODE_SUCCESS);
+    virtual_emit_le_connection_complete(ERROR_CODE_SUCCESS);
+}
+
+static void virtual_handle_link_message(virtual_link_message_t type, const uint8_t * payload, uint16_t len){
+    virtual_connection_t * connection;
+    virtual_link_t link;
+    switch (type){
+        case VIRTUAL_LINK_PAGE:
+            if (len < 12u) break;
+            connection = &virtual_connections[VIRTUAL_LINK_CLASSIC];
+            if ((memcmp(&payload[6], virtual_config->bd_addr, 6) != 0) || (connection->state != VIRTUAL_CONNECTION_IDLE)){
+                virtual_link_send_status(VIRTUAL_LINK_PAGE_RESPONSE, ERROR_CODE_PAGE_TIMEOUT);
+                break;
+            }
+            // accept when page scan gets enabled
+            if (!virtual_page_scan_enabled){
+                virtual_page_pending = true;
+                bd_addr_copy(virtual_page_pending_address, payload);
+                break;
+            }
+            virtual_handle_page(payload);
+            break;
+        case VIRTUAL_LINK_PAGE_RESPONSE:
+            if (len < 1u) break;
+            connection = &virtual_connections[VIRTUAL_LINK_CLASSIC];
+            if (connection->state != VIRTUAL_CONNECTION_W4_PEER) break;
+            btstack_run_loop_remove_timer(&virtual_page_timer);
+            connection->state = (payload[0] == ERROR_CODE_SUCCESS) ? VIRTUAL_CONNECTION_OPEN : VIRTUAL_CONNECTION_IDLE;
+            virtual_emit_connection_complete(payload[0], connection->address);
+            break;
+        case VIRTUAL_LINK_LE_CONNECT:
+            if (len < 18u) break;
+            if (memcmp(&payload[6], virtual_config->bd_addr, 6) != 0) break;
+            if (virtual_connections[VIRTUAL_LINK_LE].state != VIRTUAL_CONNECTION_IDLE) break;
+            // connect when advertising gets enabled
+            if (!virtual_advertising_enabled){
+                virtual_le_connect_pending = true;
+                (void)memcpy(virtual_le_connect_pending_params, payload, 6);
+                (void)memcpy(&virtual_le_connect_pending_params[6], &payload[12], 6);
+                break;
+            }
+            (void)memcpy(virtual_le_connect_pending_params, payload, 6);
+            (void)memcpy(&virtual_le_connect_pending_params[6], &payload[12], 6);
+            virtual_handle_le_connect(virtual_le_connect_pending_params);
+            break;
+        case VIRTUAL_LINK_LE_CONNECT_RESPONSE:
+            if (len < 1u) break;
+            connection = &virtual_connections[VIRTUAL_LINK_LE];
+            if (connection->state != VIRTUAL_CONNECTION_W4_PEER) break;
+            connection->state = (payload[0] == ERROR_CODE_SUCCESS) ? VIRTUAL_CONNECTION_OPEN : VIRTUAL_CONNECTION_IDLE;
+            virtual_emit_le_connection_complete(payload[0]);
+            break;
+        case VIRTUAL_LINK_CONNECT_CANCEL:
+            if (len < 1u) break;
+            if (payload[0] == VIRTUAL_LINK_CLASSIC){
+                virtual_page_pending = false;
+            } else {
+                virtual_le_connect_pending = false;
+            }
+            break;
+        case VIRTUAL_LINK_DISCONNECT:
+            if (len < 2u) break;
+            link = (virtual_link_t) payload[0];
+            if (link >= VIRTUAL_LINK_NUM) break;
+            if (virtual_connections[link].state != VIRTUAL_CONNECTION_OPEN) break;
+            virtual_connection_close(link, payload[1]);
+            break;
+        case VIRTUAL_LINK_ACL:
+            if (len < 5u) break;
+            link = (virtual_link_t) payload[0];
+            if (link >= VIRTUAL_LINK_NUM) break;
+            if (virtual_connections[link].state != VIRTUAL_CONNECTION_OPEN) break;
+            if ((virtual_config->acl_drop_per_mille != 0u) && ((uint16_t) (rand() % 1000) < virtual_config->acl_drop_per_mille)){
+                // simulate packet loss, sender gets completed packet nevertheless
+                log_info("virtual: drop ACL packet");
+            } else {
+                // replace handle, keep packet boundary and broadcast flags
+                uint8_t * acl = (uint8_t *) &payload[1];
+                uint16_t flags = little_endian_read_16(acl, 0) & 0xf000u;
+                // first non-automatically-flushable packet from Host is delivered as first automatically flushable packet
+                if ((flags & 0x3000u) == 0u){
+                    flags |= 0x2000u;
+                }
+                little_endian_store_16(acl, 0, flags | virtual_handle_for_link(link));
+                (*packet_handler)(HCI_ACL_DATA_PACKET, acl, len - 1u);
+            }
+            virtual_link_send_link_and_value(VIRTUAL_LINK_ACL_ACK, link, 1);
+            break;
+        case VIRTUAL_LINK_ACL_ACK:
+            if (len < 2u) break;
+            link = (virtual_link_t) payload[0];
+            if (link >= VIRTUAL_LINK_NUM) break;
+            virtual_acl_acknowledged(link, payload[1]);
+            break;
+        default:
+            log_error("virtual: unknown message type %u", type);
+            break;
+    }
+}
+
+static void virtual_handle_peer_lost(void){
+    int i;
+    for (i = 0; i < VIRTUAL_LINK_NUM; i++){
+        if (virtual_connections[i].state == VIRTUAL_CONNECTION_OPEN){
+            virtual_connection_close((virtual_link_t) i, ERROR_CODE_CONNECTION_TIMEOUT);
+        }
+    }
+}
+
+static void virtual_process_read(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    ssize_t bytes_read = read(ds->source.fd, &virtual_rx_buffer[virtual_rx_len], sizeof(virtual_rx_buffer) - virtual_rx_len);
+    if (bytes_read <= 0){
+        if ((bytes_read < 0) && (errno == EINTR)) return;
+        log_info("virtual: peer Controller disconnected");
+        btstack_run_loop_remove_data_source(ds);
+        virtual_handle_peer_lost();
+        return;
+    }
+    virtual_rx_len += (uint16_t) bytes_read;
+
+    // process complete messages
+    uint16_t pos = 0;
+    while ((virtual_rx_len - pos) >= VIRTUAL_LINK_HEADER_SIZE){
+        uint16_t payload_len = little_endian_read_16(virtual_rx_buffer, pos + 1u);
+        if ((virtual_rx_len - pos) < (VIRTUAL_LINK_HEADER_SIZE + payload_len)) break;
+        virtual_handle_link_message((virtual_link_message_t) virtual_rx_buffer[pos], &virtual_rx_buffer[pos + VIRTUAL_LINK_HEADER_SIZE], payload_len);
+        pos += VIRTUAL_LINK_HEADER_SIZE + payload_len;
+    }
+    virtual_rx_len -= pos;
+    (void)memmove(virtual_rx_buffer, &virtual_rx_buffer[pos], virtual_rx_len);
+}
+
+// HCI Commands
+
+static bool virtual_command_uses_command_status(uint16_t opcode){
+    uint16_t ogf = opcode >> 10;
+    uint16_t ocf = opcode & 0x3ffu;
+    switch (ogf){
+        case OGF_LINK_CONTROL:
+            switch (ocf){
+                case 0x02:  // Inquiry Cancel
+                case 0x04:  // Exit Periodic Inquiry Mode
+                case 0x08:  // Create Connection Cancel
+                case 0x0b:  // Link Key Request Reply
+                case 0x0c:  // Link Key Request Negative Reply
+                case 0x0d:  // PIN Code Request Reply
+                case 0x0e:  // PIN Code Request Negative Reply
+                case 0x1a:  // Remote Name Request Cancel
+                case 0x2b:  // IO Capability Request Reply
+                case 0x2c:  // User Confirmation Request Reply
+                case 0x2d:  // User Confirmation Request Negative Reply
+                case 0x2e:  // User Passkey Request Reply
+                case 0x2f:  // User Passkey Request Negative Reply
+                case 0x33:  // Remote OOB Data Request Negative Reply
+                case 0x34:  // IO Capability Request Negative Reply
+                    return false;
+                default:
+                    return true;
+            }
+        case OGF_LINK_POLICY:
+            switch (ocf){
+                case 0x01:  // Hold Mode
+                case 0x03:  // Sniff Mode
+                case 0x04:  // Exit Sniff Mode
+                case 0x07:  // QoS Setup
+                case 0x0b:  // Switch Role
+                    return true;
+                default:
+                    return false;
+            }
+        case OGF_LE_CONTROLLER:
+            switch (ocf){
+                case 0x0d:  // LE Create Connection
+                case 0x13:  // LE Connection Update
+                case 0x16:  // LE Read Remote Features
+                case 0x19:  // LE Enable Encryption
+                case 0x25:  // LE Read Local P-256 Public Key
+                case 0x26:  // LE Generate DHKey
+                case 0x32:  // LE Set PHY
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+static void virtual_reset(void){
+    virtual_page_scan_enabled   = false;
+    virtual_advertising_enabled = false;
+    virtual_page_pending        = false;
+    virtual_le_connect_pending  = false;
+    virtual_page_timeout        = VIRTUAL_PAGE_TIMEOUT_DEFAULT;
+    memset(virtual_connections, 0, sizeof(virtual_connections));
+    virtual_acl_num_queued = 0;
+    virtual_acl_num_sent   = 0;
+    virtual_link_busy_until_us = 0;
+    btstack_run_loop_remove_timer(&virtual_link_timer);
+    btstack_run_loop_remove_timer(&virtual_page_timer);
+}
+
+static void virtual_handle_command(const uint8_t * packet, uint16_t size){
+    if (size < 3u) return;
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    const uint8_t * params = &packet[3];
+    uint16_t params_len = btstack_min(packet[2], size - 3u);
+    uint8_t result[1 + 248];
+    virtual_connection_t * connection;
+    virtual_link_t link;
+    int i;
+
+    memset(result, 0, sizeof(result));
+    result[0] = ERROR_CODE_SUCCESS;
+
+    switch (opcode){
+        case HCI_OPCODE_HCI_RESET:
+            virtual_reset();
+            virtual_emit_command_complete(opcode, result, 1);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            result[1] = 0x09;   // HCI Version 5.0
+            little_endian_store_16(result, 2, 0);
+            result[4] = 0x09;   // LMP Version 5.0
+            little_endian_store_16(result, 5, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+            little_endian_store_16(result, 7, 0);
+            virtual_emit_command_complete(opcode, result, 9);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_NAME:
+            (void)strcpy((char *) &result[1], "BTstack Virtual Controller");
+            virtual_emit_command_complete(opcode, result, 1 + 248);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            result[1 + 14] = 0x80;  // Read Buffer Size
+            result[1 + 24] = 0x40;  // Write LE Host Supported
+            virtual_emit_command_complete(opcode, result, 1 + 64);
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            result[1 + 4] = 0x40;   // LE Supported (Controller)
+            virtual_emit_command_complete(opcode, result, 1 + 8);
+            break;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            reverse_bd_addr(virtual_config->bd_addr, &result[1]);
+            virtual_emit_command_complete(opcode, result, 1 + 6);
+            break;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            little_endian_store_16(result, 1, virtual_acl_packet_len);
+            result[3] = 0;
+            little_endian_store_16(result, 4, virtual_acl_packets_num);
+            little_endian_store_16(result, 6, 0);
+            virtual_emit_command_complete(opcode, result, 8);
+            break;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            // LE shares ACL buffers with BR/EDR
+            virtual_emit_command_complete(opcode, result, 4);
+            break;
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            result[1] = 8;
+            virtual_emit_command_complete(opcode, result, 2);
+            break;
+        case HCI_OPCODE_HCI_LE_RAND:
+            for (i = 0; i < 8; i++){
+                result[1 + i] = (uint8_t) rand();
+            }
+            virtual_emit_command_complete(opcode, result, 9);
+            break;
+        case HCI_OPCODE_HCI_LE_ENCRYPT:
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+            if (params_len < 32u) break;
+            {
+                // parameters and result are little endian
+                uint8_t key[16];
+                uint8_t plaintext[16];
+                uint8_t ciphertext[16];
+                reverse_128(&params[0], key);
+                reverse_128(&params[16], plaintext);
+                btstack_aes128_calc(key, plaintext, ciphertext);
+                reverse_128(ciphertext, &result[1]);
+            }
+            virtual_emit_command_complete(opcode, result, 17);
+#else
+            virtual_emit_command_complete_status(opcode, ERROR_CODE_UNKNOWN_HCI_COMMAND);
+#endif
+            break;
+        case HCI_OPCODE_HCI_READ_RSSI:
+            if (params_len < 2u) break;
+            little_endian_store_16(result, 1, little_endian_read_16(params, 0));
+            virtual_emit_command_complete(opcode, result, 4);
+            break;
+        case HCI_OPCODE_HCI_WRITE_PAGE_TIMEOUT:
+            if (params_len < 2u) break;
+            virtual_page_timeout = little_endian_read_16(params, 0);
+            virtual_emit_command_complete(opcode, result, 1);
+            break;
+        case HCI_OPCODE_HCI_WRITE_SCAN_ENABLE:
+            if (params_len < 1u) break;
+            virtual_page_scan_enabled = (params[0] & 2u) != 0u;
+            virtual_emit_command_complete(opcode, result, 1);
+            if (virtual_page_scan_enabled && virtual_page_pending){
+                virtual_handle_page(virtual_page_pending_address);
+            }
+            break;
+        case HCI_OPCODE_HCI_LE_SET_ADVERTISE_ENABLE:
+            if (params_len < 1u) break;
+            virtual_advertising_enabled = params[0] != 0u;
+            virtual_emit_command_complete(opcode, result, 1);
+            if (virtual_advertising_enabled && virtual_le_connect_pending){
+                virtual_handle_le_connect(virtual_le_connect_pending_params);
+            }
+            break;
+        case HCI_OPCODE_HCI_CREATE_CONNECTION:
+            if (params_len < 6u) break;
+            connection = &virtual_connections[VIRTUAL_LINK_CLASSIC];
+            if (connection->state != VIRTUAL_CONNECTION_IDLE){
+                virtual_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            connection->state = VIRTUAL_CONNECTION_W4_PEER;
+            connection->role  = HCI_ROLE_MASTER;
+            reverse_bd_addr(params, connection->address);
+            bd_addr_copy(&result[0], virtual_config->bd_addr);
+            bd_addr_copy(&result[6], connection->address);
+            virtual_link_send(VIRTUAL_LINK_PAGE, result, 12);
+            btstack_run_loop_set_timer_handler(&virtual_page_timer, &virtual_page_timeout_handler);
+            btstack_run_loop_set_timer(&virtual_page_timer, ((uint32_t) virtual_page_timeout * 5u) / 8u);
+            btstack_run_loop_add_timer(&virtual_page_timer);
+            break;
+        case HCI_OPCODE_HCI_ACCEPT_CONNECTION_REQUEST:
+        case HCI_OPCODE_HCI_REJECT_CONNECTION_REQUEST:
+            if (params_len < 7u) break;
+            connection = &virtual_connections[VIRTUAL_LINK_CLASSIC];
+            if (connection->state != VIRTUAL_CONNECTION_W4_HOST_ACCEPT){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            if (opcode == HCI_OPCODE_HCI_ACCEPT_CONNECTION_REQUEST){
+                connection->state = VIRTUAL_CONNECTION_OPEN;
+                virtual_link_send_status(VIRTUAL_LINK_PAGE_RESPONSE, ERROR_CODE_SUCCESS);
+                virtual_emit_connection_complete(ERROR_CODE_SUCCESS, connection->address);
+            } else {
+                connection->state = VIRTUAL_CONNECTION_IDLE;
+                virtual_link_send_status(VIRTUAL_LINK_PAGE_RESPONSE, params[6]);
+                virtual_emit_connection_complete(params[6], connection->address);
+            }
+            break;
+        case HCI_OPCODE_HCI_LE_CREATE_CONNECTION:
+            if (params_len < 25u) break;
+            connection = &virtual_connections[VIRTUAL_LINK_LE];
+            if (connection->state != VIRTUAL_CONNECTION_IDLE){
+                virtual_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            connection->state = VIRTUAL_CONNECTION_W4_PEER;
+            connection->role  = HCI_ROLE_MASTER;
+            reverse_bd_addr(&params[6], connection->address);
+            connection->conn_interval       = little_endian_read_16(params, 15);
+            connection->conn_latency        = little_endian_read_16(params, 17);
+            connection->supervision_timeout = little_endian_read_16(params, 19);
+            bd_addr_copy(&result[0], virtual_config->bd_addr);
+            bd_addr_copy(&result[6], connection->address);
+            little_endian_store_16(result, 12, connection->conn_interval);
+            little_endian_store_16(result, 14, connection->conn_latency);
+            little_endian_store_16(result, 16, connection->supervision_timeout);
+            virtual_link_send(VIRTUAL_LINK_LE_CONNECT, result, 18);
+            break;
+        case HCI_OPCODE_HCI_LE_CREATE_CONNECTION_CANCEL:
+            connection = &virtual_connections[VIRTUAL_LINK_LE];
+            if (connection->state != VIRTUAL_CONNECTION_W4_PEER){
+                virtual_emit_command_complete_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+                break;
+            }
+            virtual_emit_command_complete(opcode, result, 1);
+            connection->state = VIRTUAL_CONNECTION_IDLE;
+            virtual_link_send_link_and_value(VIRTUAL_LINK_CONNECT_CANCEL, VIRTUAL_LINK_LE, 0);
+            virtual_emit_le_connection_complete(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+            break;
+        case HCI_OPCODE_HCI_LE_CONNECTION_UPDATE:
+            if (params_len < 14u) break;
+            if (!virtual_link_for_handle(little_endian_read_16(params, 0), &link) || (link != VIRTUAL_LINK_LE)){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            connection = &virtual_connections[VIRTUAL_LINK_LE];
+            connection->conn_interval       = little_endian_read_16(params, 4);
+            connection->conn_latency        = little_endian_read_16(params, 6);
+            connection->supervision_timeout = little_endian_read_16(params, 8);
+            result[0] = HCI_EVENT_LE_META;
+            result[1] = 10;
+            result[2] = HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE;
+            result[3] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(result, 4, virtual_handle_for_link(VIRTUAL_LINK_LE));
+            little_endian_store_16(result, 6, connection->conn_interval);
+            little_endian_store_16(result, 8, connection->conn_latency);
+            little_endian_store_16(result, 10, connection->supervision_timeout);
+            virtual_emit_event(result, 12);
+            break;
+        case HCI_OPCODE_HCI_DISCONNECT:
+            if (params_len < 3u) break;
+            if (!virtual_link_for_handle(little_endian_read_16(params, 0), &link)){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            virtual_link_send_link_and_value(VIRTUAL_LINK_DISCONNECT, link, params[2]);
+            virtual_connection_close(link, ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST);
+            break;
+        case HCI_OPCODE_HCI_READ_REMOTE_SUPPORTED_FEATURES_COMMAND:
+            if (params_len < 2u) break;
+            if (!virtual_link_for_handle(little_endian_read_16(params, 0), &link)){
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+                break;
+            }
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            result[0] = HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE;
+            result[1] = 11;
+            result[2] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(result, 3, virtual_handle_for_link(link));
+            memset(&result[5], 0, 8);
+            result[5 + 4] = 0x40;   // LE Supported (Controller)
+            virtual_emit_event(result, 13);
+            break;
+        case HCI_OPCODE_HCI_REMOTE_NAME_REQUEST:
+            if (params_len < 6u) break;
+            virtual_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+            {
+                uint8_t event[2 + 255];
+                memset(event, 0, sizeof(event));
+                event[0] = HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE;
+                event[1] = 255;
+                (void)memcpy(&event[3], params, 6);
+                (void)strcpy((char *) &event[9], "BTstack Virtual Controller");
+                virtual_emit_event(event, sizeof(event));
+            }
+            break;
+        default:
+            if (virtual_command_uses_command_status(opcode)){
+                log_info("virtual: command 0x%04x not supported", opcode);
+                virtual_emit_command_status(opcode, ERROR_CODE_UNKNOWN_HCI_COMMAND);
+            } else {
+                virtual_emit_command_complete(opcode, result, 1);
+            }
+            return;
+    }
+}
+
+static void virtual_handle_acl_packet(const uint8_t * packet, uint16_t size){
+    if (size < 4u) return;
+    virtual_link_t link;
+    if (!virtual_link_for_handle(little_endian_read_16(packet, 0) & 0x0fffu, &link)){
+        log_error("virtual: ACL packet for unknown handle");
+        return;
+    }
+    virtual_acl_queue(link, packet, size);
+}
+
+// HCI Transport
+
+static void hci_transport_virtual_init(const void * transport_config){
+    virtual_config = (const hci_transport_config_virtual_t *) transport_config;
+    virtual_acl_packet_len = (virtual_config->acl_packet_len != 0u) ? btstack_min(virtual_config->acl_packet_len, HCI_ACL_PAYLOAD_SIZE) : HCI_ACL_PAYLOAD_SIZE;
+    virtual_acl_packets_num = (virtual_config->acl_packets_num != 0u) ? btstack_min(virtual_config->acl_packets_num, HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX) : HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX;
+}
+
+static int hci_transport_virtual_open(void){
+    virtual_reset();
+    virtual_rx_len = 0;
+    virtual_events_head  = 0;
+    virtual_events_count = 0;
+    btstack_run_loop_set_data_source_fd(&virtual_data_source, virtual_config->fd_read);
+    btstack_run_loop_set_data_source_handler(&virtual_data_source, &virtual_process_read);
+    btstack_run_loop_add_data_source(&virtual_data_source);
+    btstack_run_loop_enable_data_source_callbacks(&virtual_data_source, DATA_SOURCE_CALLBACK_READ);
+    return 0;
+}
+
+static int hci_transport_virtual_close(void){
+    btstack_run_loop_remove_data_source(&virtual_data_source);
+    btstack_run_loop_remove_timer(&virtual_events_timer);
+    virtual_events_timer_active = false;
+    virtual_reset();
+    return 0;
+}
+
+static void hci_transport_virtual_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static int hci_transport_virtual_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            virtual_handle_command(packet, (uint16_t) size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            virtual_handle_acl_packet(packet, (uint16_t) size);
+            break;
+        default:
+            log_error("virtual: packet type %u not supported", packet_type);
+            break;
+    }
+    return 0;
+}
+
+static const hci_transport_t hci_transport_virtual = {
+    /* const char * name; */                                        "virtual",
+    /* void   (*init) (const void *transport_config); */            &hci_transport_virtual_init,
+    /* int    (*open)(void); */                                     &hci_transport_virtual_open,
+    /* int    (*close)(void); */                                    &hci_transport_virtual_close,
+    /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_virtual_register_packet_handler,
+    /* int    (*can_send_packet_now)(uint8_t packet_type); */       NULL,
+    /* int    (*send_packet)(...); */                               &hci_transport_virtual_send_packet,
+    /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+    /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+    /* int    (*send_packet_vectored)(...); */                      NULL,
+};
+
+const hci_transport_t * hci_transport_virtual_instance(void){
+    return &hci_transport_virtual;
+}
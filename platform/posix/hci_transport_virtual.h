@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ *  hci_transport_virtual.h
+ *
+ *  HCI Transport with built-in virtual Controller for tests and benchmarks without Bluetooth hardware.
+ *  Two BTstack processes are linked by connecting their virtual Controllers via a socket pair or two pipes.
+ */
+
+#ifndef HCI_TRANSPORT_VIRTUAL_H
+#define HCI_TRANSPORT_VIRTUAL_H
+
+#include <stdint.h>
+#include "btstack_config.h"
+#include "bluetooth.h"
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// max number of ACL buffers in virtual Controller
+#ifndef HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX
+#define HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX 8
+#endif
+
+// number of HCI Events queued for delivery to the Host
+#ifndef HCI_TRANSPORT_VIRTUAL_EVENT_QUEUE_SIZE
+#define HCI_TRANSPORT_VIRTUAL_EVENT_QUEUE_SIZE 16
+#endif
+
+typedef struct {
+    // file descriptors connected to the peer virtual Controller, can be the same for a socket
+    int       fd_read;
+    int       fd_write;
+    // public BD_ADDR
+    bd_addr_t bd_addr;
+    // size and number of ACL buffers, 0 for HCI_ACL_PAYLOAD_SIZE and HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX
+    uint16_t  acl_packet_len;
+    uint8_t   acl_packets_num;
+    // one-way latency of ACL packets, 0 for none
+    uint32_t  link_latency_us;
+    // link bitrate in bit/s, 0 for unlimited
+    uint32_t  link_bitrate;
+    // simulated loss of received ACL packets in 1/1000, 0 for lossless link
+    uint16_t  acl_drop_per_mille;
+} hci_transport_config_virtual_t;
+
+/**
+ * @brief Get Virtual HCI Transport instance, provide hci_transport_config_virtual_t to hci_init
+ * @note LE Encrypt is only supported with ENABLE_SOFTWARE_AES128 or HAVE_AES128
+ * @return hci_transport
+ */
+const hci_transport_t * hci_transport_virtual_instance(void);
+
+#if defined __cplusplus
+}
+#endif
+#endif // HCI_TRANSPORT_VIRTUAL_H
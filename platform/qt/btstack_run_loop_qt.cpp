@@ -58,8 +58,6 @@
 #include <time.h>
 #include <unistd.h>
 
-static void btstack_run_loop_qt_dump_timer(void);
-
 // start time. tv_usec/tv_nsec = 0
 #ifdef _POSIX_MONOTONIC_CLOCK
 // use monotonic clock if available
@@ -312,15 +310,6 @@ static void btstack_run_loop_qt_init(void){
 #endif
 }
 
-static void btstack_run_loop_qt_dump_timer(void){
-    btstack_linked_item_t *it;
-    int i = 0;
-    for (it = (btstack_linked_item_t *) btstack_run_loop_base_timers; it ; it = it->next){
-        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
-        log_info("timer %u (%p): timeout %u\n", i, ts, ts->timeout);
-    }
-}
-
 static const btstack_run_loop_t btstack_run_loop_qt = {
     &btstack_run_loop_qt_init,
     &btstack_run_loop_qt_add_data_source,
@@ -331,7 +320,7 @@ static const btstack_run_loop_t btstack_run_loop_qt = {
     &btstack_run_loop_qt_add_timer,
     &btstack_run_loop_base_remove_timer,
     &btstack_run_loop_qt_execute,
-    &btstack_run_loop_qt_dump_timer,
+    &btstack_run_loop_base_dump_timer,
     &btstack_run_loop_qt_get_time_ms,
 };
 
@@ -1428,6 +1428,7 @@ static const hci_transport_t hci_transport_usb = {
 #else
     /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL, 
 #endif    
+    /* int    (*send_packet_vectored)(...); */                      NULL,
 };
 
 const hci_transport_t * hci_transport_usb_instance(void) {
@@ -299,6 +299,7 @@ static const hci_transport_t transport = {
     NULL, // set baud rate
     NULL, // reset link
     NULL, // set SCO config
+    NULL, // send packet vectored
 };
 
 #else
@@ -326,6 +327,7 @@ static const hci_transport_t transport = {
     NULL, // set baud rate
     NULL, // reset link
     NULL, // set SCO config
+    NULL, // send packet vectored
 };
 #endif
 
@@ -155,6 +155,8 @@ static const hci_transport_t transport = {
     /* int    (*send_packet)(...); */                               &transport_send_packet,
     /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
     /* void   (*reset_link)(void); */                               NULL,
+    /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+    /* int    (*send_packet_vectored)(...); */                      NULL,
 };
 
 static const hci_transport_t * transport_get_instance(void){
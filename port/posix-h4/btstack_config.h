@@ -15,6 +15,7 @@
 // BTstack features that can be enabled
 #define ENABLE_BLE
 #define ENABLE_CLASSIC
+#define ENABLE_HCI_SEND_PACKET_VECTORED
 #define ENABLE_HFP_WIDE_BAND_SPEECH
 #define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 #define ENABLE_LE_CENTRAL
@@ -29,6 +30,7 @@
 #define ENABLE_SCO_OVER_HCI
 #define ENABLE_SDP_DES_DUMP
 #define ENABLE_SOFTWARE_AES128
+#define ENABLE_UART_POSIX_READ_AHEAD
 // #define ENABLE_EHCILL
 
 // BTstack configuration. buffers, sizes, ...
@@ -14,6 +14,7 @@
 // BTstack features that can be enabled
 #define ENABLE_BLE
 #define ENABLE_CLASSIC
+#define ENABLE_H5_CRC16_TABLE_256
 #define ENABLE_HFP_WIDE_BAND_SPEECH
 #define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 #define ENABLE_LE_CENTRAL
@@ -30,6 +31,7 @@
 // BTstack configuration. buffers, sizes, ...
 #define HCI_INCOMING_PRE_BUFFER_SIZE 14 // sizeof benep heade, avoid memcpy
 #define HCI_ACL_PAYLOAD_SIZE (1691 + 4)
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 7
 
 #define NVM_NUM_LINK_KEYS              16
 #define NVM_NUM_DEVICE_DB_ENTRIES      16
@@ -285,6 +285,7 @@ static const hci_transport_t controller_transport = {
         NULL, // set baud rate
         NULL, // reset link
         NULL, // set SCO config
+        NULL, // send packet vectored
 };
 
 const hci_transport_t * controller_get_hci_transport(void){
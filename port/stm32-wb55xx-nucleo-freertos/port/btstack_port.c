@@ -529,6 +529,7 @@ static const hci_transport_t transport = {
     NULL, // set baud rate
     NULL, // reset link
     NULL, // set SCO config
+    NULL, // send packet vectored
 };
 
 
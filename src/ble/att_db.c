@@ -99,10 +99,37 @@ static uint16_t att_prepare_write_error_handle = 0x0000;
 static uint16_t att_persistent_ccc_handle;
 static uint16_t att_persistent_ccc_uuid16;
 
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+#ifndef ATT_DB_HANDLE_INDEX_SIZE
+#define ATT_DB_HANDLE_INDEX_SIZE 256
+#endif
+// offset of first attribute with handle >= (index + 1) for handles up to att_db_handle_index_max_handle
+static uint16_t att_db_handle_index[ATT_DB_HANDLE_INDEX_SIZE];
+static uint16_t att_db_handle_index_max_handle;
+// offset of first attribute not covered by index, attributes added after att_set_db are found from here
+static uint16_t att_db_handle_index_tail_offset;
+#endif
+
 static void att_iterator_init(att_iterator_t *it){
     it->att_ptr = att_db;
 }
 
+// start iteration at first attribute with handle >= given handle, or earlier
+static void att_iterator_init_at_handle(att_iterator_t *it, uint16_t handle){
+    att_iterator_init(it);
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+    if (att_db == NULL) return;
+    if (handle == 0u) return;
+    if (handle <= att_db_handle_index_max_handle){
+        it->att_ptr = &att_db[att_db_handle_index[handle - 1u]];
+    } else {
+        it->att_ptr = &att_db[att_db_handle_index_tail_offset];
+    }
+#else
+    UNUSED(handle);
+#endif
+}
+
 static bool att_iterator_has_next(att_iterator_t *it){
     return it->att_ptr != NULL;
 }
@@ -160,7 +187,7 @@ static int att_iterator_match_uuid(att_iterator_t *it, uint8_t *uuid, uint16_t u
 
 static int att_find_handle(att_iterator_t *it, uint16_t handle){
     if (handle == 0u) return 0u;
-    att_iterator_init(it);
+    att_iterator_init_at_handle(it, handle);
     while (att_iterator_has_next(it)){
         att_iterator_fetch_next(it);
         if (it->handle != handle) continue;
@@ -202,6 +229,35 @@ static int att_copy_value(att_iterator_t *it, uint16_t offset, uint8_t * buffer,
     return bytes_to_copy;
 }
 
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+static void att_db_handle_index_build(void){
+    att_db_handle_index_max_handle  = 0;
+    att_db_handle_index_tail_offset = 0;
+    uint32_t offset = 0;
+    while (true){
+        uint16_t size = little_endian_read_16(att_db, offset);
+        if (size == 0u) break;
+        uint16_t handle = little_endian_read_16(att_db, offset + 4u);
+        // index requires ascending handles and 16-bit offsets
+        if (handle <= att_db_handle_index_max_handle) break;
+        if (handle > ATT_DB_HANDLE_INDEX_SIZE) break;
+        if (offset > 0xffffu) break;
+        uint16_t h;
+        for (h = att_db_handle_index_max_handle + 1u; h <= handle; h++){
+            att_db_handle_index[h - 1u] = (uint16_t) offset;
+        }
+        att_db_handle_index_max_handle = handle;
+        offset += size;
+    }
+    if (offset > 0xffffu){
+        // cannot represent tail, search from start
+        offset = 0;
+    }
+    att_db_handle_index_tail_offset = (uint16_t) offset;
+    log_info("handle index covers handles 1..%u", att_db_handle_index_max_handle);
+}
+#endif
+
 void att_set_db(uint8_t const * db){
     // validate db version
     if (db == NULL) return;
@@ -210,6 +266,9 @@ void att_set_db(uint8_t const * db){
         return;
     }
     att_db = db;
+#ifdef ENABLE_ATT_DB_HANDLE_INDEX
+    att_db_handle_index_build();
+#endif
 }
 
 void att_set_read_callback(att_read_callback_t callback){
@@ -396,7 +455,7 @@ static uint16_t handle_find_information_request2(att_connection_t * att_connecti
     uint16_t uuid_len = 0;
     
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (!it.handle) break;
@@ -489,7 +548,7 @@ static uint16_t handle_find_by_type_value_request(att_connection_t * att_connect
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
 
@@ -550,7 +609,7 @@ static uint16_t handle_read_by_type_request2(att_connection_t * att_connection,
     uint16_t pair_len = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     uint8_t error_code = 0;
     uint16_t first_matching_but_unreadable_handle = 0;
 
@@ -878,7 +937,7 @@ static uint16_t handle_read_by_group_type_request2(att_connection_t * att_connec
     uint16_t prev_handle = 0;
 
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         
@@ -1259,7 +1318,7 @@ bool gatt_server_get_get_handle_range_for_service_with_uuid16(uint16_t uuid16, u
 // returns false if not found
 uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (it.handle && (it.handle < start_handle)) continue;
@@ -1272,7 +1331,7 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid16(uint16_t st
 
 uint16_t gatt_server_get_descriptor_handle_for_characteristic_with_uuid16(uint16_t start_handle, uint16_t end_handle, uint16_t characteristic_uuid16, uint16_t descriptor_uuid16){
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     int characteristic_found = 0;
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
@@ -1345,7 +1404,7 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid128(uint16_t s
     uint8_t attribute_value[16];
     reverse_128(uuid128, attribute_value);
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
         if (it.handle && (it.handle < start_handle)) continue;
@@ -1361,7 +1420,7 @@ uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uui
     uint8_t attribute_value[16];
     reverse_128(uuid128, attribute_value);
     att_iterator_t it;
-    att_iterator_init(&it);
+    att_iterator_init_at_handle(&it, start_handle);
     int characteristic_found = 0;
     while (att_iterator_has_next(&it)){
         att_iterator_fetch_next(&it);
@@ -83,6 +83,8 @@ extern "C" {
 #define ATT_HANDLE_VALUE_INDICATION     0x1d
 #define ATT_HANDLE_VALUE_CONFIRMATION   0x1e
 
+#define ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION 0x23
+
 
 #define ATT_WRITE_COMMAND                0x52
 #define ATT_SIGNED_WRITE_COMMAND         0xD2
@@ -54,6 +54,7 @@
 #include "ble/core.h"
 #include "ble/le_device_db.h"
 #include "ble/sm.h"
+#include "bluetooth_gatt.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_memory.h"
@@ -95,6 +96,7 @@ typedef struct {
 
 // global
 static btstack_packet_callback_registration_t hci_event_callback_registration;
+static uint8_t hci_event_codes[HCI_EVENT_CODE_BITMAP_LEN];
 static btstack_packet_callback_registration_t sm_event_callback_registration;
 static btstack_packet_handler_t               att_client_packet_handler = NULL;
 static btstack_linked_list_t                  service_handlers;
@@ -103,6 +105,9 @@ static btstack_context_callback_registration_t att_client_waiting_for_can_send_r
 static att_read_callback_t                    att_server_client_read_callback;
 static att_write_callback_t                   att_server_client_write_callback;
 
+// value handle of Client Supported Features characteristic, 0 if not in database
+static uint16_t                               att_server_client_supported_features_handle;
+
 // round robin
 static hci_con_handle_t att_server_last_can_send_now = HCI_CON_HANDLE_INVALID;
 
@@ -157,6 +162,16 @@ static int att_server_can_send_packet(att_server_t * att_server){
     return att_dispatch_server_can_send_now(att_server->connection.con_handle);
 }
 
+static void att_server_send_prepared(att_server_t * att_server, uint16_t size){
+#ifdef ENABLE_GATT_OVER_CLASSIC
+    if (att_server->l2cap_cid != 0){
+        l2cap_send_prepared(att_server->l2cap_cid, size);
+        return;
+    }
+#endif
+    l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
+}
+
 static void att_handle_value_indication_notify_client(uint8_t status, uint16_t client_handle, uint16_t attribute_handle){
     btstack_packet_handler_t packet_handler = att_server_packet_handler_for_handle(attribute_handle);
     if (!packet_handler) return;
@@ -284,6 +299,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_server->l2cap_cid = l2cap_event_channel_opened_get_local_cid(packet);
                     // reset connection properties
                     att_server->state = ATT_SERVER_IDLE;
+                    att_server->client_supported_features = 0;
                     att_server->connection.mtu = l2cap_event_channel_opened_get_remote_mtu(packet);
                     att_server->connection.max_mtu = l2cap_max_mtu();
                     if (att_server->connection.max_mtu > ATT_REQUEST_BUFFER_SIZE){
@@ -334,6 +350,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                             att_server->connection.encryption_key_size = 0;
                             att_server->connection.authenticated = 0;
 		                	att_server->connection.authorized = 0;
+                            att_server->client_supported_features = 0;
                             // workaround: identity resolving can already be complete, at least store result
                             att_server->ir_le_device_db_index = sm_le_device_index(con_handle);
                             att_server->ir_lookup_active = 0;
@@ -556,14 +573,7 @@ static int att_server_process_validated_request(att_server_t * att_server){
         return 0;
     }
 
-#ifdef ENABLE_GATT_OVER_CLASSIC
-    if (att_server->l2cap_cid != 0){
-        l2cap_send_prepared(att_server->l2cap_cid, att_response_size);
-    } else
-#endif
-    {
-        l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, att_response_size);
-    }
+    att_server_send_prepared(att_server, att_response_size);
 
     // notify client about MTU exchange result
     if (att_response_buffer[0] == ATT_EXCHANGE_MTU_RESPONSE){
@@ -1053,6 +1063,13 @@ static uint8_t att_validate_prepared_write(hci_con_handle_t con_handle){
 }
 
 static uint16_t att_server_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    // Client Supported Features are tracked per connection
+    if ((attribute_handle != 0u) && (attribute_handle == att_server_client_supported_features_handle)){
+        att_server_t * att_server = att_server_for_handle(con_handle);
+        if (!att_server) return 0;
+        return att_read_callback_handle_byte(att_server->client_supported_features, offset, buffer, buffer_size);
+    }
+
     att_read_callback_t callback = att_server_read_callback_for_handle(attribute_handle);
     if (!callback) return 0;
     return (*callback)(con_handle, attribute_handle, offset, buffer, buffer_size);
@@ -1070,6 +1087,17 @@ static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attri
             break;
     }
 
+    // track Client Supported Features, features cannot be disabled by the client
+    if ((attribute_handle != 0u) && (attribute_handle == att_server_client_supported_features_handle)){
+        if (offset != 0u) return ATT_ERROR_INVALID_OFFSET;
+        att_server_t * att_server = att_server_for_handle(con_handle);
+        if (att_server && (buffer_size > 0u)){
+            att_server->client_supported_features |= buffer[0];
+            log_info("Client Supported Features 0x%02x", att_server->client_supported_features);
+        }
+        return 0;
+    }
+
     // track CCC writes
     if (att_is_persistent_ccc(attribute_handle) && (offset == 0u) && (buffer_size == 2u)){
         att_server_persistent_ccc_write(con_handle, attribute_handle, little_endian_read_16(buffer, 0));
@@ -1100,8 +1128,12 @@ void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_
     att_server_client_write_callback = write_callback;
 
     // register for HCI Events
+    hci_event_code_bitmap_set_le_subevent(hci_event_codes, HCI_SUBEVENT_LE_CONNECTION_COMPLETE);
+    hci_event_code_bitmap_set(hci_event_codes, HCI_EVENT_ENCRYPTION_CHANGE);
+    hci_event_code_bitmap_set(hci_event_codes, HCI_EVENT_ENCRYPTION_KEY_REFRESH_COMPLETE);
+    hci_event_code_bitmap_set(hci_event_codes, HCI_EVENT_DISCONNECTION_COMPLETE);
     hci_event_callback_registration.callback = &att_event_packet_handler;
-    hci_add_event_handler(&hci_event_callback_registration);
+    hci_add_event_handler_for_event_codes(&hci_event_callback_registration, hci_event_codes);
 
     // register for SM events
     sm_event_callback_registration.callback = &att_event_packet_handler;
@@ -1116,6 +1148,10 @@ void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_
 #endif
 
     att_set_db(db);
+    att_server_client_supported_features_handle = 0;
+    if (db != NULL){
+        att_server_client_supported_features_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(0x0001, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_CLIENT_SUPPORTED_FEATURES);
+    }
     att_set_read_callback(att_server_read_callback);
     att_set_write_callback(att_server_write_callback);
 }
@@ -1177,6 +1213,54 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, co
 	return l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
 }
 
+// packs as many (handle, length, value) tuples as fit into the ATT MTU, returns PDU size
+static uint16_t att_server_prepare_multiple_handle_value_notification(att_server_t * att_server, const att_server_notification_t * notifications,
+                                                                       uint16_t num_notifications, uint8_t * buffer, uint16_t * num_packed){
+    uint16_t mtu = att_server->connection.mtu;
+    uint16_t pos = 1;
+    uint16_t i;
+    buffer[0] = ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION;
+    for (i = 0; i < num_notifications; i++){
+        const att_server_notification_t * notification = &notifications[i];
+        if ((pos + 4u + notification->value_len) > mtu) break;
+        little_endian_store_16(buffer, pos, notification->attribute_handle);
+        little_endian_store_16(buffer, pos + 2u, notification->value_len);
+        (void)memcpy(&buffer[pos + 4u], notification->value, notification->value_len);
+        pos += 4u + notification->value_len;
+    }
+    *num_packed = i;
+    return pos;
+}
+
+uint16_t att_server_notify_batch(hci_con_handle_t con_handle, const att_server_notification_t * notifications, uint16_t num_notifications){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return 0;
+
+    bool multiple_supported = (att_server->client_supported_features & GATT_CLIENT_SUPPORTED_FEATURES_MULTIPLE_HANDLE_VALUE_NOTIFICATIONS) != 0u;
+    uint16_t num_sent = 0;
+    while ((num_sent < num_notifications) && att_server_can_send_packet(att_server)){
+        l2cap_reserve_packet_buffer();
+        uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
+        uint16_t remaining = num_notifications - num_sent;
+        uint16_t num_packed = 0;
+        uint16_t size = 0;
+        if (multiple_supported && (remaining > 1u)){
+            size = att_server_prepare_multiple_handle_value_notification(att_server, &notifications[num_sent],
+                                                                         remaining, packet_buffer, &num_packed);
+        }
+        // Multiple Handle Value Notification requires at least two values, fallback to single notification
+        if (num_packed < 2u){
+            const att_server_notification_t * notification = &notifications[num_sent];
+            size = att_prepare_handle_value_notification(&att_server->connection, notification->attribute_handle,
+                                                         notification->value, notification->value_len, packet_buffer);
+            num_packed = 1;
+        }
+        att_server_send_prepared(att_server, size);
+        num_sent += num_packed;
+    }
+    return num_sent;
+}
+
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len){
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
@@ -46,6 +46,13 @@
 extern "C" {
 #endif
 
+// attribute handle and value used by att_server_notify_batch
+typedef struct {
+    uint16_t        attribute_handle;
+    const uint8_t * value;
+    uint16_t        value_len;
+} att_server_notification_t;
+
 /* API_START */
 /*
  * @brief setup ATT server
@@ -114,6 +121,18 @@ int att_server_request_to_send_indication(btstack_context_callback_registration_
  */
 int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
 
+/*
+ * @brief notify client about value changes of several attributes
+ * @note Values are sent as long as outgoing buffers are available. If the client has enabled
+ *       Multiple Handle Value Notifications via the Client Supported Features characteristic,
+ *       consecutive values that fit into the ATT MTU are combined into a single PDU.
+ * @param con_handle
+ * @param notifications array of attribute handle and value pairs
+ * @param num_notifications
+ * @return number of values sent, remaining values can be sent after the next can send now callback
+ */
+uint16_t att_server_notify_batch(hci_con_handle_t con_handle, const att_server_notification_t * notifications, uint16_t num_notifications);
+
 /*
  * @brief indicate value change to client. client is supposed to reply with an indication_response
  * @param con_handle
@@ -49,10 +49,12 @@
 #include "ble/gatt_client.h"
 #include "ble/le_device_db.h"
 #include "ble/sm.h"
+#include "bluetooth_gatt.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
+#include "btstack_tlv.h"
 #include "btstack_util.h"
 #include "classic/sdp_util.h"
 #include "hci.h"
@@ -61,10 +63,16 @@
 #include "l2cap.h"
 
 static btstack_linked_list_t gatt_client_connections;
+// con handle indexed lookup table for gatt_client_connections, validated on access
+static gatt_client_t * gatt_client_lookup_table[HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+// value listeners for specific connection and characteristic, hashed by con handle and value handle
+static btstack_linked_list_t gatt_client_value_listener_buckets[GATT_CLIENT_VALUE_LISTENER_HASH_TABLE_SIZE];
+// value listeners for any connection or any characteristic
 static btstack_linked_list_t gatt_client_value_listeners;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
+static uint8_t hci_event_codes[HCI_EVENT_CODE_BITMAP_LEN];
 
-#if defined(ENABLE_GATT_CLIENT_PAIRING) || defined (ENABLE_LE_SIGNED_WRITE)
+#if defined(ENABLE_GATT_CLIENT_PAIRING) || defined (ENABLE_LE_SIGNED_WRITE) || defined (ENABLE_GATT_CLIENT_CACHE)
 static btstack_packet_callback_registration_t sm_event_callback_registration;
 #endif
 
@@ -73,11 +81,22 @@ static uint8_t mtu_exchange_enabled;
 static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size);
 static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 static void gatt_client_report_error_if_pending(gatt_client_t *peripheral, uint8_t att_error_code);
+static void gatt_client_operation_queue_flush(gatt_client_t * peripheral, uint8_t att_status);
+static void gatt_client_run(void);
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static void att_signed_write_handle_cmac_result(uint8_t hash[8]);
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+static bool gatt_client_cache_handle_query(gatt_client_t * peripheral, gatt_client_state_t query_state);
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t att_status);
+static void gatt_client_cache_record_service(gatt_client_t * peripheral, uint16_t start_group_handle, uint16_t end_group_handle, const uint8_t * uuid128);
+static void gatt_client_cache_record_characteristic(gatt_client_t * peripheral, uint16_t start_handle, uint16_t value_handle, uint16_t end_handle, uint16_t properties, const uint8_t * uuid128);
+static void gatt_client_cache_record_descriptor(gatt_client_t * peripheral, uint16_t descriptor_handle, const uint8_t * uuid128);
+static void gatt_client_cache_report_pending(void);
+#endif
+
 static uint16_t peripheral_mtu(gatt_client_t *peripheral){
     if (peripheral->mtu > l2cap_max_le_mtu()){
         log_error("Peripheral mtu is not initialized");
@@ -88,13 +107,16 @@ static uint16_t peripheral_mtu(gatt_client_t *peripheral){
 
 void gatt_client_init(void){
     gatt_client_connections = NULL;
+    (void)memset(gatt_client_lookup_table, 0, sizeof(gatt_client_lookup_table));
     mtu_exchange_enabled = 1;
 
-    // regsister for HCI Events
+    // regsister for HCI Events, can send now is requested via ATT Dispatch
+    hci_event_code_bitmap_set_all_except_scan_results(hci_event_codes);
+    hci_event_code_bitmap_clear(hci_event_codes, HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS);
     hci_event_callback_registration.callback = &gatt_client_event_packet_handler;
-    hci_add_event_handler(&hci_event_callback_registration);
+    hci_add_event_handler_for_event_codes(&hci_event_callback_registration, hci_event_codes);
 
-#if defined(ENABLE_GATT_CLIENT_PAIRING) || defined (ENABLE_LE_SIGNED_WRITE)
+#if defined(ENABLE_GATT_CLIENT_PAIRING) || defined (ENABLE_LE_SIGNED_WRITE) || defined (ENABLE_GATT_CLIENT_CACHE)
     // register for SM Events
     sm_event_callback_registration.callback = &gatt_client_event_packet_handler;
     sm_add_event_handler(&sm_event_callback_registration);
@@ -121,6 +143,7 @@ static void gatt_client_timeout_handler(btstack_timer_source_t * timer){
     if (peripheral == NULL) return;
     log_info("GATT client timeout handle, handle 0x%02x", peripheral->con_handle);
     gatt_client_report_error_if_pending(peripheral, ATT_ERROR_TIMEOUT);           
+    gatt_client_operation_queue_flush(peripheral, ATT_ERROR_TIMEOUT);
 }
 
 static void gatt_client_timeout_start(gatt_client_t * peripheral){
@@ -136,17 +159,50 @@ static void gatt_client_timeout_stop(gatt_client_t * peripheral){
     btstack_run_loop_remove_timer(&peripheral->gc_timeout);
 }
 
+static void gatt_client_lookup_add(gatt_client_t * peripheral){
+    // use first free slot in probe sequence, replace entry in first slot if table is full
+    unsigned int index = peripheral->con_handle % HCI_CONNECTION_LOOKUP_TABLE_SIZE;
+    unsigned int i;
+    for (i = 0; i < HCI_CONNECTION_LOOKUP_TABLE_SIZE; i++){
+        gatt_client_t ** entry = &gatt_client_lookup_table[(index + i) % HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+        if (*entry == NULL){
+            *entry = peripheral;
+            return;
+        }
+    }
+    gatt_client_lookup_table[index] = peripheral;
+}
+
 static gatt_client_t * get_gatt_client_context_for_handle(uint16_t handle){
+    // check lookup table first, probe sequence ends at free slot
+    unsigned int index = handle % HCI_CONNECTION_LOOKUP_TABLE_SIZE;
+    unsigned int i;
+    for (i = 0; i < HCI_CONNECTION_LOOKUP_TABLE_SIZE; i++){
+        gatt_client_t * entry = gatt_client_lookup_table[(index + i) % HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+        if (entry == NULL) break;
+        if (entry->con_handle == handle) return entry;
+    }
     btstack_linked_item_t *it;
     for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
         gatt_client_t * peripheral = (gatt_client_t *) it;
         if (peripheral->con_handle == handle){
+            gatt_client_lookup_add(peripheral);
             return peripheral;
         }
     }
     return NULL;
 }
 
+static void gatt_client_lookup_remove(gatt_client_t * peripheral){
+    // entry might not be in first slot of probe sequence
+    int i;
+    for (i = 0; i < HCI_CONNECTION_LOOKUP_TABLE_SIZE; i++){
+        if (gatt_client_lookup_table[i] == peripheral){
+            gatt_client_lookup_table[i] = NULL;
+        }
+    }
+}
+
 
 // @returns context
 // returns existing one, or tries to setup new one
@@ -170,25 +226,67 @@ static gatt_client_t * provide_context_for_conn_handle(hci_con_handle_t con_hand
         context->mtu_state = MTU_AUTO_EXCHANGE_DISABLED;
     }
     context->gatt_client_state = P_READY;
+#ifdef ENABLE_LE_SIGNED_WRITE
+    context->signed_write_state = P_READY;
+#endif
     btstack_linked_list_add(&gatt_client_connections, (btstack_linked_item_t*)context);
     return context;
 }
 
-static gatt_client_t * provide_context_for_conn_handle_and_start_timer(hci_con_handle_t con_handle){
-    gatt_client_t * context = provide_context_for_conn_handle(con_handle);
-    if (context == NULL) return NULL;
-    gatt_client_timeout_start(context);
-    return context;
-}
-
 static int is_ready(gatt_client_t * context){
     return context->gatt_client_state == P_READY;
 }
 
+static bool gatt_client_operation_queue_empty(gatt_client_t * context){
+#if GATT_CLIENT_OPERATION_QUEUE_SIZE > 0
+    return context->operation_queue_count == 0u;
+#else
+    UNUSED(context);
+    return true;
+#endif
+}
+
+static bool gatt_client_operation_queue_full(gatt_client_t * context){
+#if GATT_CLIENT_OPERATION_QUEUE_SIZE > 0
+    return context->operation_queue_count == GATT_CLIENT_OPERATION_QUEUE_SIZE;
+#else
+    UNUSED(context);
+    return true;
+#endif
+}
+
+static bool gatt_client_operation_queue_add(gatt_client_t * context, const gatt_client_operation_t * operation){
+    if (gatt_client_operation_queue_full(context)) return false;
+#if GATT_CLIENT_OPERATION_QUEUE_SIZE > 0
+    uint16_t index = (context->operation_queue_head + context->operation_queue_count) % GATT_CLIENT_OPERATION_QUEUE_SIZE;
+    context->operation_queue[index] = *operation;
+    context->operation_queue_count++;
+    return true;
+#else
+    UNUSED(operation);
+    return false;
+#endif
+}
+
+static bool gatt_client_operation_queue_pop(gatt_client_t * context, gatt_client_operation_t * operation){
+    if (gatt_client_operation_queue_empty(context)) return false;
+#if GATT_CLIENT_OPERATION_QUEUE_SIZE > 0
+    *operation = context->operation_queue[context->operation_queue_head];
+    context->operation_queue_head = (context->operation_queue_head + 1u) % GATT_CLIENT_OPERATION_QUEUE_SIZE;
+    context->operation_queue_count--;
+    return true;
+#else
+    UNUSED(operation);
+    return false;
+#endif
+}
+
 int gatt_client_is_ready(hci_con_handle_t con_handle){
     gatt_client_t * context = provide_context_for_conn_handle(con_handle);
     if (context == NULL) return 0;
-    return is_ready(context);
+    // new query is either started directly or queued
+    if (is_ready(context) && gatt_client_operation_queue_empty(context)) return 1;
+    return gatt_client_operation_queue_full(context) ? 0 : 1;
 }
 
 void gatt_client_mtu_enable_auto_negotiation(uint8_t enabled){
@@ -458,7 +556,7 @@ static void send_gatt_read_characteristic_descriptor_request(gatt_client_t * per
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static void send_gatt_signed_write_request(gatt_client_t * peripheral, uint32_t sign_counter){
-    att_signed_write_request(ATT_SIGNED_WRITE_COMMAND, peripheral->con_handle, peripheral->attribute_handle, peripheral->attribute_length, peripheral->attribute_value, sign_counter, peripheral->cmac);
+    att_signed_write_request(ATT_SIGNED_WRITE_COMMAND, peripheral->con_handle, peripheral->signed_write_handle, peripheral->signed_write_length, peripheral->signed_write_value, sign_counter, peripheral->cmac);
 }
 #endif
 
@@ -488,6 +586,14 @@ static void emit_event_new(btstack_packet_handler_t callback, uint8_t * packet,
     (*callback)(HCI_EVENT_PACKET, 0, packet, size);
 }
 
+static btstack_linked_list_t * gatt_client_value_listener_list(hci_con_handle_t con_handle, uint16_t attribute_handle){
+    if ((con_handle == GATT_CLIENT_ANY_CONNECTION) || (attribute_handle == GATT_CLIENT_ANY_VALUE_HANDLE)){
+        return &gatt_client_value_listeners;
+    }
+    uint32_t hash = ((uint32_t) con_handle * 31u) + attribute_handle;
+    return &gatt_client_value_listener_buckets[hash % GATT_CLIENT_VALUE_LISTENER_HASH_TABLE_SIZE];
+}
+
 void gatt_client_listen_for_characteristic_value_updates(gatt_client_notification_t * notification, btstack_packet_handler_t packet_handler, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic){
     notification->callback = packet_handler;
     notification->con_handle = con_handle;
@@ -496,16 +602,16 @@ void gatt_client_listen_for_characteristic_value_updates(gatt_client_notificatio
     } else {
         notification->attribute_handle = characteristic->value_handle;
     }
-    btstack_linked_list_add(&gatt_client_value_listeners, (btstack_linked_item_t*) notification);
+    btstack_linked_list_add(gatt_client_value_listener_list(notification->con_handle, notification->attribute_handle), (btstack_linked_item_t*) notification);
 }
 
 void gatt_client_stop_listening_for_characteristic_value_updates(gatt_client_notification_t * notification){
-    btstack_linked_list_remove(&gatt_client_value_listeners, (btstack_linked_item_t*) notification);
+    btstack_linked_list_remove(gatt_client_value_listener_list(notification->con_handle, notification->attribute_handle), (btstack_linked_item_t*) notification);
 }
 
-static void emit_event_to_registered_listeners(hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * packet, uint16_t size){
+static void emit_event_to_value_listeners(btstack_linked_list_t * listeners, hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * packet, uint16_t size){
     btstack_linked_list_iterator_t it;    
-    btstack_linked_list_iterator_init(&it, &gatt_client_value_listeners);
+    btstack_linked_list_iterator_init(&it, listeners);
     while (btstack_linked_list_iterator_has_next(&it)){
         gatt_client_notification_t * notification = (gatt_client_notification_t*) btstack_linked_list_iterator_next(&it);
         if ((notification->con_handle       != GATT_CLIENT_ANY_CONNECTION)   && (notification->con_handle       != con_handle)) continue;
@@ -514,14 +620,102 @@ static void emit_event_to_registered_listeners(hci_con_handle_t con_handle, uint
     } 
 }
 
-static void emit_gatt_complete_event(gatt_client_t * peripheral, uint8_t att_status){
+static void emit_event_to_registered_listeners(hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t * packet, uint16_t size){
+    // bucket may contain listeners for other con handle / value handle pairs
+    btstack_linked_list_t * listeners = gatt_client_value_listener_list(con_handle, attribute_handle);
+    if (listeners != &gatt_client_value_listeners){
+        emit_event_to_value_listeners(listeners, con_handle, attribute_handle, packet, size);
+    }
+    emit_event_to_value_listeners(&gatt_client_value_listeners, con_handle, attribute_handle, packet, size);
+}
+
+static void emit_gatt_complete_event_for_callback(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint8_t att_status){
     // @format H1
     uint8_t packet[5];
     packet[0] = GATT_EVENT_QUERY_COMPLETE;
     packet[1] = 3;
-    little_endian_store_16(packet, 2, peripheral->con_handle);
+    little_endian_store_16(packet, 2, con_handle);
     packet[4] = att_status;
-    emit_event_new(peripheral->callback, packet, sizeof(packet));
+    emit_event_new(callback, packet, sizeof(packet));
+}
+
+static void emit_gatt_complete_event(gatt_client_t * peripheral, uint8_t att_status){
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_query_complete(peripheral, att_status);
+#endif
+    emit_gatt_complete_event_for_callback(peripheral->callback, peripheral->con_handle, att_status);
+}
+
+static void gatt_client_operation_init(gatt_client_operation_t * operation, btstack_packet_handler_t callback, gatt_client_state_t state){
+    (void)memset(operation, 0, sizeof(gatt_client_operation_t));
+    operation->callback = callback;
+    operation->state = state;
+}
+
+static void gatt_client_operation_start(gatt_client_t * peripheral, const gatt_client_operation_t * operation){
+    peripheral->callback = operation->callback;
+    peripheral->start_group_handle = operation->start_group_handle;
+    peripheral->end_group_handle   = operation->end_group_handle;
+    peripheral->query_start_handle = operation->start_group_handle;
+    peripheral->query_end_handle   = operation->end_group_handle;
+    peripheral->uuid16 = operation->uuid16;
+    (void)memcpy(peripheral->uuid128, operation->uuid128, 16);
+    peripheral->filter_with_uuid = operation->filter_with_uuid;
+    peripheral->characteristic_start_handle = 0;
+    peripheral->attribute_handle = operation->attribute_handle;
+    peripheral->attribute_offset = operation->attribute_offset;
+    peripheral->attribute_length = operation->attribute_length;
+    peripheral->attribute_value  = operation->attribute_value;
+    peripheral->read_multiple_handle_count = operation->read_multiple_handle_count;
+    peripheral->read_multiple_handles = operation->read_multiple_handles;
+    little_endian_store_16(peripheral->client_characteristic_configuration_value, 0, operation->client_characteristic_configuration);
+
+    // characteristic without descriptors
+    if ((operation->state == P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY) && (operation->start_group_handle > operation->end_group_handle)){
+        emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
+        return;
+    }
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // answered from cache by gatt_client_run or waiting for Database Hash
+    if (gatt_client_cache_handle_query(peripheral, operation->state)) return;
+#endif
+
+    peripheral->gatt_client_state = operation->state;
+    gatt_client_timeout_start(peripheral);
+}
+
+// @returns false if no query is queued
+static bool gatt_client_operation_start_next(gatt_client_t * peripheral){
+    gatt_client_operation_t operation;
+    if (!gatt_client_operation_queue_pop(peripheral, &operation)) return false;
+    log_info("GATT client start queued query, handle 0x%02x", peripheral->con_handle);
+    gatt_client_operation_start(peripheral, &operation);
+    return true;
+}
+
+static void gatt_client_operation_queue_flush(gatt_client_t * peripheral, uint8_t att_status){
+    gatt_client_operation_t operation;
+    while (gatt_client_operation_queue_pop(peripheral, &operation)){
+        emit_gatt_complete_event_for_callback(operation.callback, peripheral->con_handle, att_status);
+    }
+}
+
+// start query if idle, otherwise queue it
+static uint8_t gatt_client_operation_submit(hci_con_handle_t con_handle, const gatt_client_operation_t * operation){
+    gatt_client_t * peripheral = provide_context_for_conn_handle(con_handle);
+    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+
+    if (is_ready(peripheral) && gatt_client_operation_queue_empty(peripheral)){
+        gatt_client_operation_start(peripheral, operation);
+        gatt_client_run();
+        return ERROR_CODE_SUCCESS;
+    }
+
+    // queued query is started by gatt_client_run after active query is complete
+    if (!gatt_client_operation_queue_add(peripheral, operation)) return GATT_CLIENT_IN_WRONG_STATE;
+    log_info("GATT client query queued, handle 0x%02x", con_handle);
+    return ERROR_CODE_SUCCESS;
 }
 
 static void emit_gatt_service_query_result_event(gatt_client_t * peripheral, uint16_t start_group_handle, uint16_t end_group_handle, uint8_t * uuid128){
@@ -534,6 +728,9 @@ static void emit_gatt_service_query_result_event(gatt_client_t * peripheral, uin
     little_endian_store_16(packet, 4, start_group_handle);
     little_endian_store_16(packet, 6, end_group_handle);
     reverse_128(uuid128, &packet[8]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_service(peripheral, start_group_handle, end_group_handle, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -565,6 +762,9 @@ static void emit_gatt_characteristic_query_result_event(gatt_client_t * peripher
     little_endian_store_16(packet, 8,  end_handle);
     little_endian_store_16(packet, 10, properties);
     reverse_128(uuid128, &packet[12]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_characteristic(peripheral, start_handle, value_handle, end_handle, properties, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -578,6 +778,9 @@ static void emit_gatt_all_characteristic_descriptors_result_event(
     ///
     little_endian_store_16(packet, 4,  descriptor_handle);
     reverse_128(uuid128, &packet[6]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_record_descriptor(peripheral, descriptor_handle, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -591,6 +794,441 @@ static void emit_gatt_mtu_exchanged_result_event(gatt_client_t * peripheral, uin
     att_dispatch_client_mtu_exchanged(peripheral->con_handle, new_mtu);
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+// Discovery results of bonded devices are stored via btstack_tlv, one tag per le_device_db index.
+// Value: Database Hash (16) followed by records: type (1), payload len (1), payload.
+// UUIDs with Bluetooth Base UUID are stored as UUID16, others as UUID128.
+// A *_COMPLETE record marks the handle range for which all results have been recorded.
+
+#define GATT_CLIENT_CACHE_HEADER_LEN 16u
+
+#define GATT_CLIENT_CACHE_TLV_TAG(le_device_index) ((((uint32_t) 'B') << 24u) | (((uint32_t) 'T') << 16u) | (((uint32_t) 'G') << 8u) | ((uint32_t) (le_device_index)))
+
+typedef enum {
+    GATT_CLIENT_CACHE_RECORD_INVALID = 0,
+    GATT_CLIENT_CACHE_RECORD_SERVICE,                   // start group handle, end group handle, uuid
+    GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC,            // start handle, value handle, end handle, properties (1), uuid
+    GATT_CLIENT_CACHE_RECORD_DESCRIPTOR,                // handle, uuid
+    GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE,         // start handle, end handle
+    GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE,  // start handle, end handle
+    GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE,      // start handle, end handle
+} gatt_client_cache_record_type_t;
+
+static uint8_t  gatt_client_cache_buffer[GATT_CLIENT_CACHE_SIZE];
+static uint16_t gatt_client_cache_len;
+
+// connection that reports from or records into buffer
+static gatt_client_t * gatt_client_cache_owner;
+static bool            gatt_client_cache_recording;
+static bool            gatt_client_cache_overflow;
+static gatt_client_cache_record_type_t gatt_client_cache_record_complete_type;
+static uint16_t        gatt_client_cache_record_start_handle;
+static uint16_t        gatt_client_cache_record_end_handle;
+static bool            gatt_client_cache_reporting;
+
+// @returns false if not bonded
+static bool gatt_client_cache_tag_for_peripheral(gatt_client_t * peripheral, uint32_t * tag){
+    int le_device_index = sm_le_device_index(peripheral->con_handle);
+    if (le_device_index < 0) return false;
+    *tag = GATT_CLIENT_CACHE_TLV_TAG(le_device_index);
+    return true;
+}
+
+static gatt_client_cache_record_type_t gatt_client_cache_complete_type_for_query(gatt_client_state_t query_state){
+    switch (query_state){
+        case P_W2_SEND_SERVICE_QUERY:
+        case P_W2_SEND_SERVICE_WITH_UUID_QUERY:
+            return GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE;
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+        case P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY:
+            return GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE;
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+            return GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE;
+        default:
+            return GATT_CLIENT_CACHE_RECORD_INVALID;
+    }
+}
+
+static gatt_client_cache_record_type_t gatt_client_cache_result_type_for_complete_type(gatt_client_cache_record_type_t complete_type){
+    switch (complete_type){
+        case GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE:
+            return GATT_CLIENT_CACHE_RECORD_SERVICE;
+        case GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE:
+            return GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC;
+        case GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE:
+            return GATT_CLIENT_CACHE_RECORD_DESCRIPTOR;
+        default:
+            return GATT_CLIENT_CACHE_RECORD_INVALID;
+    }
+}
+
+// @returns len of fixed payload part before uuid
+static uint8_t gatt_client_cache_uuid_offset_for_type(uint8_t type){
+    switch (type){
+        case GATT_CLIENT_CACHE_RECORD_SERVICE:
+            return 4;
+        case GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC:
+            return 7;
+        case GATT_CLIENT_CACHE_RECORD_DESCRIPTOR:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+static bool gatt_client_cache_record_valid(uint8_t type, uint8_t payload_len){
+    switch (type){
+        case GATT_CLIENT_CACHE_RECORD_SERVICE:
+        case GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC:
+        case GATT_CLIENT_CACHE_RECORD_DESCRIPTOR: {
+            uint8_t uuid_offset = gatt_client_cache_uuid_offset_for_type(type);
+            return (payload_len == (uuid_offset + 2u)) || (payload_len == (uuid_offset + 16u));
+        }
+        case GATT_CLIENT_CACHE_RECORD_SERVICES_COMPLETE:
+        case GATT_CLIENT_CACHE_RECORD_CHARACTERISTICS_COMPLETE:
+        case GATT_CLIENT_CACHE_RECORD_DESCRIPTORS_COMPLETE:
+            return payload_len == 4u;
+        default:
+            return false;
+    }
+}
+
+static uint8_t gatt_client_cache_store_uuid(uint8_t * buffer, const uint8_t * uuid128){
+    if (uuid_has_bluetooth_prefix(uuid128) && (big_endian_read_16(uuid128, 0) == 0u)){
+        little_endian_store_16(buffer, 0, big_endian_read_16(uuid128, 2));
+        return 2;
+    }
+    (void)memcpy(buffer, uuid128, 16);
+    return 16;
+}
+
+static void gatt_client_cache_read_uuid(const uint8_t * buffer, uint8_t uuid_len, uint8_t * uuid128){
+    if (uuid_len == 2u){
+        uuid_add_bluetooth_prefix(uuid128, little_endian_read_16(buffer, 0));
+    } else {
+        (void)memcpy(uuid128, buffer, 16);
+    }
+}
+
+static void gatt_client_cache_check_service_changed(gatt_client_t * peripheral, uint16_t value_handle, const uint8_t * uuid128){
+    if (!uuid_has_bluetooth_prefix(uuid128)) return;
+    if (big_endian_read_32(uuid128, 0) != ORG_BLUETOOTH_CHARACTERISTIC_GATT_SERVICE_CHANGED) return;
+    peripheral->cache_service_changed_handle = value_handle;
+}
+
+// load stored results into buffer, use empty cache if nothing stored for current Database Hash
+static bool gatt_client_cache_load(gatt_client_t * peripheral){
+    if (gatt_client_cache_owner != NULL) return false;
+
+    uint32_t tag;
+    if (!gatt_client_cache_tag_for_peripheral(peripheral, &tag)) return false;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return false;
+
+    int len = tlv_impl->get_tag(tlv_context, tag, gatt_client_cache_buffer, sizeof(gatt_client_cache_buffer));
+    bool valid = (len >= (int) GATT_CLIENT_CACHE_HEADER_LEN) && (len <= (int) sizeof(gatt_client_cache_buffer))
+            && (memcmp(gatt_client_cache_buffer, peripheral->cache_database_hash, 16) == 0);
+
+    // validate records, look for Service Changed characteristic
+    uint16_t offset = GATT_CLIENT_CACHE_HEADER_LEN;
+    while (valid && ((int) offset < len)){
+        if (((int) offset + 2) > len) {
+            valid = false;
+            break;
+        }
+        uint8_t type = gatt_client_cache_buffer[offset];
+        uint8_t payload_len = gatt_client_cache_buffer[offset+1u];
+        if ((((int) offset + 2 + payload_len) > len) || !gatt_client_cache_record_valid(type, payload_len)){
+            valid = false;
+            break;
+        }
+        if (type == GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC){
+            const uint8_t * payload = &gatt_client_cache_buffer[offset + 2u];
+            uint8_t uuid128[16];
+            gatt_client_cache_read_uuid(&payload[7], payload_len - 7u, uuid128);
+            gatt_client_cache_check_service_changed(peripheral, little_endian_read_16(payload, 2), uuid128);
+        }
+        offset += 2u + payload_len;
+    }
+
+    if (valid){
+        gatt_client_cache_len = (uint16_t) len;
+    } else {
+        (void)memcpy(gatt_client_cache_buffer, peripheral->cache_database_hash, 16);
+        gatt_client_cache_len = GATT_CLIENT_CACHE_HEADER_LEN;
+    }
+    return true;
+}
+
+static void gatt_client_cache_delete(uint16_t le_device_index){
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    log_info("GATT client cache: delete for le device index %u", le_device_index);
+    tlv_impl->delete_tag(tlv_context, GATT_CLIENT_CACHE_TLV_TAG(le_device_index));
+}
+
+static void gatt_client_cache_store(gatt_client_t * peripheral){
+    uint32_t tag;
+    if (!gatt_client_cache_tag_for_peripheral(peripheral, &tag)) return;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    log_info("GATT client cache: store %u bytes, handle 0x%02x", gatt_client_cache_len, peripheral->con_handle);
+    int result = tlv_impl->store_tag(tlv_context, tag, gatt_client_cache_buffer, gatt_client_cache_len);
+    if (result != 0){
+        log_error("GATT client cache: store failed");
+    }
+}
+
+// @returns true if there's a complete record that covers the query range
+static bool gatt_client_cache_range_complete(gatt_client_cache_record_type_t complete_type, uint16_t start_handle, uint16_t end_handle){
+    uint16_t offset;
+    for (offset = GATT_CLIENT_CACHE_HEADER_LEN; offset < gatt_client_cache_len; offset += 2u + gatt_client_cache_buffer[offset + 1u]){
+        if (gatt_client_cache_buffer[offset] != complete_type) continue;
+        const uint8_t * payload = &gatt_client_cache_buffer[offset + 2u];
+        if ((little_endian_read_16(payload, 0) <= start_handle) && (end_handle <= little_endian_read_16(payload, 2))) return true;
+    }
+    return false;
+}
+
+// drop results and complete records that start within the handle range
+static void gatt_client_cache_remove_range(gatt_client_cache_record_type_t complete_type, uint16_t start_handle, uint16_t end_handle){
+    gatt_client_cache_record_type_t result_type = gatt_client_cache_result_type_for_complete_type(complete_type);
+    uint16_t read_offset  = GATT_CLIENT_CACHE_HEADER_LEN;
+    uint16_t write_offset = GATT_CLIENT_CACHE_HEADER_LEN;
+    while (read_offset < gatt_client_cache_len){
+        uint8_t  type = gatt_client_cache_buffer[read_offset];
+        uint16_t record_len = 2u + gatt_client_cache_buffer[read_offset + 1u];
+        uint16_t handle = little_endian_read_16(gatt_client_cache_buffer, read_offset + 2u);
+        bool remove = ((type == result_type) || (type == complete_type)) && (handle >= start_handle) && (handle <= end_handle);
+        if (!remove){
+            (void)memmove(&gatt_client_cache_buffer[write_offset], &gatt_client_cache_buffer[read_offset], record_len);
+            write_offset += record_len;
+        }
+        read_offset += record_len;
+    }
+    gatt_client_cache_len = write_offset;
+}
+
+static void gatt_client_cache_append(gatt_client_t * peripheral, gatt_client_cache_record_type_t type, const uint8_t * payload, uint8_t payload_len){
+    if (gatt_client_cache_owner != peripheral) return;
+    if (!gatt_client_cache_recording) return;
+    if ((gatt_client_cache_len + 2u + payload_len) > sizeof(gatt_client_cache_buffer)){
+        gatt_client_cache_overflow = true;
+        return;
+    }
+    gatt_client_cache_buffer[gatt_client_cache_len]      = (uint8_t) type;
+    gatt_client_cache_buffer[gatt_client_cache_len + 1u] = payload_len;
+    (void)memcpy(&gatt_client_cache_buffer[gatt_client_cache_len + 2u], payload, payload_len);
+    gatt_client_cache_len += 2u + payload_len;
+}
+
+static void gatt_client_cache_record_service(gatt_client_t * peripheral, uint16_t start_group_handle, uint16_t end_group_handle, const uint8_t * uuid128){
+    uint8_t payload[20];
+    little_endian_store_16(payload, 0, start_group_handle);
+    little_endian_store_16(payload, 2, end_group_handle);
+    uint8_t uuid_len = gatt_client_cache_store_uuid(&payload[4], uuid128);
+    gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_SERVICE, payload, 4u + uuid_len);
+}
+
+static void gatt_client_cache_record_characteristic(gatt_client_t * peripheral, uint16_t start_handle, uint16_t value_handle, uint16_t end_handle, uint16_t properties, const uint8_t * uuid128){
+    gatt_client_cache_check_service_changed(peripheral, value_handle, uuid128);
+    uint8_t payload[23];
+    little_endian_store_16(payload, 0, start_handle);
+    little_endian_store_16(payload, 2, value_handle);
+    little_endian_store_16(payload, 4, end_handle);
+    payload[6] = (uint8_t) properties;
+    uint8_t uuid_len = gatt_client_cache_store_uuid(&payload[7], uuid128);
+    gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC, payload, 7u + uuid_len);
+}
+
+static void gatt_client_cache_record_descriptor(gatt_client_t * peripheral, uint16_t descriptor_handle, const uint8_t * uuid128){
+    uint8_t payload[18];
+    little_endian_store_16(payload, 0, descriptor_handle);
+    uint8_t uuid_len = gatt_client_cache_store_uuid(&payload[2], uuid128);
+    gatt_client_cache_append(peripheral, GATT_CLIENT_CACHE_RECORD_DESCRIPTOR, payload, 2u + uuid_len);
+}
+
+static void gatt_client_cache_record_start(gatt_client_t * peripheral, gatt_client_state_t query_state){
+    // only unfiltered queries provide complete results
+    switch (query_state){
+        case P_W2_SEND_SERVICE_QUERY:
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+            break;
+        default:
+            return;
+    }
+    gatt_client_cache_record_complete_type = gatt_client_cache_complete_type_for_query(query_state);
+    gatt_client_cache_record_start_handle  = peripheral->query_start_handle;
+    gatt_client_cache_record_end_handle    = peripheral->query_end_handle;
+    gatt_client_cache_remove_range(gatt_client_cache_record_complete_type, gatt_client_cache_record_start_handle, gatt_client_cache_record_end_handle);
+    gatt_client_cache_owner     = peripheral;
+    gatt_client_cache_recording = true;
+    gatt_client_cache_overflow  = false;
+}
+
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t att_status){
+    if (gatt_client_cache_owner != peripheral) return;
+    if (!gatt_client_cache_recording){
+        // reported from cache or aborted before results were reported
+        gatt_client_cache_owner = NULL;
+        return;
+    }
+
+    // mark recorded range as complete
+    uint8_t payload[4];
+    little_endian_store_16(payload, 0, gatt_client_cache_record_start_handle);
+    little_endian_store_16(payload, 2, gatt_client_cache_record_end_handle);
+    gatt_client_cache_append(peripheral, gatt_client_cache_record_complete_type, payload, sizeof(payload));
+
+    gatt_client_cache_owner = NULL;
+    gatt_client_cache_recording = false;
+
+    if (att_status != ATT_ERROR_SUCCESS) return;
+    // Service Changed received during query
+    if (peripheral->cache_state != GATT_CLIENT_CACHE_ACTIVE) return;
+    if (gatt_client_cache_overflow){
+        log_info("GATT client cache: results exceed GATT_CLIENT_CACHE_SIZE, not stored");
+        return;
+    }
+    gatt_client_cache_store(peripheral);
+}
+
+static void gatt_client_cache_report(gatt_client_t * peripheral){
+    gatt_client_state_t query_state = peripheral->cache_query_state;
+    gatt_client_cache_record_type_t result_type = gatt_client_cache_result_type_for_complete_type(gatt_client_cache_complete_type_for_query(query_state));
+
+    log_info("GATT client cache: report results from cache, handle 0x%02x", peripheral->con_handle);
+
+    uint16_t offset;
+    for (offset = GATT_CLIENT_CACHE_HEADER_LEN; offset < gatt_client_cache_len; offset += 2u + gatt_client_cache_buffer[offset + 1u]){
+        if (gatt_client_cache_buffer[offset] != result_type) continue;
+        const uint8_t * payload = &gatt_client_cache_buffer[offset + 2u];
+        uint8_t uuid_offset = gatt_client_cache_uuid_offset_for_type(result_type);
+        uint8_t uuid128[16];
+        gatt_client_cache_read_uuid(&payload[uuid_offset], gatt_client_cache_buffer[offset + 1u] - uuid_offset, uuid128);
+        uint16_t handle = little_endian_read_16(payload, 0);
+        if ((handle < peripheral->query_start_handle) || (handle > peripheral->query_end_handle)) continue;
+        switch (result_type){
+            case GATT_CLIENT_CACHE_RECORD_SERVICE:
+                if ((query_state == P_W2_SEND_SERVICE_WITH_UUID_QUERY) && (memcmp(peripheral->uuid128, uuid128, 16) != 0)) break;
+                emit_gatt_service_query_result_event(peripheral, handle, little_endian_read_16(payload, 2), uuid128);
+                break;
+            case GATT_CLIENT_CACHE_RECORD_CHARACTERISTIC:
+                if (peripheral->filter_with_uuid && (memcmp(peripheral->uuid128, uuid128, 16) != 0)) break;
+                emit_gatt_characteristic_query_result_event(peripheral, handle, little_endian_read_16(payload, 2),
+                    btstack_min(little_endian_read_16(payload, 4), peripheral->query_end_handle), payload[6], uuid128);
+                break;
+            case GATT_CLIENT_CACHE_RECORD_DESCRIPTOR:
+                emit_gatt_all_characteristic_descriptors_result_event(peripheral, handle, uuid128);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // releases buffer
+    gatt_client_handle_transaction_complete(peripheral);
+    emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
+}
+
+// called from gatt_client_run. Queries answered from cache that are started by the application
+// while results are reported are handled by this loop instead of a nested call
+static void gatt_client_cache_report_pending(void){
+    if (gatt_client_cache_reporting) return;
+    gatt_client_cache_reporting = true;
+    bool reported = true;
+    while (reported){
+        reported = false;
+        btstack_linked_item_t * it;
+        for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
+            gatt_client_t * peripheral = (gatt_client_t *) it;
+            if (peripheral->gatt_client_state != P_W4_CACHED_QUERY_RESULT) continue;
+            gatt_client_cache_report(peripheral);
+            // note: list might have changed
+            reported = true;
+            break;
+        }
+    }
+    gatt_client_cache_reporting = false;
+}
+
+// @returns true if query is answered from cache or Database Hash needs to be read first
+static bool gatt_client_cache_handle_query(gatt_client_t * peripheral, gatt_client_state_t query_state){
+    if (gatt_client_cache_complete_type_for_query(query_state) == GATT_CLIENT_CACHE_RECORD_INVALID) return false;
+
+    switch (peripheral->cache_state){
+        case GATT_CLIENT_CACHE_UNKNOWN: {
+            uint32_t tag;
+            if (!gatt_client_cache_tag_for_peripheral(peripheral, &tag)) return false;
+            const btstack_tlv_t * tlv_impl = NULL;
+            void * tlv_context;
+            btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+            if (!tlv_impl) return false;
+            log_info("GATT client cache: read Database Hash, handle 0x%02x", peripheral->con_handle);
+            peripheral->cache_query_state = query_state;
+            peripheral->gatt_client_state = P_W2_SEND_READ_DATABASE_HASH;
+            gatt_client_timeout_start(peripheral);
+            return true;
+        }
+        case GATT_CLIENT_CACHE_ACTIVE:
+            break;
+        default:
+            return false;
+    }
+
+    if (!gatt_client_cache_load(peripheral)) return false;
+    gatt_client_cache_record_type_t complete_type = gatt_client_cache_complete_type_for_query(query_state);
+    if (gatt_client_cache_range_complete(complete_type, peripheral->query_start_handle, peripheral->query_end_handle)){
+        // results are reported by gatt_client_run, keep buffer until then
+        gatt_client_cache_owner = peripheral;
+        peripheral->cache_query_state = query_state;
+        peripheral->gatt_client_state = P_W4_CACHED_QUERY_RESULT;
+        return true;
+    }
+    gatt_client_cache_record_start(peripheral, query_state);
+    return false;
+}
+
+// continue with query after Database Hash was read
+static void gatt_client_cache_resume_query(gatt_client_t * peripheral){
+    if (gatt_client_cache_handle_query(peripheral, peripheral->cache_query_state)) return;
+    peripheral->gatt_client_state = peripheral->cache_query_state;
+}
+
+static void gatt_client_cache_handle_database_hash(gatt_client_t * peripheral, const uint8_t * packet, uint16_t size){
+    // single handle-value pair: handle (2), hash (16)
+    if ((size >= 20u) && (packet[1] == 18u)){
+        (void)memcpy(peripheral->cache_database_hash, &packet[4], 16);
+        peripheral->cache_state = GATT_CLIENT_CACHE_ACTIVE;
+    } else {
+        peripheral->cache_state = GATT_CLIENT_CACHE_DISABLED;
+    }
+    gatt_client_cache_resume_query(peripheral);
+}
+
+static void gatt_client_cache_handle_indication(gatt_client_t * peripheral, uint16_t value_handle){
+    if (peripheral->cache_service_changed_handle == 0u) return;
+    if (peripheral->cache_service_changed_handle != value_handle) return;
+    log_info("GATT client cache: Service Changed, read Database Hash again");
+    peripheral->cache_state = GATT_CLIENT_CACHE_UNKNOWN;
+}
+#endif
+
 ///
 static void report_gatt_services(gatt_client_t * peripheral, uint8_t * packet,  uint16_t size){
     uint8_t attr_length = packet[1];
@@ -851,6 +1489,65 @@ static int is_value_valid(gatt_client_t *peripheral, uint8_t *packet, uint16_t s
     return memcmp(&peripheral->attribute_value[peripheral->attribute_offset], &packet[5], size-5u) == 0u;
 }
 
+static bool gatt_client_value_exceeds_mtu(gatt_client_t * peripheral){
+    switch (peripheral->gatt_client_state){
+        case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
+        case P_W2_SEND_WRITE_CHARACTERISTIC_DESCRIPTOR:
+            return peripheral->attribute_length > (peripheral_mtu(peripheral) - 3u);
+        default:
+            return false;
+    }
+}
+
+#ifdef ENABLE_LE_SIGNED_WRITE
+// returns 1 if packet was sent
+static int gatt_client_run_signed_write(gatt_client_t * peripheral){
+    switch (peripheral->signed_write_state){
+        case P_W4_IDENTITY_RESOLVING:
+            log_info("P_W4_IDENTITY_RESOLVING - state %x", sm_identity_resolving_state(peripheral->con_handle));
+            switch (sm_identity_resolving_state(peripheral->con_handle)){
+                case IRK_LOOKUP_SUCCEEDED:
+                    peripheral->le_device_index = sm_le_device_index(peripheral->con_handle);
+                    peripheral->signed_write_state = P_W4_CMAC_READY;
+                    break;
+                case IRK_LOOKUP_FAILED:
+                    peripheral->signed_write_state = P_READY;
+                    emit_gatt_complete_event_for_callback(peripheral->signed_write_callback, peripheral->con_handle, ATT_ERROR_BONDING_INFORMATION_MISSING);
+                    return 0;
+                default:
+                    return 0;
+            }
+
+            /* Fall through */
+
+        case P_W4_CMAC_READY:
+            if (sm_cmac_ready()){
+                sm_key_t csrk;
+                le_device_db_local_csrk_get(peripheral->le_device_index, csrk);
+                uint32_t sign_counter = le_device_db_local_counter_get(peripheral->le_device_index); 
+                peripheral->signed_write_state = P_W4_CMAC_RESULT;
+                sm_cmac_signed_write_start(csrk, ATT_SIGNED_WRITE_COMMAND, peripheral->signed_write_handle, peripheral->signed_write_length, peripheral->signed_write_value, sign_counter, att_signed_write_handle_cmac_result);
+            }
+            return 0;
+
+        case P_W2_SEND_SIGNED_WRITE: {
+            peripheral->signed_write_state = P_READY;
+            // bump local signing counter
+            uint32_t sign_counter = le_device_db_local_counter_get(peripheral->le_device_index);
+            le_device_db_local_counter_set(peripheral->le_device_index, sign_counter + 1);
+            // send signed write command
+            send_gatt_signed_write_request(peripheral, sign_counter);
+            // finally, notifiy client that write is complete
+            emit_gatt_complete_event_for_callback(peripheral->signed_write_callback, peripheral->con_handle, ATT_ERROR_SUCCESS);
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+}
+#endif
+
 // returns 1 if packet was sent
 static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
     // log_info("- handle_peripheral_list, mtu state %u, client state %u", peripheral->mtu_state, peripheral->gatt_client_state);
@@ -880,17 +1577,22 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
         return 1;
     }
 
-    // check MTU for writes
-    switch (peripheral->gatt_client_state){
-        case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
-        case P_W2_SEND_WRITE_CHARACTERISTIC_DESCRIPTOR:
-            if (peripheral->attribute_length <= (peripheral_mtu(peripheral) - 3u)) break;
-            log_error("gatt_client_run: value len %u > MTU %u - 3\n", peripheral->attribute_length, peripheral_mtu(peripheral));
-            gatt_client_handle_transaction_complete(peripheral);
-            emit_gatt_complete_event(peripheral, ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH);
-            return 0;
-        default:
-            break;
+#ifdef ENABLE_LE_SIGNED_WRITE
+    // signed write command does not wait for active query
+    if (gatt_client_run_signed_write(peripheral)) return 1;
+#endif
+
+    // start queued query if idle and check MTU for writes
+    while (true){
+        if (is_ready(peripheral)){
+            if (!gatt_client_operation_start_next(peripheral)) break;
+            // query might have completed without request
+            continue;
+        }
+        if (!gatt_client_value_exceeds_mtu(peripheral)) break;
+        log_error("gatt_client_run: value len %u > MTU %u - 3\n", peripheral->attribute_length, peripheral_mtu(peripheral));
+        gatt_client_handle_transaction_complete(peripheral);
+        emit_gatt_complete_event(peripheral, ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH);
     }
 
     // log_info("gatt_client_state %u", peripheral->gatt_client_state);
@@ -1018,6 +1720,17 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             send_gatt_write_client_characteristic_configuration_request(peripheral);
             return 1;
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        case P_W2_SEND_READ_DATABASE_HASH:
+            peripheral->gatt_client_state = P_W4_READ_DATABASE_HASH_RESULT;
+            att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, ORG_BLUETOOTH_CHARACTERISTIC_DATABASE_HASH, peripheral->con_handle, 0x0001, 0xffff);
+            return 1;
+
+        case P_W4_CACHED_QUERY_RESULT:
+            gatt_client_cache_report_pending();
+            return 0;
+#endif
+
         case P_W2_PREPARE_WRITE_CHARACTERISTIC_DESCRIPTOR:
             peripheral->gatt_client_state = P_W4_PREPARE_WRITE_CHARACTERISTIC_DESCRIPTOR_RESULT;
             send_gatt_prepare_write_request(peripheral);
@@ -1028,47 +1741,6 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             send_gatt_execute_write_request(peripheral);
             return 1;
 
-#ifdef ENABLE_LE_SIGNED_WRITE
-        case P_W4_IDENTITY_RESOLVING:
-            log_info("P_W4_IDENTITY_RESOLVING - state %x", sm_identity_resolving_state(peripheral->con_handle));
-            switch (sm_identity_resolving_state(peripheral->con_handle)){
-                case IRK_LOOKUP_SUCCEEDED:
-                    peripheral->le_device_index = sm_le_device_index(peripheral->con_handle);
-                    peripheral->gatt_client_state = P_W4_CMAC_READY;
-                    break;
-                case IRK_LOOKUP_FAILED:
-                    gatt_client_handle_transaction_complete(peripheral);
-                    emit_gatt_complete_event(peripheral, ATT_ERROR_BONDING_INFORMATION_MISSING);
-                    return 0;
-                default:
-                    return 0;
-            }
-
-            /* Fall through */
-
-        case P_W4_CMAC_READY:
-            if (sm_cmac_ready()){
-                sm_key_t csrk;
-                le_device_db_local_csrk_get(peripheral->le_device_index, csrk);
-                uint32_t sign_counter = le_device_db_local_counter_get(peripheral->le_device_index); 
-                peripheral->gatt_client_state = P_W4_CMAC_RESULT;
-                sm_cmac_signed_write_start(csrk, ATT_SIGNED_WRITE_COMMAND, peripheral->attribute_handle, peripheral->attribute_length, peripheral->attribute_value, sign_counter, att_signed_write_handle_cmac_result);
-            }
-            return 0;
-
-        case P_W2_SEND_SIGNED_WRITE: {
-            peripheral->gatt_client_state = P_W4_SEND_SINGED_WRITE_DONE;
-            // bump local signing counter
-            uint32_t sign_counter = le_device_db_local_counter_get(peripheral->le_device_index);
-            le_device_db_local_counter_set(peripheral->le_device_index, sign_counter + 1);
-            // send signed write command
-            send_gatt_signed_write_request(peripheral, sign_counter);
-            // finally, notifiy client that write is complete
-            gatt_client_handle_transaction_complete(peripheral);
-            emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
-            return 1;
-        }
-#endif
         default:
             break;
     }
@@ -1131,8 +1803,16 @@ static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t chann
             if (peripheral == NULL) break;
             
             gatt_client_report_error_if_pending(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+            gatt_client_operation_queue_flush(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+#ifdef ENABLE_LE_SIGNED_WRITE
+            if (peripheral->signed_write_state != P_READY){
+                peripheral->signed_write_state = P_READY;
+                emit_gatt_complete_event_for_callback(peripheral->signed_write_callback, con_handle, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+            }
+#endif
             gatt_client_timeout_stop(peripheral);
             btstack_linked_list_remove(&gatt_client_connections, (btstack_linked_item_t *) peripheral);
+            gatt_client_lookup_remove(peripheral);
             btstack_memory_gatt_client_free(peripheral);
             break;
 
@@ -1161,6 +1841,15 @@ static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t chann
         case SM_EVENT_IDENTITY_RESOLVING_FAILED:
             break;
 #endif
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        // cached results belong to previous bonding of this LE Device DB entry
+        case SM_EVENT_IDENTITY_CREATED:
+            gatt_client_cache_delete(sm_event_identity_created_get_index(packet));
+            break;
+        case SM_EVENT_BONDING_DELETED:
+            gatt_client_cache_delete(sm_event_bonding_deleted_get_index(packet));
+            break;
+#endif
 
         default:
             break;
@@ -1234,6 +1923,9 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
         case ATT_HANDLE_VALUE_INDICATION:
             if (size < 3u) break;
             report_gatt_indication(handle, little_endian_read_16(packet,1u), &packet[3], size-3u);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            gatt_client_cache_handle_indication(peripheral, little_endian_read_16(packet,1u));
+#endif
             peripheral->send_confirmation = 1;
             break;
             
@@ -1299,6 +1991,11 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     trigger_next_read_by_type_query(peripheral, last_result_handle);
                     break;
                 }
+#ifdef ENABLE_GATT_CLIENT_CACHE
+                case P_W4_READ_DATABASE_HASH_RESULT:
+                    gatt_client_cache_handle_database_hash(peripheral, packet, size);
+                    break;
+#endif
                 default:
                     break;
             }
@@ -1505,6 +2202,14 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
 
         case ATT_ERROR_RESPONSE:
             if (size < 5u) return;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            // Database Hash not supported, continue query without cache
+            if (peripheral->gatt_client_state == P_W4_READ_DATABASE_HASH_RESULT){
+                peripheral->cache_state = GATT_CLIENT_CACHE_DISABLED;
+                gatt_client_cache_resume_query(peripheral);
+                break;
+            }
+#endif
             switch (packet[4]){
                 case ATT_ERROR_ATTRIBUTE_NOT_FOUND: {
                     switch(peripheral->gatt_client_state){
@@ -1604,11 +2309,6 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                         case P_W4_EXECUTE_PREPARED_WRITE_CHARACTERISTIC_DESCRIPTOR_RESULT:
                             peripheral->gatt_client_state = P_W2_EXECUTE_PREPARED_WRITE_CHARACTERISTIC_DESCRIPTOR;
                             break;
-#ifdef ENABLE_LE_SIGNED_WRITE
-                        case P_W4_SEND_SINGED_WRITE_DONE:
-                            peripheral->gatt_client_state = P_W2_SEND_SIGNED_WRITE;
-                            break;
-#endif
                         default:
                             log_info("retry not supported for state %x", peripheral->gatt_client_state);
                             retry = 0;
@@ -1651,11 +2351,11 @@ static void att_signed_write_handle_cmac_result(uint8_t hash[8]){
     btstack_linked_list_iterator_init(&it, &gatt_client_connections);
     while (btstack_linked_list_iterator_has_next(&it)){
         gatt_client_t * peripheral = (gatt_client_t *) btstack_linked_list_iterator_next(&it);
-        if (peripheral->gatt_client_state == P_W4_CMAC_RESULT){
+        if (peripheral->signed_write_state == P_W4_CMAC_RESULT){
             // store result
             (void)memcpy(peripheral->cmac, hash, 8);
             // reverse_64(hash, peripheral->cmac);
-            peripheral->gatt_client_state = P_W2_SEND_SIGNED_WRITE;
+            peripheral->signed_write_state = P_W2_SEND_SIGNED_WRITE;
             gatt_client_run();
             return;
         }
@@ -1665,123 +2365,84 @@ static void att_signed_write_handle_cmac_result(uint8_t hash[8]){
 uint8_t gatt_client_signed_write_without_response(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t handle, uint16_t message_len, uint8_t * message){
     gatt_client_t * peripheral = provide_context_for_conn_handle(con_handle);
     if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
+    if (peripheral->signed_write_state != P_READY) return GATT_CLIENT_IN_WRONG_STATE;
 
-    peripheral->callback = callback;
-    peripheral->attribute_handle = handle;
-    peripheral->attribute_length = message_len;
-    peripheral->attribute_value = message;
-    peripheral->gatt_client_state = P_W4_IDENTITY_RESOLVING;
+    peripheral->signed_write_callback = callback;
+    peripheral->signed_write_handle = handle;
+    peripheral->signed_write_length = message_len;
+    peripheral->signed_write_value = message;
+    peripheral->signed_write_state = P_W4_IDENTITY_RESOLVING;
     gatt_client_run();
     return ERROR_CODE_SUCCESS; 
 }
 #endif
 
 uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-
-    peripheral->callback = callback;
-    peripheral->start_group_handle = 0x0001;
-    peripheral->end_group_handle   = 0xffff;
-    peripheral->gatt_client_state = P_W2_SEND_SERVICE_QUERY;
-    peripheral->uuid16 = 0;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_SERVICE_QUERY);
+    operation.start_group_handle = 0x0001;
+    operation.end_group_handle   = 0xffff;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 
 uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t uuid16){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-
-    peripheral->callback = callback;
-    peripheral->start_group_handle = 0x0001;
-    peripheral->end_group_handle   = 0xffff;
-    peripheral->gatt_client_state = P_W2_SEND_SERVICE_WITH_UUID_QUERY;
-    peripheral->uuid16 = uuid16;
-    uuid_add_bluetooth_prefix((uint8_t*) &(peripheral->uuid128), peripheral->uuid16);
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_SERVICE_WITH_UUID_QUERY);
+    operation.start_group_handle = 0x0001;
+    operation.end_group_handle   = 0xffff;
+    operation.uuid16 = uuid16;
+    uuid_add_bluetooth_prefix(operation.uuid128, uuid16);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, const uint8_t * uuid128){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-
-    peripheral->callback = callback;
-    peripheral->start_group_handle = 0x0001;
-    peripheral->end_group_handle   = 0xffff;
-    peripheral->uuid16 = 0;
-    (void)memcpy(peripheral->uuid128, uuid128, 16);
-    peripheral->gatt_client_state = P_W2_SEND_SERVICE_WITH_UUID_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_SERVICE_WITH_UUID_QUERY);
+    operation.start_group_handle = 0x0001;
+    operation.end_group_handle   = 0xffff;
+    operation.uuid16 = 0;
+    (void)memcpy(operation.uuid128, uuid128, 16);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t *service){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-
-    peripheral->callback = callback;
-    peripheral->start_group_handle = service->start_group_handle;
-    peripheral->end_group_handle   = service->end_group_handle;
-    peripheral->filter_with_uuid = 0;
-    peripheral->characteristic_start_handle = 0;
-    peripheral->gatt_client_state = P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY);
+    operation.start_group_handle = service->start_group_handle;
+    operation.end_group_handle   = service->end_group_handle;
+    operation.filter_with_uuid = 0;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t *service){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    peripheral->callback = callback;
-    peripheral->start_group_handle = service->start_group_handle;
-    peripheral->end_group_handle   = service->end_group_handle;
-    peripheral->gatt_client_state = P_W2_SEND_INCLUDED_SERVICE_QUERY;
-    
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_INCLUDED_SERVICE_QUERY);
+    operation.start_group_handle = service->start_group_handle;
+    operation.end_group_handle   = service->end_group_handle;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->start_group_handle = start_handle;
-    peripheral->end_group_handle   = end_handle;
-    peripheral->filter_with_uuid = 1;
-    peripheral->uuid16 = uuid16;
-    uuid_add_bluetooth_prefix((uint8_t*) &(peripheral->uuid128), uuid16);
-    peripheral->characteristic_start_handle = 0;
-    peripheral->gatt_client_state = P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY);
+    operation.start_group_handle = start_handle;
+    operation.end_group_handle   = end_handle;
+    operation.filter_with_uuid = 1;
+    operation.uuid16 = uuid16;
+    uuid_add_bluetooth_prefix(operation.uuid128, uuid16);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint8_t * uuid128){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->start_group_handle = start_handle;
-    peripheral->end_group_handle   = end_handle;
-    peripheral->filter_with_uuid = 1;
-    peripheral->uuid16 = 0;
-    (void)memcpy(peripheral->uuid128, uuid128, 16);
-    peripheral->characteristic_start_handle = 0;
-    peripheral->gatt_client_state = P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY);
+    operation.start_group_handle = start_handle;
+    operation.end_group_handle   = end_handle;
+    operation.filter_with_uuid = 1;
+    operation.uuid16 = 0;
+    (void)memcpy(operation.uuid128, uuid128, 16);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 
@@ -1794,67 +2455,45 @@ uint8_t gatt_client_discover_characteristics_for_service_by_uuid128(btstack_pack
 }
 
 uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t *characteristic){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    if (characteristic->value_handle == characteristic->end_handle){
-        emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
-        return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY);
+    if (characteristic->value_handle >= characteristic->end_handle){
+        // no descriptors: empty range, query completes when started
+        operation.start_group_handle = 1;
+        operation.end_group_handle   = 0;
+    } else {
+        operation.start_group_handle = characteristic->value_handle + 1u;
+        operation.end_group_handle   = characteristic->end_handle;
     }
-    peripheral->callback = callback;
-    peripheral->start_group_handle = characteristic->value_handle + 1u;
-    peripheral->end_group_handle   = characteristic->end_handle;
-    peripheral->gatt_client_state = P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_value_of_characteristic_using_value_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = value_handle;
-    peripheral->attribute_offset = 0;
-    peripheral->gatt_client_state = P_W2_SEND_READ_CHARACTERISTIC_VALUE_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_CHARACTERISTIC_VALUE_QUERY);
+    operation.attribute_handle = value_handle;
+    operation.attribute_offset = 0;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->start_group_handle = start_handle;
-    peripheral->end_group_handle = end_handle;
-    peripheral->query_start_handle = start_handle;
-    peripheral->query_end_handle = end_handle;
-    peripheral->uuid16 = uuid16;
-    uuid_add_bluetooth_prefix((uint8_t*) &(peripheral->uuid128), uuid16);
-    peripheral->gatt_client_state = P_W2_SEND_READ_BY_TYPE_REQUEST;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_BY_TYPE_REQUEST);
+    operation.start_group_handle = start_handle;
+    operation.end_group_handle = end_handle;
+    operation.uuid16 = uuid16;
+    uuid_add_bluetooth_prefix(operation.uuid128, uuid16);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_value_of_characteristics_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint8_t * uuid128){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->start_group_handle = start_handle;
-    peripheral->end_group_handle = end_handle;
-    peripheral->query_start_handle = start_handle;
-    peripheral->query_end_handle = end_handle;
-    peripheral->uuid16 = 0;
-    (void)memcpy(peripheral->uuid128, uuid128, 16);
-    peripheral->gatt_client_state = P_W2_SEND_READ_BY_TYPE_REQUEST;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_BY_TYPE_REQUEST);
+    operation.start_group_handle = start_handle;
+    operation.end_group_handle = end_handle;
+    operation.uuid16 = 0;
+    (void)memcpy(operation.uuid128, uuid128, 16);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 
@@ -1863,16 +2502,11 @@ uint8_t gatt_client_read_value_of_characteristic(btstack_packet_handler_t callba
 }
 
 uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle, uint16_t offset){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = characteristic_value_handle;
-    peripheral->attribute_offset = offset;
-    peripheral->gatt_client_state = P_W2_SEND_READ_BLOB_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_BLOB_QUERY);
+    operation.attribute_handle = characteristic_value_handle;
+    operation.attribute_offset = offset;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle){
@@ -1884,16 +2518,11 @@ uint8_t gatt_client_read_long_value_of_characteristic(btstack_packet_handler_t c
 }
 
 uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t callback, hci_con_handle_t con_handle, int num_value_handles, uint16_t * value_handles){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->read_multiple_handle_count = num_value_handles;
-    peripheral->read_multiple_handles = value_handles;
-    peripheral->gatt_client_state = P_W2_SEND_READ_MULTIPLE_REQUEST;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_MULTIPLE_REQUEST);
+    operation.read_multiple_handle_count = num_value_handles;
+    operation.read_multiple_handles = value_handles;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
@@ -1907,32 +2536,22 @@ uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handl
 }
 
 uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * data){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = value_handle;
-    peripheral->attribute_length = value_length;
-    peripheral->attribute_value = data;
-    peripheral->gatt_client_state = P_W2_SEND_WRITE_CHARACTERISTIC_VALUE;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_WRITE_CHARACTERISTIC_VALUE);
+    operation.attribute_handle = value_handle;
+    operation.attribute_length = value_length;
+    operation.attribute_value = data;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_write_long_value_of_characteristic_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t offset, uint16_t value_length, uint8_t  * data){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = value_handle;
-    peripheral->attribute_length = value_length;
-    peripheral->attribute_offset = offset;
-    peripheral->attribute_value = data;
-    peripheral->gatt_client_state = P_W2_PREPARE_WRITE;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_PREPARE_WRITE);
+    operation.attribute_handle = value_handle;
+    operation.attribute_length = value_length;
+    operation.attribute_offset = offset;
+    operation.attribute_value = data;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_write_long_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
@@ -1940,25 +2559,16 @@ uint8_t gatt_client_write_long_value_of_characteristic(btstack_packet_handler_t
 }
 
 uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * value){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = value_handle;
-    peripheral->attribute_length = value_length;
-    peripheral->attribute_offset = 0;
-    peripheral->attribute_value = value;
-    peripheral->gatt_client_state = P_W2_PREPARE_RELIABLE_WRITE;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_PREPARE_RELIABLE_WRITE);
+    operation.attribute_handle = value_handle;
+    operation.attribute_length = value_length;
+    operation.attribute_offset = 0;
+    operation.attribute_value = value;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t * characteristic, uint16_t configuration){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
     if ( (configuration & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) &&
         ((characteristic->properties & ATT_PROPERTY_NOTIFY) == 0u)) {
         log_info("gatt_client_write_client_characteristic_configuration: GATT_CLIENT_CHARACTERISTIC_NOTIFICATION_NOT_SUPPORTED");
@@ -1969,31 +2579,23 @@ uint8_t gatt_client_write_client_characteristic_configuration(btstack_packet_han
         return GATT_CLIENT_CHARACTERISTIC_INDICATION_NOT_SUPPORTED;
     }
     
-    peripheral->callback = callback;
-    peripheral->start_group_handle = characteristic->value_handle;
-    peripheral->end_group_handle = characteristic->end_handle;
-    little_endian_store_16(peripheral->client_characteristic_configuration_value, 0, configuration);
-    
+    gatt_client_operation_t operation;
 #ifdef ENABLE_GATT_FIND_INFORMATION_FOR_CCC_DISCOVERY
-    peripheral->gatt_client_state = P_W2_SEND_FIND_CLIENT_CHARACTERISTIC_CONFIGURATION_QUERY;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_FIND_CLIENT_CHARACTERISTIC_CONFIGURATION_QUERY);
 #else
-    peripheral->gatt_client_state = P_W2_SEND_READ_CLIENT_CHARACTERISTIC_CONFIGURATION_QUERY;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_CLIENT_CHARACTERISTIC_CONFIGURATION_QUERY);
 #endif
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    operation.start_group_handle = characteristic->value_handle;
+    operation.end_group_handle = characteristic->end_handle;
+    operation.client_characteristic_configuration = configuration;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = descriptor_handle;
-    
-    peripheral->gatt_client_state = P_W2_SEND_READ_CHARACTERISTIC_DESCRIPTOR_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_CHARACTERISTIC_DESCRIPTOR_QUERY);
+    operation.attribute_handle = descriptor_handle;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_characteristic_descriptor(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_descriptor_t * descriptor){
@@ -2001,16 +2603,11 @@ uint8_t gatt_client_read_characteristic_descriptor(btstack_packet_handler_t call
 }
 
 uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t offset){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = descriptor_handle;
-    peripheral->attribute_offset = offset;
-    peripheral->gatt_client_state = P_W2_SEND_READ_BLOB_CHARACTERISTIC_DESCRIPTOR_QUERY;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_READ_BLOB_CHARACTERISTIC_DESCRIPTOR_QUERY);
+    operation.attribute_handle = descriptor_handle;
+    operation.attribute_offset = offset;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle){
@@ -2022,18 +2619,13 @@ uint8_t gatt_client_read_long_characteristic_descriptor(btstack_packet_handler_t
 }
 
 uint8_t gatt_client_write_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t length, uint8_t  * data){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = descriptor_handle;
-    peripheral->attribute_length = length;
-    peripheral->attribute_offset = 0;
-    peripheral->attribute_value = data;
-    peripheral->gatt_client_state = P_W2_SEND_WRITE_CHARACTERISTIC_DESCRIPTOR;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_SEND_WRITE_CHARACTERISTIC_DESCRIPTOR);
+    operation.attribute_handle = descriptor_handle;
+    operation.attribute_length = length;
+    operation.attribute_offset = 0;
+    operation.attribute_value = data;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_write_characteristic_descriptor(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_descriptor_t * descriptor, uint16_t length, uint8_t * value){
@@ -2041,18 +2633,13 @@ uint8_t gatt_client_write_characteristic_descriptor(btstack_packet_handler_t cal
 }
 
 uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t offset, uint16_t length, uint8_t  * data){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = descriptor_handle;
-    peripheral->attribute_length = length;
-    peripheral->attribute_offset = offset;
-    peripheral->attribute_value = data;
-    peripheral->gatt_client_state = P_W2_PREPARE_WRITE_CHARACTERISTIC_DESCRIPTOR;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_PREPARE_WRITE_CHARACTERISTIC_DESCRIPTOR);
+    operation.attribute_handle = descriptor_handle;
+    operation.attribute_length = length;
+    operation.attribute_offset = offset;
+    operation.attribute_value = data;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t length, uint8_t * data){
@@ -2067,47 +2654,31 @@ uint8_t gatt_client_write_long_characteristic_descriptor(btstack_packet_handler_
  * @brief -> gatt complete event
  */
 uint8_t gatt_client_prepare_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint16_t length, uint8_t * data){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->attribute_handle = attribute_handle;
-    peripheral->attribute_length = length;
-    peripheral->attribute_offset = offset;
-    peripheral->attribute_value = data;
-    peripheral->gatt_client_state = P_W2_PREPARE_WRITE_SINGLE;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_PREPARE_WRITE_SINGLE);
+    operation.attribute_handle = attribute_handle;
+    operation.attribute_length = length;
+    operation.attribute_offset = offset;
+    operation.attribute_value = data;
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 /**
  * @brief -> gatt complete event
  */
 uint8_t gatt_client_execute_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->gatt_client_state = P_W2_EXECUTE_PREPARED_WRITE;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_EXECUTE_PREPARED_WRITE);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 /**
  * @brief -> gatt complete event
  */
 uint8_t gatt_client_cancel_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle){
-    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
-    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED; 
-    if (is_ready(peripheral) == 0) return GATT_CLIENT_IN_WRONG_STATE;
-    
-    peripheral->callback = callback;
-    peripheral->gatt_client_state = P_W2_CANCEL_PREPARED_WRITE;
-    gatt_client_run();
-    return ERROR_CODE_SUCCESS;    
+    gatt_client_operation_t operation;
+    gatt_client_operation_init(&operation, callback, P_W2_CANCEL_PREPARED_WRITE);
+    return gatt_client_operation_submit(con_handle, &operation);
 }
 
 void gatt_client_deserialize_service(const uint8_t *packet, int offset, gatt_client_service_t *service){
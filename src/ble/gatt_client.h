@@ -125,7 +125,12 @@ typedef enum {
     P_W4_CMAC_READY,
     P_W4_CMAC_RESULT,
     P_W2_SEND_SIGNED_WRITE,
-    P_W4_SEND_SINGED_WRITE_DONE,
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    P_W2_SEND_READ_DATABASE_HASH,
+    P_W4_READ_DATABASE_HASH_RESULT,
+    P_W4_CACHED_QUERY_RESULT,
+#endif
 } gatt_client_state_t;
     
     
@@ -136,6 +141,52 @@ typedef enum{
     MTU_AUTO_EXCHANGE_DISABLED
 } gatt_client_mtu_t;
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+typedef enum {
+    GATT_CLIENT_CACHE_UNKNOWN,
+    GATT_CLIENT_CACHE_ACTIVE,
+    GATT_CLIENT_CACHE_DISABLED
+} gatt_client_cache_state_t;
+
+// size of buffer used to load, report and record discovery results of a single bonded device
+#ifndef GATT_CLIENT_CACHE_SIZE
+#define GATT_CLIENT_CACHE_SIZE 512
+#endif
+#endif
+
+// max number of GATT queries queued per connection while another query is active, 0 to disable queueing
+#ifndef GATT_CLIENT_OPERATION_QUEUE_SIZE
+#define GATT_CLIENT_OPERATION_QUEUE_SIZE 4
+#endif
+
+// number of hash buckets used to look up notification and indication listeners by con handle and value handle
+#ifndef GATT_CLIENT_VALUE_LISTENER_HASH_TABLE_SIZE
+#define GATT_CLIENT_VALUE_LISTENER_HASH_TABLE_SIZE 16
+#endif
+
+// GATT query parameters, stored until previous query is complete
+typedef struct {
+    gatt_client_state_t      state;
+    btstack_packet_handler_t callback;
+
+    uint16_t start_group_handle;
+    uint16_t end_group_handle;
+
+    uint16_t uuid16;
+    uint8_t  uuid128[16];
+    uint8_t  filter_with_uuid;
+
+    uint16_t attribute_handle;
+    uint16_t attribute_offset;
+    uint16_t attribute_length;
+    uint8_t* attribute_value;
+
+    uint16_t    read_multiple_handle_count;
+    uint16_t  * read_multiple_handles;
+
+    uint16_t client_characteristic_configuration;
+} gatt_client_operation_t;
+
 typedef struct gatt_client{
     btstack_linked_item_t    item;
     // TODO: rename gatt_client_state -> state
@@ -187,6 +238,30 @@ typedef struct gatt_client{
 
     btstack_timer_source_t gc_timeout;
 
+#if GATT_CLIENT_OPERATION_QUEUE_SIZE > 0
+    // ring buffer of queued queries
+    gatt_client_operation_t operation_queue[GATT_CLIENT_OPERATION_QUEUE_SIZE];
+    uint8_t  operation_queue_head;
+    uint8_t  operation_queue_count;
+#endif
+
+#ifdef ENABLE_LE_SIGNED_WRITE
+    // signed write command, sent independent of active query
+    gatt_client_state_t      signed_write_state;
+    btstack_packet_handler_t signed_write_callback;
+    uint16_t signed_write_handle;
+    uint16_t signed_write_length;
+    uint8_t* signed_write_value;
+#endif
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // discovery cache, validated by Database Hash once per connection
+    gatt_client_cache_state_t cache_state;
+    gatt_client_state_t       cache_query_state;
+    uint8_t  cache_database_hash[16];
+    uint16_t cache_service_changed_handle;
+#endif
+
 #ifdef ENABLE_GATT_CLIENT_PAIRING
     uint8_t  security_counter;
     uint8_t  wait_for_pairing_complete;
@@ -228,6 +303,8 @@ typedef struct {
 
 /** 
  * @brief Set up GATT client.
+ * @note Queries issued while another query is active on the same connection are queued and started in order,
+ *       up to GATT_CLIENT_OPERATION_QUEUE_SIZE per connection. Write Without Response and Signed Write are sent without waiting.
  */
 void gatt_client_init(void);
 
@@ -255,7 +332,7 @@ void gatt_client_mtu_enable_auto_negotiation(uint8_t enabled);
 void gatt_client_send_mtu_negotiation(btstack_packet_handler_t callback, hci_con_handle_t con_handle);
 
 /** 
- * @brief Returns if the GATT client is ready to receive a query. It is used with daemon. 
+ * @brief Returns if the GATT client is ready to receive a query, i.e. it is idle or the query can be queued. It is used with daemon. 
  * @param  con_handle
  * @return is_ready_status     0 - if no GATT client for con_handle is found, or is not ready, otherwise 1
  */
@@ -266,7 +343,7 @@ int gatt_client_is_ready(hci_con_handle_t con_handle);
  * @param  callback   
  * @param  con_handle
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered
  */
 uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback, hci_con_handle_t con_handle);
@@ -277,7 +354,7 @@ uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback,
  * @param con_handle
  * @param uuid16
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered  
  */
 uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t uuid16);
@@ -288,7 +365,7 @@ uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t
  * @param  con_handle
  * @param  uuid128
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered  
  */
 uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, const uint8_t  * uuid128);
@@ -299,7 +376,7 @@ uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_
  * @param  con_handle
  * @param  service
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered  
  */
 uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t  *service);
@@ -310,7 +387,7 @@ uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t
  * @param  con_handle
  * @param  service
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t  *service);
@@ -323,7 +400,7 @@ uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_
  * @param  end_handle
  * @param  uuid16
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16);
@@ -336,7 +413,7 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid16(btstack_
  * @param  end_handle
  * @param  uuid128
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint8_t  * uuid128);
@@ -348,7 +425,7 @@ uint8_t gatt_client_discover_characteristics_for_handle_range_by_uuid128(btstack
  * @param  service
  * @param  uuid16
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_discover_characteristics_for_service_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t  *service, uint16_t  uuid16);
@@ -360,7 +437,7 @@ uint8_t gatt_client_discover_characteristics_for_service_by_uuid16(btstack_packe
  * @param  service
  * @param  uuid128
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_discover_characteristics_for_service_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t  *service, uint8_t  * uuid128);
@@ -371,7 +448,7 @@ uint8_t gatt_client_discover_characteristics_for_service_by_uuid128(btstack_pack
  * @param  con_handle
  * @param  characteristic 
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t  *characteristic);
@@ -382,7 +459,7 @@ uint8_t gatt_client_discover_characteristic_descriptors(btstack_packet_handler_t
  * @param  con_handle
  * @param  characteristic 
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t  *characteristic);
@@ -393,7 +470,7 @@ uint8_t gatt_client_read_value_of_characteristic(btstack_packet_handler_t callba
  * @param  con_handle
  * @param  characteristic_value_handle 
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_value_of_characteristic_using_value_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle);
@@ -406,7 +483,7 @@ uint8_t gatt_client_read_value_of_characteristic_using_value_handle(btstack_pack
  * @param  end_handle
  * @param  uuid16
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint16_t uuid16);
@@ -419,7 +496,7 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handl
  * @param  end_handle
  * @param  uuid128
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_value_of_characteristics_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t start_handle, uint16_t end_handle, uint8_t * uuid128);
@@ -430,7 +507,7 @@ uint8_t gatt_client_read_value_of_characteristics_by_uuid128(btstack_packet_hand
  * @param  con_handle
  * @param  characteristic 
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_long_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_t  *characteristic);
@@ -441,7 +518,7 @@ uint8_t gatt_client_read_long_value_of_characteristic(btstack_packet_handler_t c
  * @param  con_handle
  * @param  characteristic_value_handle 
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle);
@@ -453,7 +530,7 @@ uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle(btstack
  * @param  characteristic_value_handle
  * @param  offset 
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
 uint8_t gatt_client_read_long_value_of_characteristic_using_value_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle, uint16_t offset);
@@ -474,7 +551,7 @@ uint8_t gatt_client_read_multiple_characteristic_values(btstack_packet_handler_t
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done
  * @return status BTSTACK_MEMORY_ALLOC_FAILED, if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE , if GATT client is busy and query queue is full
  *                BTSTACK_ACL_BUFFERS_FULL   , if L2CAP cannot send, there are no free ACL slots
  *                ERROR_CODE_SUCCESS         , if query is successfully registered 
  */
@@ -489,7 +566,7 @@ uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handl
  * @param  message_len
  * @param  message is not copied, make sure memory is accessible until write is done
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if previous signed write is not complete
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_signed_write_without_response(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t message_len, uint8_t  * message);
@@ -502,7 +579,7 @@ uint8_t gatt_client_signed_write_without_response(btstack_packet_handler_t callb
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle, uint16_t length, uint8_t  * data);
@@ -515,7 +592,7 @@ uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callb
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_long_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle, uint16_t length, uint8_t  * data);
@@ -529,7 +606,7 @@ uint8_t gatt_client_write_long_value_of_characteristic(btstack_packet_handler_t
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_long_value_of_characteristic_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle, uint16_t offset, uint16_t length, uint8_t  * data);
@@ -542,7 +619,7 @@ uint8_t gatt_client_write_long_value_of_characteristic_with_offset(btstack_packe
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t characteristic_value_handle, uint16_t length, uint8_t  * data);
@@ -553,7 +630,7 @@ uint8_t gatt_client_reliable_write_long_value_of_characteristic(btstack_packet_h
  * @param  con_handle
  * @param  descriptor
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_read_characteristic_descriptor(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_descriptor_t  * descriptor);
@@ -564,7 +641,7 @@ uint8_t gatt_client_read_characteristic_descriptor(btstack_packet_handler_t call
  * @param  con_handle
  * @param  descriptor
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_read_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle);
@@ -575,7 +652,7 @@ uint8_t gatt_client_read_characteristic_descriptor_using_descriptor_handle(btsta
  * @param  con_handle
  * @param  descriptor_handle
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_read_long_characteristic_descriptor(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_descriptor_t  * descriptor);
@@ -586,7 +663,7 @@ uint8_t gatt_client_read_long_characteristic_descriptor(btstack_packet_handler_t
  * @param  con_handle
  * @param  descriptor_handle
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle);
@@ -598,7 +675,7 @@ uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle(
  * @param  descriptor_handle
  * @param  offset
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t offset);
@@ -611,7 +688,7 @@ uint8_t gatt_client_read_long_characteristic_descriptor_using_descriptor_handle_
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_characteristic_descriptor(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_descriptor_t  * descriptor, uint16_t length, uint8_t  * data);
@@ -624,7 +701,7 @@ uint8_t gatt_client_write_characteristic_descriptor(btstack_packet_handler_t cal
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t length, uint8_t  * data);
@@ -637,7 +714,7 @@ uint8_t gatt_client_write_characteristic_descriptor_using_descriptor_handle(btst
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_long_characteristic_descriptor(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_characteristic_descriptor_t  * descriptor, uint16_t length, uint8_t  * data);
@@ -650,7 +727,7 @@ uint8_t gatt_client_write_long_characteristic_descriptor(btstack_packet_handler_
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t length, uint8_t  * data);
@@ -664,7 +741,7 @@ uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle
  * @param  length of data
  * @param  data is not copied, make sure memory is accessible until write is done, i.e. GATT_EVENT_QUERY_COMPLETE is received
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                ERROR_CODE_SUCCESS                                        if query is successfully registered
  */
 uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle_with_offset(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t descriptor_handle, uint16_t offset, uint16_t length, uint8_t  * data);
@@ -679,7 +756,7 @@ uint8_t gatt_client_write_long_characteristic_descriptor_using_descriptor_handle
  * @param  characteristic
  * @param  configuration                                                    GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_INDICATION
  * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found 
- *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is not ready
+ *                GATT_CLIENT_IN_WRONG_STATE                                if GATT client is busy and query queue is full
  *                GATT_CLIENT_CHARACTERISTIC_NOTIFICATION_NOT_SUPPORTED     if configuring notification, but characteristic has no notification property set
  *                GATT_CLIENT_CHARACTERISTIC_INDICATION_NOT_SUPPORTED       if configuring indication, but characteristic has no indication property set
  *                ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE         if configuration is invalid
@@ -83,6 +83,16 @@
 #define USE_CMAC_ENGINE
 #endif
 
+// resolve private addresses synchronously against all IRKs if AES128 is computed in software
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+#define USE_SYNCHRONOUS_ADDRESS_RESOLUTION
+#endif
+
+// number of resolvable private addresses remembered with their matching device index
+#ifndef SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE
+#define SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE 16
+#endif
+
 #define BTSTACK_TAG32(A,B,C,D) (((A) << 24) | ((B) << 16) | ((C) << 8) | (D))
 
 //
@@ -148,6 +158,14 @@ typedef enum {
     ADDRESS_RESOLUTION_FAILED,
 } address_resolution_event_t;
 
+#if SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE > 0
+typedef struct {
+    bd_addr_t address;
+    sm_key_t  irk;
+    int       le_device_index;
+} sm_address_resolution_cache_entry_t;
+#endif
+
 typedef enum {
     EC_KEY_GENERATION_IDLE,
     EC_KEY_GENERATION_ACTIVE,
@@ -251,6 +269,12 @@ static void *    sm_address_resolution_context;
 static address_resolution_mode_t sm_address_resolution_mode;
 static btstack_linked_list_t sm_address_resolution_general_queue;
 
+#if SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE > 0
+// most recently used entry first
+static sm_address_resolution_cache_entry_t sm_address_resolution_cache[SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE];
+static uint8_t                             sm_address_resolution_cache_count;
+#endif
+
 // aes128 crypto engine.
 static sm_aes128_state_t  sm_aes128_state;
 
@@ -263,12 +287,15 @@ static btstack_crypto_ecc_p256_t sm_crypto_ecc_p256_request;
 
 // temp storage for random data
 static uint8_t sm_random_data[8];
+#ifndef USE_SYNCHRONOUS_ADDRESS_RESOLUTION
 static uint8_t sm_aes128_key[16];
+#endif
 static uint8_t sm_aes128_plaintext[16];
 static uint8_t sm_aes128_ciphertext[16];
 
 // to receive hci events
 static btstack_packet_callback_registration_t hci_event_callback_registration;
+static uint8_t hci_event_codes[HCI_EVENT_CODE_BITMAP_LEN];
 
 /* to dispatch sm event */
 static btstack_linked_list_t sm_event_handlers;
@@ -382,7 +409,9 @@ static void sm_done_for_handle(hci_con_handle_t con_handle);
 static sm_connection_t * sm_get_connection_for_handle(hci_con_handle_t con_handle);
 static inline int sm_calc_actual_encryption_key_size(int other);
 static int sm_validate_stk_generation_method(void);
+#ifndef USE_SYNCHRONOUS_ADDRESS_RESOLUTION
 static void sm_handle_encryption_result_address_resolution(void *arg);
+#endif
 static void sm_handle_encryption_result_dkg_dhk(void *arg);
 static void sm_handle_encryption_result_dkg_irk(void *arg);
 static void sm_handle_encryption_result_enc_a(void *arg);
@@ -857,6 +886,75 @@ static void sm_address_resolution_start_lookup(uint8_t addr_type, hci_con_handle
     sm_notify_client_base(SM_EVENT_IDENTITY_RESOLVING_STARTED, con_handle, addr_type, addr);
 }
 
+#if SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE > 0
+
+static bool sm_address_resolution_is_resolvable_private_address(uint8_t addr_type, const bd_addr_t addr){
+    return (addr_type == BD_ADDR_TYPE_LE_RANDOM) && ((addr[0] & 0xc0u) == 0x40u);
+}
+
+static void sm_address_resolution_cache_move_to_front(uint8_t pos){
+    sm_address_resolution_cache_entry_t entry = sm_address_resolution_cache[pos];
+    (void)memmove(&sm_address_resolution_cache[1], &sm_address_resolution_cache[0], pos * sizeof(sm_address_resolution_cache_entry_t));
+    sm_address_resolution_cache[0] = entry;
+}
+
+static void sm_address_resolution_cache_remove(uint8_t pos){
+    sm_address_resolution_cache_count--;
+    (void)memmove(&sm_address_resolution_cache[pos], &sm_address_resolution_cache[pos+1], (sm_address_resolution_cache_count - pos) * sizeof(sm_address_resolution_cache_entry_t));
+}
+
+// returns device index or -1 if address not in cache. entry is dropped if IRK of device changed
+static int sm_address_resolution_cache_lookup(const bd_addr_t address){
+    uint8_t pos;
+    for (pos = 0; pos < sm_address_resolution_cache_count; pos++){
+        sm_address_resolution_cache_entry_t * entry = &sm_address_resolution_cache[pos];
+        if (memcmp(entry->address, address, 6) != 0) continue;
+
+        // validate that device with same IRK is still stored at this index
+        int addr_type = BD_ADDR_TYPE_UNKNOWN;
+        bd_addr_t addr;
+        sm_key_t irk;
+        le_device_db_info(entry->le_device_index, &addr_type, addr, irk);
+        if ((addr_type == BD_ADDR_TYPE_UNKNOWN) || (memcmp(irk, entry->irk, 16) != 0)){
+            sm_address_resolution_cache_remove(pos);
+            return -1;
+        }
+
+        int le_device_index = entry->le_device_index;
+        sm_address_resolution_cache_move_to_front(pos);
+        return le_device_index;
+    }
+    return -1;
+}
+
+// store address for device, replaces previous address of this device if RPA was rotated
+static void sm_address_resolution_cache_add(const bd_addr_t address, int le_device_index){
+    int addr_type = BD_ADDR_TYPE_UNKNOWN;
+    bd_addr_t addr;
+    sm_key_t irk;
+    le_device_db_info(le_device_index, &addr_type, addr, irk);
+    if (addr_type == BD_ADDR_TYPE_UNKNOWN) return;
+
+    uint8_t pos;
+    for (pos = 0; pos < sm_address_resolution_cache_count; pos++){
+        if (sm_address_resolution_cache[pos].le_device_index == le_device_index) break;
+    }
+    if (pos == sm_address_resolution_cache_count){
+        if (sm_address_resolution_cache_count < SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE){
+            sm_address_resolution_cache_count++;
+        } else {
+            // evict least recently used entry
+            pos--;
+        }
+    }
+    sm_address_resolution_cache_entry_t * entry = &sm_address_resolution_cache[pos];
+    (void)memcpy(entry->address, address, 6);
+    (void)memcpy(entry->irk, irk, 16);
+    entry->le_device_index = le_device_index;
+    sm_address_resolution_cache_move_to_front(pos);
+}
+#endif
+
 int sm_address_resolution_lookup(uint8_t address_type, bd_addr_t address){
     // check if already in list
     btstack_linked_list_iterator_t it;
@@ -1240,6 +1338,12 @@ static void sm_address_resolution_handle_event(address_resolution_event_t event)
             break;
     }
 
+#if SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE > 0
+    if ((event == ADDRESS_RESOLUTION_SUCEEDED) && sm_address_resolution_is_resolvable_private_address(sm_address_resolution_addr_type, sm_address_resolution_address)){
+        sm_address_resolution_cache_add(sm_address_resolution_address, matched_device_id);
+    }
+#endif
+
     switch (event){
         case ADDRESS_RESOLUTION_SUCEEDED:
             sm_notify_client_index(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, con_handle, sm_address_resolution_addr_type, sm_address_resolution_address, matched_device_id);
@@ -1898,11 +2002,12 @@ static bool sm_run_rau(void){
 }
 
 // CSRK Lookup
-static bool sm_run_csrk(void){
+static void sm_address_resolution_start_next(void){
     btstack_linked_list_iterator_t it;
 
-    // -- if csrk lookup ready, find connection that require csrk lookup
-    if (sm_address_resolution_idle()){
+    while (sm_address_resolution_idle()){
+
+        // -- if csrk lookup ready, find connection that require csrk lookup
         hci_connections_get_iterator(&it);
         while(btstack_linked_list_iterator_has_next(&it)){
             hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
@@ -1914,17 +2019,80 @@ static bool sm_run_csrk(void){
                 break;
             }
         }
-    }
 
-    // -- if csrk lookup ready, resolved addresses for received addresses
-    if (sm_address_resolution_idle()) {
-        if (!btstack_linked_list_empty(&sm_address_resolution_general_queue)){
+        // -- if csrk lookup ready, resolved addresses for received addresses
+        if (sm_address_resolution_idle()) {
+            if (btstack_linked_list_empty(&sm_address_resolution_general_queue)) return;
             sm_lookup_entry_t * entry = (sm_lookup_entry_t *) sm_address_resolution_general_queue;
             btstack_linked_list_remove(&sm_address_resolution_general_queue, (btstack_linked_item_t *) entry);
             sm_address_resolution_start_lookup(entry->address_type, 0, entry->address, ADDRESS_RESOLUTION_GENERAL, NULL);
             btstack_memory_sm_lookup_entry_free(entry);
         }
+
+#if SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE > 0
+        // -- resolve recently seen resolvable private addresses from cache and continue with next lookup
+        if (sm_address_resolution_is_resolvable_private_address(sm_address_resolution_addr_type, sm_address_resolution_address)){
+            int le_device_index = sm_address_resolution_cache_lookup(sm_address_resolution_address);
+            if (le_device_index >= 0){
+                log_info("LE Device Lookup: found resolvable private address in cache");
+                sm_address_resolution_test = le_device_index;
+                sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
+            }
+        }
+#endif
+    }
+}
+
+static bool sm_run_csrk(void){
+
+#ifdef USE_SYNCHRONOUS_ADDRESS_RESOLUTION
+    // resolve all pending addresses, test each address against all IRKs in a single pass
+    while (true){
+        sm_address_resolution_start_next();
+        if (sm_address_resolution_idle()) break;
+
+        sm_key_t r_prime;
+        sm_key_t hash;
+        sm_ah_r_prime(sm_address_resolution_address, r_prime);
+
+        log_info("LE Device Lookup: device %u/%u", sm_address_resolution_test, le_device_db_max_count());
+        while (sm_address_resolution_test < le_device_db_max_count()){
+            int addr_type = BD_ADDR_TYPE_UNKNOWN;
+            bd_addr_t addr;
+            sm_key_t irk;
+            le_device_db_info(sm_address_resolution_test, &addr_type, addr, irk);
+
+            // skip unused entries
+            if (addr_type != BD_ADDR_TYPE_UNKNOWN){
+
+                if ((sm_address_resolution_addr_type == addr_type) && (memcmp(addr, sm_address_resolution_address, 6) == 0)){
+                    log_info("LE Device Lookup: found CSRK by { addr_type, address} ");
+                    break;
+                }
+
+                // if connection type is public, it must be a different one
+                if (sm_address_resolution_addr_type != BD_ADDR_TYPE_LE_PUBLIC){
+                    btstack_aes128_calc(irk, r_prime, hash);
+                    if (memcmp(&sm_address_resolution_address[3], &hash[13], 3) == 0){
+                        log_info("LE Device Lookup: matched resolvable private address");
+                        break;
+                    }
+                }
+            }
+
+            sm_address_resolution_test++;
+        }
+
+        if (sm_address_resolution_test < le_device_db_max_count()){
+            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
+        } else {
+            log_info("LE Device Lookup: not found");
+            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
+        }
     }
+    return false;
+#else
+    sm_address_resolution_start_next();
 
     // -- Continue with CSRK device lookup by public or resolvable private address
     if (!sm_address_resolution_idle()){
@@ -1973,6 +2141,7 @@ static bool sm_run_csrk(void){
         }
     }
     return false;
+#endif
 }
 
 // SC OOB
@@ -2931,6 +3100,7 @@ static void sm_handle_encryption_result_enc_ph4_ltk(void *arg){
 }
 #endif
 
+#ifndef USE_SYNCHRONOUS_ADDRESS_RESOLUTION
 static void sm_handle_encryption_result_address_resolution(void *arg){
     UNUSED(arg);
     sm_aes128_state = SM_AES128_IDLE;
@@ -2948,6 +3118,7 @@ static void sm_handle_encryption_result_address_resolution(void *arg){
     sm_address_resolution_test++;
     sm_run();
 }
+#endif
 
 static void sm_handle_encryption_result_dkg_irk(void *arg){
     UNUSED(arg);
@@ -3389,7 +3560,7 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                     if ((sm_conn->sm_role == 0u)
                         && (sm_conn->sm_engine_state == SM_INITIATOR_PH0_W4_CONNECTION_ENCRYPTED)
                         && (packet[2] == ERROR_CODE_AUTHENTICATION_FAILURE)){
-                        le_device_db_remove(sm_conn->sm_le_db_index);
+                        sm_delete_bonding(sm_conn->sm_le_db_index);
                     }
 
                     // pairing failed, if it was ongoing
@@ -4092,15 +4263,20 @@ void sm_init(void){
     sm_address_resolution_ah_calculation_active = 0;
     sm_address_resolution_mode = ADDRESS_RESOLUTION_IDLE;
     sm_address_resolution_general_queue = NULL;
+#if SM_RESOLVABLE_PRIVATE_ADDRESS_CACHE_SIZE > 0
+    sm_address_resolution_cache_count = 0;
+#endif
 
     gap_random_adress_update_period = 15 * 60 * 1000L;
     sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
 
     test_use_fixed_local_csrk = false;
 
-    // register for HCI Events from HCI
+    // register for HCI Events from HCI, can send now is requested via L2CAP
+    hci_event_code_bitmap_set_all_except_scan_results(hci_event_codes);
+    hci_event_code_bitmap_clear(hci_event_codes, HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS);
     hci_event_callback_registration.callback = &sm_event_packet_handler;
-    hci_add_event_handler(&hci_event_callback_registration);
+    hci_add_event_handler_for_event_codes(&hci_event_callback_registration, hci_event_codes);
 
     // 
     btstack_crypto_init();
@@ -4376,6 +4552,23 @@ int sm_le_device_index(hci_con_handle_t con_handle ){
     return sm_conn->sm_le_db_index;
 }
 
+void sm_delete_bonding(int le_device_index){
+    if (le_device_index < 0) return;
+
+    int addr_type;
+    bd_addr_t addr;
+    le_device_db_info(le_device_index, &addr_type, addr, NULL);
+    le_device_db_remove(le_device_index);
+
+    uint8_t event[11];
+    event[0] = SM_EVENT_BONDING_DELETED;
+    event[1] = sizeof(event) - 2u;
+    event[2] = (uint8_t) addr_type;
+    reverse_bd_addr(addr, &event[3]);
+    little_endian_store_16(event, 9, (uint16_t) le_device_index);
+    sm_dispatch_event(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
 static int gap_random_address_type_requires_updates(void){
     switch (gap_random_adress_type){
         case GAP_RANDOM_ADDRESS_TYPE_OFF:
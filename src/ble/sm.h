@@ -220,6 +220,13 @@ irk_lookup_state_t sm_identity_resolving_state(hci_con_handle_t con_handle);
  */
 int sm_le_device_index(hci_con_handle_t con_handle );
 
+/**
+ * @brief Delete bonding information of device from LE Device DB
+ * @param le_device_index
+ * @note Triggers SM_EVENT_BONDING_DELETED
+ */
+void sm_delete_bonding(int le_device_index);
+
 /**
  * @brief Use fixec passkey for Legacy and SC instead of generating a random number
  * @note Can be used to improve security over Just Works if no keyboard or displary are present and 
@@ -633,6 +633,11 @@ typedef enum {
 #define GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION  1
 #define GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_INDICATION    2
 
+// GATT Client Supported Features (first octet)
+#define GATT_CLIENT_SUPPORTED_FEATURES_ROBUST_CACHING                        0x01
+#define GATT_CLIENT_SUPPORTED_FEATURES_ENHANCED_ATT_BEARER                   0x02
+#define GATT_CLIENT_SUPPORTED_FEATURES_MULTIPLE_HANDLE_VALUE_NOTIFICATIONS   0x04
+
 #define GATT_CLIENT_ANY_CONNECTION      0xffff
 #define GATT_CLIENT_ANY_VALUE_HANDLE    0x0000
 
@@ -100,6 +100,7 @@
 #define ORG_BLUETOOTH_CHARACTERISTIC_CGM_SESSION_START_TIME                              0x2AAA // CGM Session Start Time
 #define ORG_BLUETOOTH_CHARACTERISTIC_CGM_SPECIFIC_OPS_CONTROL_POINT                      0x2AAC // CGM Specific Ops Control Point
 #define ORG_BLUETOOTH_CHARACTERISTIC_CGM_STATUS                                          0x2AA9 // CGM Status
+#define ORG_BLUETOOTH_CHARACTERISTIC_CLIENT_SUPPORTED_FEATURES                           0x2B29 // Client Supported Features
 #define ORG_BLUETOOTH_CHARACTERISTIC_CROSS_TRAINER_DATA                                  0x2ACE // Cross Trainer Data
 #define ORG_BLUETOOTH_CHARACTERISTIC_CSC_FEATURE                                         0x2A5C // CSC Feature
 #define ORG_BLUETOOTH_CHARACTERISTIC_CSC_MEASUREMENT                                     0x2A5B // CSC Measurement
@@ -109,6 +110,7 @@
 #define ORG_BLUETOOTH_CHARACTERISTIC_CYCLING_POWER_MEASUREMENT                           0x2A63 // Cycling Power Measurement
 #define ORG_BLUETOOTH_CHARACTERISTIC_CYCLING_POWER_VECTOR                                0x2A64 // Cycling Power Vector
 #define ORG_BLUETOOTH_CHARACTERISTIC_DATABASE_CHANGE_INCREMENT                           0x2A99 // Database Change Increment
+#define ORG_BLUETOOTH_CHARACTERISTIC_DATABASE_HASH                                       0x2B2A // Database Hash
 #define ORG_BLUETOOTH_CHARACTERISTIC_DATE_OF_BIRTH                                       0x2A85 // Date of Birth
 #define ORG_BLUETOOTH_CHARACTERISTIC_DATE_OF_THRESHOLD_ASSESSMENT                        0x2A86 // Date of Threshold Assessment
 #define ORG_BLUETOOTH_CHARACTERISTIC_DATE_TIME                                           0x2A08 // Date Time
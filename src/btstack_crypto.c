@@ -130,6 +130,7 @@ static const uint8_t zero[16] = { 0 };
 static uint8_t btstack_crypto_initialized;
 static btstack_linked_list_t btstack_crypto_operations;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
+static uint8_t hci_event_codes[HCI_EVENT_CODE_BITMAP_LEN];
 static uint8_t btstack_crypto_wait_for_hci_result;
 
 // state for AES-CMAC
@@ -1166,9 +1167,15 @@ void btstack_crypto_init(void){
 	if (btstack_crypto_initialized) return;
 	btstack_crypto_initialized = 1;
 
-	// register with HCI
+	// register with HCI for events that complete or allow to send HCI commands
+    hci_event_code_bitmap_set(hci_event_codes, BTSTACK_EVENT_STATE);
+    hci_event_code_bitmap_set(hci_event_codes, HCI_EVENT_COMMAND_COMPLETE);
+    hci_event_code_bitmap_set(hci_event_codes, HCI_EVENT_COMMAND_STATUS);
+    hci_event_code_bitmap_set(hci_event_codes, HCI_EVENT_TRANSPORT_PACKET_SENT);
+    hci_event_code_bitmap_set_le_subevent(hci_event_codes, HCI_SUBEVENT_LE_READ_LOCAL_P256_PUBLIC_KEY_COMPLETE);
+    hci_event_code_bitmap_set_le_subevent(hci_event_codes, HCI_SUBEVENT_LE_GENERATE_DHKEY_COMPLETE);
     hci_event_callback_registration.callback = &btstack_crypto_event_handler;
-    hci_add_event_handler(&hci_event_callback_registration);
+    hci_add_event_handler_for_event_codes(&hci_event_callback_registration, hci_event_codes);
 
 #ifdef USE_MBEDTLS_ECC_P256
 	mbedtls_ecp_group_init(&mbedtls_ec_group);
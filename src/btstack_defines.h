@@ -61,6 +61,8 @@ typedef void (*btstack_packet_handler_t) (uint8_t packet_type, uint16_t channel,
 typedef struct {
     btstack_linked_item_t    item;
     btstack_packet_handler_t callback;
+    // optional bitmap of event codes delivered to callback, NULL for all events. Used by hci_add_event_handler_for_event_codes
+    const uint8_t *          event_codes;
 } btstack_packet_callback_registration_t;
 
 // context callback supporting multiple registrations
@@ -70,6 +72,12 @@ typedef struct {
   void * context;
 } btstack_context_callback_registration_t;
 
+// data vector used for scatter/gather operations
+typedef struct {
+    const uint8_t * data;
+    uint16_t        len;
+} btstack_iovec_t;
+
 /**
  * @brief 128 bit key used with AES128 in Security Manager
  */
@@ -1322,6 +1330,16 @@ typedef uint8_t sm_key_t[16];
   */
 #define SM_EVENT_PAIRING_COMPLETE                                0xDF
 
+ /**
+  * @brief Emitted when bonding information of a device was deleted, e.g. by sm_delete_bonding
+  *
+  * @format 1B2
+  * @param addr_type
+  * @param address
+  * @param index
+  */
+#define SM_EVENT_BONDING_DELETED                                 0xE6
+
 
 // GAP
 
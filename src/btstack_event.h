@@ -3112,6 +3112,36 @@ static inline uint8_t sm_event_pairing_complete_get_reason(const uint8_t * event
 }
 #endif
 
+#ifdef ENABLE_BLE
+/**
+ * @brief Get field addr_type from event SM_EVENT_BONDING_DELETED
+ * @param event packet
+ * @return addr_type
+ * @note: btstack_type 1
+ */
+static inline uint8_t sm_event_bonding_deleted_get_addr_type(const uint8_t * event){
+    return event[2];
+}
+/**
+ * @brief Get field address from event SM_EVENT_BONDING_DELETED
+ * @param event packet
+ * @param Pointer to storage for address
+ * @note: btstack_type B
+ */
+static inline void sm_event_bonding_deleted_get_address(const uint8_t * event, bd_addr_t address){
+    reverse_bytes(&event[3], address, 6);
+}
+/**
+ * @brief Get field index from event SM_EVENT_BONDING_DELETED
+ * @param event packet
+ * @return index
+ * @note: btstack_type 2
+ */
+static inline uint16_t sm_event_bonding_deleted_get_index(const uint8_t * event){
+    return little_endian_read_16(event, 9);
+}
+#endif
+
 /**
  * @brief Get field handle from event GAP_EVENT_SECURITY_LEVEL
  * @param event packet
@@ -334,6 +334,56 @@ static void btstack_hid_parser_find_next_usage(btstack_hid_parser_t * parser){
     }
 }
 
+// read up to 32 bit from report, bits beyond report len are read as zero
+static uint32_t btstack_hid_read_bits(const uint8_t * report, uint16_t report_len, uint16_t bit_offset, uint8_t bit_size){
+    uint32_t value = 0;
+    uint16_t pos   = bit_offset >> 3;
+    uint8_t  shift = bit_offset & 0x07u;
+    uint8_t  bits_read = 0;
+    while (bits_read < bit_size){
+        uint32_t byte = (pos < report_len) ? report[pos] : 0u;
+        value |= (byte >> shift) << bits_read;
+        bits_read += 8u - shift;
+        shift = 0;
+        pos++;
+    }
+    if (bit_size < 32u){
+        value &= (1u << bit_size) - 1u;
+    }
+    return value;
+}
+
+static int32_t btstack_hid_field_read_value(const btstack_hid_field_t * field, const uint8_t * report, uint16_t report_len){
+    uint32_t unsigned_value = btstack_hid_read_bits(report, report_len, field->bit_offset, field->bit_size);
+    if (field->is_variable && field->is_signed && (field->bit_size > 0u) && (field->bit_size < 32u)){
+        if (unsigned_value & (1u << (field->bit_size - 1u))){
+            return (int32_t) (unsigned_value - (1u << field->bit_size));
+        }
+    }
+    return (int32_t) unsigned_value;
+}
+
+static void btstack_hid_parser_get_field_from_layout(btstack_hid_parser_t * parser, uint16_t * usage_page, uint16_t * usage, int32_t * value){
+    const btstack_hid_report_layout_t * report_layout = parser->report_layout;
+    const btstack_hid_field_t * field = &parser->layout->fields[report_layout->first_field + parser->layout_field_index];
+    int32_t field_value = btstack_hid_field_read_value(field, parser->report, parser->report_len);
+    *usage_page = field->usage_page;
+    if (field->is_variable){
+        *usage = field->usage_minimum;
+        *value = field_value;
+    } else {
+        *usage = (uint16_t) field_value;
+        *value = 1;
+    }
+    parser->layout_field_index++;
+    if (parser->layout_field_index < report_layout->num_fields){
+        parser->report_pos_in_bit = field[1].bit_offset;
+    } else {
+        parser->report_pos_in_bit = ((report_layout->report_id != 0u) ? 8u : 0u) + report_layout->bit_size;
+        parser->state = BTSTACK_HID_PARSER_COMPLETE;
+    }
+}
+
 // PUBLIC API
 
 void btstack_hid_parser_init(btstack_hid_parser_t * parser, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, hid_report_type_t hid_report_type, const uint8_t * hid_report, uint16_t hid_report_len){
@@ -350,12 +400,39 @@ void btstack_hid_parser_init(btstack_hid_parser_t * parser, const uint8_t * hid_
     btstack_hid_parser_find_next_usage(parser);
 }
 
+void btstack_hid_parser_init_with_layout(btstack_hid_parser_t * parser, const btstack_hid_descriptor_layout_t * layout, hid_report_type_t hid_report_type, const uint8_t * hid_report, uint16_t hid_report_len){
+
+    memset(parser, 0, sizeof(btstack_hid_parser_t));
+
+    parser->layout         = layout;
+    parser->report_type    = hid_report_type;
+    parser->report         = hid_report;
+    parser->report_len     = hid_report_len;
+    parser->state          = BTSTACK_HID_PARSER_COMPLETE;
+
+    int report_id = 0;
+    if (layout->report_id_declared){
+        if (hid_report_len == 0u) return;
+        report_id = hid_report[0];
+    }
+    parser->report_layout = btstack_hid_descriptor_layout_get_report(layout, report_id, hid_report_type);
+    if (parser->report_layout == NULL) return;
+    if (parser->report_layout->num_fields == 0u) return;
+    parser->report_pos_in_bit = layout->fields[parser->report_layout->first_field].bit_offset;
+    parser->state = BTSTACK_HID_PARSER_USAGES_AVAILABLE;
+}
+
 int  btstack_hid_parser_has_more(btstack_hid_parser_t * parser){
     return parser->state == BTSTACK_HID_PARSER_USAGES_AVAILABLE;
 }
 
 void btstack_hid_parser_get_field(btstack_hid_parser_t * parser, uint16_t * usage_page, uint16_t * usage, int32_t * value){
 
+    if (parser->layout != NULL){
+        btstack_hid_parser_get_field_from_layout(parser, usage_page, usage, value);
+        return;
+    }
+
     *usage_page = parser->usage_minimum >> 16;
 
     // read field (up to 32 bit unsigned, up to 31 bit signed - 32 bit signed behaviour is undefined) - check report len
@@ -518,3 +595,197 @@ int btstack_hid_report_id_declared(uint16_t hid_descriptor_len, const uint8_t *
     }
     return 0;
 }
+
+static btstack_hid_report_layout_t * btstack_hid_descriptor_layout_find_report(btstack_hid_descriptor_layout_t * layout, int report_id, hid_report_type_t report_type){
+    uint8_t i;
+    for (i=0;i<layout->num_reports;i++){
+        btstack_hid_report_layout_t * report_layout = &layout->reports[i];
+        if ((report_layout->report_id == report_id) && (report_layout->report_type == report_type)){
+            return report_layout;
+        }
+    }
+    return NULL;
+}
+
+static int btstack_hid_descriptor_layout_add_fields(btstack_hid_descriptor_layout_t * layout, btstack_hid_report_layout_t * report_layout, btstack_hid_parser_t * scan){
+    int is_variable = (scan->descriptor_item.item_value & 2) != 0;
+    uint32_t last_usage = 0;
+    uint32_t i;
+    for (i=0;i<scan->global_report_count;i++){
+        if (((uint32_t) report_layout->first_field + report_layout->num_fields) >= layout->num_fields){
+            log_error("field outside of layout");
+            return 0;
+        }
+        btstack_hid_field_t * field = &layout->fields[report_layout->first_field + report_layout->num_fields];
+        hid_find_next_usage(scan);
+        if (is_variable){
+            // missing usages repeat the last usage
+            if (scan->available_usages){
+                last_usage = scan->usage_minimum;
+                scan->usage_minimum++;
+                scan->available_usages--;
+            }
+            field->usage_page    = last_usage >> 16;
+            field->usage_minimum = last_usage & 0xffffu;
+            field->usage_maximum = last_usage & 0xffffu;
+        } else {
+            // all array elements share the usage range
+            if (scan->available_usages){
+                last_usage = scan->usage_minimum;
+                field->usage_maximum = (scan->usage_minimum + scan->available_usages - 1u) & 0xffffu;
+            } else {
+                field->usage_maximum = last_usage & 0xffffu;
+            }
+            field->usage_page    = last_usage >> 16;
+            field->usage_minimum = last_usage & 0xffffu;
+        }
+        field->bit_offset      = ((report_layout->report_id != 0u) ? 8u : 0u) + report_layout->bit_size;
+        field->bit_size        = (uint8_t) btstack_min(scan->global_report_size, 32u);
+        field->is_variable     = is_variable;
+        field->is_signed       = scan->global_logical_minimum < 0;
+        field->logical_minimum = scan->global_logical_minimum;
+        field->logical_maximum = scan->global_logical_maximum;
+        report_layout->bit_size += scan->global_report_size;
+        report_layout->num_fields++;
+    }
+    return 1;
+}
+
+// pass 1: collect reports, their size and number of fields; pass 2: fill fields
+static int btstack_hid_descriptor_layout_scan(btstack_hid_descriptor_layout_t * layout, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, int fill_fields){
+    btstack_hid_parser_t scan;
+    memset(&scan, 0, sizeof(btstack_hid_parser_t));
+    scan.descriptor     = hid_descriptor;
+    scan.descriptor_len = hid_descriptor_len;
+
+    while (scan.descriptor_pos < scan.descriptor_len){
+        hid_descriptor_item_t * item = &scan.descriptor_item;
+        btstack_hid_parse_descriptor_item(item, &hid_descriptor[scan.descriptor_pos], hid_descriptor_len - scan.descriptor_pos);
+        if (item->item_type == Global){
+            btstack_hid_handle_global_item(&scan, item);
+            if (item->item_tag == ReportID){
+                layout->report_id_declared = 1;
+            }
+            scan.descriptor_pos += item->item_size;
+            continue;
+        }
+        if (item->item_type != Main){
+            scan.descriptor_pos += item->item_size;
+            continue;
+        }
+        hid_report_type_t report_type;
+        switch ((MainItemTag)item->item_tag){
+            case Input:
+                report_type = HID_REPORT_TYPE_INPUT;
+                break;
+            case Output:
+                report_type = HID_REPORT_TYPE_OUTPUT;
+                break;
+            case Feature:
+                report_type = HID_REPORT_TYPE_FEATURE;
+                break;
+            default:
+                report_type = HID_REPORT_TYPE_RESERVED;
+                break;
+        }
+        if (report_type != HID_REPORT_TYPE_RESERVED){
+            btstack_hid_report_layout_t * report_layout = btstack_hid_descriptor_layout_find_report(layout, scan.global_report_id, report_type);
+            if (report_layout == NULL){
+                if (layout->num_reports >= HID_PARSER_MAX_REPORT_LAYOUTS) {
+                    log_error("more than %u reports", HID_PARSER_MAX_REPORT_LAYOUTS);
+                    return 0;
+                }
+                report_layout = &layout->reports[layout->num_reports++];
+                report_layout->report_id   = scan.global_report_id;
+                report_layout->report_type = report_type;
+            }
+            uint32_t item_bits = scan.global_report_size * scan.global_report_count;
+            // bit offset incl. Report ID has to fit into 16 bit
+            if (((uint32_t) report_layout->bit_size + item_bits + 8u) > 0xffffu){
+                log_error("report %u too large", report_layout->report_id);
+                return 0;
+            }
+            if (item->item_value & 1){
+                // constant fields used for padding
+                report_layout->bit_size += item_bits;
+            } else if (fill_fields){
+                if (btstack_hid_descriptor_layout_add_fields(layout, report_layout, &scan) == 0){
+                    return 0;
+                }
+            } else {
+                if (((uint32_t) layout->num_fields + scan.global_report_count) > layout->max_fields){
+                    log_error("more than %u fields", layout->max_fields);
+                    return 0;
+                }
+                layout->num_fields        += scan.global_report_count;
+                report_layout->bit_size   += item_bits;
+                report_layout->num_fields += scan.global_report_count;
+            }
+        }
+        // reset usages
+        scan.available_usages = 0;
+        scan.have_usage_min   = 0;
+        scan.have_usage_max   = 0;
+        hid_post_process_item(&scan, item);
+    }
+    return 1;
+}
+
+int btstack_hid_descriptor_layout_compile(btstack_hid_descriptor_layout_t * layout, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, btstack_hid_field_t * fields, uint16_t max_fields){
+    memset(layout, 0, sizeof(btstack_hid_descriptor_layout_t));
+    layout->fields     = fields;
+    layout->max_fields = max_fields;
+
+    // pass 1: collect reports
+    if (btstack_hid_descriptor_layout_scan(layout, hid_descriptor, hid_descriptor_len, 0) == 0){
+        return 0;
+    }
+
+    // assign field ranges
+    uint32_t num_fields = 0;
+    uint8_t i;
+    for (i=0;i<layout->num_reports;i++){
+        btstack_hid_report_layout_t * report_layout = &layout->reports[i];
+        report_layout->first_field = num_fields;
+        num_fields += report_layout->num_fields;
+        report_layout->num_fields = 0;
+        report_layout->bit_size   = 0;
+    }
+    if (num_fields > max_fields){
+        log_error("%u fields required, only %u available", (unsigned int) num_fields, max_fields);
+        return 0;
+    }
+    layout->num_fields = num_fields;
+
+    // pass 2: fill fields
+    return btstack_hid_descriptor_layout_scan(layout, hid_descriptor, hid_descriptor_len, 1);
+}
+
+const btstack_hid_report_layout_t * btstack_hid_descriptor_layout_get_report(const btstack_hid_descriptor_layout_t * layout, int report_id, hid_report_type_t report_type){
+    return btstack_hid_descriptor_layout_find_report((btstack_hid_descriptor_layout_t *) layout, report_id, report_type);
+}
+
+int btstack_hid_descriptor_layout_get_report_size(const btstack_hid_descriptor_layout_t * layout, int report_id, hid_report_type_t report_type){
+    const btstack_hid_report_layout_t * report_layout = btstack_hid_descriptor_layout_get_report(layout, report_id, report_type);
+    if (report_layout == NULL) return 0;
+    return (report_layout->bit_size + 7u) / 8u;
+}
+
+hid_report_id_status_t btstack_hid_descriptor_layout_id_valid(const btstack_hid_descriptor_layout_t * layout, int report_id){
+    if (layout->report_id_declared == 0u) return HID_REPORT_ID_UNDECLARED;
+    uint8_t i;
+    for (i=0;i<layout->num_reports;i++){
+        if (layout->reports[i].report_id == report_id) return HID_REPORT_ID_VALID;
+    }
+    return HID_REPORT_ID_INVALID;
+}
+
+uint16_t btstack_hid_descriptor_layout_extract(const btstack_hid_descriptor_layout_t * layout, const btstack_hid_report_layout_t * report_layout, const uint8_t * hid_report, uint16_t hid_report_len, int32_t * values, uint16_t max_values){
+    uint16_t num_values = btstack_min(report_layout->num_fields, max_values);
+    const btstack_hid_field_t * field = &layout->fields[report_layout->first_field];
+    uint16_t i;
+    for (i=0;i<num_values;i++){
+        values[i] = btstack_hid_field_read_value(&field[i], hid_report, hid_report_len);
+    }
+    return num_values;
+}
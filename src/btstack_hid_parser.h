@@ -39,6 +39,9 @@
  *  btstack_hid_parser.h
  *
  *  Single-pass HID Report Parser: HID Report is directly parsed without preprocessing HID Descriptor to minimize memory
+ *
+ *  Alternatively, HID Descriptor can be compiled once into a table of fields per report ID and report type,
+ *  which allows to decode reports without walking the HID Descriptor
  */
 
 #ifndef BTSTACK_HID_PARSER_H
@@ -120,6 +123,46 @@ typedef enum {
     HID_REPORT_ID_INVALID
 } hid_report_id_status_t;
 
+// max number of report ID / report type combinations in compiled HID Descriptor
+#ifndef HID_PARSER_MAX_REPORT_LAYOUTS
+#define HID_PARSER_MAX_REPORT_LAYOUTS 8
+#endif
+
+// single report element, i.e. one of Report Count elements of an Input, Output or Feature item
+typedef struct {
+    // bit offset in report, including Report ID
+    uint16_t bit_offset;
+    // Report Size
+    uint8_t  bit_size;
+    // Variable item: usage_minimum == usage_maximum, Array item: value is usage from usage range
+    uint8_t  is_variable;
+    uint8_t  is_signed;
+    uint16_t usage_page;
+    uint16_t usage_minimum;
+    uint16_t usage_maximum;
+    int32_t  logical_minimum;
+    int32_t  logical_maximum;
+} btstack_hid_field_t;
+
+typedef struct {
+    uint8_t           report_id;
+    hid_report_type_t report_type;
+    // size of report data without Report ID
+    uint16_t          bit_size;
+    // fields of this report in btstack_hid_descriptor_layout_t.fields
+    uint16_t          first_field;
+    uint16_t          num_fields;
+} btstack_hid_report_layout_t;
+
+typedef struct {
+    btstack_hid_field_t *       fields;
+    uint16_t                    max_fields;
+    uint16_t                    num_fields;
+    btstack_hid_report_layout_t reports[HID_PARSER_MAX_REPORT_LAYOUTS];
+    uint8_t                     num_reports;
+    uint8_t                     report_id_declared;
+} btstack_hid_descriptor_layout_t;
+
 typedef struct {
 
     // Descriptor
@@ -159,6 +202,11 @@ typedef struct {
     uint8_t         global_report_size;
     uint8_t         global_report_count;
     uint8_t         global_report_id;
+
+    // compiled HID Descriptor, used instead of descriptor if set
+    const btstack_hid_descriptor_layout_t * layout;
+    const btstack_hid_report_layout_t     * report_layout;
+    uint16_t        layout_field_index;
 } btstack_hid_parser_t;
 
 /* API_START */
@@ -174,6 +222,16 @@ typedef struct {
  */
 void btstack_hid_parser_init(btstack_hid_parser_t * parser, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, hid_report_type_t hid_report_type, const uint8_t * hid_report, uint16_t hid_report_len);
 
+/**
+ * @brief Initialize HID Parser with compiled HID Descriptor, see btstack_hid_descriptor_layout_compile
+ * @param parser state
+ * @param layout of compiled HID Descriptor
+ * @param hid_report_type
+ * @param hid_report
+ * @param hid_report_len
+ */
+void btstack_hid_parser_init_with_layout(btstack_hid_parser_t * parser, const btstack_hid_descriptor_layout_t * layout, hid_report_type_t hid_report_type, const uint8_t * hid_report, uint16_t hid_report_len);
+
 /**
  * @brief Checks if more fields are available
  * @param parser
@@ -220,6 +278,54 @@ hid_report_id_status_t btstack_hid_id_valid(int report_id, uint16_t hid_descript
  * @param hid_descriptor
  */
 int btstack_hid_report_id_declared(uint16_t hid_descriptor_len, const uint8_t * hid_descriptor);
+
+/**
+ * @brief Compile HID Descriptor into table of fields per report ID and report type
+ * @param layout
+ * @param hid_descriptor
+ * @param hid_descriptor_len
+ * @param fields storage for all fields of all reports
+ * @param max_fields
+ * @returns 1 if all reports and fields fit into layout
+ */
+int btstack_hid_descriptor_layout_compile(btstack_hid_descriptor_layout_t * layout, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, btstack_hid_field_t * fields, uint16_t max_fields);
+
+/**
+ * @brief Get compiled report for given report ID and report type
+ * @param layout
+ * @param report_id
+ * @param report_type
+ * @returns report layout or NULL
+ */
+const btstack_hid_report_layout_t * btstack_hid_descriptor_layout_get_report(const btstack_hid_descriptor_layout_t * layout, int report_id, hid_report_type_t report_type);
+
+/**
+ * @brief Get report size for given report ID and report type, see btstack_hid_get_report_size_for_id
+ * @param layout
+ * @param report_id
+ * @param report_type
+ */
+int btstack_hid_descriptor_layout_get_report_size(const btstack_hid_descriptor_layout_t * layout, int report_id, hid_report_type_t report_type);
+
+/**
+ * @brief Check report ID, see btstack_hid_id_valid
+ * @param layout
+ * @param report_id
+ */
+hid_report_id_status_t btstack_hid_descriptor_layout_id_valid(const btstack_hid_descriptor_layout_t * layout, int report_id);
+
+/**
+ * @brief Decode report into one value per field of report layout
+ * @note Variable fields provide (sign extended) value, Array fields provide selected usage
+ * @param layout
+ * @param report_layout
+ * @param hid_report including Report ID if declared
+ * @param hid_report_len
+ * @param values
+ * @param max_values
+ * @returns number of values
+ */
+uint16_t btstack_hid_descriptor_layout_extract(const btstack_hid_descriptor_layout_t * layout, const btstack_hid_report_layout_t * report_layout, const uint8_t * hid_report, uint16_t hid_report_len, int32_t * values, uint16_t max_values);
 /* API_END */
 
 #if defined __cplusplus
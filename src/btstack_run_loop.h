@@ -47,6 +47,7 @@
 #include "btstack_config.h"
 
 #include "btstack_bool.h"
+#include "btstack_defines.h"
 #include "btstack_linked_list.h"
 
 #include <stdint.h>
@@ -92,6 +93,10 @@ typedef struct btstack_timer_source {
     // will be called when timer fired
     void  (*process)(struct btstack_timer_source *ts); 
     void * context;
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    // position in timer heap, managed by btstack_run_loop_base
+    uint16_t heap_index;
+#endif
 } btstack_timer_source_t;
 
 typedef struct btstack_run_loop {
@@ -106,6 +111,7 @@ typedef struct btstack_run_loop {
 	void (*execute)(void);
 	void (*dump_timer)(void);
 	uint32_t (*get_time_ms)(void);
+	void (*execute_on_main_thread)(btstack_context_callback_registration_t * callback_registration);
 } btstack_run_loop_t;
 
 void btstack_run_loop_timer_dump(void);
@@ -220,6 +226,13 @@ int btstack_run_loop_remove_data_source(btstack_data_source_t * data_source);
  */
 void btstack_run_loop_execute(void);
 
+/**
+ * @brief Execute callback from run loop thread. Can be called from any thread, if supported by the run loop
+ * @note callback_registration must stay valid and must not be re-submitted until its callback was executed
+ * @param callback_registration with callback and context
+ */
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -53,33 +53,84 @@
 btstack_linked_list_t btstack_run_loop_base_timers;
 btstack_linked_list_t btstack_run_loop_base_data_sources;
 
-void btstack_run_loop_base_init(void){
-    btstack_run_loop_base_timers = NULL;
-    btstack_run_loop_base_data_sources = NULL;    
+// expired timers collected by btstack_run_loop_base_process_timers, but not processed yet
+static btstack_linked_list_t btstack_run_loop_base_timers_expired;
+
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+
+#ifndef RUN_LOOP_TIMER_HEAP_SIZE
+#define RUN_LOOP_TIMER_HEAP_SIZE 32
+#endif
+
+// binary min-heap ordered by timeout, timers that don't fit are kept in sorted btstack_run_loop_base_timers list
+static btstack_timer_source_t * btstack_run_loop_base_timer_heap[RUN_LOOP_TIMER_HEAP_SIZE];
+static uint16_t btstack_run_loop_base_timer_heap_count;
+
+static bool btstack_run_loop_base_timer_before(const btstack_timer_source_t * a, const btstack_timer_source_t * b){
+    return btstack_time_delta(a->timeout, b->timeout) < 0;
 }
 
-void btstack_run_loop_base_add_data_source(btstack_data_source_t *ds){
-    btstack_linked_list_add(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+static void btstack_run_loop_base_timer_heap_set(uint16_t index, btstack_timer_source_t * ts){
+    btstack_run_loop_base_timer_heap[index] = ts;
+    ts->heap_index = index;
 }
 
-bool btstack_run_loop_base_remove_data_source(btstack_data_source_t *ds){
-    return btstack_linked_list_remove(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+static bool btstack_run_loop_base_timer_heap_contains(const btstack_timer_source_t * ts){
+    uint16_t index = ts->heap_index;
+    if (index >= btstack_run_loop_base_timer_heap_count) return false;
+    return btstack_run_loop_base_timer_heap[index] == ts;
 }
 
-void btstack_run_loop_base_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
-    ds->flags |= callback_types;
+static void btstack_run_loop_base_timer_heap_sift_up(uint16_t index){
+    btstack_timer_source_t * ts = btstack_run_loop_base_timer_heap[index];
+    while (index > 0){
+        uint16_t parent = (index - 1) / 2;
+        if (!btstack_run_loop_base_timer_before(ts, btstack_run_loop_base_timer_heap[parent])) break;
+        btstack_run_loop_base_timer_heap_set(index, btstack_run_loop_base_timer_heap[parent]);
+        index = parent;
+    }
+    btstack_run_loop_base_timer_heap_set(index, ts);
 }
 
-void btstack_run_loop_base_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
-    ds->flags &= ~callback_types;
+static void btstack_run_loop_base_timer_heap_sift_down(uint16_t index){
+    btstack_timer_source_t * ts = btstack_run_loop_base_timer_heap[index];
+    while (true){
+        uint16_t child = (2 * index) + 1;
+        if (child >= btstack_run_loop_base_timer_heap_count) break;
+        if (((child + 1) < btstack_run_loop_base_timer_heap_count) &&
+            btstack_run_loop_base_timer_before(btstack_run_loop_base_timer_heap[child + 1], btstack_run_loop_base_timer_heap[child])){
+            child++;
+        }
+        if (!btstack_run_loop_base_timer_before(btstack_run_loop_base_timer_heap[child], ts)) break;
+        btstack_run_loop_base_timer_heap_set(index, btstack_run_loop_base_timer_heap[child]);
+        index = child;
+    }
+    btstack_run_loop_base_timer_heap_set(index, ts);
 }
 
+static void btstack_run_loop_base_timer_heap_remove(btstack_timer_source_t * ts){
+    uint16_t index = ts->heap_index;
+    btstack_run_loop_base_timer_heap_count--;
+    if (index == btstack_run_loop_base_timer_heap_count) return;
+    // move last timer into the gap and restore heap order
+    btstack_timer_source_t * last = btstack_run_loop_base_timer_heap[btstack_run_loop_base_timer_heap_count];
+    btstack_run_loop_base_timer_heap_set(index, last);
+    btstack_run_loop_base_timer_heap_sift_up(index);
+    if (btstack_run_loop_base_timer_heap[index] == last){
+        btstack_run_loop_base_timer_heap_sift_down(index);
+    }
+}
 
-bool btstack_run_loop_base_remove_timer(btstack_timer_source_t *ts){
-    return btstack_linked_list_remove(&btstack_run_loop_base_timers, (btstack_linked_item_t *) ts);
+static bool btstack_run_loop_base_timer_list_contains(const btstack_timer_source_t * ts){
+    btstack_linked_item_t *it;
+    for (it = btstack_run_loop_base_timers; it != NULL; it = it->next){
+        if ((const btstack_timer_source_t *) it == ts) return true;
+    }
+    return false;
 }
+#endif
 
-void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
+static void btstack_run_loop_base_timer_list_add(btstack_timer_source_t * ts){
     btstack_linked_item_t *it;
     for (it = (btstack_linked_item_t *) &btstack_run_loop_base_timers; it->next ; it = it->next){
         // don't add timer that's already in there
@@ -96,24 +147,139 @@ void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
     it->next = (btstack_linked_item_t *) ts;
 }
 
+// get timer with earliest timeout
+static btstack_timer_source_t * btstack_run_loop_base_get_next_timer(void){
+    btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    if (btstack_run_loop_base_timer_heap_count > 0){
+        btstack_timer_source_t * heap_ts = btstack_run_loop_base_timer_heap[0];
+        if ((ts == NULL) || !btstack_run_loop_base_timer_before(ts, heap_ts)){
+            ts = heap_ts;
+        }
+    }
+#endif
+    return ts;
+}
+
+void btstack_run_loop_base_init(void){
+    btstack_run_loop_base_timers = NULL;
+    btstack_run_loop_base_timers_expired = NULL;
+    btstack_run_loop_base_data_sources = NULL;    
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    btstack_run_loop_base_timer_heap_count = 0;
+#endif
+}
+
+void btstack_run_loop_base_add_data_source(btstack_data_source_t *ds){
+    btstack_linked_list_add(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+}
+
+bool btstack_run_loop_base_remove_data_source(btstack_data_source_t *ds){
+    return btstack_linked_list_remove(&btstack_run_loop_base_data_sources, (btstack_linked_item_t *) ds);
+}
+
+void btstack_run_loop_base_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    ds->flags |= callback_types;
+}
+
+void btstack_run_loop_base_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callback_types){
+    ds->flags &= ~callback_types;
+}
+
+
+bool btstack_run_loop_base_remove_timer(btstack_timer_source_t *ts){
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    if (btstack_run_loop_base_timer_heap_contains(ts)){
+        btstack_run_loop_base_timer_heap_remove(ts);
+        return true;
+    }
+#endif
+    if (btstack_linked_list_remove(&btstack_run_loop_base_timers, (btstack_linked_item_t *) ts)) return true;
+    // timer might have expired but not processed yet
+    return btstack_linked_list_remove(&btstack_run_loop_base_timers_expired, (btstack_linked_item_t *) ts);
+}
+
+void btstack_run_loop_base_add_timer(btstack_timer_source_t *ts){
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    // don't add timer that's already in there, timers that did not fit into the heap are in the sorted list
+    if (btstack_run_loop_base_timer_heap_contains(ts) || btstack_run_loop_base_timer_list_contains(ts)){
+        log_error( "btstack_run_loop_timer_add error: timer to add already in list!");
+        return;
+    }
+#endif
+    // an expired timer that gets re-added before it has been processed is not processed in this round
+    btstack_linked_list_remove(&btstack_run_loop_base_timers_expired, (btstack_linked_item_t *) ts);
+
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    if (btstack_run_loop_base_timer_heap_count < RUN_LOOP_TIMER_HEAP_SIZE){
+        btstack_run_loop_base_timer_heap_set(btstack_run_loop_base_timer_heap_count, ts);
+        btstack_run_loop_base_timer_heap_count++;
+        btstack_run_loop_base_timer_heap_sift_up(ts->heap_index);
+        return;
+    }
+    // heap full, fall back to sorted list
+#endif
+    btstack_run_loop_base_timer_list_add(ts);
+}
+
 void  btstack_run_loop_base_process_timers(uint32_t now){
-    // process timers, exit when timeout is in the future
-    while (btstack_run_loop_base_timers) {
-        btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
+    // collect all expired timers first. Timers added by a timer handler are processed in the next call
+    btstack_linked_item_t * tail = NULL;
+    while (true){
+        btstack_timer_source_t * ts = btstack_run_loop_base_get_next_timer();
+        if (ts == NULL) break;
         int32_t delta = btstack_time_delta(ts->timeout, now);
         if (delta > 0) break;
-        btstack_run_loop_base_remove_timer(ts);
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+        if (btstack_run_loop_base_timer_heap_contains(ts)){
+            btstack_run_loop_base_timer_heap_remove(ts);
+        } else
+#endif
+        {
+            btstack_run_loop_base_timers = ts->item.next;
+        }
+        ts->item.next = NULL;
+        if (tail == NULL){
+            btstack_run_loop_base_timers_expired = (btstack_linked_item_t *) ts;
+        } else {
+            tail->next = (btstack_linked_item_t *) ts;
+        }
+        tail = (btstack_linked_item_t *) ts;
+    }
+
+    // process expired timers in order, timer handlers might remove other expired timers
+    while (btstack_run_loop_base_timers_expired){
+        btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers_expired;
+        btstack_run_loop_base_timers_expired = ts->item.next;
         ts->process(ts);
     }
 }
 
+void btstack_run_loop_base_dump_timer(void){
+#ifdef ENABLE_LOG_INFO
+    btstack_linked_item_t *it;
+    uint16_t i = 0;
+#ifdef ENABLE_RUN_LOOP_TIMER_HEAP
+    for (i = 0; i < btstack_run_loop_base_timer_heap_count; i++){
+        btstack_timer_source_t *ts = btstack_run_loop_base_timer_heap[i];
+        log_info("timer %u (%p): timeout %u\n", i, ts, (unsigned int) ts->timeout);
+    }
+#endif
+    for (it = (btstack_linked_item_t *) btstack_run_loop_base_timers; it ; it = it->next){
+        btstack_timer_source_t *ts = (btstack_timer_source_t*) it;
+        log_info("timer %u (%p): timeout %u\n", i, ts, (unsigned int) ts->timeout);
+        i++;
+    }
+#endif
+}
+
 /**
  * @brief Get time until first timer fires
  * @returns -1 if no timers, time until next timeout otherwise
  */
 int32_t btstack_run_loop_base_get_time_until_timeout(uint32_t now){
-    if (btstack_run_loop_base_timers == NULL) return -1;
-    btstack_timer_source_t * ts = (btstack_timer_source_t *) btstack_run_loop_base_timers;
+    btstack_timer_source_t * ts = btstack_run_loop_base_get_next_timer();
+    if (ts == NULL) return -1;
     uint32_t list_timeout  = ts->timeout;
     int32_t delta = btstack_time_delta(list_timeout, now);
     if (delta < 0){
@@ -77,11 +77,17 @@ void btstack_run_loop_base_add_timer(btstack_timer_source_t * timer);
 bool  btstack_run_loop_base_remove_timer(btstack_timer_source_t * timer);
 
 /**
- * @brief Process timers: remove expired timers from list and call their process function
+ * @brief Process timers: remove all expired timers from list and call their process function
+ * @note timers that are (re-)added by a process function are not processed before the next call
  * @param now
  */
 void  btstack_run_loop_base_process_timers(uint32_t now);
 
+/**
+ * @brief Dump timers using log_info
+ */
+void  btstack_run_loop_base_dump_timer(void);
+
 /**
  * @brief Get time until first timer fires
  * @returns -1 if no timers, time until next timeout otherwise
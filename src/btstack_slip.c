@@ -42,6 +42,8 @@
  *  SLIP encoder/decoder
  */
 
+#include <string.h>
+
 #include "btstack_slip.h"
 #include "btstack_debug.h"
 
@@ -218,6 +220,51 @@ void btstack_slip_decoder_process(uint8_t input){
     }
 }
 
+/**
+ * @brief Process chunk of received bytes. Stops after a complete frame has been decoded
+ * @param data
+ * @param len
+ * @return number of bytes consumed
+ */
+uint16_t btstack_slip_decoder_process_chunk(const uint8_t * data, uint16_t len){
+    uint16_t pos = 0;
+    while ((pos < len) && (decoder_state != SLIP_DECODER_COMPLETE)){
+        switch (decoder_state){
+            case SLIP_DECODER_UNKNOWN: {
+                // skip to next SOF
+                const uint8_t * sof = (const uint8_t *) memchr(&data[pos], BTSTACK_SLIP_SOF, len - pos);
+                if (sof == NULL){
+                    return len;
+                }
+                pos = (uint16_t) (sof - data);
+                break;
+            }
+            case SLIP_DECODER_ACTIVE: {
+                // copy run of bytes that don't need unescaping
+                uint16_t run_end = pos;
+                while ((run_end < len) && (data[run_end] != BTSTACK_SLIP_SOF) && (data[run_end] != 0xdbu)){
+                    run_end++;
+                }
+                uint16_t run_len = run_end - pos;
+                if (run_len == 0u) break;
+                if (run_len > (decoder_max_size - decoder_pos)){
+                    log_error("btstack_slip_decoder_process_chunk: packet to long");
+                    btstack_slip_decoder_reset();
+                } else {
+                    (void) memcpy(&decoder_buffer[decoder_pos], &data[pos], run_len);
+                    decoder_pos += run_len;
+                }
+                pos = run_end;
+                continue;
+            }
+            default:
+                break;
+        }
+        btstack_slip_decoder_process(data[pos++]);
+    }
+    return pos;
+}
+
 /**
  * @brief Get size of decoded frame
  * @return size of frame. Size = 0 => frame not complete
@@ -47,6 +47,8 @@
 
 #include <stdint.h>
 
+#include "btstack_defines.h"
+
 typedef struct {
     uint32_t   baudrate;
     int        flowcontrol;
@@ -143,6 +145,23 @@ typedef struct {
      */
     void (*set_wakeup_handler)(void (*wakeup_handler)(void));
 
+    /**
+     * send multiple blocks with a single operation, optional
+     * vectors have to stay valid until block sent callback is called
+     */
+    void (*send_block_vectored)(const btstack_iovec_t * vectors, uint16_t num_vectors);
+
+    /**
+     * set callback for bytes received via receive_bytes, optional. NULL disables callback
+     */
+    void (*set_bytes_received)(void (*bytes_handler)(uint16_t num_bytes));
+
+    /**
+     * receive up to max_len bytes, optional
+     * bytes received callback is called as soon as some bytes are available
+     */
+    void (*receive_bytes)(uint8_t *buffer, uint16_t max_len);
+
 } btstack_uart_block_t;
 
 // common implementations
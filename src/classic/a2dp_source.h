@@ -149,7 +149,7 @@ uint8_t a2dp_source_disconnect(uint16_t a2dp_cid);
 void 	a2dp_source_stream_endpoint_request_can_send_now(uint16_t a2dp_cid, uint8_t local_seid);
 
 /**
- * @brief Return maximal media payload size, does not include media header.
+ * @brief Return maximal media payload size, does not include media header and number of frames byte.
  * @param a2dp_cid 			A2DP channel identifyer.
  * @param local_seid  		ID of a local stream endpoint.
  * @return max_media_payload_size_without_media_header
@@ -164,7 +164,7 @@ int 	a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid);
  * @param num_bytes_to_copy
  * @param num_frames
  * @param marker
- * @return max_media_payload_size_without_media_header
+ * @return size of outgoing buffer or 0 if payload does not fit into it
  */
 int  	a2dp_source_stream_send_media_payload(uint16_t a2dp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker);
 
@@ -161,10 +161,10 @@ void avdtp_source_init(void) {
 }
 
 
-static void avdtp_source_setup_media_header(uint8_t * media_packet, int size, int *offset, uint8_t marker, uint16_t sequence_number){
+static uint8_t avdtp_source_setup_media_header(uint8_t * media_packet, int size, int *offset, uint8_t marker, uint16_t sequence_number){
     if (size < AVDTP_MEDIA_PAYLOAD_HEADER_SIZE){
         log_error("small outgoing buffer");
-        return;
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
     }
 
     uint8_t  rtp_version = 2;
@@ -189,12 +189,13 @@ static void avdtp_source_setup_media_header(uint8_t * media_packet, int size, in
     big_endian_store_32(media_packet, pos, ssrc); // only used for multicast
     pos += 4;
     *offset = pos;
+    return ERROR_CODE_SUCCESS;
 }
 
-static void avdtp_source_copy_media_payload(uint8_t * media_packet, int size, int * offset, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames){
-    if (size < (num_bytes_to_copy + 1)){
-        log_error("small outgoing buffer: buffer size %u, but need %u", size, num_bytes_to_copy + 1);
-        return;
+static uint8_t avdtp_source_copy_media_payload(uint8_t * media_packet, int size, int * offset, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames){
+    if (size < (*offset + num_bytes_to_copy + 1)){
+        log_error("small outgoing buffer: buffer size %u, but need %u", size, *offset + num_bytes_to_copy + 1);
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
     }
     
     int pos = *offset;
@@ -202,6 +203,7 @@ static void avdtp_source_copy_media_payload(uint8_t * media_packet, int size, in
     (void)memcpy(media_packet + pos, storage, num_bytes_to_copy);
     pos += num_bytes_to_copy;
     *offset = pos;
+    return ERROR_CODE_SUCCESS;
 }
 
 int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
@@ -224,8 +226,14 @@ int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_sei
     l2cap_reserve_packet_buffer();
     uint8_t * media_packet = l2cap_get_outgoing_buffer();
 
-    avdtp_source_setup_media_header(media_packet, size, &offset, marker, stream_endpoint->sequence_number);
-    avdtp_source_copy_media_payload(media_packet, size, &offset, storage, num_bytes_to_copy, num_frames);
+    uint8_t status = avdtp_source_setup_media_header(media_packet, size, &offset, marker, stream_endpoint->sequence_number);
+    if (status == ERROR_CODE_SUCCESS){
+        status = avdtp_source_copy_media_payload(media_packet, size, &offset, storage, num_bytes_to_copy, num_frames);
+    }
+    if (status != ERROR_CODE_SUCCESS){
+        l2cap_release_packet_buffer();
+        return 0;
+    }
     stream_endpoint->sequence_number++;
     l2cap_send_prepared(stream_endpoint->l2cap_media_cid, offset);
     return size;
@@ -256,5 +264,6 @@ int avdtp_max_media_payload_size(uint16_t avdtp_cid, uint8_t local_seid){
         log_error("A2DP source: no media connection for seid %d", local_seid);
         return 0;
     }  
-    return l2cap_get_remote_mtu_for_local_cid(stream_endpoint->l2cap_media_cid) - AVDTP_MEDIA_PAYLOAD_HEADER_SIZE;
+    // RTP header and SBC header with number of frames
+    return l2cap_get_remote_mtu_for_local_cid(stream_endpoint->l2cap_media_cid) - AVDTP_MEDIA_PAYLOAD_HEADER_SIZE - 1;
 }
@@ -239,7 +239,7 @@ avdtp_stream_endpoint_t * avdtp_source_create_stream_endpoint(avdtp_sep_type_t s
  * @param num_bytes_to_copy
  * @param num_frames
  * @param marker
- * @return max_media_payload_size_without_media_header
+ * @return size of outgoing buffer or 0 if payload does not fit into it
  */
 int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker);
 
@@ -251,7 +251,7 @@ int avdtp_source_stream_send_media_payload(uint16_t avdtp_cid, uint8_t local_sei
 void avdtp_source_stream_endpoint_request_can_send_now(uint16_t avddp_cid, uint8_t local_seid);
 
 /**
- * @brief Return maximal media payload size, does not include media header.
+ * @brief Return maximal media payload size, does not include media header and number of frames byte.
  * @param avdtp_cid         AVDTP channel identifyer.
  * @param local_seid        ID of a local stream endpoint.
  */
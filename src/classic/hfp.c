@@ -938,35 +938,54 @@ static hfp_command_entry_t hfp_hf_commmand_table[] = {
     { "RING",   HFP_CMD_RING },
 };
 
+// perfect hash: with multiplier 61, all commands of each table map to different slots, verified when tables are built
+#define HFP_COMMAND_HASH_TABLE_SIZE 128
+#define HFP_COMMAND_HASH_MULTIPLIER 61
+
+// command table index + 1 per slot, 0 = empty
+static uint8_t hfp_ag_command_hash_table[HFP_COMMAND_HASH_TABLE_SIZE];
+static uint8_t hfp_hf_command_hash_table[HFP_COMMAND_HASH_TABLE_SIZE];
+static bool    hfp_command_hash_tables_ready;
+
+static uint8_t hfp_command_hash(const char * command){
+    uint32_t hash = 0;
+    while (*command != 0){
+        hash = (hash * HFP_COMMAND_HASH_MULTIPLIER) + (uint8_t) *command++;
+    }
+    return (uint8_t) (hash & (HFP_COMMAND_HASH_TABLE_SIZE - 1u));
+}
+
+static void hfp_command_hash_table_init(uint8_t * hash_table, const hfp_command_entry_t * table, uint16_t num_entries){
+    memset(hash_table, 0, HFP_COMMAND_HASH_TABLE_SIZE);
+    uint16_t i;
+    for (i=0;i<num_entries;i++){
+        uint8_t slot = hfp_command_hash(table[i].command);
+        btstack_assert(hash_table[slot] == 0u);
+        hash_table[slot] = (uint8_t) (i + 1u);
+    }
+}
+
 static hfp_command_t parse_command(const char * line_buffer, int isHandsFree){
 
+    if (hfp_command_hash_tables_ready == false){
+        hfp_command_hash_table_init(hfp_ag_command_hash_table, hfp_ag_commmand_table, sizeof(hfp_ag_commmand_table) / sizeof(hfp_command_entry_t));
+        hfp_command_hash_table_init(hfp_hf_command_hash_table, hfp_hf_commmand_table, sizeof(hfp_hf_commmand_table) / sizeof(hfp_command_entry_t));
+        hfp_command_hash_tables_ready = true;
+    }
+
     // table lookup based on role
-    uint16_t num_entries;
-    hfp_command_entry_t * table;
+    const hfp_command_entry_t * table;
+    const uint8_t * hash_table;
     if (isHandsFree == 0){
         table = hfp_ag_commmand_table;
-        num_entries = sizeof(hfp_ag_commmand_table) / sizeof(hfp_command_entry_t);
+        hash_table = hfp_ag_command_hash_table;
     } else {
         table = hfp_hf_commmand_table;
-        num_entries = sizeof(hfp_hf_commmand_table) / sizeof(hfp_command_entry_t);
+        hash_table = hfp_hf_command_hash_table;
     }
-    // binary search
-    uint16_t left = 0;
-    uint16_t right = num_entries - 1;
-    while (left <= right){
-        uint16_t middle = left + (right - left) / 2;
-        hfp_command_entry_t *entry = &table[middle];
-        int match = strcmp(line_buffer, entry->command);
-        if (match < 0){
-            // search term is lower than middle element
-            if (right == 0) break;
-            right = middle - 1;
-        } else if (match == 0){
-            return entry->command_id;
-        } else {
-            // search term is higher than middle element
-            left = middle + 1;
-        }
+    uint8_t entry_index = hash_table[hfp_command_hash(line_buffer)];
+    if ((entry_index > 0u) && (strcmp(line_buffer, table[entry_index - 1u].command) == 0)){
+        return table[entry_index - 1u].command_id;
     }
 
     // note: if parser in CMD_HEADER state would treats digits and maybe '+' as separator, match on "ATD" would work.
@@ -993,6 +1012,14 @@ static void hfp_parser_store_byte(hfp_connection_t * hfp_connection, uint8_t byt
     hfp_connection->line_buffer[hfp_connection->line_size++] = byte;
     hfp_connection->line_buffer[hfp_connection->line_size] = 0;
 }
+static void hfp_parser_store_bytes(hfp_connection_t * hfp_connection, const uint8_t * data, uint16_t len){
+    if ((hfp_connection->line_size + 1 ) >= HFP_MAX_INDICATOR_DESC_SIZE) return;
+    uint16_t bytes_to_store = btstack_min(len, HFP_MAX_INDICATOR_DESC_SIZE - 1 - hfp_connection->line_size);
+    (void)memcpy(&hfp_connection->line_buffer[hfp_connection->line_size], data, bytes_to_store);
+    hfp_connection->line_size += bytes_to_store;
+    hfp_connection->line_buffer[hfp_connection->line_size] = 0;
+}
+
 static int hfp_parser_is_buffer_empty(hfp_connection_t * hfp_connection){
     return hfp_connection->line_size == 0;
 }
@@ -1238,6 +1265,75 @@ void hfp_parse(hfp_connection_t * hfp_connection, uint8_t byte, int isHandsFree)
     }
 }
 
+// number of bytes without end of line that hfp_parse_byte would only store in line buffer
+static uint16_t hfp_parser_plain_bytes(hfp_connection_t * hfp_connection, const uint8_t * data, uint16_t len){
+    uint16_t pos;
+    if (hfp_connection->parser_quoted){
+        for (pos = 0; pos < len; pos++){
+            if (data[pos] == '"') break;
+        }
+        return pos;
+    }
+    if (hfp_connection->parser_state == HFP_PARSER_CMD_HEADER){
+        if (hfp_connection->found_equal_sign) return 0;
+        for (pos = 0; pos < len; pos++){
+            switch (data[pos]){
+                case '"':
+                case ';':
+                case ':':
+                case '?':
+                case '=':
+                    return pos;
+                default:
+                    break;
+            }
+        }
+        return pos;
+    }
+    for (pos = 0; pos < len; pos++){
+        switch (data[pos]){
+            case '"':
+            case ' ':
+            case ',':
+            case ';':
+            case '(':
+            case ')':
+                return pos;
+            default:
+                break;
+        }
+    }
+    return pos;
+}
+
+uint16_t hfp_parse_line(hfp_connection_t * hfp_connection, const uint8_t * data, uint16_t len, int isHandsFree){
+    // find end of line
+    uint16_t text_len = len;
+    const uint8_t * end_of_line = (const uint8_t *) memchr(data, '\n', len);
+    if (end_of_line != NULL){
+        text_len = (uint16_t) (end_of_line - data);
+    }
+    end_of_line = (const uint8_t *) memchr(data, '\r', text_len);
+    if (end_of_line != NULL){
+        text_len = (uint16_t) (end_of_line - data);
+    }
+    uint16_t line_len = (text_len < len) ? (text_len + 1u) : len;
+
+    // store runs of plain bytes at once, process all others incl. end of line byte-wise
+    uint16_t pos = 0;
+    while (pos < line_len){
+        uint16_t plain_bytes = (pos < text_len) ? hfp_parser_plain_bytes(hfp_connection, &data[pos], text_len - pos) : 0u;
+        if (plain_bytes > 0u){
+            hfp_parser_store_bytes(hfp_connection, &data[pos], plain_bytes);
+            pos += plain_bytes;
+            continue;
+        }
+        hfp_parse(hfp_connection, data[pos], isHandsFree);
+        pos++;
+    }
+    return line_len;
+}
+
 static void parse_sequence(hfp_connection_t * hfp_connection){
     int value;
     switch (hfp_connection->command){
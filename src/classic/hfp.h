@@ -673,6 +673,9 @@ hfp_connection_t * get_hfp_connection_context_for_acl_handle(uint16_t handle, hf
 btstack_linked_list_t * hfp_get_connections(void);
 void hfp_parse(hfp_connection_t * connection, uint8_t byte, int isHandsFree);
 
+// parse data up to and including first end of line, same as calling hfp_parse for each byte, returns number of bytes processed
+uint16_t hfp_parse_line(hfp_connection_t * connection, const uint8_t * data, uint16_t len, int isHandsFree);
+
 void hfp_establish_service_level_connection(bd_addr_t bd_addr, uint16_t service_uuid, hfp_role_t local_role);
 void hfp_release_service_level_connection(hfp_connection_t * connection);
 void hfp_reset_context_flags(hfp_connection_t * connection);
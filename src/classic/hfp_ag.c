@@ -1850,13 +1850,13 @@ static void hfp_ag_handle_rfcomm_data(uint8_t packet_type, uint16_t channel, uin
     
     hfp_log_rfcomm_message("HFP_AG_RX", packet, size);
     
-    // process messages byte-wise
-    int pos;
-    for (pos = 0; pos < size ; pos++){
-        hfp_parse(hfp_connection, packet[pos], 0);
+    // process messages line by line
+    uint16_t pos = 0;
+    while (pos < size){
+        pos += hfp_parse_line(hfp_connection, &packet[pos], size - pos, 0);
 
         // parse until end of line
-        if (!hfp_parser_is_end_of_line(packet[pos])) continue;
+        if (!hfp_parser_is_end_of_line(packet[pos - 1])) continue;
 
         hfp_generic_status_indicator_t * indicator;
         switch(hfp_connection->command){
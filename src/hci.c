@@ -281,17 +281,53 @@ void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
     btstack_linked_list_iterator_init(it, &hci_stack->connections);
 }
 
+static void hci_connection_lookup_add(hci_connection_t * conn){
+    // use first free slot in probe sequence, replace entry in first slot if table is full
+    unsigned int index = conn->con_handle % HCI_CONNECTION_LOOKUP_TABLE_SIZE;
+    unsigned int i;
+    for (i = 0; i < HCI_CONNECTION_LOOKUP_TABLE_SIZE; i++){
+        hci_connection_t ** entry = &hci_stack->connection_lookup_table[(index + i) % HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+        if (*entry == NULL){
+            *entry = conn;
+            return;
+        }
+    }
+    hci_stack->connection_lookup_table[index] = conn;
+}
+
+static void hci_connection_lookup_remove(hci_connection_t * conn){
+    // con handle might have changed since entry was stored
+    int i;
+    for (i = 0; i < HCI_CONNECTION_LOOKUP_TABLE_SIZE; i++){
+        if (hci_stack->connection_lookup_table[i] == conn){
+            hci_stack->connection_lookup_table[i] = NULL;
+        }
+    }
+}
+
 /**
  * get connection for a given handle
  *
  * @return connection OR NULL, if not found
  */
 hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
+    // check lookup table first, probe sequence ends at free slot
+    unsigned int index = con_handle % HCI_CONNECTION_LOOKUP_TABLE_SIZE;
+    unsigned int i;
+    for (i = 0; i < HCI_CONNECTION_LOOKUP_TABLE_SIZE; i++){
+        hci_connection_t * entry = hci_stack->connection_lookup_table[(index + i) % HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+        if (entry == NULL) break;
+        if (entry->con_handle == con_handle) return entry;
+    }
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->connections);
     while (btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * item = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
         if ( item->con_handle == con_handle ) {
+            // con handle is assigned after connection was created, only store valid ones
+            if (con_handle != HCI_CON_HANDLE_INVALID){
+                hci_connection_lookup_add(item);
+            }
             return item;
         }
     } 
@@ -452,7 +488,19 @@ static int nr_hci_connections(void){
     return count;
 }
 
-static int hci_number_free_acl_slots_for_connection_type(bd_addr_type_t address_type){
+// number of ACL packets sent to the controller, and - if requested - queued in the outgoing packet pool
+static unsigned int hci_number_outstanding_acl_packets(hci_connection_t * connection, bool include_queued){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    if (include_queued){
+        return connection->num_packets_sent + connection->num_packets_queued;
+    }
+#else
+    UNUSED(include_queued);
+#endif
+    return connection->num_packets_sent;
+}
+
+static int hci_number_free_acl_slots(bd_addr_type_t address_type, bool include_queued){
     
     unsigned int num_packets_sent_classic = 0;
     unsigned int num_packets_sent_le = 0;
@@ -461,10 +509,10 @@ static int hci_number_free_acl_slots_for_connection_type(bd_addr_type_t address_
     for (it = (btstack_linked_item_t *) hci_stack->connections; it != NULL; it = it->next){
         hci_connection_t * connection = (hci_connection_t *) it;
         if (hci_is_le_connection(connection)){
-            num_packets_sent_le += connection->num_packets_sent;
+            num_packets_sent_le += hci_number_outstanding_acl_packets(connection, include_queued);
         }
         if (connection->address_type == BD_ADDR_TYPE_ACL){
-            num_packets_sent_classic += connection->num_packets_sent;
+            num_packets_sent_classic += hci_number_outstanding_acl_packets(connection, include_queued);
         }
     }
     log_debug("ACL classic buffers: %u used of %u", num_packets_sent_classic, hci_stack->acl_packets_total_num);
@@ -508,6 +556,11 @@ static int hci_number_free_acl_slots_for_connection_type(bd_addr_type_t address_
     }
 }
 
+// free ACL slots for new packets, packets queued in outgoing packet pool are counted as sent
+static int hci_number_free_acl_slots_for_connection_type(bd_addr_type_t address_type){
+    return hci_number_free_acl_slots(address_type, true);
+}
+
 int hci_number_free_acl_slots_for_handle(hci_con_handle_t con_handle){
     // get connection type
     hci_connection_t * connection = hci_connection_for_handle(con_handle);
@@ -573,33 +626,95 @@ static int hci_transport_can_send_prepared_packet_now(uint8_t packet_type){
     return hci_stack->hci_transport->can_send_packet_now(packet_type);
 }
 
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+static hci_outgoing_packet_t * hci_outgoing_packet_get_free(void){
+    int i;
+    for (i=0;i<HCI_OUTGOING_PACKET_BUFFER_NUM;i++){
+        if (hci_stack->outgoing_packets[i].in_use == 0u) {
+            return &hci_stack->outgoing_packets[i];
+        }
+    }
+    return NULL;
+}
+
+static void hci_outgoing_packet_free(hci_outgoing_packet_t * outgoing_packet){
+    outgoing_packet->in_use = 0;
+}
+
+static void hci_outgoing_packets_reset(void){
+    int i;
+    for (i=0;i<HCI_OUTGOING_PACKET_BUFFER_NUM;i++){
+        hci_outgoing_packet_free(&hci_stack->outgoing_packets[i]);
+    }
+    hci_stack->outgoing_packet_reserved = NULL;
+    hci_stack->outgoing_packet_active = NULL;
+    hci_stack->outgoing_packet_last_con_handle = HCI_CON_HANDLE_INVALID;
+    hci_stack->hci_packet_buffer = &hci_stack->hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+}
+
+static void hci_connection_drop_queued_acl_packets(hci_connection_t * connection){
+    while (true){
+        hci_outgoing_packet_t * outgoing_packet = (hci_outgoing_packet_t *) btstack_linked_list_pop(&connection->acl_packets_queued);
+        if (outgoing_packet == NULL) break;
+        hci_outgoing_packet_free(outgoing_packet);
+    }
+    connection->num_packets_queued = 0;
+}
+#endif
+
+// checks if the outgoing packet buffer - or one from the outgoing packet pool - can be reserved
+static int hci_can_reserve_packet_buffer(void){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    if (hci_stack->outgoing_packet_reserved != NULL) return 0;
+    return hci_outgoing_packet_get_free() != NULL;
+#else
+    return hci_stack->hci_packet_buffer_reserved == 0u;
+#endif
+}
+
+// checks if the next ACL fragment can be sent to the controller
+static int hci_can_send_acl_fragment_now(hci_connection_t * connection){
+    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
+    return hci_number_free_acl_slots(connection->address_type, false) > 0;
+}
+
 static int hci_can_send_prepared_acl_packet_for_address_type(bd_addr_type_t address_type){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM == 1
+    // with outgoing packet pool, prepared packets are queued until transport is ready
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
+#endif
     return hci_number_free_acl_slots_for_connection_type(address_type) > 0;
 }
 
 int hci_can_send_acl_le_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (!hci_can_reserve_packet_buffer()) return 0;
     return hci_can_send_prepared_acl_packet_for_address_type(BD_ADDR_TYPE_LE_PUBLIC);
 }
 
 int hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle) {
+#if HCI_OUTGOING_PACKET_BUFFER_NUM == 1
+    // with outgoing packet pool, prepared packets are queued until transport is ready
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
+#endif
     return hci_number_free_acl_slots_for_handle(con_handle) > 0;
 }
 
 int hci_can_send_acl_packet_now(hci_con_handle_t con_handle){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (!hci_can_reserve_packet_buffer()) return 0;
     return hci_can_send_prepared_acl_packet_now(con_handle);
 }
 
 #ifdef ENABLE_CLASSIC
 int hci_can_send_acl_classic_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (!hci_can_reserve_packet_buffer()) return 0;
     return hci_can_send_prepared_acl_packet_for_address_type(BD_ADDR_TYPE_ACL);
 }
 
 int hci_can_send_prepared_sco_packet_now(void){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    // SCO packets are sent directly, transport must not be used by command or ACL packet
+    if (hci_stack->hci_packet_buffer_reserved) return 0;
+#endif
     if (!hci_transport_can_send_prepared_packet_now(HCI_SCO_DATA_PACKET)) return 0;
     if (hci_have_usb_transport()){
         return hci_stack->sco_can_send_now;
@@ -609,7 +724,7 @@ int hci_can_send_prepared_sco_packet_now(void){
 }
 
 int hci_can_send_sco_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (!hci_can_reserve_packet_buffer()) return 0;
     return hci_can_send_prepared_sco_packet_now();
 }
 
@@ -621,11 +736,15 @@ void hci_request_sco_can_send_now_event(void){
 
 // used for internal checks in l2cap.c
 int hci_is_packet_buffer_reserved(void){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    return hci_stack->outgoing_packet_reserved != NULL;
+#else
     return hci_stack->hci_packet_buffer_reserved;
+#endif
 }
 
-// reserves outgoing packet buffer. @returns 1 if successful
-int hci_reserve_packet_buffer(void){
+// reserves hci packet buffer used by the transport. @returns 1 if successful
+static int hci_reserve_transport_buffer(void){
     if (hci_stack->hci_packet_buffer_reserved) {
         log_error("hci_reserve_packet_buffer called but buffer already reserved");
         return 0;
@@ -634,8 +753,46 @@ int hci_reserve_packet_buffer(void){
     return 1;    
 }
 
-void hci_release_packet_buffer(void){
+static void hci_release_transport_buffer(void){
     hci_stack->hci_packet_buffer_reserved = 0;
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    // return packet to pool and use command buffer again
+    if (hci_stack->outgoing_packet_active != NULL){
+        hci_outgoing_packet_free(hci_stack->outgoing_packet_active);
+        hci_stack->outgoing_packet_active = NULL;
+        hci_stack->hci_packet_buffer = &hci_stack->hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    }
+#endif
+}
+
+// reserves outgoing packet buffer. @returns 1 if successful
+int hci_reserve_packet_buffer(void){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    if (hci_stack->outgoing_packet_reserved != NULL) {
+        log_error("hci_reserve_packet_buffer called but buffer already reserved");
+        return 0;
+    }
+    hci_outgoing_packet_t * outgoing_packet = hci_outgoing_packet_get_free();
+    if (outgoing_packet == NULL){
+        log_error("hci_reserve_packet_buffer called but no free outgoing packet buffer");
+        return 0;
+    }
+    outgoing_packet->in_use = 1;
+    hci_stack->outgoing_packet_reserved = outgoing_packet;
+    return 1;
+#else
+    return hci_reserve_transport_buffer();
+#endif
+}
+
+void hci_release_packet_buffer(void){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    if (hci_stack->outgoing_packet_reserved == NULL) return;
+    hci_outgoing_packet_free(hci_stack->outgoing_packet_reserved);
+    hci_stack->outgoing_packet_reserved = NULL;
+#else
+    hci_release_transport_buffer();
+#endif
 }
 
 // assumption: synchronous implementations don't provide can_send_packet_now as they don't keep the buffer after the call
@@ -643,6 +800,114 @@ static int hci_transport_synchronous(void){
     return hci_stack->hci_transport->can_send_packet_now == NULL;
 }
 
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+static void hci_dump_acl_fragment(const uint8_t * header, uint8_t * payload, uint16_t payload_len){
+    // temporarily place header in front of payload for contiguous packet log
+    uint8_t saved_data[HCI_ACL_HEADER_SIZE];
+    uint8_t * packet = payload - HCI_ACL_HEADER_SIZE;
+    (void)memcpy(saved_data, packet, HCI_ACL_HEADER_SIZE);
+    (void)memcpy(packet, header, HCI_ACL_HEADER_SIZE);
+    hci_dump_packet(HCI_ACL_DATA_PACKET, 0, packet, payload_len + HCI_ACL_HEADER_SIZE);
+    (void)memcpy(packet, saved_data, HCI_ACL_HEADER_SIZE);
+}
+
+// send all fragments that fit into available controller buffers with a single transport operation
+static int hci_send_acl_packet_fragments_vectored(hci_connection_t *connection, uint16_t max_acl_data_packet_length){
+
+    const uint16_t handle_and_flags = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
+    const uint16_t total_size = hci_stack->acl_fragmentation_total_size;
+    uint16_t fragment_positions[HCI_ACL_FRAGMENTS_VECTORED_MAX];
+
+    while (true){
+
+        int max_fragments = hci_number_free_acl_slots(connection->address_type, false);
+        if (max_fragments > HCI_ACL_FRAGMENTS_VECTORED_MAX){
+            max_fragments = HCI_ACL_FRAGMENTS_VECTORED_MAX;
+        }
+
+        // collect fragments, payload stays in packet buffer, headers are stored separately
+        int num_fragments = 0;
+        do {
+            uint16_t fragment_pos = hci_stack->acl_fragmentation_pos;
+            uint16_t fragment_len = hci_stack->acl_fragmentation_total_size - fragment_pos;
+            if (fragment_len > max_acl_data_packet_length){
+                fragment_len = max_acl_data_packet_length;
+            }
+
+            // update packet boundary flags to be 01 (continuing fragment) if not first fragment
+            uint16_t fragment_handle_and_flags = handle_and_flags;
+            if (fragment_pos > HCI_ACL_HEADER_SIZE){
+                fragment_handle_and_flags = (handle_and_flags & 0xcfffu) | (1u << 12u);
+            }
+            fragment_positions[num_fragments] = fragment_pos;
+            uint8_t * header  = hci_stack->acl_fragment_headers[num_fragments];
+            uint8_t * payload = &hci_stack->hci_packet_buffer[fragment_pos];
+            little_endian_store_16(header, 0, fragment_handle_and_flags);
+            little_endian_store_16(header, 2, fragment_len);
+            hci_dump_acl_fragment(header, payload, fragment_len);
+
+            hci_stack->acl_fragment_vectors[2 * num_fragments].data     = header;
+            hci_stack->acl_fragment_vectors[2 * num_fragments].len      = HCI_ACL_HEADER_SIZE;
+            hci_stack->acl_fragment_vectors[2 * num_fragments + 1].data = payload;
+            hci_stack->acl_fragment_vectors[2 * num_fragments + 1].len  = fragment_len;
+            num_fragments++;
+
+            // count packet
+            connection->num_packets_sent++;
+
+            // update state for next fragment (if any)
+            fragment_pos += fragment_len;
+            if (fragment_pos < hci_stack->acl_fragmentation_total_size){
+                hci_stack->acl_fragmentation_pos = fragment_pos;
+            } else {
+                // done
+                hci_stack->acl_fragmentation_pos = 0;
+                hci_stack->acl_fragmentation_total_size = 0;
+            }
+        } while ((hci_stack->acl_fragmentation_total_size > 0u) && (num_fragments < max_fragments));
+
+        log_debug("hci_send_acl_packet_fragments_vectored send %u fragments", num_fragments);
+
+        // send fragments
+        hci_stack->acl_fragmentation_tx_active = 1;
+        int num_fragments_sent = hci_stack->hci_transport->send_packet_vectored(HCI_ACL_DATA_PACKET, hci_stack->acl_fragment_vectors, 2 * num_fragments);
+
+        if (num_fragments_sent < num_fragments){
+            log_error("hci_send_acl_packet_fragments_vectored: transport accepted only %u of %u fragments", num_fragments_sent, num_fragments);
+            if (num_fragments_sent <= 0){
+                // transport failed, drop remaining fragments
+                connection->num_packets_sent -= num_fragments;
+                hci_stack->acl_fragmentation_tx_active = 0;
+                hci_stack->acl_fragmentation_pos = 0;
+                hci_stack->acl_fragmentation_total_size = 0;
+                hci_release_transport_buffer();
+                hci_emit_transport_packet_sent();
+                return ERROR_CODE_HARDWARE_FAILURE;
+            }
+            // fragments not accepted are sent again when transport is ready
+            connection->num_packets_sent -= num_fragments - num_fragments_sent;
+            hci_stack->acl_fragmentation_pos = fragment_positions[num_fragments_sent];
+            hci_stack->acl_fragmentation_total_size = total_size;
+        }
+
+        // done yet?
+        if (hci_stack->acl_fragmentation_total_size == 0u) break;
+
+        // can send more?
+        if (!hci_can_send_acl_fragment_now(connection)) return 0;
+    }
+
+    // release buffer now for synchronous transport
+    if (hci_transport_synchronous()){
+        hci_stack->acl_fragmentation_tx_active = 0;
+        hci_release_transport_buffer();
+        hci_emit_transport_packet_sent();
+    }
+
+    return 0;
+}
+#endif
+
 static int hci_send_acl_packet_fragments(hci_connection_t *connection){
 
     // log_info("hci_send_acl_packet_fragments  %u/%u (con 0x%04x)", hci_stack->acl_fragmentation_pos, hci_stack->acl_fragmentation_total_size, connection->con_handle);
@@ -659,6 +924,12 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
     }
 #endif
 
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+    if (hci_stack->hci_transport->send_packet_vectored != NULL){
+        return hci_send_acl_packet_fragments_vectored(connection, max_acl_data_packet_length);
+    }
+#endif
+
     log_debug("hci_send_acl_packet_fragments entered");
 
     int err;
@@ -715,7 +986,7 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
         if (!more_fragments) break;
 
         // can send more?
-        if (!hci_can_send_prepared_acl_packet_now(connection->con_handle)) return err;
+        if (!hci_can_send_acl_fragment_now(connection)) return err;
     }
 
     log_debug("hci_send_acl_packet_fragments loop over");
@@ -723,13 +994,59 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
     // release buffer now for synchronous transport
     if (hci_transport_synchronous()){
         hci_stack->acl_fragmentation_tx_active = 0;
-        hci_release_packet_buffer();
+        hci_release_transport_buffer();
         hci_emit_transport_packet_sent();
     }
 
     return err;
 }
 
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+static bool hci_run_acl_queues(void);
+
+// pre: caller has reserved a packet buffer from the outgoing packet pool
+int hci_send_acl_packet_buffer(int size){
+
+    hci_outgoing_packet_t * outgoing_packet = hci_stack->outgoing_packet_reserved;
+    if (outgoing_packet == NULL) {
+        log_error("hci_send_acl_packet_buffer called without reserving packet buffer");
+        return 0;
+    }
+
+    hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(&outgoing_packet->data[HCI_OUTGOING_PRE_BUFFER_SIZE]);
+    hci_connection_t *connection = hci_connection_for_handle( con_handle);
+    if (!connection) {
+        log_error("hci_send_acl_packet_buffer called but no connection for handle 0x%04x", con_handle);
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+        return 0;
+    }
+
+    // check for free places on Bluetooth module, including already queued packets
+    if (hci_number_free_acl_slots_for_connection_type(connection->address_type) <= 0) {
+        log_error("hci_send_acl_packet_buffer called but no free ACL buffers on controller");
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+        return BTSTACK_ACL_BUFFERS_FULL;
+    }
+
+#ifdef ENABLE_CLASSIC
+    hci_connection_timestamp(connection);
+#endif
+
+    // queue packet, buffer is owned by connection until sent
+    hci_stack->outgoing_packet_reserved = NULL;
+    outgoing_packet->size = size;
+    btstack_linked_list_add_tail(&connection->acl_packets_queued, (btstack_linked_item_t *) outgoing_packet);
+    connection->num_packets_queued++;
+
+    // send now if transport is idle
+    (void) hci_run_acl_queues();
+    return 0;
+}
+
+#else
+
 // pre: caller has reserved the packet buffer
 int hci_send_acl_packet_buffer(int size){
 
@@ -771,6 +1088,7 @@ int hci_send_acl_packet_buffer(int size){
 
     return hci_send_acl_packet_fragments(connection);
 }
+#endif
 
 #ifdef ENABLE_CLASSIC
 // pre: caller has reserved the packet buffer
@@ -778,12 +1096,12 @@ int hci_send_sco_packet_buffer(int size){
 
     // log_info("hci_send_acl_packet_buffer size %u", size);
 
-    if (!hci_stack->hci_packet_buffer_reserved) {
+    if (!hci_is_packet_buffer_reserved()) {
         log_error("hci_send_acl_packet_buffer called without reserving packet buffer");
         return 0;
     }
 
-    uint8_t * packet = hci_stack->hci_packet_buffer;
+    uint8_t * packet = hci_get_outgoing_packet_buffer();
 
     // skip checks in loopback mode
     if (!hci_stack->loopback_mode){
@@ -818,11 +1136,19 @@ int hci_send_sco_packet_buffer(int size){
         }
     }
 
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    // hand packet over to transport
+    hci_stack->hci_packet_buffer_reserved = 1;
+    hci_stack->outgoing_packet_active = hci_stack->outgoing_packet_reserved;
+    hci_stack->outgoing_packet_reserved = NULL;
+    hci_stack->hci_packet_buffer = packet;
+#endif
+
     hci_dump_packet( HCI_SCO_DATA_PACKET, 0, packet, size);
     int err = hci_stack->hci_transport->send_packet(HCI_SCO_DATA_PACKET, packet, size);
 
     if (hci_transport_synchronous()){
-        hci_release_packet_buffer();
+        hci_release_transport_buffer();
         hci_emit_transport_packet_sent();
     }
 
@@ -943,8 +1269,14 @@ static void hci_shutdown_connection(hci_connection_t *conn){
 #endif
 
     btstack_run_loop_remove_timer(&conn->timeout);
+
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    hci_connection_drop_queued_acl_packets(conn);
+#endif
     
     btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+    hci_connection_lookup_remove(conn);
+    
     btstack_memory_hci_connection_free( conn );
     
     // now it's gone
@@ -1014,6 +1346,11 @@ uint16_t hci_usable_acl_packet_types(void){
 #endif
 
 uint8_t* hci_get_outgoing_packet_buffer(void){
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    if (hci_stack->outgoing_packet_reserved != NULL){
+        return &hci_stack->outgoing_packet_reserved->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+    }
+#endif
     // hci packet buffer is >= acl data packet length
     return hci_stack->hci_packet_buffer;
 }
@@ -1403,7 +1740,7 @@ static void hci_initializing_run(void){
             break;
         case HCI_INIT_WRITE_LOCAL_NAME: {
             hci_stack->substate = HCI_INIT_W4_WRITE_LOCAL_NAME;
-            hci_reserve_packet_buffer();
+            hci_reserve_transport_buffer();
             uint8_t * packet = hci_stack->hci_packet_buffer;
             // construct HCI Command and send
             uint16_t opcode = hci_write_local_name.opcode;
@@ -1419,11 +1756,16 @@ static void hci_initializing_run(void){
             // expand '00:00:00:00:00:00' in name with bd_addr
             btstack_replace_bd_addr_placeholder(&packet[3], bytes_to_copy, hci_stack->local_bd_addr);
             hci_send_cmd_packet(packet, HCI_CMD_HEADER_SIZE + DEVICE_NAME_LEN);
+            // release packet buffer for synchronous transport implementations
+            if (hci_transport_synchronous()){
+                hci_release_transport_buffer();
+                hci_emit_transport_packet_sent();
+            }
             break;
         }
         case HCI_INIT_WRITE_EIR_DATA: {
             hci_stack->substate = HCI_INIT_W4_WRITE_EIR_DATA;
-            hci_reserve_packet_buffer();
+            hci_reserve_transport_buffer();
             uint8_t * packet = hci_stack->hci_packet_buffer;
             // construct HCI Command in-place and send
             uint16_t opcode = hci_write_extended_inquiry_response.opcode;
@@ -1461,6 +1803,11 @@ static void hci_initializing_run(void){
                 btstack_replace_bd_addr_placeholder(&packet[offset], bytes_to_copy, hci_stack->local_bd_addr);
             }
             hci_send_cmd_packet(packet, HCI_CMD_HEADER_SIZE + 1 + EXTENDED_INQUIRY_RESPONSE_DATA_LEN);
+            // release packet buffer for synchronous transport implementations
+            if (hci_transport_synchronous()){
+                hci_release_transport_buffer();
+                hci_emit_transport_packet_sent();
+            }
             break;
         }
         case HCI_INIT_WRITE_INQUIRY_MODE:
@@ -1883,6 +2230,7 @@ static void hci_handle_connection_failed(hci_connection_t * conn, uint8_t status
     
     // connection failed, remove entry
     btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+    hci_connection_lookup_remove(conn);
     btstack_memory_hci_connection_free( conn );
 
 #ifdef ENABLE_CLASSIC
@@ -2538,13 +2886,17 @@ static void event_handler(uint8_t *packet, uint16_t size){
                     hci_stack->acl_fragmentation_total_size = 0;
                     hci_stack->acl_fragmentation_pos = 0;
                     if (release_buffer){
-                        hci_release_packet_buffer();
+                        hci_release_transport_buffer();
                     }
                 }
             }
 
             conn = hci_connection_for_handle(handle);
             if (!conn) break;
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+            // drop queued ACL packets
+            hci_connection_drop_queued_acl_packets(conn);
+#endif
             // mark connection for shutdown
             conn->state = RECEIVED_DISCONNECTION_COMPLETE;
 
@@ -2593,7 +2945,7 @@ static void event_handler(uint8_t *packet, uint16_t size){
             }
             hci_stack->acl_fragmentation_tx_active = 0;
             if (hci_stack->acl_fragmentation_total_size) break;
-            hci_release_packet_buffer();
+            hci_release_transport_buffer();
             
             // L2CAP receives this event via the hci_emit_event below
 
@@ -2656,6 +3008,7 @@ static void event_handler(uint8_t *packet, uint16_t size){
                         // remove entry
                         if (conn){
                             btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+                            hci_connection_lookup_remove(conn);
                             btstack_memory_hci_connection_free( conn );
                         }
                         break;
@@ -2910,6 +3263,20 @@ static void packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
  * @brief Add event packet handler. 
  */
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    callback_handler->event_codes = NULL;
+    (void)memset(hci_stack->event_codes_subscribed, 0xff, HCI_EVENT_CODE_BITMAP_LEN);
+    btstack_linked_list_add_tail(&hci_stack->event_handlers, (btstack_linked_item_t*) callback_handler);
+}
+
+/**
+ * @brief Add event packet handler that only receives events with the event codes set in bitmap
+ */
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+    callback_handler->event_codes = event_codes;
+    uint16_t i;
+    for (i = 0; i < HCI_EVENT_CODE_BITMAP_LEN; i++){
+        hci_stack->event_codes_subscribed[i] |= event_codes[i];
+    }
     btstack_linked_list_add_tail(&hci_stack->event_handlers, (btstack_linked_item_t*) callback_handler);
 }
 
@@ -2931,6 +3298,7 @@ void hci_register_sco_packet_handler(btstack_packet_handler_t handler){
 static void hci_state_reset(void){
     // no connections yet
     hci_stack->connections = NULL;
+    (void)memset(hci_stack->connection_lookup_table, 0, sizeof(hci_stack->connection_lookup_table));
 
     // keep discoverable/connectable as this has been requested by the client(s)
     // hci_stack->discoverable = 0;
@@ -2940,6 +3308,9 @@ static void hci_state_reset(void){
 
     // buffer is free
     hci_stack->hci_packet_buffer_reserved = 0;
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    hci_outgoing_packets_reset();
+#endif
 
     // no pending cmds
     hci_stack->decline_reason = 0;
@@ -3274,6 +3645,9 @@ static void hci_power_transition_to_initializing(void){
     // set up state machine
     hci_stack->num_cmd_packets = 1; // assume that one cmd can be sent
     hci_stack->hci_packet_buffer_reserved = 0;
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    hci_outgoing_packets_reset();
+#endif
     hci_stack->state = HCI_STATE_INITIALIZING;
     hci_stack->substate = HCI_INIT_SEND_RESET;
 }
@@ -3456,8 +3830,8 @@ void gap_local_bd_addr(bd_addr_t address_buffer){
 static void hci_host_num_completed_packets(void){
 
     // create packet manually as arrays are not supported and num_commands should not get reduced
-    hci_reserve_packet_buffer();
-    uint8_t * packet = hci_get_outgoing_packet_buffer();
+    hci_reserve_transport_buffer();
+    uint8_t * packet = hci_stack->hci_packet_buffer;
 
     uint16_t size = 0;
     uint16_t num_handles = 0;
@@ -3491,7 +3865,7 @@ static void hci_host_num_completed_packets(void){
 
     // release packet buffer for synchronous transport implementations    
     if (hci_transport_synchronous()){
-        hci_release_packet_buffer();
+        hci_release_transport_buffer();
         hci_emit_transport_packet_sent();
     }
 }
@@ -3510,7 +3884,7 @@ static bool hci_run_acl_fragments(void){
         hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(hci_stack->hci_packet_buffer);
         hci_connection_t *connection = hci_connection_for_handle(con_handle);
         if (connection) {
-            if (hci_can_send_prepared_acl_packet_now(con_handle)){
+            if (hci_can_send_acl_fragment_now(connection)){
                 hci_send_acl_packet_fragments(connection);
                 return true;
             }
@@ -3524,6 +3898,54 @@ static bool hci_run_acl_fragments(void){
     return false;
 }
 
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+static bool hci_run_acl_queues(void){
+    // transport busy with command, SCO or ACL fragments?
+    if (hci_stack->hci_packet_buffer_reserved) return false;
+    if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return false;
+
+    // round robin: select next connection with queued packets after the one served last
+    hci_connection_t * first_connection = NULL;
+    hci_connection_t * next_connection  = NULL;
+    bool last_connection_seen = false;
+    btstack_linked_item_t * it;
+    for (it = (btstack_linked_item_t *) hci_stack->connections; it != NULL; it = it->next){
+        hci_connection_t * connection = (hci_connection_t *) it;
+        if ((connection->acl_packets_queued != NULL) && hci_can_send_acl_fragment_now(connection)){
+            if (first_connection == NULL){
+                first_connection = connection;
+            }
+            if (last_connection_seen){
+                next_connection = connection;
+                break;
+            }
+        }
+        if (connection->con_handle == hci_stack->outgoing_packet_last_con_handle){
+            last_connection_seen = true;
+        }
+    }
+    if (next_connection == NULL){
+        next_connection = first_connection;
+    }
+    if (next_connection == NULL) return false;
+
+    // transport owns packet until sent
+    hci_outgoing_packet_t * outgoing_packet = (hci_outgoing_packet_t *) btstack_linked_list_pop(&next_connection->acl_packets_queued);
+    next_connection->num_packets_queued--;
+    hci_stack->outgoing_packet_last_con_handle = next_connection->con_handle;
+    hci_stack->hci_packet_buffer_reserved = 1;
+    hci_stack->outgoing_packet_active = outgoing_packet;
+    hci_stack->hci_packet_buffer = &outgoing_packet->data[HCI_OUTGOING_PRE_BUFFER_SIZE];
+
+    // setup data
+    hci_stack->acl_fragmentation_total_size = outgoing_packet->size;
+    hci_stack->acl_fragmentation_pos = 4;   // start of L2CAP packet
+
+    hci_send_acl_packet_fragments(next_connection);
+    return true;
+}
+#endif
+
 #ifdef ENABLE_CLASSIC
 static bool hci_run_general_gap_classic(void){
 
@@ -4005,6 +4427,12 @@ static void hci_run(void){
     // send continuation fragments first, as they block the prepared packet buffer
     done = hci_run_acl_fragments();
     if (done) return;
+
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    // start next queued ACL packet
+    done = hci_run_acl_queues();
+    if (done) return;
+#endif
     
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     // send host num completed packets next as they don't require num_cmd_packets > 0
@@ -4380,14 +4808,14 @@ int hci_send_cmd_va_arg(const hci_cmd_t *cmd, va_list argptr){
     // log_info("hci_send_cmd: opcode %04x", cmd->opcode);
     hci_stack->last_cmd_opcode = cmd->opcode;
 
-    hci_reserve_packet_buffer();
+    hci_reserve_transport_buffer();
     uint8_t * packet = hci_stack->hci_packet_buffer;
     uint16_t size = hci_cmd_create_from_template(packet, cmd, argptr);
     int err = hci_send_cmd_packet(packet, size);
 
     // release packet buffer on error or for synchronous transport implementations
     if ((err < 0) || hci_transport_synchronous()){
-        hci_release_packet_buffer();
+        hci_release_transport_buffer();
         hci_emit_transport_packet_sent();
     }
 
@@ -4408,17 +4836,28 @@ int hci_send_cmd(const hci_cmd_t *cmd, ...){
 // Create various non-HCI events. 
 // TODO: generalize, use table similar to hci_create_command
 
+static bool hci_event_code_bitmap_matches(const uint8_t * event_codes, const uint8_t * event, uint16_t size){
+    uint8_t event_code = hci_event_packet_get_type(event);
+    if (!hci_event_code_bitmap_is_set(event_codes, event_code)) return false;
+    if ((event_code != HCI_EVENT_LE_META) || (size < 3u)) return true;
+    return hci_event_code_bitmap_is_le_subevent_set(event_codes, hci_event_le_meta_get_subevent_code(event));
+}
+
 static void hci_emit_event(uint8_t * event, uint16_t size, int dump){
     // dump packet
     if (dump) {
         hci_dump_packet( HCI_EVENT_PACKET, 0, event, size);
     } 
 
-    // dispatch to all event handlers
+    // skip handler list if no handler is subscribed to event code
+    if (!hci_event_code_bitmap_matches(hci_stack->event_codes_subscribed, event, size)) return;
+
+    // dispatch to all subscribed event handlers
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->event_handlers);
     while (btstack_linked_list_iterator_has_next(&it)){
         btstack_packet_callback_registration_t * entry = (btstack_packet_callback_registration_t*) btstack_linked_list_iterator_next(&it);
+        if ((entry->event_codes != NULL) && !hci_event_code_bitmap_matches(entry->event_codes, event, size)) continue;
         entry->callback(HCI_EVENT_PACKET, 0, event, size);
     }
 }
@@ -4945,6 +5384,7 @@ uint8_t gap_connect_cancel(void){
             // skip sending create connection and emit event instead
             hci_emit_le_connection_complete(conn->address_type, conn->address, 0, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
             btstack_linked_list_remove(&hci_stack->connections, (btstack_linked_item_t *) conn);
+            hci_connection_lookup_remove(conn);
             btstack_memory_hci_connection_free( conn );
             break;            
         case SENT_CREATE_CONNECTION:
@@ -5700,6 +6140,7 @@ void hci_free_connections_fuzz(void){
     while (btstack_linked_list_iterator_has_next(&it)){
         hci_connection_t * con = (hci_connection_t*) btstack_linked_list_iterator_next(&it);
         btstack_linked_list_iterator_remove(&it);
+        hci_connection_lookup_remove(con);
         btstack_memory_hci_connection_free(con);
     }
 }
@@ -140,6 +140,30 @@ extern "C" {
 #endif
 #endif
 
+// number of outgoing packet buffers. with more than one buffer, prepared ACL packets are queued per connection
+#ifndef HCI_OUTGOING_PACKET_BUFFER_NUM
+#define HCI_OUTGOING_PACKET_BUFFER_NUM 1
+#endif
+
+// size of con handle indexed lookup tables for HCI connections and GATT Client contexts
+// tables use linear probing, twice the max number of connections keeps probe sequences short
+#ifndef HCI_CONNECTION_LOOKUP_TABLE_SIZE
+#if defined(MAX_NR_HCI_CONNECTIONS) && (MAX_NR_HCI_CONNECTIONS > 8)
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE (2 * MAX_NR_HCI_CONNECTIONS)
+#else
+#define HCI_CONNECTION_LOOKUP_TABLE_SIZE 16
+#endif
+#endif
+
+// max number of ACL fragments passed to hci_transport_t.send_packet_vectored at once
+#ifndef HCI_ACL_FRAGMENTS_VECTORED_MAX
+#define HCI_ACL_FRAGMENTS_VECTORED_MAX 8
+#endif
+
+// size of event code bitmap for hci_add_event_handler_for_event_codes: 256 event codes followed by 256 LE Meta subevents
+#define HCI_EVENT_CODE_BITMAP_LEN 64
+#define HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET 32
+
 // BNEP may uncompress the IP Header by 16 bytes, GATT Client requires two additional bytes for long characteristic reads
 #ifndef HCI_INCOMING_PRE_BUFFER_SIZE
 #ifdef ENABLE_CLASSIC
@@ -447,6 +471,9 @@ typedef struct {
 
     att_connection_t        connection;
 
+    // first octet of Client Supported Features characteristic written by client
+    uint8_t                 client_supported_features;
+
     btstack_linked_list_t   notification_requests;
     btstack_linked_list_t   indication_requests;
 
@@ -475,6 +502,20 @@ typedef struct {
 } l2cap_state_t;
 #endif
 
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+// outgoing packet from pool, queued in hci_connection_t until sent
+typedef struct {
+    // linked list - assert: first field
+    btstack_linked_item_t item;
+
+    uint8_t  in_use;
+    uint16_t size;
+
+    // HCI packet + additional prebuffer for H4 drivers
+    uint8_t  data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
+} hci_outgoing_packet_t;
+#endif
+
 //
 typedef struct {
     // linked list - assert: first field
@@ -551,6 +592,12 @@ typedef struct {
     // number packets sent to controller
     uint8_t num_packets_sent;
 
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    // prepared ACL packets waiting for transport and controller buffers
+    btstack_linked_list_t acl_packets_queued;
+    uint8_t num_packets_queued;
+#endif
+
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     uint8_t num_packets_completed;
 #endif
@@ -749,6 +796,9 @@ typedef struct {
     // list of existing baseband connections
     btstack_linked_list_t     connections;
 
+    // con handle indexed lookup table for connections list, validated on access
+    hci_connection_t *        connection_lookup_table[HCI_CONNECTION_LOOKUP_TABLE_SIZE];
+
     /* callback to L2CAP layer */
     btstack_packet_handler_t acl_packet_handler;
 
@@ -758,6 +808,9 @@ typedef struct {
     /* callbacks for events */
     btstack_linked_list_t event_handlers;
 
+    /* union of event codes of all event handlers */
+    uint8_t event_codes_subscribed[HCI_EVENT_CODE_BITMAP_LEN];
+
 #ifdef ENABLE_CLASSIC
     /* callback for reject classic connection */
     int (*gap_classic_accept_callback)(bd_addr_t addr);
@@ -787,12 +840,25 @@ typedef struct {
 #endif
 
     // single buffer for HCI packet assembly + additional prebuffer for H4 drivers
+    // with outgoing packet pool: buffer for HCI commands or pointer to packet currently owned by the transport
     uint8_t   * hci_packet_buffer;
     uint8_t   hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
     uint8_t   hci_packet_buffer_reserved;
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+    // pool of outgoing ACL/SCO packets
+    hci_outgoing_packet_t   outgoing_packets[HCI_OUTGOING_PACKET_BUFFER_NUM];
+    hci_outgoing_packet_t * outgoing_packet_reserved;
+    hci_outgoing_packet_t * outgoing_packet_active;
+    hci_con_handle_t        outgoing_packet_last_con_handle;
+#endif
     uint16_t  acl_fragmentation_pos;
     uint16_t  acl_fragmentation_total_size;
     uint8_t   acl_fragmentation_tx_active;
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+    // headers of ACL fragments, payload is sent directly from packet buffer
+    uint8_t         acl_fragment_headers[HCI_ACL_FRAGMENTS_VECTORED_MAX][HCI_ACL_HEADER_SIZE];
+    btstack_iovec_t acl_fragment_vectors[2 * HCI_ACL_FRAGMENTS_VECTORED_MAX];
+#endif
      
     /* host to controller flow control */
     uint8_t  num_cmd_packets;
@@ -1026,6 +1092,95 @@ void hci_close(void);
  */
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler);
 
+/**
+ * @brief Add event packet handler that only receives events with the event codes set in bitmap
+ * @note HCI_EVENT_LE_META events are only delivered if their subevent is set in the bitmap as well
+ * @note bitmap needs to stay valid and must not be changed after registration
+ * @param callback_handler
+ * @param event_codes bitmap of HCI_EVENT_CODE_BITMAP_LEN bytes, see hci_event_code_bitmap_set
+ */
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes);
+
+/**
+ * @brief Add event code to bitmap for hci_add_event_handler_for_event_codes
+ * @note HCI_EVENT_LE_META also adds all LE Meta subevents, see hci_event_code_bitmap_set_le_subevent
+ * @param event_codes bitmap
+ * @param event_code
+ */
+static inline void hci_event_code_bitmap_set(uint8_t * event_codes, uint8_t event_code){
+    event_codes[event_code >> 3] |= (uint8_t) (1u << (event_code & 7u));
+    if (event_code == HCI_EVENT_LE_META){
+        (void)memset(&event_codes[HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET], 0xff, HCI_EVENT_CODE_BITMAP_LEN - HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET);
+    }
+}
+
+/**
+ * @brief Remove event code from bitmap for hci_add_event_handler_for_event_codes
+ * @note HCI_EVENT_LE_META also removes all LE Meta subevents
+ * @param event_codes bitmap
+ * @param event_code
+ */
+static inline void hci_event_code_bitmap_clear(uint8_t * event_codes, uint8_t event_code){
+    event_codes[event_code >> 3] &= (uint8_t) ~(1u << (event_code & 7u));
+    if (event_code == HCI_EVENT_LE_META){
+        (void)memset(&event_codes[HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET], 0, HCI_EVENT_CODE_BITMAP_LEN - HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET);
+    }
+}
+
+/**
+ * @brief Check if event code is set in bitmap
+ * @param event_codes bitmap
+ * @param event_code
+ * @return true if set
+ */
+static inline bool hci_event_code_bitmap_is_set(const uint8_t * event_codes, uint8_t event_code){
+    return (event_codes[event_code >> 3] & (1u << (event_code & 7u))) != 0u;
+}
+
+/**
+ * @brief Add single LE Meta subevent to bitmap for hci_add_event_handler_for_event_codes
+ * @param event_codes bitmap
+ * @param subevent_code
+ */
+static inline void hci_event_code_bitmap_set_le_subevent(uint8_t * event_codes, uint8_t subevent_code){
+    event_codes[HCI_EVENT_LE_META >> 3] |= (uint8_t) (1u << (HCI_EVENT_LE_META & 7u));
+    event_codes[HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET + (subevent_code >> 3)] |= (uint8_t) (1u << (subevent_code & 7u));
+}
+
+/**
+ * @brief Remove single LE Meta subevent from bitmap for hci_add_event_handler_for_event_codes
+ * @param event_codes bitmap
+ * @param subevent_code
+ */
+static inline void hci_event_code_bitmap_clear_le_subevent(uint8_t * event_codes, uint8_t subevent_code){
+    event_codes[HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET + (subevent_code >> 3)] &= (uint8_t) ~(1u << (subevent_code & 7u));
+}
+
+/**
+ * @brief Check if LE Meta subevent is set in bitmap
+ * @param event_codes bitmap
+ * @param subevent_code
+ * @return true if set
+ */
+static inline bool hci_event_code_bitmap_is_le_subevent_set(const uint8_t * event_codes, uint8_t subevent_code){
+    return (event_codes[HCI_EVENT_CODE_BITMAP_LE_SUBEVENT_OFFSET + (subevent_code >> 3)] & (1u << (subevent_code & 7u))) != 0u;
+}
+
+/**
+ * @brief Add all event codes except for inquiry results and advertising reports to bitmap
+ * @param event_codes bitmap
+ */
+static inline void hci_event_code_bitmap_set_all_except_scan_results(uint8_t * event_codes){
+    (void)memset(event_codes, 0xff, HCI_EVENT_CODE_BITMAP_LEN);
+    hci_event_code_bitmap_clear(event_codes, HCI_EVENT_INQUIRY_RESULT);
+    hci_event_code_bitmap_clear(event_codes, HCI_EVENT_INQUIRY_RESULT_WITH_RSSI);
+    hci_event_code_bitmap_clear(event_codes, HCI_EVENT_EXTENDED_INQUIRY_RESPONSE);
+    hci_event_code_bitmap_clear(event_codes, GAP_EVENT_INQUIRY_RESULT);
+    hci_event_code_bitmap_clear(event_codes, GAP_EVENT_ADVERTISING_REPORT);
+    hci_event_code_bitmap_clear_le_subevent(event_codes, HCI_SUBEVENT_LE_ADVERTISING_REPORT);
+    hci_event_code_bitmap_clear_le_subevent(event_codes, HCI_SUBEVENT_LE_DIRECT_ADVERTISING_REPORT);
+}
+
 /**
  * @brief Registers a packet handler for ACL data. Used by L2CAP
  */
@@ -44,6 +44,8 @@
  *
  *  - BlueZ's hcidump format
  *  - Apple's PacketLogger
+ *  - btsnoop (RFC 1761)
+ *  - pcapng
  *  - stdout hexdump
  *
  */
@@ -59,6 +61,7 @@
 #include "hci_cmd.h"
 #include "btstack_run_loop.h"
 #include <stdio.h>
+#include <string.h>
 
 #ifdef HAVE_POSIX_FILE_IO
 #include <fcntl.h>        // open
@@ -68,6 +71,26 @@
 #include <sys/stat.h>     // for mode flags
 #endif
 
+#ifdef ENABLE_HCI_DUMP_ASYNC
+#ifndef HAVE_POSIX_FILE_IO
+#error "ENABLE_HCI_DUMP_ASYNC requires HAVE_POSIX_FILE_IO"
+#endif
+#include <pthread.h>
+
+// size of ring buffer for formatted records, must be power of two
+#ifndef HCI_DUMP_ASYNC_BUFFER_SIZE
+#define HCI_DUMP_ASYNC_BUFFER_SIZE 65536
+#endif
+#if (HCI_DUMP_ASYNC_BUFFER_SIZE & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1)) != 0
+#error "HCI_DUMP_ASYNC_BUFFER_SIZE must be power of two"
+#endif
+
+// writer thread checks for new records with this period if idle
+#ifndef HCI_DUMP_ASYNC_WRITER_PERIOD_MS
+#define HCI_DUMP_ASYNC_WRITER_PERIOD_MS 20
+#endif
+#endif
+
 #ifdef ENABLE_SEGGER_RTT
 #include "SEGGER_RTT.h"
 
@@ -108,12 +131,50 @@ typedef struct {
 pktlog_hdr;
 #define PKTLOG_HDR_SIZE 13
 
+// btsnoop - file header: "btsnoop\0", version 1, datalink 1002 (HCI UART H4) - big endian
+// record: original length, included length, flags, cumulative drops, timestamp in us since 0 AD, H4 packet type
+#define BTSNOOP_FILE_HDR_SIZE 16
+#define BTSNOOP_HDR_SIZE 25
+#define BTSNOOP_DATALINK_HCI_UART 1002
+#define BTSNOOP_EPOCH_DELTA_HI 0x00dcddb3UL
+#define BTSNOOP_EPOCH_DELTA_LO 0x0f2f8000UL
+
+// pcapng - Section Header and Interface Description Block with LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR - little endian
+// Enhanced Packet Block: type, total length, interface, timestamp high/low, captured/original length, direction, H4 packet type
+// log messages are stored as Enhanced Packet Block without data and with opt_comment
+#define PCAPNG_FILE_HDR_SIZE (28 + 20)
+#define PCAPNG_EPB_HDR_SIZE 28
+#define PCAPNG_HDR_SIZE (PCAPNG_EPB_HDR_SIZE + 5)
+#define PCAPNG_TRAILER_MAX_SIZE (3 + 4 + 4)
+#define PCAPNG_LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR 201
+
+#define HCI_DUMP_MAX_HDR_SIZE PCAPNG_HDR_SIZE
+#define HCI_DUMP_MAX_FILE_NAME_LEN 256
+
+// while async writer is active, dump_file only marks dumping as active, the file is owned by the writer thread
 static int dump_file = -1;
 static int dump_format;
 #ifdef HAVE_POSIX_FILE_IO
 static char time_string[40];
+static char dump_file_name[HCI_DUMP_MAX_FILE_NAME_LEN];
 static int  max_nr_packets = -1;
 static int  nr_packets = 0;
+static uint32_t max_file_size;
+static uint32_t file_size;  // only accessed by Bluetooth thread
+#endif
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+// lock-free single producer / single consumer ring buffer. positions are free running
+static uint8_t   async_buffer[HCI_DUMP_ASYNC_BUFFER_SIZE];
+static uint32_t  async_write_pos;       // only modified by Bluetooth thread
+static uint32_t  async_read_pos;        // only modified by writer thread
+static uint32_t  async_rotate_pos;      // write position where next file starts
+static int       async_rotate_pending;  // set by Bluetooth thread, cleared by writer thread
+static int       async_writer_stop;
+static int       async_writer_active;
+static uint32_t  async_dropped_records;
+static pthread_t async_writer_thread;
+static int       async_dump_file = -1;  // only accessed by writer thread while active
 #endif
 
 #if defined(HAVE_POSIX_FILE_IO) || defined (ENABLE_SEGGER_RTT)
@@ -123,6 +184,180 @@ static char log_message_buffer[256];
 // levels: debug, info, error
 static int log_level_enabled[3] = { 1, 1, 1};
 
+#ifdef HAVE_POSIX_FILE_IO
+
+static void hci_dump_write_all(int fd, const uint8_t * data, uint32_t len){
+    if (fd < 0) return;
+    while (len > 0u){
+        ssize_t res = write(fd, data, len);
+        if (res <= 0) return;
+        data += res;
+        len  -= (uint32_t) res;
+    }
+}
+
+static uint16_t hci_dump_file_header_len(void){
+    switch (dump_format){
+        case HCI_DUMP_BTSNOOP:
+            return BTSNOOP_FILE_HDR_SIZE;
+        case HCI_DUMP_PCAPNG:
+            return PCAPNG_FILE_HDR_SIZE;
+        default:
+            return 0;
+    }
+}
+
+// does not update file_size as it is also used by the async writer thread
+static void hci_dump_write_file_header(int fd){
+    uint8_t header[PCAPNG_FILE_HDR_SIZE];
+    uint16_t header_len = hci_dump_file_header_len();
+    switch (dump_format){
+        case HCI_DUMP_BTSNOOP:
+            (void) memcpy(header, "btsnoop", 8);
+            big_endian_store_32(header,  8, 1);
+            big_endian_store_32(header, 12, BTSNOOP_DATALINK_HCI_UART);
+            break;
+        case HCI_DUMP_PCAPNG:
+            // Section Header Block, section length not specified
+            little_endian_store_32(header,  0, 0x0A0D0D0A);
+            little_endian_store_32(header,  4, 28);
+            little_endian_store_32(header,  8, 0x1A2B3C4D);
+            little_endian_store_16(header, 12, 1);
+            little_endian_store_16(header, 14, 0);
+            little_endian_store_32(header, 16, 0xffffffffUL);
+            little_endian_store_32(header, 20, 0xffffffffUL);
+            little_endian_store_32(header, 24, 28);
+            // Interface Description Block, no snap length, microsecond resolution
+            little_endian_store_32(header, 28, 1);
+            little_endian_store_32(header, 32, 20);
+            little_endian_store_16(header, 36, PCAPNG_LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR);
+            little_endian_store_16(header, 38, 0);
+            little_endian_store_32(header, 40, 0);
+            little_endian_store_32(header, 44, 20);
+            break;
+        default:
+            break;
+    }
+    hci_dump_write_all(fd, header, header_len);
+}
+
+// keep previous file as <filename>.1 and continue with new file, returns new fd
+static int hci_dump_rotate_file(int fd){
+    char old_file_name[HCI_DUMP_MAX_FILE_NAME_LEN + 2];
+    if (fd >= 0){
+        close(fd);
+    }
+    snprintf(old_file_name, sizeof(old_file_name), "%s.1", dump_file_name);
+    (void) rename(dump_file_name, old_file_name);
+    int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef _WIN32
+    oflags |= O_BINARY;
+#endif
+    fd = open(dump_file_name, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+    if (fd < 0) return fd;
+    hci_dump_write_file_header(fd);
+    return fd;
+}
+
+#endif
+
+#ifdef ENABLE_HCI_DUMP_ASYNC
+
+// write [async_read_pos, end) to file
+static void hci_dump_async_write_range(uint32_t end){
+    while (async_read_pos != end){
+        uint32_t index = async_read_pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1u);
+        uint32_t bytes_to_write = btstack_min(end - async_read_pos, HCI_DUMP_ASYNC_BUFFER_SIZE - index);
+        hci_dump_write_all(async_dump_file, &async_buffer[index], bytes_to_write);
+        __atomic_store_n(&async_read_pos, async_read_pos + bytes_to_write, __ATOMIC_RELEASE);
+    }
+}
+
+static void * hci_dump_async_writer(void * context){
+    UNUSED(context);
+    while (true){
+        int stop = __atomic_load_n(&async_writer_stop, __ATOMIC_ACQUIRE);
+        uint32_t write_pos = __atomic_load_n(&async_write_pos, __ATOMIC_ACQUIRE);
+        uint32_t end = write_pos;
+        bool rotate = false;
+        if (__atomic_load_n(&async_rotate_pending, __ATOMIC_ACQUIRE) != 0){
+            if ((async_rotate_pos - async_read_pos) <= (write_pos - async_read_pos)){
+                end = async_rotate_pos;
+                rotate = true;
+            }
+        }
+        bool idle = (end == async_read_pos) && !rotate;
+        hci_dump_async_write_range(end);
+        if (rotate){
+            async_dump_file = hci_dump_rotate_file(async_dump_file);
+            __atomic_store_n(&async_rotate_pending, 0, __ATOMIC_RELEASE);
+            continue;
+        }
+        if (!idle) continue;
+        if (stop != 0) break;
+        struct timespec period = { 0, HCI_DUMP_ASYNC_WRITER_PERIOD_MS * 1000000L };
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+static uint32_t hci_dump_async_store(uint32_t write_pos, const uint8_t * data, uint16_t len){
+    while (len > 0u){
+        uint32_t index = write_pos & (HCI_DUMP_ASYNC_BUFFER_SIZE - 1u);
+        uint32_t bytes_to_copy = btstack_min(len, HCI_DUMP_ASYNC_BUFFER_SIZE - index);
+        (void) memcpy(&async_buffer[index], data, bytes_to_copy);
+        write_pos += bytes_to_copy;
+        data += bytes_to_copy;
+        len  -= bytes_to_copy;
+    }
+    return write_pos;
+}
+
+// store complete record or drop it
+static bool hci_dump_async_queue_record(const uint8_t * header, uint16_t header_len, const uint8_t * packet, uint16_t len, const uint8_t * trailer, uint16_t trailer_len){
+    uint32_t record_len = header_len + len + trailer_len;
+    uint32_t read_pos   = __atomic_load_n(&async_read_pos, __ATOMIC_ACQUIRE);
+    uint32_t free_space = HCI_DUMP_ASYNC_BUFFER_SIZE - (async_write_pos - read_pos);
+    if (record_len > free_space){
+        async_dropped_records++;
+        return false;
+    }
+    uint32_t write_pos = async_write_pos;
+    write_pos = hci_dump_async_store(write_pos, header, header_len);
+    write_pos = hci_dump_async_store(write_pos, packet, len);
+    write_pos = hci_dump_async_store(write_pos, trailer, trailer_len);
+    // publish record
+    __atomic_store_n(&async_write_pos, write_pos, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void hci_dump_async_start(void){
+    // hand file over to writer thread
+    async_dump_file = dump_file;
+    async_write_pos = 0;
+    async_read_pos = 0;
+    async_rotate_pending = 0;
+    async_writer_stop = 0;
+    async_dropped_records = 0;
+    async_writer_active = pthread_create(&async_writer_thread, NULL, &hci_dump_async_writer, NULL) == 0;
+    if (!async_writer_active){
+        async_dump_file = -1;
+        printf("hci_dump_open: failed to start writer thread, writing synchronously\n");
+    }
+}
+
+static void hci_dump_async_stop(void){
+    if (!async_writer_active) return;
+    __atomic_store_n(&async_writer_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(async_writer_thread, NULL);
+    async_writer_active = false;
+    // take file back from writer thread
+    dump_file = async_dump_file;
+    async_dump_file = -1;
+}
+
+#endif
+
 void hci_dump_open(const char *filename, hci_dump_format_t format){
 
     dump_format = format;
@@ -139,7 +374,17 @@ void hci_dump_open(const char *filename, hci_dump_format_t format){
         dump_file = open(filename, oflags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
         if (dump_file < 0){
             printf("hci_dump_open: failed to open file %s\n", filename);
+            return;
         }
+        // remember file name for rotation
+        strncpy(dump_file_name, filename, sizeof(dump_file_name) - 1u);
+        dump_file_name[sizeof(dump_file_name) - 1u] = 0;
+        nr_packets = 0;
+        hci_dump_write_file_header(dump_file);
+        file_size = hci_dump_file_header_len();
+#ifdef ENABLE_HCI_DUMP_ASYNC
+        hci_dump_async_start();
+#endif
     }
 #else
 
@@ -164,7 +409,19 @@ void hci_dump_open(const char *filename, hci_dump_format_t format){
 void hci_dump_set_max_packets(int packets){
     max_nr_packets = packets;
 }
+
+void hci_dump_set_max_file_size(uint32_t max_size){
+    max_file_size = max_size;
+}
+#endif
+
+uint32_t hci_dump_get_dropped_records(void){
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    return async_dropped_records;
+#else
+    return 0;
 #endif
+}
 
 static void hci_dump_packetlogger_setup_header(uint8_t * buffer, uint32_t tv_sec, uint32_t tv_us, uint8_t packet_type, uint8_t in, uint16_t len){
     big_endian_store_32( buffer, 0, PKTLOG_HDR_SIZE - 4 + len);
@@ -202,6 +459,109 @@ static void hci_dump_bluez_setup_header(uint8_t * buffer, uint32_t tv_sec, uint3
     buffer[12] = packet_type;
 }
 
+#ifdef HAVE_POSIX_FILE_IO
+static uint16_t hci_dump_btsnoop_setup_header(uint8_t * buffer, uint32_t tv_sec, uint32_t tv_us, uint8_t packet_type, uint8_t in, uint16_t len, uint32_t drops){
+    uint32_t flags = in ? 1u : 0u;
+    if ((packet_type == HCI_COMMAND_DATA_PACKET) || (packet_type == HCI_EVENT_PACKET)){
+        flags |= 2u;
+    }
+    // timestamp in us since 0 AD: tv_sec * 1000000 + tv_us + epoch delta
+    uint64_t timestamp = ((uint64_t) tv_sec * 1000000u) + tv_us + ((((uint64_t) BTSNOOP_EPOCH_DELTA_HI) << 32) | BTSNOOP_EPOCH_DELTA_LO);
+    big_endian_store_32( buffer,  0, 1u + len);
+    big_endian_store_32( buffer,  4, 1u + len);
+    big_endian_store_32( buffer,  8, flags);
+    big_endian_store_32( buffer, 12, drops);
+    big_endian_store_32( buffer, 16, (uint32_t) (timestamp >> 32));
+    big_endian_store_32( buffer, 20, (uint32_t) timestamp);
+    buffer[24] = packet_type;
+    return BTSNOOP_HDR_SIZE;
+}
+
+static uint16_t hci_dump_pcapng_setup_header(uint8_t * buffer, uint8_t * trailer, uint16_t * trailer_len, uint32_t tv_sec, uint32_t tv_us, uint8_t packet_type, uint8_t in, uint16_t len){
+    uint64_t timestamp = ((uint64_t) tv_sec * 1000000u) + tv_us;
+    uint16_t header_len;
+    uint16_t data_len;
+    uint16_t pos = 0;
+    if (packet_type == LOG_MESSAGE_PACKET){
+        // no packet data, message as opt_comment followed by opt_endofopt
+        header_len = PCAPNG_EPB_HDR_SIZE + 4u;
+        data_len   = 0;
+        little_endian_store_16(buffer, PCAPNG_EPB_HDR_SIZE,      1);
+        little_endian_store_16(buffer, PCAPNG_EPB_HDR_SIZE + 2u, len);
+    } else {
+        // direction pseudo header and H4 packet type
+        header_len = PCAPNG_HDR_SIZE;
+        data_len   = 5u + len;
+        big_endian_store_32(buffer, PCAPNG_EPB_HDR_SIZE, in ? 1u : 0u);
+        buffer[PCAPNG_EPB_HDR_SIZE + 4u] = packet_type;
+    }
+    // pad to 32 bit
+    uint16_t padding = (4u - ((header_len + len) & 3u)) & 3u;
+    while (pos < padding){
+        trailer[pos++] = 0;
+    }
+    if (packet_type == LOG_MESSAGE_PACKET){
+        little_endian_store_32(trailer, pos, 0);
+        pos += 4u;
+    }
+    uint32_t total_len = header_len + len + pos + 4u;
+    little_endian_store_32(trailer, pos, total_len);
+    pos += 4u;
+    *trailer_len = pos;
+
+    little_endian_store_32(buffer,  0, 6);
+    little_endian_store_32(buffer,  4, total_len);
+    little_endian_store_32(buffer,  8, 0);
+    little_endian_store_32(buffer, 12, (uint32_t) (timestamp >> 32));
+    little_endian_store_32(buffer, 16, (uint32_t) timestamp);
+    little_endian_store_32(buffer, 20, data_len);
+    little_endian_store_32(buffer, 24, data_len);
+    return header_len;
+}
+
+// start next file if max packets or max file size would be exceeded
+static void hci_dump_check_rotation(uint32_t record_len){
+    if (dump_format == HCI_DUMP_STDOUT) return;
+    bool max_packets_reached = (max_nr_packets > 0) && (nr_packets >= max_nr_packets);
+    bool max_size_reached    = (max_file_size > 0u) && (nr_packets > 0) && ((file_size + record_len) > max_file_size);
+    if (!max_packets_reached && !max_size_reached) return;
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    if (async_writer_active){
+        // previous rotation not done by writer thread yet, try again with next record
+        if (__atomic_load_n(&async_rotate_pending, __ATOMIC_ACQUIRE) != 0) return;
+        async_rotate_pos = async_write_pos;
+        __atomic_store_n(&async_rotate_pending, 1, __ATOMIC_RELEASE);
+        // file header is written by writer thread
+        file_size = hci_dump_file_header_len();
+        nr_packets = 0;
+        return;
+    }
+#endif
+    dump_file = hci_dump_rotate_file(dump_file);
+    file_size = hci_dump_file_header_len();
+    nr_packets = 0;
+}
+
+static void hci_dump_write_record(const uint8_t * header, uint16_t header_len, const uint8_t * packet, uint16_t len, const uint8_t * trailer, uint16_t trailer_len){
+    uint32_t record_len = header_len + len + trailer_len;
+    hci_dump_check_rotation(record_len);
+    if (dump_file < 0) return;
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    if (async_writer_active){
+        if (hci_dump_async_queue_record(header, header_len, packet, len, trailer, trailer_len) == false) return;
+        nr_packets++;
+        file_size += record_len;
+        return;
+    }
+#endif
+    hci_dump_write_all(dump_file, header, header_len);
+    hci_dump_write_all(dump_file, packet, len);
+    hci_dump_write_all(dump_file, trailer, trailer_len);
+    nr_packets++;
+    file_size += record_len;
+}
+#endif
+
 static void printf_packet(uint8_t packet_type, uint8_t in, uint8_t * packet, uint16_t len){
     switch (packet_type){
         case HCI_COMMAND_DATA_PACKET:
@@ -264,27 +624,15 @@ static void printf_timestamp(void){
 
 void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t len) {
 
-    static union {
-        uint8_t header_bluez[HCIDUMP_HDR_SIZE];
-        uint8_t header_packetlogger[PKTLOG_HDR_SIZE];
-    } header;
-
-    if (dump_file < 0) return; // not activated yet
-
+    uint8_t header[HCI_DUMP_MAX_HDR_SIZE];
 #ifdef HAVE_POSIX_FILE_IO
-    // don't grow bigger than max_nr_packets
-    if (dump_format != HCI_DUMP_STDOUT && max_nr_packets > 0){
-        if (nr_packets >= max_nr_packets){
-            lseek(dump_file, 0, SEEK_SET);
-            // avoid -Wunused-result
-            int res = ftruncate(dump_file, 0);
-            UNUSED(res);
-            nr_packets = 0;
-        }
-        nr_packets++;
-    }
+    uint8_t  trailer[PCAPNG_TRAILER_MAX_SIZE];
+    uint16_t trailer_len = 0;
+    uint32_t drops = hci_dump_get_dropped_records();
 #endif
 
+    if (dump_file < 0) return; // not activated yet
+
     if (dump_format == HCI_DUMP_STDOUT){
         printf_timestamp();
         printf_packet(packet_type, in, packet, len);
@@ -323,23 +671,29 @@ void hci_dump_packet(uint8_t packet_type, uint8_t in, uint8_t *packet, uint16_t
     uint16_t header_len = 0;
     switch (dump_format){
         case HCI_DUMP_BLUEZ:
-            hci_dump_bluez_setup_header(header.header_bluez, tv_sec, tv_us, packet_type, in, len);
+            hci_dump_bluez_setup_header(header, tv_sec, tv_us, packet_type, in, len);
             header_len = HCIDUMP_HDR_SIZE;
             break;
         case HCI_DUMP_PACKETLOGGER:
-            hci_dump_packetlogger_setup_header(header.header_packetlogger, tv_sec, tv_us, packet_type, in, len);
+            hci_dump_packetlogger_setup_header(header, tv_sec, tv_us, packet_type, in, len);
             header_len = PKTLOG_HDR_SIZE;
             break;
+#ifdef HAVE_POSIX_FILE_IO
+        case HCI_DUMP_BTSNOOP:
+            // btsnoop has no record type for log messages
+            if (packet_type == LOG_MESSAGE_PACKET) return;
+            header_len = hci_dump_btsnoop_setup_header(header, tv_sec, tv_us, packet_type, in, len, drops);
+            break;
+        case HCI_DUMP_PCAPNG:
+            header_len = hci_dump_pcapng_setup_header(header, trailer, &trailer_len, tv_sec, tv_us, packet_type, in, len);
+            break;
+#endif
         default:
             return;
     }
 
 #ifdef HAVE_POSIX_FILE_IO
-    // avoid -Wunused-result
-    int res = 0;
-    res = write (dump_file, &header, header_len);
-    res = write (dump_file, packet, len );
-    UNUSED(res);
+    hci_dump_write_record(header, header_len, packet, len, trailer, trailer_len);
 #endif
 
 #ifdef ENABLE_SEGGER_RTT
@@ -371,6 +725,11 @@ void hci_dump_log_va_arg(int log_level, const char * format, va_list argptr){
 #if defined(HAVE_POSIX_FILE_IO) || defined (ENABLE_SEGGER_RTT)
     if (dump_file >= 0){
         int len = vsnprintf(log_message_buffer, sizeof(log_message_buffer), format, argptr);
+        // vsnprintf returns length of untruncated message
+        if (len >= (int) sizeof(log_message_buffer)){
+            len = sizeof(log_message_buffer) - 1u;
+        }
+        if (len < 0) return;
         hci_dump_packet(LOG_MESSAGE_PACKET, 0, (uint8_t*) log_message_buffer, len);
         return;
     }
@@ -402,6 +761,10 @@ void hci_dump_log_P(int log_level, PGM_P format, ...){
 #endif
 
 void hci_dump_close(void){
+#ifdef ENABLE_HCI_DUMP_ASYNC
+    // write remaining records
+    hci_dump_async_stop();
+#endif
 #ifdef HAVE_POSIX_FILE_IO
     close(dump_file);
 #endif
@@ -38,7 +38,7 @@
 /*
  *  hci_dump.h
  *
- *  Dump HCI trace as BlueZ's hcidump format, Apple's PacketLogger, or stdout
+ *  Dump HCI trace as BlueZ's hcidump format, Apple's PacketLogger, btsnoop, pcapng, or stdout
  * 
  *  Created by Matthias Ringwald on 5/26/09.
  */
@@ -66,7 +66,9 @@ extern "C" {
 typedef enum {
     HCI_DUMP_BLUEZ = 0,
     HCI_DUMP_PACKETLOGGER,
-    HCI_DUMP_STDOUT
+    HCI_DUMP_STDOUT,
+    HCI_DUMP_BTSNOOP,
+    HCI_DUMP_PCAPNG
 } hci_dump_format_t;
 
 /*
@@ -77,7 +79,17 @@ void hci_dump_open(const char *filename, hci_dump_format_t format);
 /*
  * @brief 
  */
-void hci_dump_set_max_packets(int packets); // -1 for unlimited
+void hci_dump_set_max_packets(int packets); // -1 for unlimited. Previous file is kept as <filename>.1
+
+/*
+ * @brief Start new file if size would exceed max size. Previous file is kept as <filename>.1
+ */
+void hci_dump_set_max_file_size(uint32_t max_size); // 0 for unlimited
+
+/*
+ * @brief Get number of records dropped as ring buffer of ENABLE_HCI_DUMP_ASYNC was full
+ */
+uint32_t hci_dump_get_dropped_records(void);
 
 /*
  * @brief 
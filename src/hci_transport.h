@@ -111,6 +111,14 @@ typedef struct {
      */
     void   (*set_sco_config)(uint16_t voice_setting, int num_connections);
 
+    /**
+     * optional: send multiple packets of the same type with a single transport operation
+     * each packet is provided by two vectors: packet header and payload
+     * vectors have to stay valid until HCI_EVENT_TRANSPORT_PACKET_SENT, which is emitted once for all accepted packets
+     * returns number of packets accepted, which can be less than num_vectors / 2 on error
+     */
+    int    (*send_packet_vectored)(uint8_t packet_type, const btstack_iovec_t * vectors, int num_vectors);
+
 } hci_transport_t;
 
 typedef enum {
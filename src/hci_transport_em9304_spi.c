@@ -562,6 +562,7 @@ const hci_transport_t * hci_transport_em9304_spi_instance(const btstack_em9304_s
             /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
             /* void   (*reset_link)(void); */                               NULL,
             /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+            /* int    (*send_packet_vectored)(...); */                      NULL,
     };
 
     btstack_em9304_spi = em9304_spi_driver;
@@ -46,6 +46,7 @@
  */
 
 #include <inttypes.h>
+#include <string.h>
 
 #include "btstack_config.h"
 
@@ -136,6 +137,17 @@ static uint8_t * ehcill_tx_data;
 static uint16_t  ehcill_tx_len;   // 0 == no outgoing packet
 #endif
 
+// vectored send is not supported in combination with eHCILL
+#if defined(ENABLE_HCI_SEND_PACKET_VECTORED) && !defined(ENABLE_EHCILL)
+#define ENABLE_H4_SEND_PACKET_VECTORED
+// packet type + packet header per packet, payload is sent directly from caller's buffer
+static uint8_t         h4_tx_headers[HCI_ACL_FRAGMENTS_VECTORED_MAX][1 + HCI_ACL_HEADER_SIZE];
+static btstack_iovec_t h4_tx_vectors[2 * HCI_ACL_FRAGMENTS_VECTORED_MAX];
+// send vectors one by one if UART driver does not provide send_block_vectored
+static uint16_t        h4_tx_vectors_num;
+static uint16_t        h4_tx_vectors_pos;
+#endif
+
 static  void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size) = dummy_handler;
 
 // packet reader state machine
@@ -324,6 +336,16 @@ static void hci_transport_h4_block_sent(void){
 
     switch (tx_state){
         case TX_W4_PACKET_SENT:
+#ifdef ENABLE_H4_SEND_PACKET_VECTORED
+            // send next non-empty vector
+            while (h4_tx_vectors_pos < h4_tx_vectors_num){
+                const btstack_iovec_t * vector = &h4_tx_vectors[h4_tx_vectors_pos++];
+                if (vector->len == 0u) continue;
+                btstack_uart->send_block(vector->data, vector->len);
+                return;
+            }
+            h4_tx_vectors_num = 0;
+#endif
             // packet fully sent, reset state
 #ifdef ENABLE_EHCILL
             ehcill_tx_len = 0;
@@ -392,6 +414,44 @@ static int hci_transport_h4_send_packet(uint8_t packet_type, uint8_t * packet, i
     return 0;
 }
 
+#ifdef ENABLE_H4_SEND_PACKET_VECTORED
+static int hci_transport_h4_send_packet_vectored(uint8_t packet_type, const btstack_iovec_t * vectors, int num_vectors){
+
+    int num_packets = num_vectors / 2;
+    if ((num_packets == 0) || (num_packets > HCI_ACL_FRAGMENTS_VECTORED_MAX)){
+        log_error("hci_transport_h4: cannot send %u vectors", num_vectors);
+        return 0;
+    }
+
+    // prefix packet header with packet type
+    int i;
+    for (i = 0; i < num_packets; i++){
+        const btstack_iovec_t * header  = &vectors[2 * i];
+        const btstack_iovec_t * payload = &vectors[2 * i + 1];
+        if (header->len > HCI_ACL_HEADER_SIZE){
+            log_error("hci_transport_h4: packet header len %u too long", header->len);
+            return 0;
+        }
+        h4_tx_headers[i][0] = packet_type;
+        (void)memcpy(&h4_tx_headers[i][1], header->data, header->len);
+        h4_tx_vectors[2 * i].data = h4_tx_headers[i];
+        h4_tx_vectors[2 * i].len  = 1u + header->len;
+        h4_tx_vectors[2 * i + 1]  = *payload;
+    }
+
+    // start sending
+    tx_state = TX_W4_PACKET_SENT;
+    if (btstack_uart->send_block_vectored != NULL){
+        btstack_uart->send_block_vectored(h4_tx_vectors, 2 * num_packets);
+    } else {
+        h4_tx_vectors_num = 2 * num_packets;
+        h4_tx_vectors_pos = 1;
+        btstack_uart->send_block(h4_tx_vectors[0].data, h4_tx_vectors[0].len);
+    }
+    return num_packets;
+}
+#endif
+
 static void hci_transport_h4_init(const void * transport_config){
     // check for hci_transport_config_uart_t
     if (!transport_config) {
@@ -430,6 +490,9 @@ static int hci_transport_h4_open(void){
     hci_transport_h4_reset_statemachine();
     hci_transport_h4_trigger_next_read();
     tx_state = TX_IDLE;
+#ifdef ENABLE_H4_SEND_PACKET_VECTORED
+    h4_tx_vectors_num = 0;
+#endif
 
 #ifdef ENABLE_EHCILL
     hci_transport_h4_ehcill_open();
@@ -738,6 +801,11 @@ const hci_transport_t * hci_transport_h4_instance(const btstack_uart_block_t * u
             /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_h4_set_baudrate,
             /* void   (*reset_link)(void); */                               NULL,
             /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+#ifdef ENABLE_H4_SEND_PACKET_VECTORED
+            /* int    (*send_packet_vectored)(...); */                      &hci_transport_h4_send_packet_vectored,
+#else
+            /* int    (*send_packet_vectored)(...); */                      NULL,
+#endif
     };
 
     btstack_uart = uart_driver;
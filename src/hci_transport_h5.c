@@ -74,8 +74,16 @@ typedef enum {
 
 } hci_transport_link_actions_t;
 
-// Configuration Field. No packet buffers -> sliding window = 1, no OOF flow control, support data integrity check
-#define LINK_CONFIG_SLIDING_WINDOW_SIZE 1
+// Number of reliable packets sent without waiting for acknowledgement. With sliding window > 1, outgoing packets are copied into transport buffers
+#ifndef HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 1
+#endif
+#if (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE < 1) || (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 7)
+#error "HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE must be between 1 and 7"
+#endif
+
+// Configuration Field. Sliding window, no OOF flow control, support data integrity check
+#define LINK_CONFIG_SLIDING_WINDOW_SIZE HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
 #define LINK_CONFIG_OOF_FLOW_CONTROL 0
 #define LINK_CONFIG_DATA_INTEGRITY_CHECK 1
 #define LINK_CONFIG_VERSION_NR 0
@@ -118,8 +126,9 @@ static int       slip_write_active;
 // H5 Link State
 static hci_transport_link_state_t link_state;
 static btstack_timer_source_t link_timer;
-static uint8_t  link_seq_nr;
+static uint8_t  link_seq_nr;     // seq nr of oldest unacknowledged packet
 static uint8_t  link_ack_nr;
+static uint8_t  link_window_size;
 static uint16_t link_resend_timeout_ms;
 static uint8_t  link_peer_asleep;
 static uint8_t  link_peer_supports_data_integrity_check;
@@ -128,10 +137,24 @@ static uint8_t  link_peer_supports_data_integrity_check;
 static btstack_timer_source_t inactivity_timer;
 static uint16_t link_inactivity_timeout_ms; // auto-sleep if set
 
-// Outgoing packet
-static uint8_t   hci_packet_type;
-static uint16_t  hci_packet_size;
-static uint8_t * hci_packet;
+// Outgoing packets, ring buffer of sliding window slots
+typedef struct {
+    uint8_t * packet;
+    uint16_t  size;
+    uint8_t   type;
+    uint32_t  sent_ms;      // time of last transmission
+} hci_transport_link_slot_t;
+
+static hci_transport_link_slot_t link_slots[HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE];
+static uint8_t link_slots_head;  // index of oldest unacknowledged packet
+static uint8_t link_slots_num;   // number of queued packets
+static uint8_t link_slots_sent;  // number of queued packets transmitted, reset to resend all on timeout
+
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+static uint8_t link_slot_buffers[HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE][HCI_OUTGOING_PACKET_BUFFER_SIZE];
+// packet has been copied, emit packet sent after current transmission
+static int     link_packet_sent_pending;
+#endif
 
 // hci packet handler
 static  void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
@@ -155,9 +178,54 @@ static void hci_transport_slip_init(void);
 
 // -----------------------------
 // CRC16-CCITT Calculation - compromise: use 32 byte table - 512 byte table would be faster, but that's too large
+// With ENABLE_H5_CRC16_TABLE_256, the 512 byte table is used to process one byte per lookup
 
+#ifdef ENABLE_H5_CRC16_TABLE_256
+static uint16_t crc16_ccitt_update_block(uint16_t crc, const uint8_t * data, uint16_t len){
 
-static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
+    static const uint16_t crc16_ccitt_table[] ={
+            0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+            0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+            0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+            0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+            0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+            0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+            0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+            0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+            0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+            0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+            0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+            0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+            0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+            0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+            0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+            0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+            0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+            0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+            0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+            0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+            0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+            0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+            0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+            0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+            0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+            0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+            0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+            0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+            0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+            0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+            0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+            0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+    };
+
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        crc = (crc >> 8u) ^ crc16_ccitt_table[(crc ^ data[i]) & 0x00ffu];
+    }
+    return crc;
+}
+#else
+static uint16_t crc16_ccitt_update_block(uint16_t crc, const uint8_t * data, uint16_t len){
 
     static const uint16_t crc16_ccitt_table[] ={
             0x0000, 0x1081, 0x2102, 0x3183,
@@ -166,10 +234,15 @@ static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
             0xc60c, 0xd68d, 0xe70e, 0xf78f
     };
 
-    crc = (crc >> 4u) ^ crc16_ccitt_table[(crc ^ ch) & 0x000fu];
-    crc = (crc >> 4u) ^ crc16_ccitt_table[(crc ^ (ch >> 4u)) & 0x000fu];
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        uint8_t ch = data[i];
+        crc = (crc >> 4u) ^ crc16_ccitt_table[(crc ^ ch) & 0x000fu];
+        crc = (crc >> 4u) ^ crc16_ccitt_table[(crc ^ (ch >> 4u)) & 0x000fu];
+    }
     return crc;
 }
+#endif
 
 static uint16_t btstack_reverse_bits_16(uint16_t value){
     int reverse = 0;
@@ -183,14 +256,9 @@ static uint16_t btstack_reverse_bits_16(uint16_t value){
 }
 
 static uint16_t crc16_calc_for_slip_frame(const uint8_t * header, const uint8_t * payload, uint16_t len){
-    int i;
     uint16_t crc = 0xffff;
-    for (i=0 ; i < 4 ; i++){
-        crc = crc16_ccitt_update(crc, header[i]);
-    }
-    for (i=0 ; i < len ; i++){
-        crc = crc16_ccitt_update(crc, payload[i]);
-    }
+    crc = crc16_ccitt_update_block(crc, header, 4);
+    crc = crc16_ccitt_update_block(crc, payload, len);
     return btstack_reverse_bits_16(crc);
 }
 
@@ -348,19 +416,45 @@ static void hci_transport_link_send_sleep(void){
     hci_transport_link_send_control(link_control_sleep, sizeof(link_control_sleep));
 }
 
+static hci_transport_link_slot_t * hci_transport_link_get_slot(uint8_t offset){
+    return &link_slots[(link_slots_head + offset) % HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE];
+}
+
+// (re)start resend timer for oldest unacknowledged packet
+static void hci_transport_link_set_resend_timer(void){
+    btstack_run_loop_remove_timer(&link_timer);
+    if (link_slots_sent == 0u) return;
+    uint32_t elapsed_ms = btstack_run_loop_get_time_ms() - hci_transport_link_get_slot(0)->sent_ms;
+    uint16_t timeout_ms = 0;
+    if (elapsed_ms < link_resend_timeout_ms){
+        timeout_ms = link_resend_timeout_ms - elapsed_ms;
+    }
+    hci_transport_link_set_timer(timeout_ms);
+}
+
 static void hci_transport_link_send_queued_packet(void){
 
+    hci_transport_link_slot_t * slot = hci_transport_link_get_slot(link_slots_sent);
+    uint8_t seq_nr = (link_seq_nr + link_slots_sent) & 0x07u;
+    link_slots_sent++;
+
     uint8_t header[4];
-    hci_transport_link_calc_header(header, link_seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, hci_packet_type, hci_packet_size);
+    hci_transport_link_calc_header(header, seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, slot->type, slot->size);
 
     uint16_t data_integrity_check = 0;
     if (link_peer_supports_data_integrity_check){
-        data_integrity_check = crc16_calc_for_slip_frame(header, hci_packet, hci_packet_size);
+        data_integrity_check = crc16_calc_for_slip_frame(header, slot->packet, slot->size);
     }
-    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", link_seq_nr, link_ack_nr, hci_packet_size, link_peer_supports_data_integrity_check, data_integrity_check);
-    log_debug_hexdump(hci_packet, hci_packet_size);
+    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", seq_nr, link_ack_nr, slot->size, link_peer_supports_data_integrity_check, data_integrity_check);
+    log_debug_hexdump(slot->packet, slot->size);
 
-    hci_transport_slip_send_frame(header, hci_packet, hci_packet_size, data_integrity_check);
+    hci_transport_slip_send_frame(header, slot->packet, slot->size, data_integrity_check);
+
+    // track transmission, timer only needs update for oldest packet
+    slot->sent_ms = btstack_run_loop_get_time_ms();
+    if (link_slots_sent == 1u){
+        hci_transport_link_set_resend_timer();
+    }
 
     // reset inactvitiy timer
     hci_transport_inactivity_timer_set();
@@ -419,6 +513,10 @@ static void hci_transport_link_run(void){
         // packet already contains ack, no need to send addtitional one
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
         hci_transport_link_send_queued_packet();
+        // send remaining packets in window after this one
+        if (link_slots_sent < link_slots_num){
+            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
+        }
         return;
     }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
@@ -436,6 +534,7 @@ static void hci_transport_link_run(void){
 }
 
 static void hci_transport_link_set_timer(uint16_t timeout_ms){
+    btstack_run_loop_remove_timer(&link_timer);
     btstack_run_loop_set_timer_handler(&link_timer, &hci_transport_link_timeout_handler);
     btstack_run_loop_set_timer(&link_timer, timeout_ms);
     btstack_run_loop_add_timer(&link_timer);
@@ -462,7 +561,8 @@ static void hci_transport_link_timeout_handler(btstack_timer_source_t * ts){
                 hci_transport_link_set_timer(LINK_WAKEUP_MS);
                 return;
             }
-            // resend packet
+            // peer discards out-of-sequence packets -> resend all unacknowledged packets starting with oldest one
+            link_slots_sent = 0;
             hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
             hci_transport_link_set_timer(link_resend_timeout_ms);
             break;
@@ -489,18 +589,63 @@ static int hci_transport_link_inc_seq_nr(int seq_nr){
 }
 
 static int hci_transport_link_have_outgoing_packet(void){
-    return hci_packet != NULL;
+    return link_slots_num > 0u;
 }
 
 static void hci_transport_link_clear_queue(void){
     btstack_run_loop_remove_timer(&link_timer);
-    hci_packet = NULL;
+    link_slots_head = 0;
+    link_slots_num  = 0;
+    link_slots_sent = 0;
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+    link_packet_sent_pending = 0;
+#endif
 }
 
 static void hci_transport_h5_queue_packet(uint8_t packet_type, uint8_t *packet, int size){
-    hci_packet = packet;
-    hci_packet_type = packet_type;
-    hci_packet_size = size;
+    uint8_t index = (link_slots_head + link_slots_num) % HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE;
+    hci_transport_link_slot_t * slot = &link_slots[index];
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+    // copy packet to allow HCI to prepare next one
+    (void) memcpy(link_slot_buffers[index], packet, size);
+    slot->packet = link_slot_buffers[index];
+    link_packet_sent_pending = 1;
+#else
+    slot->packet = packet;
+#endif
+    slot->type = packet_type;
+    slot->size = size;
+    link_slots_num++;
+}
+
+// cumulative acknowledgement: peer expects ack_nr as next seq nr
+static void hci_transport_link_process_ack(uint8_t ack_nr){
+    uint8_t num_acked = (ack_nr - link_seq_nr) & 0x07u;
+    if (num_acked == 0u) return;
+    if (num_acked > link_slots_num) {
+        log_info("ack nr %u outside of window, oldest seq %u, %u packets queued", ack_nr, link_seq_nr, link_slots_num);
+        return;
+    }
+    log_debug("%u outgoing packets with seq %u.. ack'ed", num_acked, link_seq_nr);
+    link_seq_nr     = ack_nr;
+    link_slots_head = (link_slots_head + num_acked) % HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE;
+    link_slots_num -= num_acked;
+    link_slots_sent = (link_slots_sent > num_acked) ? (link_slots_sent - num_acked) : 0;
+    if ((link_slots_sent == 0u) && (link_slots_num > 0u)){
+        // resend in progress, continue with oldest unacknowledged packet
+        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
+    }
+    hci_transport_link_set_resend_timer();
+
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+    // packet sent event has already been emitted in block sent unless window was full
+    if (link_packet_sent_pending == 0) return;
+    link_packet_sent_pending = 0;
+#endif
+
+    // notify upper stack that it can send again
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
 }
 
 static void hci_transport_h5_emit_sleep_state(int sleep_active){
@@ -611,7 +756,12 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
             if (memcmp(slip_payload, link_control_config_response, link_control_config_response_prefix_len) == 0){
                 uint8_t config = slip_payload[2];
                 link_peer_supports_data_integrity_check = (config & 0x10u) != 0u;
-                log_info("link received config response 0x%02x, data integrity check supported %u", config, link_peer_supports_data_integrity_check);
+                // use smaller sliding window, peer without config field supports window size 1
+                link_window_size = 1;
+                if (link_payload_len > link_control_config_response_prefix_len){
+                    link_window_size = btstack_max(1, btstack_min(config & 0x07u, HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE));
+                }
+                log_info("link received config response 0x%02x, data integrity check supported %u, sliding window %u", config, link_peer_supports_data_integrity_check, link_window_size);
                 link_state = LINK_ACTIVE;
                 btstack_run_loop_remove_timer(&link_timer);
                 log_info("link activated");
@@ -640,17 +790,7 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
 
             // Process ACKs in reliable packet and explicit ack packets
             if (reliable_packet || (link_packet_type == LINK_ACKNOWLEDGEMENT_TYPE)){
-                // our packet is good if the remote expects our seq nr + 1
-                int next_seq_nr = hci_transport_link_inc_seq_nr(link_seq_nr);
-                if (hci_transport_link_have_outgoing_packet() && (next_seq_nr == ack_nr)){
-                    log_debug("outoing packet with seq %u ack'ed", link_seq_nr);
-                    link_seq_nr = next_seq_nr;
-                    hci_transport_link_clear_queue();
-
-                    // notify upper stack that it can send again
-                    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
-                }
+                hci_transport_link_process_ack(ack_nr);
             } 
 
             switch (link_packet_type){
@@ -735,12 +875,39 @@ static void hci_transport_link_update_resend_timeout(uint32_t baudrate){
 static uint8_t hci_transport_link_read_byte;
 static int hci_transport_h5_active;
 
+#ifndef HCI_TRANSPORT_H5_RX_CHUNK_LEN
+#define HCI_TRANSPORT_H5_RX_CHUNK_LEN 128
+#endif
+
+// received bytes if UART driver supports receive_bytes
+static uint8_t hci_transport_h5_rx_chunk[HCI_TRANSPORT_H5_RX_CHUNK_LEN];
+
 static void hci_transport_h5_read_next_byte(void){
+    // read all available bytes if supported
+    if (btstack_uart->receive_bytes != NULL){
+        btstack_uart->receive_bytes(hci_transport_h5_rx_chunk, sizeof(hci_transport_h5_rx_chunk));
+        return;
+    }
     btstack_uart->receive_block(&hci_transport_link_read_byte, 1);    
 }
 
 // track time receiving SLIP frame
 static uint32_t hci_transport_h5_receive_start;
+
+static void hci_transport_h5_frame_received(uint16_t frame_size){
+    // track time
+    uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
+    uint32_t nominal_time = (frame_size + 6u) * 10u * 1000u / uart_config.baudrate;
+    UNUSED(nominal_time);
+    UNUSED(packet_receive_time);
+    log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominal_time);
+    // reset state
+    hci_transport_h5_receive_start = 0;
+    // 
+    hci_transport_h5_process_frame(frame_size);
+    hci_transport_slip_init();
+}
+
 static void hci_transport_h5_block_received(void){
     if (hci_transport_h5_active == 0) return;
 
@@ -751,17 +918,27 @@ static void hci_transport_h5_block_received(void){
     btstack_slip_decoder_process(hci_transport_link_read_byte);
     uint16_t frame_size = btstack_slip_decoder_frame_size();
     if (frame_size) {
-        // track time
-        uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
-        uint32_t nominal_time = (frame_size + 6u) * 10u * 1000u / uart_config.baudrate;
-        UNUSED(nominal_time);
-        UNUSED(packet_receive_time);
-        log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominal_time);
-        // reset state
-        hci_transport_h5_receive_start = 0;
-        // 
-        hci_transport_h5_process_frame(frame_size);
-        hci_transport_slip_init();
+        hci_transport_h5_frame_received(frame_size);
+    }
+    hci_transport_h5_read_next_byte();
+}
+
+static void hci_transport_h5_bytes_received(uint16_t num_bytes){
+    if (hci_transport_h5_active == 0) return;
+
+    uint16_t pos = 0;
+    while (pos < num_bytes){
+        // track start time when receiving first chunk of a frame
+        if (hci_transport_h5_receive_start == 0u){
+            hci_transport_h5_receive_start = btstack_run_loop_get_time_ms();
+        }
+        pos += btstack_slip_decoder_process_chunk(&hci_transport_h5_rx_chunk[pos], num_bytes - pos);
+        uint16_t frame_size = btstack_slip_decoder_frame_size();
+        if (frame_size) {
+            hci_transport_h5_frame_received(frame_size);
+            // transport might have been closed by packet handler
+            if (hci_transport_h5_active == 0) return;
+        }
     }
     hci_transport_h5_read_next_byte();
 }
@@ -778,6 +955,15 @@ static void hci_transport_h5_block_sent(void){
     // done
     slip_write_active = 0;
 
+#if HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 1
+    // packet has been copied, notify upper stack if window is not full
+    if (link_packet_sent_pending && (link_slots_num < link_window_size)){
+        link_packet_sent_pending = 0;
+        uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+        packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+    }
+#endif
+
     // enter sleep mode after sending sleep message
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_ENTER_SLEEP){
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_ENTER_SLEEP;
@@ -815,6 +1001,9 @@ static void hci_transport_h5_init(const void * transport_config){
     // setup UART driver
     btstack_uart->init(&uart_config);
     btstack_uart->set_block_received(&hci_transport_h5_block_received);
+    if (btstack_uart->set_bytes_received != NULL){
+        btstack_uart->set_bytes_received(&hci_transport_h5_bytes_received);
+    }
     btstack_uart->set_block_sent(&hci_transport_h5_block_sent);
 }
 
@@ -869,7 +1058,8 @@ static void hci_transport_h5_register_packet_handler(void (*handler)(uint8_t pac
 }
 
 static int hci_transport_h5_can_send_packet_now(uint8_t packet_type){
-    int res = !hci_transport_link_have_outgoing_packet() && (link_state == LINK_ACTIVE);
+    UNUSED(packet_type);
+    int res = (link_slots_num < link_window_size) && (link_state == LINK_ACTIVE);
     // log_info("can_send_packet_now: %u", res);
     return res;
 }
@@ -893,8 +1083,8 @@ static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, in
         hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_WAKEUP;
         hci_transport_link_set_timer(LINK_WAKEUP_MS);
     } else {
+        // resend timer is started on transmission
         hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        hci_transport_link_set_timer(link_resend_timeout_ms);
     }
     hci_transport_link_run();
     return 0;
@@ -939,6 +1129,7 @@ const hci_transport_t * hci_transport_h5_instance(const btstack_uart_block_t * u
             /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_h5_set_baudrate,
             /* void   (*reset_link)(void); */                               &hci_transport_h5_reset_link,
             /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+            /* int    (*send_packet_vectored)(...); */                      NULL,
     };
 
     btstack_uart = uart_driver;
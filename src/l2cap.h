@@ -338,6 +338,9 @@ typedef struct {
     // receiver: value of tx_seq in next expected i-frame
     uint8_t expected_tx_seq;
 
+    // receiver: tx_seq following the last frame requested by SREJ
+    uint8_t srej_next_tx_seq;
+
     // receiver: request transmission with tx_seq = req_seq and ack up to and including req_seq
     uint8_t req_seq;
 
@@ -377,7 +380,7 @@ typedef struct {
     // receiver: eassembly buffer
     uint8_t * reassembly_buffer;
 
-    // receiver: num_rx_buffers of size local_mps
+    // receiver: num_rx_buffers of size local_mps + 2 (SDU Length)
     uint8_t * rx_packets_data;
 
     // sender: num_tx_buffers of size local_mps
@@ -50,6 +50,7 @@
 #include "mesh/mesh_foundation.h"
 #include "mesh/mesh_iv_index_seq_number.h"
 #include "mesh/mesh_keys.h"
+#include "mesh/mesh_network_cache.h"
 #include "mesh/mesh_node.h"
 #include "mesh/provisioning.h"
 #include "mesh/provisioning_device.h"
@@ -62,16 +63,45 @@
 #include "mesh/gatt_bearer.h"
 #endif
 
-// configuration
-#define MESH_NETWORK_CACHE_SIZE 2
-
 // debug config
 // #define LOG_NETWORK
 
 static void mesh_network_dump_network_pdus(const char * name, btstack_linked_list_t * list);
 
+// validate received Network PDUs synchronously if AES128 is computed in software
+#if defined(ENABLE_SOFTWARE_AES128) || defined(HAVE_AES128)
+#define MESH_NETWORK_RX_SYNCHRONOUS
+#endif
+
+// number of received Network PDUs in validation
+#ifdef MESH_NETWORK_RX_SYNCHRONOUS
+#undef  MESH_NETWORK_RX_PIPELINE_SIZE
+#define MESH_NETWORK_RX_PIPELINE_SIZE 1
+#else
+#ifndef MESH_NETWORK_RX_PIPELINE_SIZE
+#define MESH_NETWORK_RX_PIPELINE_SIZE 4
+#endif
+#endif
+
 // structs
 
+typedef struct {
+    mesh_network_pdu_t *            raw_pdu;
+    mesh_network_pdu_t *            decoded_pdu;
+    mesh_network_key_iterator_t     key_it;
+    const mesh_network_key_t *      network_key;
+    uint8_t                         network_nonce[13];
+    bool                            validated;
+#ifndef MESH_NETWORK_RX_SYNCHRONOUS
+    union {
+        btstack_crypto_ccm_t        ccm;
+        btstack_crypto_aes128_t     aes128;
+    } crypto_request;
+    uint8_t                         encryption_block[16];
+    uint8_t                         obfuscation_block[16];
+#endif
+} mesh_network_rx_context_t;
+
 // globals
 
 static void (*mesh_network_higher_layer_handler)(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu);
@@ -81,7 +111,7 @@ static void (*mesh_network_proxy_message_handler)(mesh_network_callback_type_t c
 static hci_con_handle_t gatt_bearer_con_handle;
 #endif
 
-// shared send/receive crypto
+// send crypto active
 static int mesh_crypto_active;
 
 // crypto requests
@@ -107,10 +137,10 @@ static uint8_t network_nonce[13];
 // unprocessed network pdu - added by mesh_network_pdus_received_message
 static btstack_linked_list_t        network_pdus_received;
 
-// in validation
-static mesh_network_pdu_t *         incoming_pdu_raw;
-static mesh_network_pdu_t *         incoming_pdu_decoded;
-static mesh_network_key_iterator_t  validation_network_key_it;
+// in validation, used in order of reception starting with the oldest context
+static mesh_network_rx_context_t    mesh_network_rx_contexts[MESH_NETWORK_RX_PIPELINE_SIZE];
+static uint8_t                      mesh_network_rx_context_oldest;
+static uint8_t                      mesh_network_rx_contexts_active;
 
 // OUTGOING //
 
@@ -135,43 +165,14 @@ static mesh_network_pdu_t * adv_bearer_network_pdu;
 #endif
 
 
-// mesh network cache - we use 32-bit 'hashes'
-static uint32_t mesh_network_cache[MESH_NETWORK_CACHE_SIZE];
-static int      mesh_network_cache_index;
+// mesh_network_run active, nested calls are handled by the outer loop
+static bool mesh_network_run_active;
+static bool mesh_network_run_requested;
 
 // prototypes
 
 static void mesh_network_run(void);
-static void process_network_pdu_validate(void);
-
-// network caching
-static uint32_t mesh_network_cache_hash(mesh_network_pdu_t * network_pdu){
-    // - The SEQ field is a 24-bit integer that when combined with the IV Index, 
-    // shall be a unique value for each new Network PDU originated by this node (=> SRC)
-    // - IV updates only rarely
-    // => 16 bit SRC, 1 bit IVI, 15 bit SEQ
-    uint8_t  ivi = network_pdu->data[0] >> 7;
-    uint16_t seq = big_endian_read_16(network_pdu->data, 3);
-    uint16_t src = big_endian_read_16(network_pdu->data, 5);
-    return (src << 16) | (ivi << 15) | (seq & 0x7fff);
-}
-
-static int mesh_network_cache_find(uint32_t hash){
-    int i;
-    for (i = 0; i < MESH_NETWORK_CACHE_SIZE; i++) {
-        if (mesh_network_cache[i] == hash) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-static void mesh_network_cache_add(uint32_t hash){
-    mesh_network_cache[mesh_network_cache_index++] = hash;
-    if (mesh_network_cache_index >= MESH_NETWORK_CACHE_SIZE){
-        mesh_network_cache_index = 0;
-    }
-}
+static void process_network_pdu_validate(mesh_network_rx_context_t * context);
 
 // common helper
 int mesh_network_address_unicast(uint16_t addr){
@@ -470,218 +471,317 @@ void mesh_network_message_processed_by_higher_layer(mesh_network_pdu_t * network
     btstack_memory_mesh_network_pdu_free(network_pdu);
 }
 
-static void process_network_pdu_done(void){
-    btstack_memory_mesh_network_pdu_free(incoming_pdu_raw);
-    incoming_pdu_raw = NULL;
-    mesh_crypto_active = 0;
+static mesh_network_rx_context_t * mesh_network_rx_context_for_raw_pdu(void){
+    if (mesh_network_rx_contexts_active == MESH_NETWORK_RX_PIPELINE_SIZE){
+        return NULL;
+    }
+    unsigned int index = (mesh_network_rx_context_oldest + mesh_network_rx_contexts_active) % MESH_NETWORK_RX_PIPELINE_SIZE;
+    return &mesh_network_rx_contexts[index];
+}
 
-    mesh_network_run();
+static uint32_t iv_index_for_pdu(const mesh_network_pdu_t * network_pdu){
+    // get IV Index and IVI
+    uint32_t iv_index = mesh_get_iv_index();
+    int ivi = network_pdu->data[0] >> 7;
+
+    // if least significant bit differs, use previous IV Index
+    if ((iv_index & 1 ) ^ ivi){
+        iv_index--;
+#ifdef LOG_NETWORK
+        printf("RX-IV: IVI indicates previous IV index, using 0x%08x\n", iv_index);
+#endif
+    }
+    return iv_index;
 }
 
-static void process_network_pdu_validate_d(void * arg){
-    UNUSED(arg);
-    // mesh_network_pdu_t * network_pdu = (mesh_network_pdu_t *) arg;
+static void process_network_pdu_setup_pecb(const mesh_network_rx_context_t * context, uint8_t * pecb_input){
+    uint32_t iv_index = iv_index_for_pdu(context->raw_pdu);
+    memset(pecb_input, 0, 5);
+    big_endian_store_32(pecb_input, 5, iv_index);
+    (void)memcpy(&pecb_input[9], &context->raw_pdu->data[7], 7);
+}
 
-    uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
-    uint8_t ctl         = ctl_ttl >> 7;
+static void process_network_pdu_deobfuscate(mesh_network_rx_context_t * context, const uint8_t * pecb){
+    mesh_network_pdu_t * raw_pdu     = context->raw_pdu;
+    mesh_network_pdu_t * decoded_pdu = context->decoded_pdu;
+
+#ifdef LOG_NETWORK
+    printf("RX-PECB: ");
+    printf_hexdump(pecb, 6);
+#endif
+
+    // de-obfuscate
+    unsigned int i;
+    for (i=0;i<6;i++){
+        decoded_pdu->data[1+i] = raw_pdu->data[1+i] ^ pecb[i];
+    }
+
+    uint32_t iv_index = iv_index_for_pdu(raw_pdu);
+
+    if (decoded_pdu->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
+        // create network nonce
+        mesh_proxy_create_nonce(context->network_nonce, decoded_pdu, iv_index);
+#ifdef LOG_NETWORK
+        printf("RX-Proxy Nonce: ");
+        printf_hexdump(context->network_nonce, 13);
+#endif
+    } else {
+        // create network nonce
+        mesh_network_create_nonce(context->network_nonce, decoded_pdu, iv_index);
+#ifdef LOG_NETWORK
+        printf("RX-Network Nonce: ");
+        printf_hexdump(context->network_nonce, 13);
+#endif
+    }
+}
+
+// returns true if NetMIC matches
+static bool process_network_pdu_check_net_mic(mesh_network_rx_context_t * context, const uint8_t * net_mic){
+    mesh_network_pdu_t * decoded_pdu = context->decoded_pdu;
+    uint8_t ctl_ttl     = decoded_pdu->data[1];
     uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
 
-    // store NetMIC
-    uint8_t net_mic[8];
-    btstack_crypto_ccm_get_authentication_value(&mesh_network_crypto_request.ccm, net_mic);
 #ifdef LOG_NETWORK
-    printf("RX-NetMIC (%p): ", incoming_pdu_decoded); 
+    printf("RX-NetMIC (%p): ", decoded_pdu);
     printf_hexdump(net_mic, net_mic_len);
 #endif
     // store in decoded pdu
-    (void)memcpy(&incoming_pdu_decoded->data[incoming_pdu_decoded->len - net_mic_len],
-                 net_mic, net_mic_len);
+    (void)memcpy(&decoded_pdu->data[decoded_pdu->len - net_mic_len], net_mic, net_mic_len);
 
 #ifdef LOG_NETWORK
-    uint8_t cypher_len  = incoming_pdu_decoded->len - 9 - net_mic_len;
-    printf("RX-Decrypted DST/TransportPDU (%p): ", incoming_pdu_decoded);
-    printf_hexdump(&incoming_pdu_decoded->data[7], 2 + cypher_len);
+    uint8_t cypher_len  = decoded_pdu->len - 9 - net_mic_len;
+    printf("RX-Decrypted DST/TransportPDU (%p): ", decoded_pdu);
+    printf_hexdump(&decoded_pdu->data[7], 2 + cypher_len);
 
     printf("RX-Decrypted: ");
-    printf_hexdump(incoming_pdu_decoded->data, incoming_pdu_decoded->len);
+    printf_hexdump(decoded_pdu->data, decoded_pdu->len);
 #endif
 
     // validate network mic
-    if (memcmp(net_mic, &incoming_pdu_raw->data[incoming_pdu_decoded->len-net_mic_len], net_mic_len) != 0){
-        // fail
-        printf("RX-NetMIC mismatch, try next key (%p)\n", incoming_pdu_decoded);
-        process_network_pdu_validate();
-        return;
-    }    
+    if (memcmp(net_mic, &context->raw_pdu->data[decoded_pdu->len - net_mic_len], net_mic_len) != 0){
+#ifdef LOG_NETWORK
+        printf("RX-NetMIC mismatch, try next key (%p)\n", decoded_pdu);
+#endif
+        return false;
+    }
+    return true;
+}
+
+// pass validated pdu to proxy or higher layer, or drop it
+static void process_network_pdu_deliver(mesh_network_pdu_t * decoded_pdu){
+    uint8_t ctl_ttl     = decoded_pdu->data[1];
+    uint8_t ctl         = ctl_ttl >> 7;
+    uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
 
     // remove NetMIC from payload
-    incoming_pdu_decoded->len -= net_mic_len;
+    decoded_pdu->len -= net_mic_len;
 
 #ifdef LOG_NETWORK
     // match
-    printf("RX-NetMIC matches (%p)\n", incoming_pdu_decoded);
-    printf("RX-TTL (%p): 0x%02x\n", incoming_pdu_decoded, incoming_pdu_decoded->data[1] & 0x7f);
+    printf("RX-NetMIC matches (%p)\n", decoded_pdu);
+    printf("RX-TTL (%p): 0x%02x\n", decoded_pdu, decoded_pdu->data[1] & 0x7f);
 #endif
 
-    // set netkey_index
-    incoming_pdu_decoded->netkey_index = current_network_key->netkey_index;
-
-    if (incoming_pdu_decoded->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
-
-        mesh_network_pdu_t * decoded_pdu = incoming_pdu_decoded;
-        incoming_pdu_decoded = NULL;
-
+    if (decoded_pdu->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
         // no additional checks for proxy messages
         (*mesh_network_proxy_message_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
- 
-    } else {
+        return;
+    }
 
-        // validate src/dest addresses
-        uint16_t src = big_endian_read_16(incoming_pdu_decoded->data, 5);
-        uint16_t dst = big_endian_read_16(incoming_pdu_decoded->data, 7);
-        int valid = mesh_network_addresses_valid(ctl, src, dst);
-        if (!valid){
+    // validate src/dest addresses
+    uint16_t src = big_endian_read_16(decoded_pdu->data, 5);
+    uint16_t dst = big_endian_read_16(decoded_pdu->data, 7);
+    int valid = mesh_network_addresses_valid(ctl, src, dst);
+    if (!valid){
 #ifdef LOG_NETWORK
-            printf("RX Address invalid (%p)\n", incoming_pdu_decoded);
+        printf("RX Address invalid (%p)\n", decoded_pdu);
 #endif
-            btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
-            incoming_pdu_decoded = NULL;
-            process_network_pdu_done();
-            return;
-        }
+        btstack_memory_mesh_network_pdu_free(decoded_pdu);
+        return;
+    }
 
-        // check cache
-        uint32_t hash = mesh_network_cache_hash(incoming_pdu_decoded);
+    // check cache and store if new
+    uint8_t  ivi = decoded_pdu->data[0] >> 7;
+    uint32_t seq = big_endian_read_24(decoded_pdu->data, 2);
+    if (mesh_network_cache_lookup_and_add(src, seq, ivi)){
+        // found in cache, drop
 #ifdef LOG_NETWORK
-        printf("RX-Hash (%p): %08x\n", incoming_pdu_decoded, hash);
+        printf("Found in cache -> drop packet (%p)\n", decoded_pdu);
 #endif
-        if (mesh_network_cache_find(hash)){
-            // found in cache, drop
-#ifdef LOG_NETWORK
-            printf("Found in cache -> drop packet (%p)\n", incoming_pdu_decoded);
-#endif
-            btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
-            incoming_pdu_decoded = NULL;
-            process_network_pdu_done();
-            return;
-        }
-
-        // store in network cache
-        mesh_network_cache_add(hash);
+        btstack_memory_mesh_network_pdu_free(decoded_pdu);
+        return;
+    }
 
 #ifdef LOG_NETWORK
-            printf("RX-Validated (%p) - forward to lower transport\n", incoming_pdu_decoded);
+    printf("RX-Validated (%p) - forward to lower transport\n", decoded_pdu);
 #endif
 
-        // forward to lower transport layer. message is freed by call to mesh_network_message_processed_by_upper_layer
-        mesh_network_pdu_t * decoded_pdu = incoming_pdu_decoded;
-        incoming_pdu_decoded = NULL;
-        (*mesh_network_higher_layer_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
+    // forward to lower transport layer. message is freed by call to mesh_network_message_processed_by_upper_layer
+    (*mesh_network_higher_layer_handler)(MESH_NETWORK_PDU_RECEIVED, decoded_pdu);
+}
+
+// validated pdus are delivered in order of reception by mesh_network_run_validated
+static void process_network_pdu_finalize(mesh_network_rx_context_t * context, bool net_mic_matches){
+    if (net_mic_matches){
+        context->decoded_pdu->netkey_index = context->network_key->netkey_index;
+    } else {
+        log_info("No valid network key found");
+        btstack_memory_mesh_network_pdu_free(context->decoded_pdu);
+        context->decoded_pdu = NULL;
+    }
+    btstack_memory_mesh_network_pdu_free(context->raw_pdu);
+    context->raw_pdu = NULL;
+    context->validated = true;
+}
+
+#ifdef MESH_NETWORK_RX_SYNCHRONOUS
+
+// AES-CCM decryption with 13 byte nonce, L = 2 and no additional data, see RFC 3610
+// returns encrypted authentication value in net_mic as btstack_crypto_ccm_get_authentication_value
+static void process_network_pdu_ccm_decrypt(const uint8_t * key, const uint8_t * nonce, const uint8_t * ciphertext, uint8_t len,
+                                            uint8_t net_mic_len, uint8_t * plaintext, uint8_t * net_mic){
+    uint8_t a_i[16];
+    uint8_t s_i[16];
+    uint8_t x_i[16];
+    uint8_t b_i[16];
+
+    // X_1 = E(K, B_0)
+    b_i[0] = (uint8_t) ((((net_mic_len - 2u) / 2u) << 3) | 1u);
+    (void)memcpy(&b_i[1], nonce, 13);
+    big_endian_store_16(b_i, 14, len);
+    btstack_aes128_calc(key, b_i, x_i);
+
+    // A_i = flags | nonce | counter i
+    a_i[0] = 1u;
+    (void)memcpy(&a_i[1], nonce, 13);
+
+    uint16_t counter = 1;
+    uint8_t  offset  = 0;
+    unsigned int i;
+    while (offset < len){
+        uint8_t block_len = (uint8_t) btstack_min(len - offset, 16);
+        big_endian_store_16(a_i, 14, counter);
+        btstack_aes128_calc(key, a_i, s_i);
+        for (i=0;i<block_len;i++){
+            plaintext[offset+i] = ciphertext[offset+i] ^ s_i[i];
+            x_i[i] ^= plaintext[offset+i];
+        }
+        (void)memcpy(b_i, x_i, 16);
+        btstack_aes128_calc(key, b_i, x_i);
+        offset += block_len;
+        counter++;
     }
 
-    // done
-    process_network_pdu_done();
+    // encrypt authentication value with S_0
+    big_endian_store_16(a_i, 14, 0);
+    btstack_aes128_calc(key, a_i, s_i);
+    for (i=0;i<net_mic_len;i++){
+        net_mic[i] = x_i[i] ^ s_i[i];
+    }
 }
 
-static uint32_t iv_index_for_pdu(const mesh_network_pdu_t * network_pdu){
-    // get IV Index and IVI
-    uint32_t iv_index = mesh_get_iv_index();
-    int ivi = network_pdu->data[0] >> 7;
-
-    // if least significant bit differs, use previous IV Index
-    if ((iv_index & 1 ) ^ ivi){
-        iv_index--;
-#ifdef LOG_NETWORK
-        printf("RX-IV: IVI indicates previous IV index, using 0x%08x\n", iv_index);
-#endif
+static void process_network_pdu_validate(mesh_network_rx_context_t * context){
+    uint8_t pecb_input[16];
+    uint8_t pecb[16];
+    uint8_t net_mic[8];
+    bool net_mic_matches = false;
+
+    // try all network keys with matching NID
+    while (mesh_network_key_nid_iterator_has_more(&context->key_it)){
+        context->network_key = mesh_network_key_nid_iterator_get_next(&context->key_it);
+
+        // calc PECB
+        process_network_pdu_setup_pecb(context, pecb_input);
+        btstack_aes128_calc(context->network_key->privacy_key, pecb_input, pecb);
+        process_network_pdu_deobfuscate(context, pecb);
+
+        uint8_t ctl_ttl     = context->decoded_pdu->data[1];
+        uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
+        uint8_t cypher_len  = context->decoded_pdu->len - 7 - net_mic_len;
+        process_network_pdu_ccm_decrypt(context->network_key->encryption_key, context->network_nonce,
+                                        &context->raw_pdu->data[7], cypher_len, net_mic_len,
+                                        &context->decoded_pdu->data[7], net_mic);
+
+        net_mic_matches = process_network_pdu_check_net_mic(context, net_mic);
+        if (net_mic_matches) break;
     }
-    return iv_index;
+
+    process_network_pdu_finalize(context, net_mic_matches);
 }
 
-static void process_network_pdu_validate_b(void * arg){
-    UNUSED(arg);
+#else
 
-#ifdef LOG_NETWORK
-    printf("RX-PECB: ");
-    printf_hexdump(obfuscation_block, 6);
-#endif
+static void process_network_pdu_done(mesh_network_rx_context_t * context, bool net_mic_matches){
+    process_network_pdu_finalize(context, net_mic_matches);
+    mesh_network_run();
+}
 
-    // de-obfuscate
-    unsigned int i;
-    for (i=0;i<6;i++){
-        incoming_pdu_decoded->data[1+i] = incoming_pdu_raw->data[1+i] ^ obfuscation_block[i];
+static void process_network_pdu_validate_d(void * arg){
+    mesh_network_rx_context_t * context = (mesh_network_rx_context_t *) arg;
+
+    uint8_t net_mic[8];
+    btstack_crypto_ccm_get_authentication_value(&context->crypto_request.ccm, net_mic);
+    if (!process_network_pdu_check_net_mic(context, net_mic)){
+        // try next key, later pdus are not delivered before this one
+        process_network_pdu_validate(context);
+        return;
     }
 
-    uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
+    process_network_pdu_done(context, true);
+}
 
-    if (incoming_pdu_decoded->flags & MESH_NETWORK_PDU_FLAGS_PROXY_CONFIGURATION){
-        // create network nonce
-        mesh_proxy_create_nonce(network_nonce, incoming_pdu_decoded, iv_index);
-#ifdef LOG_NETWORK
-        printf("RX-Proxy Nonce: ");
-        printf_hexdump(network_nonce, 13);
-#endif
-    } else {
-        // create network nonce
-        mesh_network_create_nonce(network_nonce, incoming_pdu_decoded, iv_index);
-#ifdef LOG_NETWORK
-        printf("RX-Network Nonce: ");
-        printf_hexdump(network_nonce, 13);
-#endif
-    }
+static void process_network_pdu_validate_b(void * arg){
+    mesh_network_rx_context_t * context = (mesh_network_rx_context_t *) arg;
+
+    process_network_pdu_deobfuscate(context, context->obfuscation_block);
 
     // 
-    uint8_t ctl_ttl     = incoming_pdu_decoded->data[1];
+    uint8_t ctl_ttl     = context->decoded_pdu->data[1];
     uint8_t net_mic_len = (ctl_ttl & 0x80) ? 8 : 4;
-    uint8_t cypher_len  = incoming_pdu_decoded->len - 7 - net_mic_len;
+    uint8_t cypher_len  = context->decoded_pdu->len - 7 - net_mic_len;
 
 #ifdef LOG_NETWORK
     printf("RX-Cyper len %u, mic len %u\n", cypher_len, net_mic_len);
 
     printf("RX-Encryption Key: ");
-    printf_hexdump(current_network_key->encryption_key, 16);
+    printf_hexdump(context->network_key->encryption_key, 16);
 
 #endif
 
-    btstack_crypto_ccm_init(&mesh_network_crypto_request.ccm, current_network_key->encryption_key, network_nonce, cypher_len, 0, net_mic_len);
-    btstack_crypto_ccm_decrypt_block(&mesh_network_crypto_request.ccm, cypher_len, &incoming_pdu_raw->data[7], &incoming_pdu_decoded->data[7], &process_network_pdu_validate_d, incoming_pdu_decoded);
+    btstack_crypto_ccm_init(&context->crypto_request.ccm, context->network_key->encryption_key, context->network_nonce, cypher_len, 0, net_mic_len);
+    btstack_crypto_ccm_decrypt_block(&context->crypto_request.ccm, cypher_len, &context->raw_pdu->data[7], &context->decoded_pdu->data[7], &process_network_pdu_validate_d, context);
 }
 
-static void process_network_pdu_validate(void){
-    if (!mesh_network_key_nid_iterator_has_more(&validation_network_key_it)){
-        printf("No valid network key found\n");
-        btstack_memory_mesh_network_pdu_free(incoming_pdu_decoded);
-        incoming_pdu_decoded = NULL;
-        process_network_pdu_done();
+static void process_network_pdu_validate(mesh_network_rx_context_t * context){
+    if (!mesh_network_key_nid_iterator_has_more(&context->key_it)){
+        process_network_pdu_done(context, false);
         return;
     }
 
-    current_network_key = mesh_network_key_nid_iterator_get_next(&validation_network_key_it);
+    context->network_key = mesh_network_key_nid_iterator_get_next(&context->key_it);
 
     // calc PECB
-    uint32_t iv_index = iv_index_for_pdu(incoming_pdu_raw);
-    memset(encryption_block, 0, 5);
-    big_endian_store_32(encryption_block, 5, iv_index);
-    (void)memcpy(&encryption_block[9], &incoming_pdu_raw->data[7], 7);
-    btstack_crypto_aes128_encrypt(&mesh_network_crypto_request.aes128, current_network_key->privacy_key, encryption_block, obfuscation_block, &process_network_pdu_validate_b, NULL);
+    process_network_pdu_setup_pecb(context, context->encryption_block);
+    btstack_crypto_aes128_encrypt(&context->crypto_request.aes128, context->network_key->privacy_key, context->encryption_block, context->obfuscation_block, &process_network_pdu_validate_b, context);
 }
 
+#endif
 
-static void process_network_pdu(void){
+static void process_network_pdu(mesh_network_rx_context_t * context){
     //
-    uint8_t nid_ivi = incoming_pdu_raw->data[0];
+    uint8_t nid_ivi = context->raw_pdu->data[0];
 
     // setup pdu object
-    incoming_pdu_decoded->data[0] = nid_ivi;
-    incoming_pdu_decoded->len     = incoming_pdu_raw->len;
-    incoming_pdu_decoded->flags   = incoming_pdu_raw->flags;
+    context->decoded_pdu->data[0] = nid_ivi;
+    context->decoded_pdu->len     = context->raw_pdu->len;
+    context->decoded_pdu->flags   = context->raw_pdu->flags;
 
     // init provisioning data iterator
     uint8_t nid = nid_ivi & 0x7f;
     // uint8_t iv_index = network_pdu_data[0] >> 7;
-    mesh_network_key_nid_iterator_init(&validation_network_key_it, nid);
+    mesh_network_key_nid_iterator_init(&context->key_it, nid);
 
-    process_network_pdu_validate();
+    process_network_pdu_validate(context);
 }
 
 // returns true if done
@@ -787,22 +887,45 @@ static bool mesh_network_run_adv(void){
 
 // returns true if done
 static bool mesh_network_run_received(void){
-    if (mesh_crypto_active) {
+    if (btstack_linked_list_empty(&network_pdus_received)) {
         return true;
     }
 
-    if (btstack_linked_list_empty(&network_pdus_received)) {
+    mesh_network_rx_context_t * context = mesh_network_rx_context_for_raw_pdu();
+    if (context == NULL) return true;
+
+    context->decoded_pdu = mesh_network_pdu_get();
+    if (context->decoded_pdu == NULL) return true;
+
+    // get encoded network pdu and start processing
+    context->raw_pdu = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_received);
+    mesh_network_rx_contexts_active++;
+    process_network_pdu(context);
+    return false;
+}
+
+// returns true if done
+static bool mesh_network_run_validated(void){
+    if (mesh_network_rx_contexts_active == 0){
         return true;
     }
 
-    incoming_pdu_decoded = mesh_network_pdu_get();
-    if (incoming_pdu_decoded == NULL) return true;
+    // deliver in order of reception
+    mesh_network_rx_context_t * context = &mesh_network_rx_contexts[mesh_network_rx_context_oldest];
+    if (context->validated == false){
+        return true;
+    }
 
-    // get encoded network pdu and start processing
-    mesh_crypto_active = 1;
-    incoming_pdu_raw = (mesh_network_pdu_t *) btstack_linked_list_pop(&network_pdus_received);
-    process_network_pdu();
-    return true;
+    mesh_network_pdu_t * decoded_pdu = context->decoded_pdu;
+    context->decoded_pdu = NULL;
+    context->validated = false;
+    mesh_network_rx_context_oldest = (mesh_network_rx_context_oldest + 1) % MESH_NETWORK_RX_PIPELINE_SIZE;
+    mesh_network_rx_contexts_active--;
+
+    if (decoded_pdu != NULL){
+        process_network_pdu_deliver(decoded_pdu);
+    }
+    return false;
 }
 
 // returns true if done
@@ -827,14 +950,23 @@ static bool mesh_network_run_queued(void){
 }
 
 static void mesh_network_run(void){
+    // called from higher layer or bearer while running, e.g. on delivery of a validated pdu
+    if (mesh_network_run_active){
+        mesh_network_run_requested = true;
+        return;
+    }
+    mesh_network_run_active = true;
     while (true){
+        mesh_network_run_requested = false;
         bool done = true;
         done &= mesh_network_run_gatt();
         done &= mesh_network_run_adv();
         done &= mesh_network_run_received();
+        done &= mesh_network_run_validated();
         done &= mesh_network_run_queued();
-        if (done) break;
+        if (done && !mesh_network_run_requested) break;
     }
+    mesh_network_run_active = false;
 }
 
 #ifdef ENABLE_MESH_ADV_BEARER
@@ -991,6 +1123,7 @@ static void mesh_netework_gatt_bearer_handle_proxy_configuration(uint8_t packet_
 #endif
 
 void mesh_network_init(void){
+    mesh_network_cache_reset();
 #ifdef ENABLE_MESH_ADV_BEARER
     adv_bearer_register_for_network_pdu(&mesh_adv_bearer_handle_network_event);
 #endif
@@ -1195,8 +1328,11 @@ void mesh_network_dump(void){
     mesh_network_dump_network_pdus("network_pdus_outgoing_adv", &network_pdus_outgoing_adv);
     printf("outgoing_pdu: \n");
     mesh_network_dump_network_pdu(outgoing_pdu);
-    printf("incoming_pdu_raw: \n");
-    mesh_network_dump_network_pdu(incoming_pdu_raw);
+    unsigned int i;
+    for (i=0;i<MESH_NETWORK_RX_PIPELINE_SIZE;i++){
+        printf("incoming_pdu_raw[%u]: \n", i);
+        mesh_network_dump_network_pdu(mesh_network_rx_contexts[i].raw_pdu);
+    }
 #ifdef ENABLE_MESH_GATT_BEARER
     printf("gatt_bearer_network_pdu: \n");
     mesh_network_dump_network_pdu(gatt_bearer_network_pdu);
@@ -1208,6 +1344,8 @@ void mesh_network_dump(void){
 
 }
 void mesh_network_reset(void){
+    mesh_network_cache_reset();
+
     mesh_network_reset_network_pdus(&network_pdus_received);
     mesh_network_reset_network_pdus(&network_pdus_queued);
     mesh_network_reset_network_pdus(&network_pdus_outgoing_gatt);
@@ -1225,14 +1363,21 @@ void mesh_network_reset(void){
 #endif
     outgoing_pdu = NULL;
     
-    if (incoming_pdu_raw){
-        mesh_network_pdu_free(incoming_pdu_raw);
-        incoming_pdu_raw = NULL;
-    }
-    if (incoming_pdu_decoded){
-        mesh_network_pdu_free(incoming_pdu_decoded);
-        incoming_pdu_decoded = NULL;
+    unsigned int i;
+    for (i=0;i<MESH_NETWORK_RX_PIPELINE_SIZE;i++){
+        mesh_network_rx_context_t * context = &mesh_network_rx_contexts[i];
+        if (context->raw_pdu){
+            mesh_network_pdu_free(context->raw_pdu);
+            context->raw_pdu = NULL;
+        }
+        if (context->decoded_pdu){
+            mesh_network_pdu_free(context->decoded_pdu);
+            context->decoded_pdu = NULL;
+        }
+        context->validated = false;
     }
+    mesh_network_rx_context_oldest = 0;
+    mesh_network_rx_contexts_active = 0;
     mesh_crypto_active = 0;
 }
 
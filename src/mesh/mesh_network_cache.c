@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "mesh_network_cache.c"
+
+#include "mesh/mesh_network_cache.h"
+
+#include <string.h>
+
+#include "btstack_bool.h"
+#include "btstack_config.h"
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+
+// max number of cached Network PDUs, power of two
+#ifndef MESH_NETWORK_CACHE_SIZE
+#define MESH_NETWORK_CACHE_SIZE 64
+#endif
+
+// entries older than this are evicted, 0 = evict only if cache is full
+#ifndef MESH_NETWORK_CACHE_TIMEOUT_MS
+#define MESH_NETWORK_CACHE_TIMEOUT_MS 10000
+#endif
+
+#if (MESH_NETWORK_CACHE_SIZE == 0) || ((MESH_NETWORK_CACHE_SIZE & (MESH_NETWORK_CACHE_SIZE - 1)) != 0)
+#error "MESH_NETWORK_CACHE_SIZE must be a power of two"
+#endif
+
+// hash set has twice as many buckets as entries to keep probe sequences short
+#define MESH_NETWORK_CACHE_NUM_BUCKETS (2 * MESH_NETWORK_CACHE_SIZE)
+
+typedef struct {
+    // IVI << 24 | SEQ
+    uint32_t ivi_seq;
+    uint32_t timestamp_ms;
+    uint16_t src;
+} mesh_network_cache_entry_t;
+
+// entries in insertion order, ring buffer starting at oldest
+static mesh_network_cache_entry_t mesh_network_cache_entries[MESH_NETWORK_CACHE_SIZE];
+static uint16_t mesh_network_cache_oldest;
+static uint16_t mesh_network_cache_num_entries;
+
+// open-addressed hash set with linear probing, stores entry index + 1, 0 = empty bucket
+static uint16_t mesh_network_cache_buckets[MESH_NETWORK_CACHE_NUM_BUCKETS];
+
+static uint32_t mesh_network_cache_hits;
+static uint32_t mesh_network_cache_misses;
+
+static uint16_t mesh_network_cache_home_bucket(uint16_t src, uint32_t ivi_seq){
+    uint32_t hash = (((uint32_t) src) << 16) ^ ivi_seq;
+    hash *= 0x9E3779B1u;
+    return (uint16_t) ((hash >> 16) & (MESH_NETWORK_CACHE_NUM_BUCKETS - 1));
+}
+
+static uint16_t mesh_network_cache_home_bucket_for_entry(uint16_t entry_index){
+    const mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[entry_index];
+    return mesh_network_cache_home_bucket(entry->src, entry->ivi_seq);
+}
+
+// returns bucket with entry or first empty bucket in probe sequence
+static uint16_t mesh_network_cache_find_bucket(uint16_t src, uint32_t ivi_seq){
+    uint16_t bucket = mesh_network_cache_home_bucket(src, ivi_seq);
+    while (mesh_network_cache_buckets[bucket] != 0u){
+        const mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[mesh_network_cache_buckets[bucket] - 1u];
+        if ((entry->src == src) && (entry->ivi_seq == ivi_seq)) break;
+        bucket = (bucket + 1u) & (MESH_NETWORK_CACHE_NUM_BUCKETS - 1u);
+    }
+    return bucket;
+}
+
+static void mesh_network_cache_remove_oldest(void){
+    const mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[mesh_network_cache_oldest];
+    uint16_t free_bucket = mesh_network_cache_find_bucket(entry->src, entry->ivi_seq);
+    btstack_assert(mesh_network_cache_buckets[free_bucket] != 0u);
+
+    // backward shift deletion: move following entries of the probe sequence into the free bucket
+    // unless their home bucket lies cyclically in (free_bucket, bucket]
+    mesh_network_cache_buckets[free_bucket] = 0;
+    uint16_t bucket = free_bucket;
+    while (true){
+        bucket = (bucket + 1u) & (MESH_NETWORK_CACHE_NUM_BUCKETS - 1u);
+        if (mesh_network_cache_buckets[bucket] == 0u) break;
+        uint16_t home = mesh_network_cache_home_bucket_for_entry(mesh_network_cache_buckets[bucket] - 1u);
+        bool stays;
+        if (free_bucket <= bucket){
+            stays = (free_bucket < home) && (home <= bucket);
+        } else {
+            stays = (free_bucket < home) || (home <= bucket);
+        }
+        if (stays) continue;
+        mesh_network_cache_buckets[free_bucket] = mesh_network_cache_buckets[bucket];
+        mesh_network_cache_buckets[bucket] = 0;
+        free_bucket = bucket;
+    }
+
+    mesh_network_cache_oldest = (mesh_network_cache_oldest + 1u) & (MESH_NETWORK_CACHE_SIZE - 1u);
+    mesh_network_cache_num_entries--;
+}
+
+#if MESH_NETWORK_CACHE_TIMEOUT_MS > 0
+static void mesh_network_cache_remove_expired(uint32_t now){
+    while (mesh_network_cache_num_entries > 0u){
+        const mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[mesh_network_cache_oldest];
+        if (btstack_time_delta(now, entry->timestamp_ms) < MESH_NETWORK_CACHE_TIMEOUT_MS) break;
+        mesh_network_cache_remove_oldest();
+    }
+}
+#endif
+
+void mesh_network_cache_reset(void){
+    memset(mesh_network_cache_buckets, 0, sizeof(mesh_network_cache_buckets));
+    mesh_network_cache_oldest = 0;
+    mesh_network_cache_num_entries = 0;
+    mesh_network_cache_hits = 0;
+    mesh_network_cache_misses = 0;
+}
+
+int mesh_network_cache_lookup_and_add(uint16_t src, uint32_t seq, uint8_t ivi){
+    uint32_t ivi_seq = (((uint32_t) (ivi & 1u)) << 24) | (seq & 0x00ffffffu);
+    uint32_t now = 0;
+
+#if MESH_NETWORK_CACHE_TIMEOUT_MS > 0
+    now = btstack_run_loop_get_time_ms();
+    mesh_network_cache_remove_expired(now);
+#endif
+
+    uint16_t bucket = mesh_network_cache_find_bucket(src, ivi_seq);
+    if (mesh_network_cache_buckets[bucket] != 0u){
+        mesh_network_cache_hits++;
+        return 1;
+    }
+    mesh_network_cache_misses++;
+
+    // evict oldest entry if full, this might move the empty bucket found above
+    if (mesh_network_cache_num_entries == MESH_NETWORK_CACHE_SIZE){
+        mesh_network_cache_remove_oldest();
+        bucket = mesh_network_cache_find_bucket(src, ivi_seq);
+    }
+
+    uint16_t entry_index = (mesh_network_cache_oldest + mesh_network_cache_num_entries) & (MESH_NETWORK_CACHE_SIZE - 1u);
+    mesh_network_cache_entry_t * entry = &mesh_network_cache_entries[entry_index];
+    entry->src = src;
+    entry->ivi_seq = ivi_seq;
+    entry->timestamp_ms = now;
+    mesh_network_cache_buckets[bucket] = entry_index + 1u;
+    mesh_network_cache_num_entries++;
+    return 0;
+}
+
+uint32_t mesh_network_cache_get_hits(void){
+    return mesh_network_cache_hits;
+}
+
+uint32_t mesh_network_cache_get_misses(void){
+    return mesh_network_cache_misses;
+}
+
+uint16_t mesh_network_cache_get_num_entries(void){
+    return mesh_network_cache_num_entries;
+}
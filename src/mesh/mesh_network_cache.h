@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#ifndef __MESH_NETWORK_CACHE_H
+#define __MESH_NETWORK_CACHE_H
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Network Message Cache
+ *
+ * Stores (SRC, SEQ, IVI) of recently received Network PDUs to drop duplicates before relaying them or
+ * passing them to the lower transport layer. Entries are kept in an open-addressed hash set and evicted
+ * in insertion order when the cache is full or when they are older than MESH_NETWORK_CACHE_TIMEOUT_MS.
+ */
+
+/**
+ * @brief Clear all entries and statistics
+ */
+void mesh_network_cache_reset(void);
+
+/**
+ * @brief Check if Network PDU with given SRC, SEQ and IVI is in the cache, add it otherwise
+ * @param src
+ * @param seq 24-bit sequence number
+ * @param ivi least significant bit of IV Index
+ * @return 1 if already in cache (duplicate), 0 if added
+ */
+int mesh_network_cache_lookup_and_add(uint16_t src, uint32_t seq, uint8_t ivi);
+
+/**
+ * @brief Get number of Network PDUs found in cache since reset
+ */
+uint32_t mesh_network_cache_get_hits(void);
+
+/**
+ * @brief Get number of Network PDUs not found in cache since reset
+ */
+uint32_t mesh_network_cache_get_misses(void);
+
+/**
+ * @brief Get number of entries currently stored
+ */
+uint16_t mesh_network_cache_get_num_entries(void);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif //__MESH_NETWORK_CACHE_H
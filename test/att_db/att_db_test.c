@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2014 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "hci.h"
+#include "ble/att_db.h"
+#include "ble/att_db_util.h"
+#include "btstack_util.h"
+#include "bluetooth.h"
+#include "bluetooth_gatt.h"
+
+#define NUM_CHARACTERISTICS 60
+
+static uint16_t value_handles[NUM_CHARACTERISTICS];
+static uint16_t max_handle;
+
+static uint16_t read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(attribute_handle);
+    UNUSED(offset);
+    UNUSED(buffer);
+    UNUSED(buffer_size);
+    return 0;
+}
+
+// mock
+extern "C" {
+    void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    }
+    void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+        (void) event_codes;
+        hci_add_event_handler(callback_handler);
+    }
+    int hci_can_send_command_packet_now(void){
+        return 1;
+    }
+    HCI_STATE hci_get_state(void){
+        return HCI_STATE_WORKING;
+    }
+    void hci_halting_defer(void){
+    }
+    int hci_send_cmd(const hci_cmd_t *cmd, ...){
+        return 0;
+    }
+}
+
+static uint16_t characteristic_uuid16(int i){
+    return 0x2a00 + i;
+}
+
+TEST_GROUP(AttDb){
+    att_connection_t att_connection;
+    uint8_t response[100];
+
+    void setup(void){
+        memset(&att_connection, 0, sizeof(att_connection));
+        att_connection.mtu = 100;
+        att_connection.max_mtu = 100;
+
+        // service with characteristics, each with declaration, value and client configuration
+        att_db_util_init();
+        att_db_util_add_service_uuid16(0x1234);
+        int i;
+        for (i=0;i<NUM_CHARACTERISTICS;i++){
+            uint8_t value = i;
+            value_handles[i] = att_db_util_add_characteristic_uuid16(characteristic_uuid16(i), ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY, ATT_SECURITY_NONE, ATT_SECURITY_NONE, &value, 1);
+        }
+        max_handle = value_handles[NUM_CHARACTERISTICS-1] + 1;
+        att_set_db(att_db_util_get_address());
+        att_set_read_callback(&read_callback);
+    }
+    void teardown(void){
+        free(att_db_util_get_address());
+    }
+};
+
+TEST(AttDb, UuidForHandle){
+    CHECK_EQUAL(0, att_uuid_for_handle(0));
+    CHECK_EQUAL(GATT_PRIMARY_SERVICE_UUID, att_uuid_for_handle(1));
+    int i;
+    for (i=0;i<NUM_CHARACTERISTICS;i++){
+        CHECK_EQUAL(GATT_CHARACTERISTICS_UUID, att_uuid_for_handle(value_handles[i] - 1));
+        CHECK_EQUAL(characteristic_uuid16(i), att_uuid_for_handle(value_handles[i]));
+        CHECK_EQUAL(GATT_CLIENT_CHARACTERISTICS_CONFIGURATION, att_uuid_for_handle(value_handles[i] + 1));
+    }
+    CHECK_EQUAL(0, att_uuid_for_handle(max_handle + 1));
+}
+
+TEST(AttDb, CharacteristicHelpers){
+    int i;
+    for (i=0;i<NUM_CHARACTERISTICS;i++){
+        uint16_t value_handle = value_handles[i];
+        CHECK_EQUAL(value_handle, gatt_server_get_value_handle_for_characteristic_with_uuid16(1, 0xffff, characteristic_uuid16(i)));
+        CHECK_EQUAL(value_handle, gatt_server_get_value_handle_for_characteristic_with_uuid16(value_handle, value_handle, characteristic_uuid16(i)));
+        CHECK_EQUAL(0, gatt_server_get_value_handle_for_characteristic_with_uuid16(value_handle + 1, 0xffff, characteristic_uuid16(i)));
+        CHECK_EQUAL(value_handle + 1, gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(1, 0xffff, characteristic_uuid16(i)));
+        CHECK_EQUAL(value_handle + 1, gatt_server_get_client_configuration_handle_for_characteristic_with_uuid16(value_handle - 1, value_handle + 1, characteristic_uuid16(i)));
+    }
+}
+
+TEST(AttDb, ReadRequest){
+    int i;
+    for (i=0;i<NUM_CHARACTERISTICS;i++){
+        uint8_t request[3];
+        request[0] = ATT_READ_REQUEST;
+        little_endian_store_16(request, 1, value_handles[i]);
+        uint16_t response_len = att_handle_request(&att_connection, request, sizeof(request), response);
+        CHECK_EQUAL(2, response_len);
+        CHECK_EQUAL(ATT_READ_RESPONSE, response[0]);
+        CHECK_EQUAL(i, response[1]);
+    }
+    uint8_t request[3];
+    request[0] = ATT_READ_REQUEST;
+    little_endian_store_16(request, 1, max_handle + 1);
+    CHECK_EQUAL(5, att_handle_request(&att_connection, request, sizeof(request), response));
+    CHECK_EQUAL(ATT_ERROR_RESPONSE, response[0]);
+    CHECK_EQUAL(ATT_ERROR_INVALID_HANDLE, response[4]);
+}
+
+TEST(AttDb, FindInformationRange){
+    uint16_t start_handle = value_handles[NUM_CHARACTERISTICS - 3];
+    uint8_t request[5];
+    request[0] = ATT_FIND_INFORMATION_REQUEST;
+    little_endian_store_16(request, 1, start_handle);
+    little_endian_store_16(request, 3, start_handle + 2);
+    uint16_t response_len = att_handle_request(&att_connection, request, sizeof(request), response);
+    CHECK_EQUAL(2 + 3 * 4, response_len);
+    CHECK_EQUAL(ATT_FIND_INFORMATION_REPLY, response[0]);
+    CHECK_EQUAL(start_handle,     little_endian_read_16(response, 2));
+    CHECK_EQUAL(characteristic_uuid16(NUM_CHARACTERISTICS - 3), little_endian_read_16(response, 4));
+    CHECK_EQUAL(start_handle + 1, little_endian_read_16(response, 6));
+    CHECK_EQUAL(start_handle + 2, little_endian_read_16(response, 10));
+    CHECK_EQUAL(GATT_CHARACTERISTICS_UUID, little_endian_read_16(response, 12));
+}
+
+TEST(AttDb, ReadByTypeRange){
+    uint16_t start_handle = value_handles[NUM_CHARACTERISTICS / 2];
+    uint8_t request[7];
+    request[0] = ATT_READ_BY_TYPE_REQUEST;
+    little_endian_store_16(request, 1, start_handle);
+    little_endian_store_16(request, 3, 0xffff);
+    little_endian_store_16(request, 5, characteristic_uuid16(NUM_CHARACTERISTICS - 1));
+    uint16_t response_len = att_handle_request(&att_connection, request, sizeof(request), response);
+    CHECK_EQUAL(5, response_len);
+    CHECK_EQUAL(ATT_READ_BY_TYPE_RESPONSE, response[0]);
+    CHECK_EQUAL(value_handles[NUM_CHARACTERISTICS - 1], little_endian_read_16(response, 2));
+    CHECK_EQUAL(NUM_CHARACTERISTICS - 1, response[4]);
+}
+
+TEST(AttDb, AttributesAddedAfterSetDb){
+    uint8_t value = 0x55;
+    uint16_t value_handle = att_db_util_add_characteristic_uuid16(0x2b00, ATT_PROPERTY_READ, ATT_SECURITY_NONE, ATT_SECURITY_NONE, &value, 1);
+    CHECK_EQUAL(0x2b00, att_uuid_for_handle(value_handle));
+    CHECK_EQUAL(value_handle, gatt_server_get_value_handle_for_characteristic_with_uuid16(value_handle, 0xffff, 0x2b00));
+    CHECK_EQUAL(value_handles[0], gatt_server_get_value_handle_for_characteristic_with_uuid16(1, 0xffff, characteristic_uuid16(0)));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -95,6 +95,10 @@ extern "C" {
     }
     void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
     }
+    void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+        (void) event_codes;
+        hci_add_event_handler(callback_handler);
+    }
     int hci_can_send_command_packet_now(void){
         return 1;
     }
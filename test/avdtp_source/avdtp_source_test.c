@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+ 
+// *****************************************************************************
+//
+// test AVDTP Source media packet assembly
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_util.h"
+#include "classic/avdtp_source.h"
+
+#define TEST_LOCAL_SEID  1
+#define TEST_MEDIA_CID   0x41
+#define TEST_REMOTE_MTU  672
+
+// mock.c
+void mock_init(uint8_t local_seid, uint16_t media_cid, uint16_t remote_mtu);
+const uint8_t * mock_sent_packet(void);
+uint16_t mock_sent_packet_len(void);
+int mock_outgoing_buffer_is_reserved(void);
+
+static uint8_t payload[TEST_REMOTE_MTU];
+
+TEST_GROUP(AvdtpSource){
+    void setup(void){
+        mock_init(TEST_LOCAL_SEID, TEST_MEDIA_CID, TEST_REMOTE_MTU);
+        unsigned int i;
+        for (i = 0; i < sizeof(payload); i++){
+            payload[i] = (uint8_t) i;
+        }
+    }
+};
+
+TEST(AvdtpSource, MaxMediaPayloadSize){
+    // RTP header and number of frames byte
+    CHECK_EQUAL(TEST_REMOTE_MTU - 12 - 1, avdtp_max_media_payload_size(0, TEST_LOCAL_SEID));
+}
+
+TEST(AvdtpSource, SendMaxMediaPayload){
+    int max_payload_size = avdtp_max_media_payload_size(0, TEST_LOCAL_SEID);
+    int size = avdtp_source_stream_send_media_payload(0, TEST_LOCAL_SEID, payload, max_payload_size, 5, 0);
+    CHECK_EQUAL(TEST_REMOTE_MTU, size);
+    CHECK_EQUAL(TEST_REMOTE_MTU, mock_sent_packet_len());
+    const uint8_t * packet = mock_sent_packet();
+    CHECK_EQUAL(0x80, packet[0]);
+    CHECK_EQUAL(0, big_endian_read_16(packet, 2));
+    CHECK_EQUAL(5, packet[12]);
+    MEMCMP_EQUAL(payload, &packet[13], max_payload_size);
+}
+
+TEST(AvdtpSource, SendMediaPayloadTooLarge){
+    int max_payload_size = avdtp_max_media_payload_size(0, TEST_LOCAL_SEID);
+    int size = avdtp_source_stream_send_media_payload(0, TEST_LOCAL_SEID, payload, max_payload_size + 1, 5, 0);
+    CHECK_EQUAL(0, size);
+    CHECK_EQUAL(0, mock_sent_packet_len());
+    CHECK_FALSE(mock_outgoing_buffer_is_reserved());
+
+    // sequence number not consumed by dropped packet
+    size = avdtp_source_stream_send_media_payload(0, TEST_LOCAL_SEID, payload, max_payload_size, 5, 0);
+    CHECK_EQUAL(TEST_REMOTE_MTU, size);
+    CHECK_EQUAL(0, big_endian_read_16(mock_sent_packet(), 2));
+}
+
+TEST(AvdtpSource, SendWithoutMediaConnection){
+    mock_init(TEST_LOCAL_SEID, 0, TEST_REMOTE_MTU);
+    CHECK_EQUAL(0, avdtp_max_media_payload_size(0, TEST_LOCAL_SEID));
+    CHECK_EQUAL(0, avdtp_source_stream_send_media_payload(0, TEST_LOCAL_SEID, payload, 10, 1, 0));
+    CHECK_FALSE(mock_outgoing_buffer_is_reserved());
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+ 
+// *****************************************************************************
+//
+// AVDTP and L2CAP mock for AVDTP Source test
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#include "btstack_config.h"
+#include "l2cap.h"
+#include "classic/avdtp.h"
+#include "classic/avdtp_util.h"
+
+static avdtp_stream_endpoint_t mock_stream_endpoint;
+static uint8_t  mock_outgoing_buffer[1024];
+static uint16_t mock_remote_mtu;
+static int      mock_outgoing_buffer_reserved;
+static uint16_t mock_sent_len;
+
+void mock_init(uint8_t local_seid, uint16_t media_cid, uint16_t remote_mtu){
+    memset(&mock_stream_endpoint, 0, sizeof(mock_stream_endpoint));
+    mock_stream_endpoint.sep.seid = local_seid;
+    mock_stream_endpoint.l2cap_media_cid = media_cid;
+    mock_remote_mtu = remote_mtu;
+    mock_outgoing_buffer_reserved = 0;
+    mock_sent_len = 0;
+}
+
+const uint8_t * mock_sent_packet(void){
+    return mock_outgoing_buffer;
+}
+
+uint16_t mock_sent_packet_len(void){
+    return mock_sent_len;
+}
+
+int mock_outgoing_buffer_is_reserved(void){
+    return mock_outgoing_buffer_reserved;
+}
+
+uint16_t l2cap_get_remote_mtu_for_local_cid(uint16_t local_cid){
+    UNUSED(local_cid);
+    return mock_remote_mtu;
+}
+
+int l2cap_reserve_packet_buffer(void){
+    mock_outgoing_buffer_reserved = 1;
+    return 1;
+}
+
+void l2cap_release_packet_buffer(void){
+    mock_outgoing_buffer_reserved = 0;
+}
+
+uint8_t * l2cap_get_outgoing_buffer(void){
+    return mock_outgoing_buffer;
+}
+
+int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
+    UNUSED(local_cid);
+    mock_sent_len = len;
+    mock_outgoing_buffer_reserved = 0;
+    return ERROR_CODE_SUCCESS;
+}
+
+avdtp_stream_endpoint_t * avdtp_get_stream_endpoint_for_seid(uint16_t seid){
+    if (seid != mock_stream_endpoint.sep.seid) return NULL;
+    return &mock_stream_endpoint;
+}
+
+uint8_t avdtp_request_can_send_now_initiator(avdtp_connection_t * connection, uint16_t l2cap_cid){
+    UNUSED(connection);
+    UNUSED(l2cap_cid);
+    return ERROR_CODE_SUCCESS;
+}
+
+void avdtp_init(void){
+}
+
+void avdtp_register_source_packet_handler(btstack_packet_handler_t callback){
+    UNUSED(callback);
+}
+
+avdtp_stream_endpoint_t * avdtp_create_stream_endpoint(avdtp_sep_type_t sep_type, avdtp_media_type_t media_type){
+    UNUSED(sep_type);
+    UNUSED(media_type);
+    return &mock_stream_endpoint;
+}
+
+void avdtp_register_media_transport_category(avdtp_stream_endpoint_t * stream_endpoint){
+    UNUSED(stream_endpoint);
+}
+
+void avdtp_register_reporting_category(avdtp_stream_endpoint_t * stream_endpoint){
+    UNUSED(stream_endpoint);
+}
+
+void avdtp_register_delay_reporting_category(avdtp_stream_endpoint_t * stream_endpoint){
+    UNUSED(stream_endpoint);
+}
+
+void avdtp_register_recovery_category(avdtp_stream_endpoint_t * stream_endpoint, uint8_t maximum_recovery_window_size, uint8_t maximum_number_media_packets){
+    UNUSED(stream_endpoint);
+    UNUSED(maximum_recovery_window_size);
+    UNUSED(maximum_number_media_packets);
+}
+
+void avdtp_register_content_protection_category(avdtp_stream_endpoint_t * stream_endpoint, uint16_t cp_type, const uint8_t * cp_type_value, uint8_t cp_type_value_len){
+    UNUSED(stream_endpoint);
+    UNUSED(cp_type);
+    UNUSED(cp_type_value);
+    UNUSED(cp_type_value_len);
+}
+
+void avdtp_register_header_compression_category(avdtp_stream_endpoint_t * stream_endpoint, uint8_t back_ch, uint8_t media, uint8_t recovery){
+    UNUSED(stream_endpoint);
+    UNUSED(back_ch);
+    UNUSED(media);
+    UNUSED(recovery);
+}
+
+void avdtp_register_media_codec_category(avdtp_stream_endpoint_t * stream_endpoint, avdtp_media_type_t media_type, avdtp_media_codec_type_t media_codec_type, uint8_t * media_codec_info, uint16_t media_codec_info_len){
+    UNUSED(stream_endpoint);
+    UNUSED(media_type);
+    UNUSED(media_codec_type);
+    UNUSED(media_codec_info);
+    UNUSED(media_codec_info_len);
+}
+
+void avdtp_register_multiplexing_category(avdtp_stream_endpoint_t * stream_endpoint, uint8_t fragmentation){
+    UNUSED(stream_endpoint);
+    UNUSED(fragmentation);
+}
+
+uint8_t avdtp_connect(bd_addr_t remote, avdtp_role_t role, uint16_t * avdtp_cid){
+    (void) remote;
+    UNUSED(role);
+    UNUSED(avdtp_cid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_disconnect(uint16_t avdtp_cid){
+    UNUSED(avdtp_cid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_open_stream(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    UNUSED(remote_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_start_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_stop_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_abort_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_suspend_stream(uint16_t avdtp_cid, uint8_t local_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_discover_stream_endpoints(uint16_t avdtp_cid){
+    UNUSED(avdtp_cid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_get_capabilities(uint16_t avdtp_cid, uint8_t remote_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(remote_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_get_all_capabilities(uint16_t avdtp_cid, uint8_t remote_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(remote_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_get_configuration(uint16_t avdtp_cid, uint8_t remote_seid){
+    UNUSED(avdtp_cid);
+    UNUSED(remote_seid);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_set_configuration(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid, uint16_t configured_services_bitmap, avdtp_capabilities_t configuration){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    UNUSED(remote_seid);
+    UNUSED(configured_services_bitmap);
+    UNUSED(configuration);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t avdtp_reconfigure(uint16_t avdtp_cid, uint8_t local_seid, uint8_t remote_seid, uint16_t configured_services_bitmap, avdtp_capabilities_t configuration){
+    UNUSED(avdtp_cid);
+    UNUSED(local_seid);
+    UNUSED(remote_seid);
+    UNUSED(configured_services_bitmap);
+    UNUSED(configuration);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint32_t btstack_run_loop_get_time_ms(void){
+    return 0;
+}
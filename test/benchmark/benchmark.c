@@ -0,0 +1,627 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY MATTHIAS RINGWALD AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#define BTSTACK_FILE__ "benchmark.c"
+
+/*
+ *  benchmark.c
+ *
+ *  Host stack throughput and latency benchmark using the virtual HCI Transport
+ *
+ *  For each test, a sink and a source process are forked and their virtual Controllers are linked via
+ *  a socket pair. The source sends data as fast as flow control allows, each payload starts with the
+ *  monotonic send time in microseconds. The sink reports received bytes/s and one-way latency.
+ *
+ *  The ertm test runs L2CAP Enhanced Retransmission Mode over a lossy link, see -p.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btstack.h"
+#include "btstack_run_loop_posix.h"
+#include "hci_transport_virtual.h"
+
+#include "benchmark.h"
+
+#define BENCHMARK_L2CAP_PSM         0x1001
+#define BENCHMARK_RFCOMM_CHANNEL    1
+#define BENCHMARK_TIMESTAMP_SIZE    8
+
+typedef enum {
+    BENCHMARK_L2CAP = 0,
+    BENCHMARK_GATT,
+    BENCHMARK_RFCOMM,
+    BENCHMARK_A2DP,
+    BENCHMARK_ERTM,
+    BENCHMARK_NUM_TESTS
+} benchmark_test_t;
+
+static const char * benchmark_test_names[BENCHMARK_NUM_TESTS] = {
+    "l2cap", "gatt", "rfcomm", "a2dp", "ertm"
+};
+
+static bd_addr_t sink_addr   = { 0x00, 0x1B, 0xDC, 0x00, 0x00, 0x01 };
+static bd_addr_t source_addr = { 0x00, 0x1B, 0xDC, 0x00, 0x00, 0x02 };
+
+static hci_transport_config_virtual_t transport_config;
+static benchmark_test_t benchmark_test;
+static bool     benchmark_is_source;
+static uint32_t benchmark_duration_ms = 5000;
+static bool     benchmark_verbose;
+static uint16_t benchmark_drop_per_mille;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_timer_source_t benchmark_timer;
+static uint8_t  benchmark_buffer[HCI_ACL_PAYLOAD_SIZE];
+
+// sink statistics
+static bool     benchmark_running;
+static uint64_t benchmark_start_us;
+static uint64_t benchmark_bytes;
+static uint32_t benchmark_packets;
+static uint64_t benchmark_latency_sum_us;
+static uint64_t benchmark_latency_min_us;
+static uint64_t benchmark_latency_max_us;
+static uint64_t benchmark_last_sent_us;
+
+// L2CAP / RFCOMM
+static uint16_t benchmark_cid;
+static uint16_t benchmark_mtu;
+
+// L2CAP ERTM
+static uint8_t  benchmark_ertm_buffer[20000];
+static l2cap_ertm_config_t benchmark_ertm_config = {
+    1,      // ertm mandatory
+    8,      // max transmit
+    2000,   // retransmission timeout ms
+    12000,  // monitor timeout ms
+    1000,   // local mtu
+    8,      // num tx buffers
+    8,      // num rx buffers
+    1       // use fcs
+};
+
+// GATT
+static hci_con_handle_t benchmark_con_handle;
+static gatt_client_notification_t benchmark_notification_listener;
+static uint8_t benchmark_adv_data[] = {
+    0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06,
+    0x0a, BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME, 'B', 'e', 'n', 'c', 'h', 'm', 'a', 'r', 'k',
+};
+
+// A2DP
+static uint16_t benchmark_a2dp_cid;
+static uint8_t  benchmark_a2dp_local_seid;
+static uint8_t  benchmark_sdp_service_buffer[150];
+static uint8_t  media_sbc_codec_capabilities[] = {
+    0xFF,
+    0xFF,
+    2, 53
+};
+static uint8_t  media_sbc_codec_configuration[] = {
+    (AVDTP_SBC_44100 << 4) | AVDTP_SBC_STEREO,
+    (AVDTP_SBC_BLOCK_LENGTH_16 << 4) | (AVDTP_SBC_SUBBANDS_8 << 2) | AVDTP_SBC_ALLOCATION_METHOD_LOUDNESS,
+    2, 53
+};
+// RTP header + SBC media payload header
+#define BENCHMARK_A2DP_MEDIA_HEADER_SIZE 13
+
+static uint64_t benchmark_time_us(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000u) + ((uint64_t) now.tv_nsec / 1000u);
+}
+
+static uint16_t benchmark_prepare_payload(uint16_t size){
+    size = btstack_min(size, sizeof(benchmark_buffer));
+    if (size < BENCHMARK_TIMESTAMP_SIZE) return size;
+    uint64_t now_us = benchmark_time_us();
+    little_endian_store_32(benchmark_buffer, 0, (uint32_t) now_us);
+    little_endian_store_32(benchmark_buffer, 4, (uint32_t) (now_us >> 32));
+    return size;
+}
+
+// Sink
+
+static void benchmark_report(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    uint64_t duration_us = benchmark_time_us() - benchmark_start_us;
+    uint64_t bytes_per_second = (benchmark_bytes * 1000000u) / duration_us;
+    uint64_t latency_avg_us = (benchmark_packets > 0u) ? (benchmark_latency_sum_us / benchmark_packets) : 0u;
+    printf("%-8s %10" PRIu64 " bytes/s %8" PRIu32 " packets, latency us min %6" PRIu64 " avg %6" PRIu64 " max %6" PRIu64 "\n",
+           benchmark_test_names[benchmark_test], bytes_per_second, benchmark_packets,
+           benchmark_latency_min_us, latency_avg_us, benchmark_latency_max_us);
+    fflush(stdout);
+    exit(EXIT_SUCCESS);
+}
+
+static void benchmark_received(const uint8_t * payload, uint16_t size){
+    uint64_t now_us = benchmark_time_us();
+    if (!benchmark_running){
+        // first packet starts measurement
+        benchmark_running = true;
+        benchmark_start_us = now_us;
+        benchmark_latency_min_us = UINT64_MAX;
+        btstack_run_loop_set_timer_handler(&benchmark_timer, &benchmark_report);
+        btstack_run_loop_set_timer(&benchmark_timer, benchmark_duration_ms);
+        btstack_run_loop_add_timer(&benchmark_timer);
+        return;
+    }
+    benchmark_bytes += size;
+    benchmark_packets++;
+    if (size < BENCHMARK_TIMESTAMP_SIZE) return;
+    uint64_t sent_us = ((uint64_t) little_endian_read_32(payload, 4) << 32) | little_endian_read_32(payload, 0);
+    // all tested channels are reliable and in-order
+    if (sent_us < benchmark_last_sent_us){
+        printf("%-8s packet received out of order\n", benchmark_test_names[benchmark_test]);
+        exit(EXIT_FAILURE);
+    }
+    benchmark_last_sent_us = sent_us;
+    uint64_t latency_us = now_us - sent_us;
+    benchmark_latency_sum_us += latency_us;
+    benchmark_latency_min_us = btstack_min(benchmark_latency_min_us, latency_us);
+    benchmark_latency_max_us = btstack_max(benchmark_latency_max_us, latency_us);
+}
+
+// L2CAP
+
+static void benchmark_l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            benchmark_received(packet, size);
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_INCOMING_CONNECTION:
+                    if (benchmark_test == BENCHMARK_ERTM){
+                        l2cap_accept_ertm_connection(l2cap_event_incoming_connection_get_local_cid(packet),
+                                                     &benchmark_ertm_config, benchmark_ertm_buffer, sizeof(benchmark_ertm_buffer));
+                    } else {
+                        l2cap_accept_connection(l2cap_event_incoming_connection_get_local_cid(packet));
+                    }
+                    break;
+                case L2CAP_EVENT_CHANNEL_OPENED:
+                    if (l2cap_event_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS){
+                        printf("l2cap: channel open failed, status 0x%02x\n", l2cap_event_channel_opened_get_status(packet));
+                        exit(EXIT_FAILURE);
+                    }
+                    benchmark_cid = l2cap_event_channel_opened_get_local_cid(packet);
+                    benchmark_mtu = l2cap_event_channel_opened_get_remote_mtu(packet);
+                    if (benchmark_is_source){
+                        l2cap_request_can_send_now_event(benchmark_cid);
+                    }
+                    break;
+                case L2CAP_EVENT_CAN_SEND_NOW:
+                    l2cap_send(benchmark_cid, benchmark_buffer, benchmark_prepare_payload(benchmark_mtu));
+                    l2cap_request_can_send_now_event(benchmark_cid);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            UNUSED(channel);
+            break;
+    }
+}
+
+static void benchmark_l2cap_setup(void){
+    if (benchmark_is_source) return;
+    l2cap_register_service(&benchmark_l2cap_packet_handler, BENCHMARK_L2CAP_PSM, l2cap_max_mtu(), LEVEL_0);
+}
+
+static void benchmark_l2cap_start(void){
+    if (benchmark_test == BENCHMARK_ERTM){
+        l2cap_create_ertm_channel(&benchmark_l2cap_packet_handler, sink_addr, BENCHMARK_L2CAP_PSM,
+                                  &benchmark_ertm_config, benchmark_ertm_buffer, sizeof(benchmark_ertm_buffer), &benchmark_cid);
+    } else {
+        l2cap_create_channel(&benchmark_l2cap_packet_handler, sink_addr, BENCHMARK_L2CAP_PSM, l2cap_max_mtu(), &benchmark_cid);
+    }
+}
+
+// GATT Notifications
+
+static void benchmark_gatt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case GATT_EVENT_NOTIFICATION:
+            benchmark_received(gatt_event_notification_get_value(packet), gatt_event_notification_get_value_length(packet));
+            break;
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            if (!benchmark_is_source) break;
+            benchmark_con_handle = att_event_mtu_exchange_complete_get_handle(packet);
+            benchmark_mtu = att_event_mtu_exchange_complete_get_MTU(packet) - 3u;
+            att_server_request_can_send_now_event(benchmark_con_handle);
+            break;
+        case ATT_EVENT_CAN_SEND_NOW:
+            att_server_notify(benchmark_con_handle, ATT_CHARACTERISTIC_0000FF11_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE,
+                              benchmark_buffer, benchmark_prepare_payload(benchmark_mtu));
+            att_server_request_can_send_now_event(benchmark_con_handle);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_gatt_setup(void){
+    // fixed keys, no pairing takes place
+    static sm_key_t benchmark_sm_key = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    sm_init();
+    sm_set_er(benchmark_sm_key);
+    sm_set_ir(benchmark_sm_key);
+    if (benchmark_is_source){
+        att_server_init(profile_data, NULL, NULL);
+        att_server_register_packet_handler(&benchmark_gatt_packet_handler);
+        bd_addr_t null_addr;
+        memset(null_addr, 0, 6);
+        gap_advertisements_set_params(0x0030, 0x0030, 0, 0, null_addr, 0x07, 0x00);
+        gap_advertisements_set_data(sizeof(benchmark_adv_data), benchmark_adv_data);
+        gap_advertisements_enable(1);
+    } else {
+        gatt_client_init();
+    }
+}
+
+static void benchmark_gatt_start(void){
+    gap_connect(source_addr, BD_ADDR_TYPE_LE_PUBLIC);
+}
+
+static void benchmark_gatt_connected(hci_con_handle_t con_handle){
+    if (benchmark_is_source) return;
+    benchmark_con_handle = con_handle;
+    gatt_client_listen_for_characteristic_value_updates(&benchmark_notification_listener, &benchmark_gatt_packet_handler, con_handle, NULL);
+    gatt_client_send_mtu_negotiation(&benchmark_gatt_packet_handler, con_handle);
+}
+
+// RFCOMM
+
+static void benchmark_rfcomm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    switch (packet_type){
+        case RFCOMM_DATA_PACKET:
+            benchmark_received(packet, size);
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case RFCOMM_EVENT_INCOMING_CONNECTION:
+                    rfcomm_accept_connection(rfcomm_event_incoming_connection_get_rfcomm_cid(packet));
+                    break;
+                case RFCOMM_EVENT_CHANNEL_OPENED:
+                    if (rfcomm_event_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS){
+                        printf("rfcomm: channel open failed, status 0x%02x\n", rfcomm_event_channel_opened_get_status(packet));
+                        exit(EXIT_FAILURE);
+                    }
+                    benchmark_cid = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
+                    benchmark_mtu = rfcomm_event_channel_opened_get_max_frame_size(packet);
+                    if (benchmark_is_source){
+                        rfcomm_request_can_send_now_event(benchmark_cid);
+                    }
+                    break;
+                case RFCOMM_EVENT_CAN_SEND_NOW:
+                    // also emitted without request after channel was opened
+                    if (!benchmark_is_source) break;
+                    rfcomm_send(benchmark_cid, benchmark_buffer, benchmark_prepare_payload(benchmark_mtu));
+                    rfcomm_request_can_send_now_event(benchmark_cid);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            UNUSED(channel);
+            break;
+    }
+}
+
+static void benchmark_rfcomm_setup(void){
+    rfcomm_init();
+    rfcomm_set_required_security_level(LEVEL_0);
+    if (benchmark_is_source) return;
+    rfcomm_register_service(&benchmark_rfcomm_packet_handler, BENCHMARK_RFCOMM_CHANNEL, 0xffff);
+}
+
+static void benchmark_rfcomm_start(void){
+    rfcomm_create_channel(&benchmark_rfcomm_packet_handler, sink_addr, BENCHMARK_RFCOMM_CHANNEL, &benchmark_cid);
+}
+
+// A2DP
+
+static void benchmark_a2dp_media_handler(uint8_t local_seid, uint8_t *packet, uint16_t size){
+    UNUSED(local_seid);
+    if (size < BENCHMARK_A2DP_MEDIA_HEADER_SIZE) return;
+    benchmark_received(&packet[BENCHMARK_A2DP_MEDIA_HEADER_SIZE], size - BENCHMARK_A2DP_MEDIA_HEADER_SIZE);
+}
+
+static void benchmark_a2dp_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_A2DP_META) return;
+    switch (hci_event_a2dp_meta_get_subevent_code(packet)){
+        case A2DP_SUBEVENT_STREAM_ESTABLISHED:
+            if (a2dp_subevent_stream_established_get_status(packet) != ERROR_CODE_SUCCESS){
+                printf("a2dp: stream establishment failed, status 0x%02x\n", a2dp_subevent_stream_established_get_status(packet));
+                exit(EXIT_FAILURE);
+            }
+            if (!benchmark_is_source) break;
+            benchmark_a2dp_cid = a2dp_subevent_stream_established_get_a2dp_cid(packet);
+            a2dp_source_start_stream(benchmark_a2dp_cid, benchmark_a2dp_local_seid);
+            break;
+        case A2DP_SUBEVENT_STREAM_STARTED:
+            if (!benchmark_is_source) break;
+            // media payload: timestamp followed by dummy SBC frames
+            benchmark_mtu = (uint16_t) a2dp_max_media_payload_size(benchmark_a2dp_cid, benchmark_a2dp_local_seid);
+            a2dp_source_stream_endpoint_request_can_send_now(benchmark_a2dp_cid, benchmark_a2dp_local_seid);
+            break;
+        case A2DP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW:
+            if (!benchmark_is_source) break;
+            a2dp_source_stream_send_media_payload(benchmark_a2dp_cid, benchmark_a2dp_local_seid, benchmark_buffer,
+                                                  benchmark_prepare_payload(benchmark_mtu), 1, 0);
+            a2dp_source_stream_endpoint_request_can_send_now(benchmark_a2dp_cid, benchmark_a2dp_local_seid);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_a2dp_setup(void){
+    avdtp_stream_endpoint_t * stream_endpoint;
+    if (benchmark_is_source){
+        a2dp_source_init();
+        a2dp_source_register_packet_handler(&benchmark_a2dp_packet_handler);
+        stream_endpoint = a2dp_source_create_stream_endpoint(AVDTP_AUDIO, AVDTP_CODEC_SBC,
+            media_sbc_codec_capabilities, sizeof(media_sbc_codec_capabilities),
+            media_sbc_codec_configuration, sizeof(media_sbc_codec_configuration));
+    } else {
+        a2dp_sink_init();
+        a2dp_sink_register_packet_handler(&benchmark_a2dp_packet_handler);
+        a2dp_sink_register_media_handler(&benchmark_a2dp_media_handler);
+        stream_endpoint = a2dp_sink_create_stream_endpoint(AVDTP_AUDIO, AVDTP_CODEC_SBC,
+            media_sbc_codec_capabilities, sizeof(media_sbc_codec_capabilities),
+            media_sbc_codec_configuration, sizeof(media_sbc_codec_configuration));
+        sdp_init();
+        a2dp_sink_create_sdp_record(benchmark_sdp_service_buffer, 0x10001, AVDTP_SINK_FEATURE_MASK_HEADPHONE, NULL, NULL);
+        sdp_register_service(benchmark_sdp_service_buffer);
+    }
+    btstack_assert(stream_endpoint != NULL);
+    benchmark_a2dp_local_seid = avdtp_local_seid(stream_endpoint);
+}
+
+static void benchmark_a2dp_start(void){
+    a2dp_source_establish_stream(sink_addr, benchmark_a2dp_local_seid, &benchmark_a2dp_cid);
+}
+
+// Stack setup
+
+static void benchmark_hci_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) break;
+            // virtual Controllers hold page and connect requests until the peer is connectable
+            switch (benchmark_test){
+                case BENCHMARK_L2CAP:
+                case BENCHMARK_ERTM:
+                    if (benchmark_is_source) benchmark_l2cap_start();
+                    break;
+                case BENCHMARK_GATT:
+                    // GATT Client is the sink
+                    if (!benchmark_is_source) benchmark_gatt_start();
+                    break;
+                case BENCHMARK_RFCOMM:
+                    if (benchmark_is_source) benchmark_rfcomm_start();
+                    break;
+                case BENCHMARK_A2DP:
+                    if (benchmark_is_source) benchmark_a2dp_start();
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            benchmark_gatt_connected(hci_subevent_le_connection_complete_get_connection_handle(packet));
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            // source gets terminated by runner, sink reports result on timeout
+            if (benchmark_is_source) break;
+            printf("%-8s disconnected before measurement completed\n", benchmark_test_names[benchmark_test]);
+            exit(EXIT_FAILURE);
+            break;
+        default:
+            break;
+    }
+}
+
+static void benchmark_run(int fd){
+    transport_config.fd_read  = fd;
+    transport_config.fd_write = fd;
+    bd_addr_copy(transport_config.bd_addr, benchmark_is_source ? source_addr : sink_addr);
+
+    if (benchmark_verbose){
+        hci_dump_open(NULL, HCI_DUMP_STDOUT);
+    }
+
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    hci_init(hci_transport_virtual_instance(), &transport_config);
+
+    hci_event_callback_registration.callback = &benchmark_hci_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    l2cap_init();
+    gap_set_security_level(LEVEL_0);
+
+    switch (benchmark_test){
+        case BENCHMARK_L2CAP:
+        case BENCHMARK_ERTM:
+            benchmark_l2cap_setup();
+            break;
+        case BENCHMARK_GATT:
+            benchmark_gatt_setup();
+            break;
+        case BENCHMARK_RFCOMM:
+            benchmark_rfcomm_setup();
+            break;
+        case BENCHMARK_A2DP:
+            benchmark_a2dp_setup();
+            break;
+        default:
+            break;
+    }
+
+    gap_connectable_control(1);
+    hci_power_control(HCI_POWER_ON);
+    btstack_run_loop_execute();
+}
+
+// Runner
+
+static int benchmark_run_test(benchmark_test_t test){
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0){
+        perror("socketpair");
+        return -1;
+    }
+    benchmark_test = test;
+    // only ERTM recovers lost packets
+    transport_config.acl_drop_per_mille = (test == BENCHMARK_ERTM) ? benchmark_drop_per_mille : 0;
+    fflush(stdout);
+
+    pid_t sink_pid = fork();
+    if (sink_pid == 0){
+        close(fds[1]);
+        benchmark_is_source = false;
+        benchmark_run(fds[0]);
+        exit(EXIT_FAILURE);
+    }
+    pid_t source_pid = fork();
+    if (source_pid == 0){
+        close(fds[0]);
+        benchmark_is_source = true;
+        benchmark_run(fds[1]);
+        exit(EXIT_FAILURE);
+    }
+    close(fds[0]);
+    close(fds[1]);
+
+    int status = EXIT_FAILURE;
+    waitpid(sink_pid, &status, 0);
+    kill(source_pid, SIGTERM);
+    waitpid(source_pid, NULL, 0);
+    return (WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS)) ? 0 : -1;
+}
+
+static void benchmark_usage(const char * name){
+    printf("Usage: %s [options] [l2cap|gatt|rfcomm|a2dp|ertm]...\n", name);
+    printf(" -d duration_ms   measurement duration (default %u)\n", benchmark_duration_ms);
+    printf(" -l latency_us    link latency\n");
+    printf(" -b bitrate       link bitrate in bit/s, 0 = unlimited\n");
+    printf(" -n num_buffers   number of ACL buffers (max %u)\n", HCI_TRANSPORT_VIRTUAL_ACL_PACKETS_MAX);
+    printf(" -s size          ACL buffer size\n");
+    printf(" -p per_mille     ACL packet loss for ertm test\n");
+    printf(" -v               dump HCI traffic of sink and source\n");
+}
+
+int main(int argc, char * argv[]){
+    transport_config.link_latency_us = 1000;
+    transport_config.link_bitrate    = 2000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:l:b:n:s:p:vh")) != -1){
+        switch (opt){
+            case 'd':
+                benchmark_duration_ms = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                transport_config.link_latency_us = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                transport_config.link_bitrate = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                transport_config.acl_packets_num = (uint8_t) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                transport_config.acl_packet_len = (uint16_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'p':
+                benchmark_drop_per_mille = (uint16_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'v':
+                benchmark_verbose = true;
+                break;
+            default:
+                benchmark_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    bool selected[BENCHMARK_NUM_TESTS];
+    bool select_all = optind == argc;
+    int i;
+    for (i = 0; i < BENCHMARK_NUM_TESTS; i++){
+        selected[i] = select_all;
+    }
+    for (; optind < argc; optind++){
+        for (i = 0; i < BENCHMARK_NUM_TESTS; i++){
+            if (strcmp(argv[optind], benchmark_test_names[i]) == 0) break;
+        }
+        if (i == BENCHMARK_NUM_TESTS){
+            benchmark_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        selected[i] = true;
+    }
+
+    int result = EXIT_SUCCESS;
+    for (i = 0; i < BENCHMARK_NUM_TESTS; i++){
+        if (!selected[i]) continue;
+        if (benchmark_run_test((benchmark_test_t) i) != 0){
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
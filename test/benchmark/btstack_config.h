@@ -0,0 +1,29 @@
+//
+// btstack_config.h for benchmark
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+#define HAVE_POSIX_TIME
+#define HAVE_POSIX_FILE_IO
+
+// BTstack features that can be enabled
+#define ENABLE_BLE
+#define ENABLE_CLASSIC
+#define ENABLE_LE_PERIPHERAL
+#define ENABLE_LE_CENTRAL
+#define ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+#define ENABLE_L2CAP_ERTM_FCS_SLICE_BY_8
+#define ENABLE_LOG_ERROR
+#define ENABLE_SOFTWARE_AES128
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE (1021 + 4)
+#define HCI_INCOMING_PRE_BUFFER_SIZE 14
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 4
+
+#endif
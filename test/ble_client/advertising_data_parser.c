@@ -110,6 +110,9 @@ static hci_transport_t dummy_transport = {
   /*  .transport.can_send_packet_now           = */  NULL,
   /*  .transport.send_packet                   = */  NULL,
   /*  .transport.set_baudrate                  = */  NULL,
+  /*  .transport.reset_link                    = */  NULL,
+  /*  .transport.set_sco_config                = */  NULL,
+  /*  .transport.send_packet_vectored          = */  NULL,
 };
 
 
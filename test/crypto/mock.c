@@ -12,6 +12,10 @@ static uint8_t aes128_cyphertext[16];
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
 	btstack_linked_list_add(&event_packet_handlers, (btstack_linked_item_t *) callback_handler);
 }
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+	(void) event_codes;
+	hci_add_event_handler(callback_handler);
+}
 
 int hci_can_send_command_packet_now(void){
 	return 1;
@@ -0,0 +1,190 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "hal_flash_bank.h"
+#include "hal_flash_bank_memory.h"
+#include "btstack_tlv.h"
+#include "btstack_tlv_flash_bank.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_run_loop_posix.h"
+#include "hci_dump.h"
+#include "btstack_util.h"
+#include "btstack_config.h"
+#include "btstack_debug.h"
+
+#define HAL_FLASH_BANK_MEMORY_STORAGE_SIZE 1024
+static uint8_t hal_flash_bank_memory_storage[HAL_FLASH_BANK_MEMORY_STORAGE_SIZE];
+
+// count write operations of hal_flash_bank_memory
+static const hal_flash_bank_t * hal_flash_bank_memory_impl;
+static int num_flash_writes;
+
+static uint32_t counting_get_size(void * context){
+	return hal_flash_bank_memory_impl->get_size(context);
+}
+static uint32_t counting_get_alignment(void * context){
+	return hal_flash_bank_memory_impl->get_alignment(context);
+}
+static void counting_erase(void * context, int bank){
+	hal_flash_bank_memory_impl->erase(context, bank);
+}
+static void counting_read(void * context, int bank, uint32_t offset, uint8_t * buffer, uint32_t size){
+	hal_flash_bank_memory_impl->read(context, bank, offset, buffer, size);
+}
+static void counting_write(void * context, int bank, uint32_t offset, const uint8_t * data, uint32_t size){
+	num_flash_writes++;
+	hal_flash_bank_memory_impl->write(context, bank, offset, data, size);
+}
+
+static const hal_flash_bank_t hal_flash_bank_counting = {
+	&counting_get_size,
+	&counting_get_alignment,
+	&counting_erase,
+	&counting_read,
+	&counting_write,
+};
+
+TEST_GROUP(TLV_WRITE_CACHE){
+	hal_flash_bank_memory_t  hal_flash_bank_context;
+	const btstack_tlv_t *    btstack_tlv_impl;
+	btstack_tlv_flash_bank_t btstack_tlv_context;
+
+	void setup(void){
+		hal_flash_bank_memory_impl = hal_flash_bank_memory_init_instance(&hal_flash_bank_context, hal_flash_bank_memory_storage, HAL_FLASH_BANK_MEMORY_STORAGE_SIZE);
+		btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, &hal_flash_bank_counting, &hal_flash_bank_context);
+		num_flash_writes = 0;
+	}
+	void teardown(void){
+		btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+	}
+	void reset(void){
+		// pending operations are lost on reset
+		btstack_run_loop_remove_timer(&btstack_tlv_context.write_cache_timer);
+		btstack_tlv_impl = btstack_tlv_flash_bank_init_instance(&btstack_tlv_context, &hal_flash_bank_counting, &hal_flash_bank_context);
+	}
+	int store_and_count_writes(bool write_through){
+		num_flash_writes = 0;
+		uint8_t data[8];
+		memcpy(data, "01234567", 8);
+		int i;
+		for (i=0;i<10;i++){
+			data[0] = '0' + i;
+			btstack_tlv_impl->store_tag(&btstack_tlv_context, 'aaaa', data, 8);
+			btstack_tlv_impl->store_tag(&btstack_tlv_context, 'bbbb', data, 8);
+			if (write_through){
+				btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+			}
+		}
+		btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+		return num_flash_writes;
+	}
+};
+
+TEST(TLV_WRITE_CACHE, ReadPending){
+	uint8_t data = 7;
+	uint8_t buffer = 0;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &data, 1);
+	CHECK_EQUAL(0, num_flash_writes);
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', NULL, 0));
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', &buffer, 1));
+	CHECK_EQUAL(data, buffer);
+	reset();
+	CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', NULL, 0));
+}
+
+TEST(TLV_WRITE_CACHE, Flush){
+	uint8_t data = 7;
+	uint8_t buffer = 0;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &data, 1);
+	btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+	CHECK(num_flash_writes > 0);
+	reset();
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', &buffer, 1));
+	CHECK_EQUAL(data, buffer);
+}
+
+TEST(TLV_WRITE_CACHE, CoalesceWrites){
+	int writes_cached        = store_and_count_writes(false);
+	int writes_write_through = store_and_count_writes(true);
+	// only last value of each tag is written
+	CHECK(writes_cached * 5 <= writes_write_through);
+	reset();
+	uint8_t buffer[8];
+	CHECK_EQUAL(8, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'aaaa', buffer, 8));
+	CHECK_EQUAL('9', buffer[0]);
+	CHECK_EQUAL(8, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'bbbb', buffer, 8));
+	CHECK_EQUAL('9', buffer[0]);
+}
+
+TEST(TLV_WRITE_CACHE, DeletePending){
+	uint8_t data = 7;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &data, 1);
+	btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+	btstack_tlv_impl->delete_tag(&btstack_tlv_context, 'abcd');
+	CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', NULL, 0));
+	btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+	reset();
+	CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', NULL, 0));
+}
+
+TEST(TLV_WRITE_CACHE, StoreAfterDelete){
+	uint8_t data = 7;
+	uint8_t buffer = 0;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &data, 1);
+	btstack_tlv_impl->delete_tag(&btstack_tlv_context, 'abcd');
+	data++;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &data, 1);
+	btstack_tlv_flash_bank_flush(&btstack_tlv_context);
+	reset();
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', &buffer, 1));
+	CHECK_EQUAL(data, buffer);
+}
+
+TEST(TLV_WRITE_CACHE, JournalFull){
+	uint8_t data[32];
+	uint32_t i;
+	uint32_t num_tags = (2 * TLV_FLASH_BANK_WRITE_CACHE_SIZE) / (8 + sizeof(data));
+	for (i=0;i<num_tags;i++){
+		memset(data, i, sizeof(data));
+		btstack_tlv_impl->store_tag(&btstack_tlv_context, 0x1000 + i, data, sizeof(data));
+	}
+	CHECK(num_flash_writes > 0);
+	CHECK(btstack_tlv_context.write_cache_len <= TLV_FLASH_BANK_WRITE_CACHE_SIZE);
+	for (i=0;i<num_tags;i++){
+		CHECK_EQUAL(sizeof(data), btstack_tlv_impl->get_tag(&btstack_tlv_context, 0x1000 + i, data, sizeof(data)));
+		CHECK_EQUAL(i, data[31]);
+	}
+}
+
+TEST(TLV_WRITE_CACHE, LargeValueWriteThrough){
+	uint8_t small = 7;
+	uint8_t large[TLV_FLASH_BANK_WRITE_CACHE_SIZE];
+	memset(large, 0x55, sizeof(large));
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &small, 1);
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'efgh', large, sizeof(large));
+	CHECK_EQUAL(0, btstack_tlv_context.write_cache_len);
+	reset();
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', NULL, 0));
+	CHECK_EQUAL(sizeof(large), btstack_tlv_impl->get_tag(&btstack_tlv_context, 'efgh', NULL, 0));
+}
+
+TEST(TLV_WRITE_CACHE, IdleTimeout){
+	uint8_t data = 7;
+	uint8_t buffer = 0;
+	uint32_t now = btstack_run_loop_get_time_ms();
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, 'abcd', &data, 1);
+	btstack_run_loop_base_process_timers(now + TLV_FLASH_BANK_WRITE_CACHE_IDLE_MS / 2);
+	CHECK_EQUAL(0, num_flash_writes);
+	btstack_run_loop_base_process_timers(now + TLV_FLASH_BANK_WRITE_CACHE_IDLE_MS + 100);
+	CHECK(num_flash_writes > 0);
+	reset();
+	CHECK_EQUAL(1, btstack_tlv_impl->get_tag(&btstack_tlv_context, 'abcd', &buffer, 1));
+	CHECK_EQUAL(data, buffer);
+}
+
+int main (int argc, const char * argv[]){
+	hci_dump_open("tlv_write_cache_test.pklg", HCI_DUMP_PACKETLOGGER);
+	btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+	return CommandLineTestRunner::RunAllTests(argc, argv);
+}
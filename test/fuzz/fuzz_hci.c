@@ -47,6 +47,7 @@ static const hci_transport_t hci_transport_fuzz = {
         /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_fuzz_set_baudrate,
         /* void   (*reset_link)(void); */                               NULL,
         /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+        /* int    (*send_packet_vectored)(...); */                      NULL,
 };
 
 static void l2cap_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
@@ -8,12 +8,19 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     if (size < 1) return 0;
 
     int is_handsfree = data[0] & 1;
+    int parse_lines  = data[0] & 2;
     hfp_connection_t hfp_connection;
     memset(&hfp_connection, 0, sizeof(hfp_connection_t));
 
     uint32_t i;
-    for (i = 1; i < size; i++){
-        hfp_parse(&hfp_connection, data[i], is_handsfree);
+    if (parse_lines){
+        for (i = 1; i < size; ){
+            i += hfp_parse_line(&hfp_connection, &data[i], (uint16_t) btstack_min(size - i, 0xffff), is_handsfree);
+        }
+    } else {
+        for (i = 1; i < size; i++){
+            hfp_parse(&hfp_connection, data[i], is_handsfree);
+        }
     }
  
     return 0;
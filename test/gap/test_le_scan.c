@@ -75,6 +75,7 @@ static const hci_transport_t hci_transport_test = {
         /* int    (*set_baudrate)(uint32_t baudrate); */                &hci_transport_test_set_baudrate,
         /* void   (*reset_link)(void); */                               NULL,
         /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+        /* int    (*send_packet_vectored)(...); */                      NULL,
 };
 
 static uint16_t next_hci_packet;
@@ -131,6 +132,156 @@ TEST(GAP_LE, ScanStartParam){
     CHECK_HCI_COMMAND(&hci_le_set_scan_enable);
 }
 
+static int vendor_event_handler_count;
+static int disconnect_event_handler_count;
+
+static void vendor_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    CHECK_EQUAL(HCI_EVENT_VENDOR_SPECIFIC, hci_event_packet_get_type(packet));
+    vendor_event_handler_count++;
+}
+
+static void disconnect_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    disconnect_event_handler_count++;
+}
+
+static int all_event_handler_advertising_report_count;
+static int filtered_event_handler_advertising_report_count;
+static int filtered_event_handler_connection_complete_count;
+
+static bool is_advertising_report(const uint8_t * packet){
+    switch (hci_event_packet_get_type(packet)){
+        case GAP_EVENT_ADVERTISING_REPORT:
+            return true;
+        case HCI_EVENT_LE_META:
+            return hci_event_le_meta_get_subevent_code(packet) == HCI_SUBEVENT_LE_ADVERTISING_REPORT;
+        default:
+            return false;
+    }
+}
+
+static void all_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    if (is_advertising_report(packet)){
+        all_event_handler_advertising_report_count++;
+    }
+}
+
+static void filtered_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    if (is_advertising_report(packet)){
+        filtered_event_handler_advertising_report_count++;
+    }
+    if ((hci_event_packet_get_type(packet) == HCI_EVENT_LE_META) &&
+        (hci_event_le_meta_get_subevent_code(packet) == HCI_SUBEVENT_LE_CONNECTION_COMPLETE)){
+        filtered_event_handler_connection_complete_count++;
+    }
+}
+
+TEST_GROUP(HCI_EVENT_CODES){
+        btstack_packet_callback_registration_t vendor_event_callback_registration;
+        btstack_packet_callback_registration_t disconnect_event_callback_registration;
+        uint8_t vendor_event_codes[HCI_EVENT_CODE_BITMAP_LEN];
+        uint8_t disconnect_event_codes[HCI_EVENT_CODE_BITMAP_LEN];
+
+        void setup(void){
+            hci_init(&hci_transport_test, NULL);
+            hci_simulate_working_fuzz();
+            vendor_event_handler_count = 0;
+            disconnect_event_handler_count = 0;
+            memset(vendor_event_codes, 0, sizeof(vendor_event_codes));
+            memset(disconnect_event_codes, 0, sizeof(disconnect_event_codes));
+        }
+};
+
+TEST(HCI_EVENT_CODES, BitmapSetClear){
+    hci_event_code_bitmap_set(vendor_event_codes, HCI_EVENT_VENDOR_SPECIFIC);
+    CHECK_TRUE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_VENDOR_SPECIFIC));
+    CHECK_FALSE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_DISCONNECTION_COMPLETE));
+    hci_event_code_bitmap_clear(vendor_event_codes, HCI_EVENT_VENDOR_SPECIFIC);
+    CHECK_FALSE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_VENDOR_SPECIFIC));
+
+    hci_event_code_bitmap_set_all_except_scan_results(vendor_event_codes);
+    CHECK_TRUE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_DISCONNECTION_COMPLETE));
+    CHECK_FALSE(hci_event_code_bitmap_is_set(vendor_event_codes, GAP_EVENT_ADVERTISING_REPORT));
+    CHECK_FALSE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_INQUIRY_RESULT));
+    CHECK_TRUE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_LE_META));
+    CHECK_TRUE(hci_event_code_bitmap_is_le_subevent_set(vendor_event_codes, HCI_SUBEVENT_LE_CONNECTION_COMPLETE));
+    CHECK_FALSE(hci_event_code_bitmap_is_le_subevent_set(vendor_event_codes, HCI_SUBEVENT_LE_ADVERTISING_REPORT));
+    CHECK_FALSE(hci_event_code_bitmap_is_le_subevent_set(vendor_event_codes, HCI_SUBEVENT_LE_DIRECT_ADVERTISING_REPORT));
+}
+
+TEST(HCI_EVENT_CODES, BitmapLeSubevent){
+    hci_event_code_bitmap_set_le_subevent(vendor_event_codes, HCI_SUBEVENT_LE_CONNECTION_COMPLETE);
+    CHECK_TRUE(hci_event_code_bitmap_is_set(vendor_event_codes, HCI_EVENT_LE_META));
+    CHECK_TRUE(hci_event_code_bitmap_is_le_subevent_set(vendor_event_codes, HCI_SUBEVENT_LE_CONNECTION_COMPLETE));
+    CHECK_FALSE(hci_event_code_bitmap_is_le_subevent_set(vendor_event_codes, HCI_SUBEVENT_LE_ADVERTISING_REPORT));
+
+    hci_event_code_bitmap_set(disconnect_event_codes, HCI_EVENT_LE_META);
+    CHECK_TRUE(hci_event_code_bitmap_is_le_subevent_set(disconnect_event_codes, HCI_SUBEVENT_LE_ADVERTISING_REPORT));
+    hci_event_code_bitmap_clear(disconnect_event_codes, HCI_EVENT_LE_META);
+    CHECK_FALSE(hci_event_code_bitmap_is_le_subevent_set(disconnect_event_codes, HCI_SUBEVENT_LE_CONNECTION_COMPLETE));
+}
+
+TEST(HCI_EVENT_CODES, FilteredHandlerSkipsAdvertisingReportWhileScanning){
+    static btstack_packet_callback_registration_t all_event_callback_registration;
+    all_event_callback_registration.callback = &all_event_handler;
+    hci_add_event_handler(&all_event_callback_registration);
+
+    hci_event_code_bitmap_set_all_except_scan_results(vendor_event_codes);
+    vendor_event_callback_registration.callback = &filtered_event_handler;
+    hci_add_event_handler_for_event_codes(&vendor_event_callback_registration, vendor_event_codes);
+
+    all_event_handler_advertising_report_count = 0;
+    filtered_event_handler_advertising_report_count = 0;
+    filtered_event_handler_connection_complete_count = 0;
+
+    gap_start_scan();
+
+    // LE Advertising Report: 1 report, ADV_IND, public address, 3 bytes data, rssi
+    const uint8_t advertising_report[] = {
+        HCI_EVENT_LE_META, 15, HCI_SUBEVENT_LE_ADVERTISING_REPORT, 1, 0x00, 0x00,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 3, 0x02, 0x01, 0x06, 0xC0
+    };
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) advertising_report, sizeof(advertising_report));
+
+    // raw and GAP advertising report for the unfiltered handler
+    CHECK_EQUAL(2, all_event_handler_advertising_report_count);
+    CHECK_EQUAL(0, filtered_event_handler_advertising_report_count);
+
+    // other LE Meta subevents are still delivered
+    const uint8_t connection_complete[] = {
+        HCI_EVENT_LE_META, 19, HCI_SUBEVENT_LE_CONNECTION_COMPLETE, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER,
+        0x40, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x18, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00
+    };
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) connection_complete, sizeof(connection_complete));
+    CHECK_EQUAL(1, filtered_event_handler_connection_complete_count);
+
+    gap_stop_scan();
+}
+
+TEST(HCI_EVENT_CODES, EmitSkipsHandlerWithoutEventCode){
+    hci_event_code_bitmap_set(vendor_event_codes, HCI_EVENT_VENDOR_SPECIFIC);
+    vendor_event_callback_registration.callback = &vendor_event_handler;
+    hci_add_event_handler_for_event_codes(&vendor_event_callback_registration, vendor_event_codes);
+
+    hci_event_code_bitmap_set(disconnect_event_codes, HCI_EVENT_DISCONNECTION_COMPLETE);
+    disconnect_event_callback_registration.callback = &disconnect_event_handler;
+    hci_add_event_handler_for_event_codes(&disconnect_event_callback_registration, disconnect_event_codes);
+
+    const uint8_t vendor_event[] = { HCI_EVENT_VENDOR_SPECIFIC, 1, 0x00 };
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) vendor_event, sizeof(vendor_event));
+    CHECK_EQUAL(1, vendor_event_handler_count);
+    CHECK_EQUAL(0, disconnect_event_handler_count);
+}
+
+TEST(HCI_EVENT_CODES, EmitSkipsUnsubscribedEventCode){
+    hci_event_code_bitmap_set(disconnect_event_codes, HCI_EVENT_DISCONNECTION_COMPLETE);
+    disconnect_event_callback_registration.callback = &disconnect_event_handler;
+    hci_add_event_handler_for_event_codes(&disconnect_event_callback_registration, disconnect_event_codes);
+
+    const uint8_t vendor_event[] = { HCI_EVENT_VENDOR_SPECIFIC, 1, 0x00 };
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) vendor_event, sizeof(vendor_event));
+    CHECK_EQUAL(0, disconnect_event_handler_count);
+}
+
 int main (int argc, const char * argv[]){
     const char * log_path = "/tmp/test_scan.pklg";
     printf("Log: %s\n", log_path);
@@ -26,6 +26,7 @@
 
 static uint16_t gatt_client_handle = 0x40;
 static int gatt_query_complete = 0;
+static int gatt_query_complete_counter = 0;
 
 typedef enum {
 	IDLE,
@@ -73,6 +74,9 @@ static gatt_client_characteristic_descriptor_t descriptors[50];
 
 void mock_simulate_discover_primary_services_response(void);
 void mock_simulate_att_exchange_mtu_response(void);
+void mock_defer_att_responses(int enabled);
+int  mock_deliver_deferred_att_response(void);
+void mock_simulate_att_notification(uint16_t value_handle, const uint8_t * value, uint16_t value_len);
 
 void CHECK_EQUAL_ARRAY(const uint8_t * expected, uint8_t * actual, int size){
 	for (int i=0; i<size; i++){
@@ -151,6 +155,7 @@ static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8
 		case GATT_EVENT_QUERY_COMPLETE:
 			status = packet[4];
             gatt_query_complete = 1;
+            gatt_query_complete_counter++;
             if (status){
                 gatt_query_complete = 0;
                 printf("GATT_EVENT_QUERY_COMPLETE failed with status 0x%02X\n", status);
@@ -302,6 +307,7 @@ TEST_GROUP(GATTClient){
 
 	void reset_query_state(void){
 		gatt_query_complete = 0;
+		gatt_query_complete_counter = 0;
 		result_counter = 0;
 		result_index = 0;
 	}
@@ -466,6 +472,20 @@ TEST(GATTClient, TestDiscoverCharacteristicDescriptor){
 	CHECK_EQUAL(0x2901, descriptors[2].uuid16);
 }
 
+TEST(GATTClient, TestDiscoverCharacteristicDescriptorAtLastHandle){
+	test = DISCOVER_CHARACTERISTIC_DESCRIPTORS;
+	reset_query_state();
+	gatt_client_characteristic_t characteristic;
+	memset(&characteristic, 0, sizeof(characteristic));
+	characteristic.start_handle = 0xfffe;
+	characteristic.value_handle = 0xffff;
+	characteristic.end_handle   = 0xffff;
+	status = gatt_client_discover_characteristic_descriptors(handle_ble_client_event, gatt_client_handle, &characteristic);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 0);
+}
+
 TEST(GATTClient, TestWriteClientCharacteristicConfiguration){
 	test = WRITE_CLIENT_CHARACTERISTIC_CONFIGURATION;
 	reset_query_state();
@@ -535,6 +555,94 @@ TEST(GATTClient, TestReadCharacteristicValue){
 	CHECK_EQUAL(result_counter, 3);
 }
 
+TEST(GATTClient, TestQueuedReadCharacteristicValue){
+	test = READ_CHARACTERISTIC_VALUE;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xF100);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+
+	// first read is sent, further reads are queued until queue is full
+	reset_query_state();
+	mock_defer_att_responses(1);
+	int i;
+	for (i = 0; i <= GATT_CLIENT_OPERATION_QUEUE_SIZE; i++){
+		status = gatt_client_read_value_of_characteristic(handle_ble_client_event, gatt_client_handle, &characteristics[0]);
+		CHECK_EQUAL(status, 0);
+	}
+	CHECK_EQUAL(gatt_client_is_ready(gatt_client_handle), 0);
+	status = gatt_client_read_value_of_characteristic(handle_ble_client_event, gatt_client_handle, &characteristics[0]);
+	CHECK_EQUAL(status, GATT_CLIENT_IN_WRONG_STATE);
+	CHECK_EQUAL(gatt_query_complete_counter, 0);
+
+	// each response starts next queued read
+	while (mock_deliver_deferred_att_response() != 0){}
+	mock_defer_att_responses(0);
+	CHECK_EQUAL(gatt_query_complete_counter, GATT_CLIENT_OPERATION_QUEUE_SIZE + 1);
+	CHECK_EQUAL(gatt_client_is_ready(gatt_client_handle), 1);
+}
+
+static int value_listener_a_counter;
+static int value_listener_b_counter;
+static int value_listener_any_counter;
+
+static void handle_value_listener_a(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	CHECK_EQUAL(GATT_EVENT_NOTIFICATION, packet[0]);
+	value_listener_a_counter++;
+}
+
+static void handle_value_listener_b(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	value_listener_b_counter++;
+}
+
+static void handle_value_listener_any(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	value_listener_any_counter++;
+}
+
+TEST(GATTClient, TestValueListeners){
+	gatt_client_notification_t listener_a;
+	gatt_client_notification_t listener_b;
+	gatt_client_notification_t listener_any;
+	gatt_client_characteristic_t characteristic_a;
+	gatt_client_characteristic_t characteristic_b;
+	characteristic_a.value_handle = 0x0010;
+	// same hash bucket as characteristic_a
+	characteristic_b.value_handle = 0x0010 + GATT_CLIENT_VALUE_LISTENER_HASH_TABLE_SIZE;
+	value_listener_a_counter = 0;
+	value_listener_b_counter = 0;
+	value_listener_any_counter = 0;
+
+	gatt_client_listen_for_characteristic_value_updates(&listener_a, &handle_value_listener_a, gatt_client_handle, &characteristic_a);
+	gatt_client_listen_for_characteristic_value_updates(&listener_b, &handle_value_listener_b, gatt_client_handle, &characteristic_b);
+	gatt_client_listen_for_characteristic_value_updates(&listener_any, &handle_value_listener_any, GATT_CLIENT_ANY_CONNECTION, NULL);
+
+	const uint8_t value[] = { 1, 2, 3 };
+	mock_simulate_att_notification(characteristic_a.value_handle, value, sizeof(value));
+	CHECK_EQUAL(1, value_listener_a_counter);
+	CHECK_EQUAL(0, value_listener_b_counter);
+	CHECK_EQUAL(1, value_listener_any_counter);
+
+	mock_simulate_att_notification(0x0011, value, sizeof(value));
+	CHECK_EQUAL(1, value_listener_a_counter);
+	CHECK_EQUAL(0, value_listener_b_counter);
+	CHECK_EQUAL(2, value_listener_any_counter);
+
+	gatt_client_stop_listening_for_characteristic_value_updates(&listener_a);
+	gatt_client_stop_listening_for_characteristic_value_updates(&listener_any);
+	mock_simulate_att_notification(characteristic_a.value_handle, value, sizeof(value));
+	mock_simulate_att_notification(characteristic_b.value_handle, value, sizeof(value));
+	CHECK_EQUAL(1, value_listener_a_counter);
+	CHECK_EQUAL(1, value_listener_b_counter);
+	CHECK_EQUAL(2, value_listener_any_counter);
+
+	gatt_client_stop_listening_for_characteristic_value_updates(&listener_b);
+}
+
 TEST(GATTClient, TestWriteCharacteristicValue){
     test = WRITE_CHARACTERISTIC_VALUE;
 	reset_query_state();
@@ -100,6 +100,10 @@ void l2cap_register_fixed_channel(btstack_packet_handler_t packet_handler, uint1
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
 	registered_hci_event_handler = callback_handler->callback;
 }
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+	(void) event_codes;
+	hci_add_event_handler(callback_handler);
+}
 
 int l2cap_reserve_packet_buffer(void){
 	return 1;
@@ -114,19 +118,62 @@ void l2cap_request_can_send_fix_channel_now_event(uint16_t handle, uint16_t chan
 	att_packet_handler(HCI_EVENT_PACKET, 0, (uint8_t*)event, sizeof(event));
 }
 
+// deferred ATT responses, delivered by mock_deliver_deferred_att_response
+#define MOCK_DEFERRED_RESPONSES_MAX 4
+static int      deferred_responses_enabled;
+static int      deferred_responses_count;
+static uint8_t  deferred_responses[MOCK_DEFERRED_RESPONSES_MAX][PREBUFFER_SIZE + max_mtu];
+static uint16_t deferred_responses_len[MOCK_DEFERRED_RESPONSES_MAX];
+
+void mock_defer_att_responses(int enabled){
+	deferred_responses_enabled = enabled;
+}
+
+// returns 1 if response was delivered
+int mock_deliver_deferred_att_response(void){
+	if (deferred_responses_count == 0) return 0;
+	uint8_t response_buffer[PREBUFFER_SIZE + max_mtu];
+	uint16_t response_len = deferred_responses_len[0];
+	memcpy(response_buffer, deferred_responses[0], sizeof(response_buffer));
+	deferred_responses_count--;
+	memmove(&deferred_responses[0], &deferred_responses[1], deferred_responses_count * sizeof(deferred_responses[0]));
+	memmove(&deferred_responses_len[0], &deferred_responses_len[1], deferred_responses_count * sizeof(deferred_responses_len[0]));
+	att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response_buffer[PREBUFFER_SIZE], response_len);
+	return 1;
+}
+
+void mock_simulate_att_notification(uint16_t value_handle, const uint8_t * value, uint16_t value_len){
+	uint8_t packet_buffer[PREBUFFER_SIZE + max_mtu];
+	uint8_t * packet = &packet_buffer[PREBUFFER_SIZE];
+	packet[0] = ATT_HANDLE_VALUE_NOTIFICATION;
+	little_endian_store_16(packet, 1, value_handle);
+	memcpy(&packet[3], value, value_len);
+	att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, packet, 3 + value_len);
+}
+
 int l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t len){
 	att_connection_t att_connection;
 	att_init_connection(&att_connection);
 	uint8_t response_buffer[PREBUFFER_SIZE + max_mtu];
 	uint8_t * response = &response_buffer[PREBUFFER_SIZE];
 	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, response);
-	if (response_len){
-		att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response[0], response_len);
+	if (response_len == 0) return 0;
+	if (deferred_responses_enabled && (deferred_responses_count < MOCK_DEFERRED_RESPONSES_MAX)){
+		memcpy(deferred_responses[deferred_responses_count], response_buffer, sizeof(response_buffer));
+		deferred_responses_len[deferred_responses_count] = response_len;
+		deferred_responses_count++;
+		return 0;
 	}
+	att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response[0], response_len);
 	return 0;
 }
 
+static btstack_packet_handler_t registered_sm_event_handler;
 void sm_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
+	registered_sm_event_handler = callback_handler->callback;
+}
+void mock_simulate_sm_event(const uint8_t * packet, uint16_t size){
+	registered_sm_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *) packet, size);
 }
 
 int  sm_cmac_ready(void){
@@ -135,8 +182,12 @@ int  sm_cmac_ready(void){
 void sm_cmac_signed_write_start(const sm_key_t key, uint8_t opcode, uint16_t attribute_handle, uint16_t message_len, const uint8_t * message, uint32_t sign_counter, void (*done_callback)(uint8_t * hash)){
 	//sm_notify_client(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, sm_central_device_addr_type, sm_central_device_address, 0, sm_central_device_matched);      
 }
+static int mock_le_device_index = -1;
+void mock_set_le_device_index(int le_device_index){
+	mock_le_device_index = le_device_index;
+}
 int sm_le_device_index(uint16_t handle ){
-	return -1;
+	return mock_le_device_index;
 }
 void sm_send_security_request(hci_con_handle_t con_handle){
 }
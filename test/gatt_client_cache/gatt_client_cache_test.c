@@ -0,0 +1,265 @@
+
+// *****************************************************************************
+//
+// test GATT Client discovery cache
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_memory.h"
+#include "hci.h"
+#include "ble/gatt_client.h"
+#include "ble/att_db.h"
+#include "btstack_event.h"
+#include "btstack_tlv.h"
+#include "profile.h"
+
+static uint16_t gatt_client_handle = 0x40;
+static int gatt_query_complete;
+static int gatt_query_complete_counter;
+static int result_index;
+
+static gatt_client_service_t services[10];
+static gatt_client_characteristic_t characteristics[10];
+static gatt_client_characteristic_descriptor_t descriptors[10];
+
+void mock_defer_att_responses(int enabled);
+int  mock_deliver_deferred_att_response(void);
+void mock_set_le_device_index(int le_device_index);
+void mock_simulate_sm_event(const uint8_t * packet, uint16_t size);
+
+// single tag TLV for GATT Client cache
+static uint32_t tlv_tag;
+static uint8_t  tlv_value[GATT_CLIENT_CACHE_SIZE];
+static int      tlv_value_len;
+
+static int tlv_get_tag(void * context, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
+	if ((tlv_value_len == 0) || (tag != tlv_tag)) return 0;
+	memcpy(buffer, tlv_value, btstack_min(buffer_size, tlv_value_len));
+	return tlv_value_len;
+}
+
+static int tlv_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
+	tlv_tag = tag;
+	tlv_value_len = data_size;
+	memcpy(tlv_value, data, data_size);
+	return 0;
+}
+
+static void tlv_delete_tag(void * context, uint32_t tag){
+	if (tag == tlv_tag) tlv_value_len = 0;
+}
+
+static const btstack_tlv_t tlv_impl = {
+	&tlv_get_tag,
+	&tlv_store_tag,
+	&tlv_delete_tag,
+};
+
+static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	if (packet_type != HCI_EVENT_PACKET) return;
+	switch (packet[0]){
+		case GATT_EVENT_QUERY_COMPLETE:
+			gatt_query_complete_counter++;
+			gatt_query_complete = (gatt_event_query_complete_get_att_status(packet) == ATT_ERROR_SUCCESS) ? 1 : 0;
+			break;
+		case GATT_EVENT_SERVICE_QUERY_RESULT:
+			gatt_event_service_query_result_get_service(packet, &services[result_index++]);
+			break;
+		case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+			gatt_event_characteristic_query_result_get_characteristic(packet, &characteristics[result_index++]);
+			break;
+		case GATT_EVENT_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT:
+			gatt_event_all_characteristic_descriptors_query_result_get_characteristic_descriptor(packet, &descriptors[result_index++]);
+			break;
+		default:
+			break;
+	}
+}
+
+static void simulate_bonding_deleted(uint16_t le_device_index){
+	uint8_t event[11];
+	memset(event, 0, sizeof(event));
+	event[0] = SM_EVENT_BONDING_DELETED;
+	event[1] = sizeof(event) - 2;
+	little_endian_store_16(event, 9, le_device_index);
+	mock_simulate_sm_event(event, sizeof(event));
+}
+
+static void simulate_identity_created(uint16_t le_device_index){
+	uint8_t event[20];
+	memset(event, 0, sizeof(event));
+	event[0] = SM_EVENT_IDENTITY_CREATED;
+	event[1] = sizeof(event) - 2;
+	little_endian_store_16(event, 2, gatt_client_handle);
+	little_endian_store_16(event, 18, le_device_index);
+	mock_simulate_sm_event(event, sizeof(event));
+}
+
+TEST_GROUP(GATTClientCache){
+	uint8_t status;
+
+	void setup(void){
+		tlv_value_len = 0;
+		btstack_tlv_set_instance(&tlv_impl, NULL);
+		mock_set_le_device_index(0);
+		mock_defer_att_responses(0);
+		reset_query_state();
+	}
+
+	void teardown(void){
+		while (mock_deliver_deferred_att_response() != 0){}
+		mock_defer_att_responses(0);
+		mock_set_le_device_index(-1);
+		btstack_tlv_set_instance(NULL, NULL);
+	}
+
+	void reset_query_state(void){
+		gatt_query_complete = 0;
+		gatt_query_complete_counter = 0;
+		result_index = 0;
+	}
+
+	void discover_all(void){
+		reset_query_state();
+		status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+		CHECK_EQUAL(0, status);
+		CHECK_EQUAL(1, gatt_query_complete);
+		CHECK_EQUAL(4, result_index);
+		CHECK_EQUAL(ATT_SERVICE_FF10_START_HANDLE, services[2].start_group_handle);
+		CHECK_EQUAL(ATT_SERVICE_FF10_END_HANDLE, services[2].end_group_handle);
+		CHECK_EQUAL(0xFF10, services[2].uuid16);
+		CHECK_EQUAL(0, services[3].uuid16);
+		CHECK_EQUAL(0x3A, services[3].uuid128[0]);
+
+		reset_query_state();
+		status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, 0xFF10);
+		CHECK_EQUAL(0, status);
+		CHECK_EQUAL(1, gatt_query_complete);
+		CHECK_EQUAL(1, result_index);
+		CHECK_EQUAL(ATT_SERVICE_FF10_START_HANDLE, services[0].start_group_handle);
+		gatt_client_service_t service = services[0];
+
+		reset_query_state();
+		status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &service);
+		CHECK_EQUAL(0, status);
+		CHECK_EQUAL(1, gatt_query_complete);
+		CHECK_EQUAL(2, result_index);
+		CHECK_EQUAL(ATT_CHARACTERISTIC_FF11_01_VALUE_HANDLE, characteristics[0].value_handle);
+		CHECK_EQUAL(0xFF11, characteristics[0].uuid16);
+		CHECK_EQUAL(ATT_CHARACTERISTIC_FF12_01_VALUE_HANDLE, characteristics[1].value_handle);
+		CHECK_EQUAL(0xFF12, characteristics[1].uuid16);
+
+		reset_query_state();
+		status = gatt_client_discover_characteristic_descriptors(handle_ble_client_event, gatt_client_handle, &characteristics[0]);
+		CHECK_EQUAL(0, status);
+		CHECK_EQUAL(1, gatt_query_complete);
+		CHECK_EQUAL(2, result_index);
+		CHECK_EQUAL(ATT_CHARACTERISTIC_FF11_01_CLIENT_CONFIGURATION_HANDLE, descriptors[0].handle);
+		CHECK_EQUAL(0x2902, descriptors[0].uuid16);
+		CHECK_EQUAL(ATT_CHARACTERISTIC_FF11_01_USER_DESCRIPTION_HANDLE, descriptors[1].handle);
+		CHECK_EQUAL(0x2901, descriptors[1].uuid16);
+	}
+};
+
+TEST(GATTClientCache, DiscoveryFromCache){
+	// first discovery is recorded
+	discover_all();
+	CHECK(tlv_value_len > 16);
+
+	// repeated discovery is answered without ATT requests
+	mock_defer_att_responses(1);
+	discover_all();
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xFF12);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(1, result_index);
+	CHECK_EQUAL(ATT_CHARACTERISTIC_FF12_01_VALUE_HANDLE, characteristics[0].value_handle);
+	CHECK_EQUAL(0, mock_deliver_deferred_att_response());
+
+	// cache for different Database Hash is ignored
+	tlv_value[0] ^= 0xff;
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(0, gatt_query_complete);
+	while (mock_deliver_deferred_att_response() != 0){}
+	CHECK_EQUAL(1, gatt_query_complete);
+	CHECK_EQUAL(4, result_index);
+}
+
+TEST(GATTClientCache, DiscoveryWithoutBonding){
+	mock_set_le_device_index(-1);
+	discover_all();
+	CHECK_EQUAL(0, tlv_value_len);
+}
+
+static int cached_query_depth;
+static int cached_query_max_depth;
+static int cached_query_remaining;
+
+static void handle_cached_query_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	if (packet[0] != GATT_EVENT_QUERY_COMPLETE) return;
+	gatt_query_complete_counter++;
+	cached_query_depth++;
+	cached_query_max_depth = btstack_max(cached_query_max_depth, cached_query_depth);
+	if (cached_query_remaining > 0){
+		cached_query_remaining--;
+		CHECK_EQUAL(0, gatt_client_discover_primary_services(&handle_cached_query_event, gatt_client_handle));
+	}
+	cached_query_depth--;
+}
+
+TEST(GATTClientCache, DiscoveryFromCacheStartedFromCallback){
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(1, gatt_query_complete);
+
+	// cached results are reported from run loop, follow-up queries do not nest
+	mock_defer_att_responses(1);
+	gatt_query_complete_counter = 0;
+	cached_query_depth = 0;
+	cached_query_max_depth = 0;
+	cached_query_remaining = 10;
+	status = gatt_client_discover_primary_services(&handle_cached_query_event, gatt_client_handle);
+	CHECK_EQUAL(0, status);
+	CHECK_EQUAL(11, gatt_query_complete_counter);
+	CHECK_EQUAL(1, cached_query_max_depth);
+	CHECK_EQUAL(0, mock_deliver_deferred_att_response());
+	CHECK_EQUAL(1, gatt_client_is_ready(gatt_client_handle));
+}
+
+TEST(GATTClientCache, CacheDeletedWithBonding){
+	discover_all();
+	CHECK(tlv_value_len > 16);
+
+	// other device
+	simulate_bonding_deleted(1);
+	CHECK(tlv_value_len > 16);
+
+	simulate_bonding_deleted(0);
+	CHECK_EQUAL(0, tlv_value_len);
+}
+
+TEST(GATTClientCache, CacheDeletedWithNewBonding){
+	discover_all();
+	CHECK(tlv_value_len > 16);
+
+	simulate_identity_created(0);
+	CHECK_EQUAL(0, tlv_value_len);
+}
+
+int main (int argc, const char * argv[]){
+	att_set_db(profile_data);
+	gatt_client_init();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
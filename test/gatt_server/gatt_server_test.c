@@ -14,6 +14,7 @@
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
 
+#include "bluetooth_gatt.h"
 #include "hci_cmd.h"
 
 #include "btstack_memory.h"
@@ -23,6 +24,95 @@
 #include "ble/att_db.h"
 #include "profile.h"
 
+void mock_simulate_hci_state_working(void);
+void mock_simulate_connected(void);
+void mock_simulate_att_pdu(const uint8_t * pdu, uint16_t pdu_len);
+void mock_clear_sent_pdus(void);
+int  mock_get_sent_pdu_count(void);
+const uint8_t * mock_get_sent_pdu(int index, uint16_t * pdu_len);
+
+static const hci_con_handle_t con_handle = 0x40;
+
+static const uint8_t value_a[] = { 0x01, 0x02 };
+static const uint8_t value_b[] = { 0x03, 0x04 };
+static const uint8_t value_c[] = { 0x05, 0x06 };
+static const uint8_t value_d[] = { 0x07, 0x08 };
+
+static const att_server_notification_t notifications[] = {
+    { 0x0010, value_a, sizeof(value_a) },
+    { 0x0011, value_b, sizeof(value_b) },
+    { 0x0012, value_c, sizeof(value_c) },
+    { 0x0013, value_d, sizeof(value_d) },
+};
+
+TEST_GROUP(ATTServer){
+    void setup(void){
+        att_server_init(profile_data, NULL, NULL);
+        mock_simulate_hci_state_working();
+        mock_simulate_connected();
+        mock_clear_sent_pdus();
+    }
+
+    void enable_multiple_handle_value_notifications(void){
+        uint16_t features_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(0x0001, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_CLIENT_SUPPORTED_FEATURES);
+        CHECK(features_handle != 0);
+        uint8_t write_request[] = { ATT_WRITE_REQUEST, (uint8_t) (features_handle & 0xff), (uint8_t) (features_handle >> 8), GATT_CLIENT_SUPPORTED_FEATURES_MULTIPLE_HANDLE_VALUE_NOTIFICATIONS };
+        mock_simulate_att_pdu(write_request, sizeof(write_request));
+        CHECK_EQUAL(1, mock_get_sent_pdu_count());
+        uint16_t pdu_len;
+        const uint8_t * pdu = mock_get_sent_pdu(0, &pdu_len);
+        CHECK_EQUAL(ATT_WRITE_RESPONSE, pdu[0]);
+        mock_clear_sent_pdus();
+    }
+
+    void check_single_notification(int index, const att_server_notification_t * notification){
+        uint16_t pdu_len;
+        const uint8_t * pdu = mock_get_sent_pdu(index, &pdu_len);
+        CHECK_EQUAL(3 + notification->value_len, pdu_len);
+        CHECK_EQUAL(ATT_HANDLE_VALUE_NOTIFICATION, pdu[0]);
+        CHECK_EQUAL(notification->attribute_handle, little_endian_read_16(pdu, 1));
+        MEMCMP_EQUAL(notification->value, &pdu[3], notification->value_len);
+    }
+};
+
+TEST(ATTServer, NotifyBatchSingleNotifications){
+    // client did not enable Multiple Handle Value Notifications
+    uint16_t num_sent = att_server_notify_batch(con_handle, notifications, 4);
+    CHECK_EQUAL(4, num_sent);
+    CHECK_EQUAL(4, mock_get_sent_pdu_count());
+    int i;
+    for (i = 0; i < 4; i++){
+        check_single_notification(i, &notifications[i]);
+    }
+}
+
+TEST(ATTServer, NotifyBatchMultipleHandleValueNotification){
+    enable_multiple_handle_value_notifications();
+    uint16_t num_sent = att_server_notify_batch(con_handle, notifications, 4);
+    CHECK_EQUAL(4, num_sent);
+    CHECK_EQUAL(2, mock_get_sent_pdu_count());
+
+    // three (handle, length, value) tuples fit into default MTU of 23
+    uint16_t pdu_len;
+    const uint8_t * pdu = mock_get_sent_pdu(0, &pdu_len);
+    CHECK_EQUAL(1 + 3 * 6, pdu_len);
+    CHECK_EQUAL(ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION, pdu[0]);
+    int i;
+    for (i = 0; i < 3; i++){
+        uint16_t pos = 1 + i * 6;
+        CHECK_EQUAL(notifications[i].attribute_handle, little_endian_read_16(pdu, pos));
+        CHECK_EQUAL(notifications[i].value_len, little_endian_read_16(pdu, pos + 2));
+        MEMCMP_EQUAL(notifications[i].value, &pdu[pos + 4], notifications[i].value_len);
+    }
+
+    // single remaining value falls back to Handle Value Notification
+    check_single_notification(1, &notifications[3]);
+}
+
+TEST(ATTServer, NotifyBatchUnknownConnection){
+    CHECK_EQUAL(0, att_server_notify_batch(HCI_CON_HANDLE_INVALID, notifications, 4));
+}
+
 int main (int argc, const char * argv[]){
     return CommandLineTestRunner::RunAllTests(argc, argv);
 }
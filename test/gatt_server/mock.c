@@ -20,6 +20,12 @@ static uint8_t  l2cap_stack_buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 8 + max_mtu];
 static uint16_t gatt_client_handle = 0x40;
 static hci_connection_t hci_connection;
 
+// PDUs sent by ATT Server
+#define MOCK_MAX_SENT_PDUS 10
+static uint8_t  sent_pdus[MOCK_MAX_SENT_PDUS][max_mtu];
+static uint16_t sent_pdu_lens[MOCK_MAX_SENT_PDUS];
+static int      sent_pdu_count;
+
 uint16_t get_gatt_client_handle(void){
 	return gatt_client_handle;
 }
@@ -35,6 +41,8 @@ void mock_simulate_hci_state_working(void){
 }
 
 void mock_simulate_connected(void){
+	hci_connection.con_handle = gatt_client_handle;
+	btstack_linked_list_add(&connections, (btstack_linked_item_t *) &hci_connection);
 	uint8_t packet[] = {0x3E, 0x13, 0x01, 0x00, 0x40, 0x00, 0x00, 0x00, 0x9B, 0x77, 0xD1, 0xF7, 0xB1, 0x34, 0x50, 0x00, 0x00, 0x00, 0xD0, 0x07, 0x05};
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
 }
@@ -44,6 +52,23 @@ void mock_simulate_scan_response(void){
 	registered_hci_event_handler(HCI_EVENT_PACKET, 0, (uint8_t *)&packet, sizeof(packet));
 }
 
+void mock_simulate_att_pdu(const uint8_t * pdu, uint16_t pdu_len){
+	att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, (uint8_t *) pdu, pdu_len);
+}
+
+void mock_clear_sent_pdus(void){
+	sent_pdu_count = 0;
+}
+
+int mock_get_sent_pdu_count(void){
+	return sent_pdu_count;
+}
+
+const uint8_t * mock_get_sent_pdu(int index, uint16_t * pdu_len){
+	*pdu_len = sent_pdu_lens[index];
+	return sent_pdus[index];
+}
+
 void gap_start_scan(void){
 }
 void gap_stop_scan(void){
@@ -59,14 +84,6 @@ int gap_reconnect_security_setup_active(hci_con_handle_t con_handle){
 	return 0;
 }
 
-static void att_init_connection(att_connection_t * att_connection){
-    att_connection->mtu = 23;
-    att_connection->max_mtu = 23;
-    att_connection->encryption_key_size = 0;
-    att_connection->authenticated = 0;
-	att_connection->authorized = 0;
-}
-
 int hci_can_send_acl_le_packet_now(void){
 	return 1;
 }
@@ -99,6 +116,10 @@ void l2cap_register_fixed_channel(btstack_packet_handler_t packet_handler, uint1
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
 	registered_hci_event_handler = callback_handler->callback;
 }
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+	(void) event_codes;
+	hci_add_event_handler(callback_handler);
+}
 
 int l2cap_reserve_packet_buffer(void){
 	return 1;
@@ -117,12 +138,10 @@ void l2cap_request_can_send_fix_channel_now_event(uint16_t handle, uint16_t chan
 }
 
 int l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t len){
-	att_connection_t att_connection;
-	att_init_connection(&att_connection);
-	uint8_t response[max_mtu];
-	uint16_t response_len = att_handle_request(&att_connection, l2cap_get_outgoing_buffer(), len, &response[0]);
-	if (response_len){
-		att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, &response[0], response_len);
+	if (sent_pdu_count < MOCK_MAX_SENT_PDUS){
+		memcpy(sent_pdus[sent_pdu_count], l2cap_get_outgoing_buffer(), btstack_min(len, max_mtu));
+		sent_pdu_lens[sent_pdu_count] = len;
+		sent_pdu_count++;
 	}
 	return 0;
 }
@@ -172,6 +191,7 @@ hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t addr, bd_addr_t
 	return NULL;
 }
 hci_connection_t * hci_connection_for_handle(hci_con_handle_t con_handle){
+	if (con_handle != gatt_client_handle) return NULL;
 	return &hci_connection;
 }
 void hci_connections_get_iterator(btstack_linked_list_iterator_t *it){
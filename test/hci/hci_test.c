@@ -0,0 +1,405 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "btstack_event.h"
+#include "bluetooth.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "hci_transport.h"
+
+#define TEST_CON_HANDLE        0x0040
+#define TEST_ACL_PACKET_LEN    27
+#define TEST_ACL_PACKETS_NUM   4
+
+#define MAX_ACL_FRAGMENTS      16
+
+typedef struct {
+    uint16_t size;
+    uint8_t  buffer[4 + TEST_ACL_PACKET_LEN];
+} acl_fragment_t;
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static acl_fragment_t transport_acl_fragments[MAX_ACL_FRAGMENTS];
+static int transport_acl_fragments_num;
+static int transport_acl_busy;
+static int transport_vectored_calls;
+static int transport_vectored_accept;
+
+static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+
+static void transport_store_acl_fragment(const uint8_t * header, uint16_t header_len, const uint8_t * payload, uint16_t payload_len){
+    CHECK_TRUE(transport_acl_fragments_num < MAX_ACL_FRAGMENTS);
+    CHECK_TRUE((header_len + payload_len) <= (4 + TEST_ACL_PACKET_LEN));
+    acl_fragment_t * fragment = &transport_acl_fragments[transport_acl_fragments_num++];
+    memcpy(fragment->buffer, header, header_len);
+    memcpy(&fragment->buffer[header_len], payload, payload_len);
+    fragment->size = header_len + payload_len;
+}
+
+static int hci_transport_test_can_send_now(uint8_t packet_type){
+    if (packet_type == HCI_ACL_DATA_PACKET) return transport_acl_busy == 0;
+    return 1;
+}
+
+static int hci_transport_test_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    if (packet_type != HCI_ACL_DATA_PACKET){
+        // commands are done immediately
+        packet_handler(HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+        return 0;
+    }
+    CHECK_FALSE(transport_acl_busy);
+    transport_store_acl_fragment(packet, 4, &packet[4], size - 4);
+    transport_acl_busy = 1;
+    return 0;
+}
+
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+static int hci_transport_test_send_packet_vectored(uint8_t packet_type, const btstack_iovec_t * vectors, int num_vectors){
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, packet_type);
+    CHECK_FALSE(transport_acl_busy);
+    transport_vectored_calls++;
+    int num_packets = num_vectors / 2;
+    if ((transport_vectored_accept >= 0) && (num_packets > transport_vectored_accept)){
+        num_packets = transport_vectored_accept;
+    }
+    int i;
+    for (i = 0; i < num_packets; i++){
+        transport_store_acl_fragment((const uint8_t *) vectors[2 * i].data, vectors[2 * i].len,
+                                     (const uint8_t *) vectors[2 * i + 1].data, vectors[2 * i + 1].len);
+    }
+    if (num_packets > 0){
+        transport_acl_busy = 1;
+    }
+    return num_packets;
+}
+#endif
+
+static void hci_transport_test_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int hci_transport_test_open(void){
+    return 0;
+}
+
+static int hci_transport_test_close(void){
+    return 0;
+}
+
+static void hci_transport_test_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static const hci_transport_t hci_transport_test = {
+        /* const char * name; */                                        "TEST",
+        /* void   (*init) (const void *transport_config); */            &hci_transport_test_init,
+        /* int    (*open)(void); */                                     &hci_transport_test_open,
+        /* int    (*close)(void); */                                    &hci_transport_test_close,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_test_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_test_can_send_now,
+        /* int    (*send_packet)(...); */                               &hci_transport_test_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+        /* int    (*send_packet_vectored)(...); */                      &hci_transport_test_send_packet_vectored,
+#else
+        /* int    (*send_packet_vectored)(...); */                      NULL,
+#endif
+};
+
+// complete all ACL packets passed to transport
+static void transport_complete(void){
+    transport_acl_busy = 0;
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+}
+
+static void simulate_le_read_buffer_size(uint16_t acl_len, uint8_t acl_num){
+    uint8_t event[] = { HCI_EVENT_COMMAND_COMPLETE, 7, 1, 0x02, 0x20, 0x00, 0, 0, 0};
+    little_endian_store_16(event, 6, acl_len);
+    event[8] = acl_num;
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void simulate_le_connection_complete(hci_con_handle_t con_handle){
+    uint8_t event[] = { HCI_EVENT_LE_META, 19, HCI_SUBEVENT_LE_CONNECTION_COMPLETE, 0x00, 0, 0, HCI_ROLE_SLAVE, 0x00,
+                        0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x28, 0x00, 0x00, 0x00, 0xd0, 0x07, 0x00 };
+    little_endian_store_16(event, 4, con_handle);
+    event[12] = (uint8_t) (con_handle >> 8);
+    event[13] = (uint8_t) con_handle;
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void simulate_number_of_completed_packets(hci_con_handle_t con_handle, uint16_t num_packets){
+    uint8_t event[] = { HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 5, 1, 0, 0, 0, 0};
+    little_endian_store_16(event, 3, con_handle);
+    little_endian_store_16(event, 5, num_packets);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void simulate_disconnection_complete(hci_con_handle_t con_handle){
+    uint8_t event[] = { HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, 0, 0, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION};
+    little_endian_store_16(event, 3, con_handle);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static uint8_t test_payload_byte(hci_con_handle_t con_handle, uint16_t pos){
+    return (uint8_t) (pos + con_handle);
+}
+
+static int send_acl_packet(hci_con_handle_t con_handle, uint16_t payload_len){
+    CHECK_TRUE(hci_reserve_packet_buffer());
+    uint8_t * packet = hci_get_outgoing_packet_buffer();
+    little_endian_store_16(packet, 0, con_handle | 0x2000);
+    little_endian_store_16(packet, 2, payload_len);
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        packet[4 + i] = test_payload_byte(con_handle, i);
+    }
+    return hci_send_acl_packet_buffer(4 + payload_len);
+}
+
+// reassemble ACL packet from fragments and check packet boundary flags
+static void check_acl_packet(hci_con_handle_t con_handle, int first_fragment, int num_fragments, uint16_t payload_len){
+    uint16_t pos = 0;
+    int i;
+    for (i = first_fragment; i < first_fragment + num_fragments; i++){
+        const acl_fragment_t * fragment = &transport_acl_fragments[i];
+        uint16_t handle_and_flags = little_endian_read_16(fragment->buffer, 0);
+        CHECK_EQUAL(con_handle, handle_and_flags & 0x0fff);
+        CHECK_EQUAL(i == first_fragment ? 2 : 1, (handle_and_flags >> 12) & 0x03);
+        uint16_t fragment_len = little_endian_read_16(fragment->buffer, 2);
+        CHECK_EQUAL(fragment->size - 4, fragment_len);
+        uint16_t j;
+        for (j = 0; j < fragment_len; j++){
+            CHECK_EQUAL(test_payload_byte(con_handle, pos + j), fragment->buffer[4 + j]);
+        }
+        pos += fragment_len;
+    }
+    CHECK_EQUAL(payload_len, pos);
+}
+
+TEST_GROUP(HCI_ACL){
+    void setup(void){
+        transport_acl_fragments_num = 0;
+        transport_acl_busy = 0;
+        transport_vectored_calls = 0;
+        transport_vectored_accept = -1;
+        hci_init(&hci_transport_test, NULL);
+        hci_simulate_working_fuzz();
+        simulate_le_read_buffer_size(TEST_ACL_PACKET_LEN, TEST_ACL_PACKETS_NUM);
+        simulate_le_connection_complete(TEST_CON_HANDLE);
+    }
+    void teardown(void){
+        simulate_disconnection_complete(TEST_CON_HANDLE);
+    }
+};
+
+TEST(HCI_ACL, SendFragments){
+    CHECK_TRUE(hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 100));
+    while (transport_acl_busy){
+        transport_complete();
+    }
+    CHECK_EQUAL(4, transport_acl_fragments_num);
+    check_acl_packet(TEST_CON_HANDLE, 0, 4, 100);
+    CHECK_FALSE(hci_can_send_acl_le_packet_now());
+    simulate_number_of_completed_packets(TEST_CON_HANDLE, 4);
+    CHECK_TRUE(hci_can_send_acl_le_packet_now());
+}
+
+TEST(HCI_ACL, FragmentsLimitedByControllerBuffers){
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 150));
+    while (transport_acl_busy){
+        transport_complete();
+    }
+    CHECK_EQUAL(TEST_ACL_PACKETS_NUM, transport_acl_fragments_num);
+    simulate_number_of_completed_packets(TEST_CON_HANDLE, 2);
+    while (transport_acl_busy){
+        transport_complete();
+    }
+    CHECK_EQUAL(6, transport_acl_fragments_num);
+    check_acl_packet(TEST_CON_HANDLE, 0, 6, 150);
+}
+
+#ifdef ENABLE_HCI_SEND_PACKET_VECTORED
+TEST(HCI_ACL, VectoredSingleTransportCall){
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 100));
+    CHECK_EQUAL(1, transport_vectored_calls);
+    CHECK_EQUAL(4, transport_acl_fragments_num);
+    check_acl_packet(TEST_CON_HANDLE, 0, 4, 100);
+    transport_complete();
+    CHECK_EQUAL(1, transport_vectored_calls);
+}
+
+TEST(HCI_ACL, VectoredPartialAcceptSendsRemainingFragments){
+    transport_vectored_accept = 2;
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 100));
+    CHECK_EQUAL(2, transport_acl_fragments_num);
+    // remaining fragments are sent without waiting for completed packets, as they did not use controller buffers
+    transport_complete();
+    CHECK_EQUAL(4, transport_acl_fragments_num);
+    transport_complete();
+    check_acl_packet(TEST_CON_HANDLE, 0, 4, 100);
+    simulate_number_of_completed_packets(TEST_CON_HANDLE, 4);
+    CHECK_TRUE(hci_can_send_acl_le_packet_now());
+}
+
+TEST(HCI_ACL, VectoredTransportFailureDropsPacket){
+    transport_vectored_accept = 0;
+    CHECK_TRUE(send_acl_packet(TEST_CON_HANDLE, 100) != 0);
+    CHECK_EQUAL(0, transport_acl_fragments_num);
+    // packet buffer released and no controller buffers used
+    CHECK_TRUE(hci_can_send_acl_le_packet_now());
+
+    transport_vectored_accept = -1;
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 100));
+    CHECK_EQUAL(4, transport_acl_fragments_num);
+    check_acl_packet(TEST_CON_HANDLE, 0, 4, 100);
+}
+#endif
+
+// con handles with same index in connection lookup table, more than table size
+#define TEST_LOOKUP_CONNECTIONS_NUM (HCI_CONNECTION_LOOKUP_TABLE_SIZE + 4)
+
+static hci_con_handle_t test_lookup_con_handle(int index){
+    return TEST_CON_HANDLE + (index * HCI_CONNECTION_LOOKUP_TABLE_SIZE);
+}
+
+static void check_connections_for_handles(int num_connections){
+    int i;
+    for (i = 0; i < num_connections; i++){
+        hci_connection_t * connection = hci_connection_for_handle(test_lookup_con_handle(i));
+        CHECK_TRUE(connection != NULL);
+        CHECK_EQUAL(test_lookup_con_handle(i), connection->con_handle);
+    }
+}
+
+TEST(HCI_ACL, LookupTableCollisions){
+    int i;
+    for (i = 1; i < 4; i++){
+        simulate_le_connection_complete(test_lookup_con_handle(i));
+    }
+    // first lookup fills table, second one uses it
+    check_connections_for_handles(4);
+    check_connections_for_handles(4);
+    POINTERS_EQUAL(NULL, hci_connection_for_handle(test_lookup_con_handle(4)));
+
+    // remove connection in the middle of probe sequence
+    simulate_disconnection_complete(test_lookup_con_handle(1));
+    POINTERS_EQUAL(NULL, hci_connection_for_handle(test_lookup_con_handle(1)));
+    CHECK_EQUAL(test_lookup_con_handle(2), hci_connection_for_handle(test_lookup_con_handle(2))->con_handle);
+    CHECK_EQUAL(test_lookup_con_handle(3), hci_connection_for_handle(test_lookup_con_handle(3))->con_handle);
+
+    for (i = 2; i < 4; i++){
+        simulate_disconnection_complete(test_lookup_con_handle(i));
+    }
+}
+
+TEST(HCI_ACL, LookupTableEviction){
+    int i;
+    for (i = 1; i < TEST_LOOKUP_CONNECTIONS_NUM; i++){
+        simulate_le_connection_complete(test_lookup_con_handle(i));
+    }
+    // more connections than table entries, evicted ones are found in connection list
+    check_connections_for_handles(TEST_LOOKUP_CONNECTIONS_NUM);
+    check_connections_for_handles(TEST_LOOKUP_CONNECTIONS_NUM);
+
+    for (i = 1; i < TEST_LOOKUP_CONNECTIONS_NUM; i += 2){
+        simulate_disconnection_complete(test_lookup_con_handle(i));
+    }
+    for (i = 0; i < TEST_LOOKUP_CONNECTIONS_NUM; i++){
+        hci_connection_t * connection = hci_connection_for_handle(test_lookup_con_handle(i));
+        if ((i & 1) == 0){
+            CHECK_TRUE(connection != NULL);
+            CHECK_EQUAL(test_lookup_con_handle(i), connection->con_handle);
+        } else {
+            POINTERS_EQUAL(NULL, connection);
+        }
+    }
+
+    for (i = 2; i < TEST_LOOKUP_CONNECTIONS_NUM; i += 2){
+        simulate_disconnection_complete(test_lookup_con_handle(i));
+    }
+}
+
+#if HCI_OUTGOING_PACKET_BUFFER_NUM > 1
+#define TEST_CON_HANDLE_2      0x0041
+
+static hci_con_handle_t acl_fragment_con_handle(int index){
+    return little_endian_read_16(transport_acl_fragments[index].buffer, 0) & 0x0fff;
+}
+
+TEST(HCI_ACL, PoolQueuesPacketsWhileTransportBusy){
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 20));
+    CHECK_TRUE(transport_acl_busy);
+    // packets are queued while transport is busy until pool is exhausted
+    int i;
+    for (i = 1; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        CHECK_TRUE(hci_can_send_acl_le_packet_now());
+        CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 20));
+    }
+    CHECK_EQUAL(1, transport_acl_fragments_num);
+    CHECK_FALSE(hci_can_send_acl_le_packet_now());
+    while (transport_acl_busy){
+        transport_complete();
+    }
+    CHECK_EQUAL(HCI_OUTGOING_PACKET_BUFFER_NUM, transport_acl_fragments_num);
+    for (i = 0; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        check_acl_packet(TEST_CON_HANDLE, i, 1, 20);
+    }
+}
+
+TEST(HCI_ACL, PoolQueuesServedRoundRobin){
+    simulate_le_connection_complete(TEST_CON_HANDLE_2);
+    // first packet goes to transport directly, others are queued
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 20));
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 20));
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE_2, 20));
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE_2, 20));
+    while (transport_acl_busy){
+        transport_complete();
+    }
+    CHECK_EQUAL(4, transport_acl_fragments_num);
+    CHECK_EQUAL(TEST_CON_HANDLE,   acl_fragment_con_handle(0));
+    CHECK_EQUAL(TEST_CON_HANDLE_2, acl_fragment_con_handle(1));
+    CHECK_EQUAL(TEST_CON_HANDLE,   acl_fragment_con_handle(2));
+    CHECK_EQUAL(TEST_CON_HANDLE_2, acl_fragment_con_handle(3));
+    simulate_disconnection_complete(TEST_CON_HANDLE_2);
+}
+
+TEST(HCI_ACL, PoolDisconnectReleasesQueuedPackets){
+    simulate_le_connection_complete(TEST_CON_HANDLE_2);
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 20));
+    int i;
+    for (i = 1; i < HCI_OUTGOING_PACKET_BUFFER_NUM; i++){
+        CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE_2, 20));
+    }
+    CHECK_FALSE(hci_can_send_acl_le_packet_now());
+
+    // queued packets and their controller buffers are released on disconnect
+    simulate_disconnection_complete(TEST_CON_HANDLE_2);
+    CHECK_TRUE(hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(TEST_ACL_PACKETS_NUM - 1, hci_number_free_acl_slots_for_handle(TEST_CON_HANDLE));
+    CHECK_EQUAL(0, send_acl_packet(TEST_CON_HANDLE, 20));
+    while (transport_acl_busy){
+        transport_complete();
+    }
+    CHECK_EQUAL(2, transport_acl_fragments_num);
+    check_acl_packet(TEST_CON_HANDLE, 0, 1, 20);
+    check_acl_packet(TEST_CON_HANDLE, 1, 1, 20);
+}
+#endif
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,162 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_util.h"
+#include "bluetooth.h"
+#include "hci_dump.h"
+
+#define TEST_FILE_NAME   "hci_dump_test.log"
+#define TEST_FILE_NAME_1 "hci_dump_test.log.1"
+
+#define BTSNOOP_FILE_HDR_SIZE 16
+#define BTSNOOP_HDR_SIZE      25
+#define PCAPNG_SHB_SIZE       28
+#define PCAPNG_IDB_SIZE       20
+#define PCAPNG_EPB_HDR_SIZE   28
+
+static const uint8_t hci_reset[] = { 0x03, 0x0c, 0x00 };
+static const uint8_t hci_command_complete[] = { 0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00 };
+
+static uint8_t  file_data[1000];
+static uint32_t file_len;
+
+static void read_file(const char * name){
+    file_len = 0;
+    FILE * file = fopen(name, "rb");
+    if (file == NULL) return;
+    file_len = (uint32_t) fread(file_data, 1, sizeof(file_data), file);
+    fclose(file);
+}
+
+static void dump_packets(int count){
+    int i;
+    for (i = 0; i < count; i++){
+        hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, (uint8_t *) hci_reset, sizeof(hci_reset));
+    }
+}
+
+TEST_GROUP(HCIDump){
+    void setup(void){
+        remove(TEST_FILE_NAME);
+        remove(TEST_FILE_NAME_1);
+        hci_dump_set_max_packets(-1);
+        hci_dump_set_max_file_size(0);
+    }
+    void teardown(void){
+        remove(TEST_FILE_NAME);
+        remove(TEST_FILE_NAME_1);
+    }
+};
+
+TEST(HCIDump, Btsnoop){
+    hci_dump_open(TEST_FILE_NAME, HCI_DUMP_BTSNOOP);
+    hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, (uint8_t *) hci_reset, sizeof(hci_reset));
+    // no record type for log messages
+    hci_dump_log(HCI_DUMP_LOG_LEVEL_INFO, "skipped");
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) hci_command_complete, sizeof(hci_command_complete));
+    hci_dump_close();
+
+    read_file(TEST_FILE_NAME);
+    CHECK_EQUAL(BTSNOOP_FILE_HDR_SIZE + 2 * BTSNOOP_HDR_SIZE + sizeof(hci_reset) + sizeof(hci_command_complete), file_len);
+    MEMCMP_EQUAL("btsnoop", file_data, 8);
+    CHECK_EQUAL(1, big_endian_read_32(file_data, 8));
+    CHECK_EQUAL(1002, big_endian_read_32(file_data, 12));
+
+    // command: original and included length incl. H4 packet type, flags: sent, command/event
+    uint8_t * record = &file_data[BTSNOOP_FILE_HDR_SIZE];
+    CHECK_EQUAL(1 + sizeof(hci_reset), big_endian_read_32(record, 0));
+    CHECK_EQUAL(1 + sizeof(hci_reset), big_endian_read_32(record, 4));
+    CHECK_EQUAL(2, big_endian_read_32(record, 8));
+    CHECK_EQUAL(0, big_endian_read_32(record, 12));
+    CHECK_EQUAL(HCI_COMMAND_DATA_PACKET, record[24]);
+    MEMCMP_EQUAL(hci_reset, &record[BTSNOOP_HDR_SIZE], sizeof(hci_reset));
+
+    // event: flags received, command/event
+    record += BTSNOOP_HDR_SIZE + sizeof(hci_reset);
+    CHECK_EQUAL(1 + sizeof(hci_command_complete), big_endian_read_32(record, 0));
+    CHECK_EQUAL(3, big_endian_read_32(record, 8));
+    CHECK_EQUAL(HCI_EVENT_PACKET, record[24]);
+    MEMCMP_EQUAL(hci_command_complete, &record[BTSNOOP_HDR_SIZE], sizeof(hci_command_complete));
+}
+
+TEST(HCIDump, Pcapng){
+    hci_dump_open(TEST_FILE_NAME, HCI_DUMP_PCAPNG);
+    hci_dump_packet(HCI_EVENT_PACKET, 1, (uint8_t *) hci_command_complete, sizeof(hci_command_complete));
+    hci_dump_log(HCI_DUMP_LOG_LEVEL_INFO, "log");
+    hci_dump_close();
+
+    read_file(TEST_FILE_NAME);
+
+    // Section Header Block and Interface Description Block with LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR
+    CHECK_EQUAL(0x0A0D0D0A, little_endian_read_32(file_data, 0));
+    CHECK_EQUAL(PCAPNG_SHB_SIZE, little_endian_read_32(file_data, 4));
+    CHECK_EQUAL(0x1A2B3C4D, little_endian_read_32(file_data, 8));
+    uint8_t * block = &file_data[PCAPNG_SHB_SIZE];
+    CHECK_EQUAL(1, little_endian_read_32(block, 0));
+    CHECK_EQUAL(PCAPNG_IDB_SIZE, little_endian_read_32(block, 4));
+    CHECK_EQUAL(201, little_endian_read_16(block, 8));
+
+    // Enhanced Packet Block with direction pseudo header, H4 packet type and padding to 32 bit
+    block += PCAPNG_IDB_SIZE;
+    uint32_t captured_len = 4 + 1 + sizeof(hci_command_complete);
+    uint32_t block_len = PCAPNG_EPB_HDR_SIZE + ((captured_len + 3) & ~3u) + 4;
+    CHECK_EQUAL(6, little_endian_read_32(block, 0));
+    CHECK_EQUAL(block_len, little_endian_read_32(block, 4));
+    CHECK_EQUAL(captured_len, little_endian_read_32(block, 20));
+    CHECK_EQUAL(captured_len, little_endian_read_32(block, 24));
+    CHECK_EQUAL(1, big_endian_read_32(block, PCAPNG_EPB_HDR_SIZE));
+    CHECK_EQUAL(HCI_EVENT_PACKET, block[PCAPNG_EPB_HDR_SIZE + 4]);
+    MEMCMP_EQUAL(hci_command_complete, &block[PCAPNG_EPB_HDR_SIZE + 5], sizeof(hci_command_complete));
+    CHECK_EQUAL(block_len, little_endian_read_32(block, block_len - 4));
+
+    // log message as Enhanced Packet Block without data and with opt_comment
+    block += block_len;
+    uint32_t log_block_len = little_endian_read_32(block, 4);
+    CHECK_EQUAL(6, little_endian_read_32(block, 0));
+    CHECK_EQUAL(0, little_endian_read_32(block, 20));
+    CHECK_EQUAL(1, little_endian_read_16(block, PCAPNG_EPB_HDR_SIZE));
+    CHECK_EQUAL(3, little_endian_read_16(block, PCAPNG_EPB_HDR_SIZE + 2));
+    MEMCMP_EQUAL("log", &block[PCAPNG_EPB_HDR_SIZE + 4], 3);
+    CHECK_EQUAL(log_block_len, little_endian_read_32(block, log_block_len - 4));
+
+    CHECK_EQUAL((uint32_t) (block + log_block_len - file_data), file_len);
+}
+
+TEST(HCIDump, RotateByPackets){
+    hci_dump_open(TEST_FILE_NAME, HCI_DUMP_BTSNOOP);
+    hci_dump_set_max_packets(2);
+    dump_packets(3);
+    hci_dump_close();
+
+    uint32_t record_len = BTSNOOP_HDR_SIZE + sizeof(hci_reset);
+    read_file(TEST_FILE_NAME_1);
+    CHECK_EQUAL(BTSNOOP_FILE_HDR_SIZE + 2 * record_len, file_len);
+    MEMCMP_EQUAL("btsnoop", file_data, 8);
+    read_file(TEST_FILE_NAME);
+    CHECK_EQUAL(BTSNOOP_FILE_HDR_SIZE + record_len, file_len);
+    MEMCMP_EQUAL("btsnoop", file_data, 8);
+}
+
+TEST(HCIDump, RotateBySize){
+    uint32_t record_len = BTSNOOP_HDR_SIZE + sizeof(hci_reset);
+    hci_dump_open(TEST_FILE_NAME, HCI_DUMP_BTSNOOP);
+    // header and three records fit
+    hci_dump_set_max_file_size(BTSNOOP_FILE_HDR_SIZE + 3 * record_len + 1);
+    dump_packets(5);
+    hci_dump_close();
+
+    read_file(TEST_FILE_NAME_1);
+    CHECK_EQUAL(BTSNOOP_FILE_HDR_SIZE + 3 * record_len, file_len);
+    read_file(TEST_FILE_NAME);
+    CHECK_EQUAL(BTSNOOP_FILE_HDR_SIZE + 2 * record_len, file_len);
+    MEMCMP_EQUAL("btsnoop", file_data, 8);
+    CHECK_EQUAL(HCI_COMMAND_DATA_PACKET, file_data[BTSNOOP_FILE_HDR_SIZE + 24]);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,567 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_uart_block.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_transport.h"
+
+// H5 link layer
+#define LINK_ACKNOWLEDGEMENT_TYPE 0x00
+#define LINK_CONTROL_PACKET_TYPE  0x0f
+#define SLIP_SOF                  0xc0
+#define SLIP_ESC                  0xdb
+#define SLIP_ESC_SOF              0xdc
+#define SLIP_ESC_ESC              0xdd
+
+#define TEST_BAUDRATE             115200
+#define MAX_FRAMES                16
+#define MAX_FRAME_SIZE            64
+
+typedef struct {
+    uint8_t  seq_nr;
+    uint8_t  ack_nr;
+    uint8_t  reliable;
+    uint8_t  type;
+    uint16_t payload_len;
+    uint8_t  payload[MAX_FRAME_SIZE];
+} frame_t;
+
+// fake run loop with manual time
+
+static uint32_t test_time_ms;
+
+static void test_run_loop_set_timer(btstack_timer_source_t * timer, uint32_t timeout_in_ms){
+    timer->timeout = test_time_ms + timeout_in_ms;
+}
+
+static uint32_t test_run_loop_get_time_ms(void){
+    return test_time_ms;
+}
+
+static const btstack_run_loop_t test_run_loop = {
+    &btstack_run_loop_base_init,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    &test_run_loop_set_timer,
+    &btstack_run_loop_base_add_timer,
+    &btstack_run_loop_base_remove_timer,
+    NULL,
+    &btstack_run_loop_base_dump_timer,
+    &test_run_loop_get_time_ms,
+    NULL,
+};
+
+static void test_run_loop_advance_time(uint32_t delta_ms){
+    test_time_ms += delta_ms;
+    btstack_run_loop_base_process_timers(test_time_ms);
+}
+
+// fake UART driver, sent blocks are collected and completed by test
+
+static void (*uart_block_sent)(void);
+static void (*uart_bytes_received)(uint16_t num_bytes);
+static uint8_t * uart_rx_buffer;
+static uint16_t  uart_rx_max_len;
+static int       uart_tx_active;
+
+static uint8_t   uart_tx_data[2048];
+static uint16_t  uart_tx_len;
+
+static int test_uart_init(const btstack_uart_config_t * config){
+    UNUSED(config);
+    return 0;
+}
+
+static int test_uart_open(void){
+    return 0;
+}
+
+static int test_uart_close(void){
+    return 0;
+}
+
+static void test_uart_set_block_received(void (*handler)(void)){
+    UNUSED(handler);
+}
+
+static void test_uart_set_block_sent(void (*handler)(void)){
+    uart_block_sent = handler;
+}
+
+static int test_uart_set_baudrate(uint32_t baudrate){
+    UNUSED(baudrate);
+    return 0;
+}
+
+static int test_uart_set_parity(int parity){
+    UNUSED(parity);
+    return 0;
+}
+
+static void test_uart_receive_block(uint8_t * buffer, uint16_t len){
+    UNUSED(buffer);
+    UNUSED(len);
+}
+
+static void test_uart_send_block(const uint8_t * buffer, uint16_t length){
+    CHECK_FALSE(uart_tx_active);
+    CHECK(((uint32_t) uart_tx_len + length) <= sizeof(uart_tx_data));
+    memcpy(&uart_tx_data[uart_tx_len], buffer, length);
+    uart_tx_len += length;
+    uart_tx_active = 1;
+}
+
+static void test_uart_set_bytes_received(void (*handler)(uint16_t num_bytes)){
+    uart_bytes_received = handler;
+}
+
+static void test_uart_receive_bytes(uint8_t * buffer, uint16_t max_len){
+    uart_rx_buffer  = buffer;
+    uart_rx_max_len = max_len;
+}
+
+static const btstack_uart_block_t test_uart = {
+    &test_uart_init,
+    &test_uart_open,
+    &test_uart_close,
+    &test_uart_set_block_received,
+    &test_uart_set_block_sent,
+    &test_uart_set_baudrate,
+    &test_uart_set_parity,
+    NULL,
+    &test_uart_receive_block,
+    &test_uart_send_block,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    &test_uart_set_bytes_received,
+    &test_uart_receive_bytes,
+};
+
+// complete all pending UART writes
+static void uart_complete_writes(void){
+    while (uart_tx_active){
+        uart_tx_active = 0;
+        (*uart_block_sent)();
+    }
+}
+
+// deliver data in chunks of given size
+static void uart_receive_data(const uint8_t * data, uint16_t len, uint16_t chunk_len){
+    uint16_t pos = 0;
+    while (pos < len){
+        uint16_t bytes_to_copy = btstack_min(btstack_min(chunk_len, len - pos), uart_rx_max_len);
+        memcpy(uart_rx_buffer, &data[pos], bytes_to_copy);
+        pos += bytes_to_copy;
+        (*uart_bytes_received)(bytes_to_copy);
+    }
+}
+
+// decode collected tx data into frames
+static int uart_get_sent_frames(frame_t * frames){
+    int num_frames = 0;
+    uint8_t  buffer[4 + MAX_FRAME_SIZE];
+    uint16_t len = 0;
+    int escape = 0;
+    uint16_t i;
+    for (i = 0; i < uart_tx_len; i++){
+        uint8_t byte = uart_tx_data[i];
+        if (byte == SLIP_SOF){
+            if (len >= 4){
+                CHECK(num_frames < MAX_FRAMES);
+                frame_t * frame = &frames[num_frames++];
+                frame->seq_nr      = buffer[0] & 0x07;
+                frame->ack_nr      = (buffer[0] >> 3) & 0x07;
+                frame->reliable    = (buffer[0] >> 7) & 0x01;
+                frame->type        = buffer[1] & 0x0f;
+                frame->payload_len = (buffer[1] >> 4) | (buffer[2] << 4);
+                memcpy(frame->payload, &buffer[4], len - 4);
+            }
+            len = 0;
+            continue;
+        }
+        if (escape){
+            escape = 0;
+            byte = (byte == SLIP_ESC_SOF) ? SLIP_SOF : SLIP_ESC;
+        } else if (byte == SLIP_ESC){
+            escape = 1;
+            continue;
+        }
+        CHECK(len < sizeof(buffer));
+        buffer[len++] = byte;
+    }
+    uart_tx_len = 0;
+    return num_frames;
+}
+
+static uint16_t slip_encode(uint8_t * buffer, const uint8_t * data, uint16_t len){
+    uint16_t pos = 0;
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        switch (data[i]){
+            case SLIP_SOF:
+                buffer[pos++] = SLIP_ESC;
+                buffer[pos++] = SLIP_ESC_SOF;
+                break;
+            case SLIP_ESC:
+                buffer[pos++] = SLIP_ESC;
+                buffer[pos++] = SLIP_ESC_ESC;
+                break;
+            default:
+                buffer[pos++] = data[i];
+                break;
+        }
+    }
+    return pos;
+}
+
+// build H5 frame without data integrity check
+static uint16_t build_frame(uint8_t * buffer, uint8_t seq_nr, uint8_t ack_nr, uint8_t reliable, uint8_t type, const uint8_t * payload, uint16_t payload_len){
+    uint8_t header[4];
+    header[0] = seq_nr | (ack_nr << 3) | (reliable << 7);
+    header[1] = type | ((payload_len & 0x0f) << 4);
+    header[2] = payload_len >> 4;
+    header[3] = 0xff - (header[0] + header[1] + header[2]);
+    uint16_t pos = 0;
+    buffer[pos++] = SLIP_SOF;
+    pos += slip_encode(&buffer[pos], header, sizeof(header));
+    pos += slip_encode(&buffer[pos], payload, payload_len);
+    buffer[pos++] = SLIP_SOF;
+    return pos;
+}
+
+static void receive_frame(uint8_t seq_nr, uint8_t ack_nr, uint8_t reliable, uint8_t type, const uint8_t * payload, uint16_t payload_len){
+    uint8_t buffer[2 * (4 + MAX_FRAME_SIZE) + 2];
+    uint16_t len = build_frame(buffer, seq_nr, ack_nr, reliable, type, payload, payload_len);
+    uart_receive_data(buffer, len, len);
+}
+
+static void receive_ack(uint8_t ack_nr){
+    receive_frame(0, ack_nr, 0, LINK_ACKNOWLEDGEMENT_TYPE, NULL, 0);
+}
+
+// HCI layer
+
+static const hci_transport_t * transport;
+static int packet_sent_events;
+static int received_packets;
+static uint8_t  received_packet_type;
+static uint8_t  received_packet[MAX_FRAME_SIZE];
+static uint16_t received_packet_len;
+
+static void packet_handler(uint8_t packet_type, uint8_t * packet, uint16_t size){
+    if ((packet_type == HCI_EVENT_PACKET) && (packet[0] == HCI_EVENT_TRANSPORT_PACKET_SENT)){
+        packet_sent_events++;
+        return;
+    }
+    received_packets++;
+    received_packet_type = packet_type;
+    received_packet_len  = size;
+    memcpy(received_packet, packet, size);
+}
+
+static void send_acl_packet(uint8_t marker){
+    uint8_t packet[] = { 0x01, 0x20, 0x02, 0x00, marker, marker};
+    CHECK_EQUAL(1, transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+    CHECK_EQUAL(0, transport->send_packet(HCI_ACL_DATA_PACKET, packet, sizeof(packet)));
+}
+
+static hci_transport_config_uart_t config = {
+    HCI_TRANSPORT_CONFIG_UART,
+    TEST_BAUDRATE,
+    0,
+    0,
+    NULL
+};
+
+// open transport and complete link establishment with sliding window size 4, no data integrity check
+static void h5_open_link(void){
+    test_time_ms = 0;
+    uart_tx_len = 0;
+    uart_tx_active = 0;
+    packet_sent_events = 0;
+    received_packets = 0;
+    received_packet_len = 0;
+    btstack_run_loop_base_init();
+    transport = hci_transport_h5_instance(&test_uart);
+    transport->init(&config);
+    transport->register_packet_handler(&packet_handler);
+    transport->open();
+
+    // sync
+    uart_complete_writes();
+    uint8_t sync_response[] = { 0x02, 0x7d };
+    receive_frame(0, 0, 0, LINK_CONTROL_PACKET_TYPE, sync_response, sizeof(sync_response));
+    uart_complete_writes();
+
+    // config
+    uint8_t config_response[] = { 0x04, 0x7b, 0x04 };
+    receive_frame(0, 0, 0, LINK_CONTROL_PACKET_TYPE, config_response, sizeof(config_response));
+    uart_complete_writes();
+    CHECK_EQUAL(1, packet_sent_events);
+    packet_sent_events = 0;
+    uart_tx_len = 0;
+}
+
+static void h5_close_link(void){
+    // drop queued packets for next test
+    transport->reset_link();
+    uart_complete_writes();
+    transport->close();
+}
+
+TEST_GROUP(H5SlidingWindow){
+    frame_t frames[MAX_FRAMES];
+
+    void setup(void){
+        h5_open_link();
+    }
+
+    void teardown(void){
+        h5_close_link();
+    }
+};
+
+TEST(H5SlidingWindow, WindowAllowsMultiplePackets){
+    send_acl_packet(0);
+    uart_complete_writes();
+    send_acl_packet(1);
+    uart_complete_writes();
+    send_acl_packet(2);
+    uart_complete_writes();
+    send_acl_packet(3);
+    uart_complete_writes();
+
+    // window full
+    CHECK_EQUAL(0, transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+    CHECK_EQUAL(3, packet_sent_events);
+
+    int num_frames = uart_get_sent_frames(frames);
+    CHECK_EQUAL(4, num_frames);
+    int i;
+    for (i = 0; i < 4; i++){
+        CHECK_EQUAL(1, frames[i].reliable);
+        CHECK_EQUAL(i, frames[i].seq_nr);
+        CHECK_EQUAL(HCI_ACL_DATA_PACKET, frames[i].type);
+        CHECK_EQUAL(i, frames[i].payload[4]);
+    }
+
+    // cumulative ack releases all slots, one packet sent event for the deferred one
+    receive_ack(4);
+    uart_complete_writes();
+    CHECK_EQUAL(4, packet_sent_events);
+    CHECK_EQUAL(1, transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+}
+
+TEST(H5SlidingWindow, CumulativeAckEmitsPacketSentOncePerPacket){
+    send_acl_packet(0);
+    uart_complete_writes();
+    send_acl_packet(1);
+    uart_complete_writes();
+    CHECK_EQUAL(2, packet_sent_events);
+
+    receive_ack(2);
+    uart_complete_writes();
+    CHECK_EQUAL(2, packet_sent_events);
+
+    send_acl_packet(2);
+    uart_complete_writes();
+    CHECK_EQUAL(3, packet_sent_events);
+    receive_ack(3);
+    uart_complete_writes();
+    CHECK_EQUAL(3, packet_sent_events);
+}
+
+TEST(H5SlidingWindow, AckInReliablePacket){
+    send_acl_packet(0);
+    uart_complete_writes();
+    uart_get_sent_frames(frames);
+
+    // incoming event acknowledges packet and gets acknowledged
+    uint8_t event[] = { HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 0x00 };
+    receive_frame(0, 1, 1, HCI_EVENT_PACKET, event, sizeof(event));
+    uart_complete_writes();
+    CHECK_EQUAL(HCI_EVENT_PACKET, received_packet_type);
+    CHECK_EQUAL(sizeof(event), received_packet_len);
+    CHECK_EQUAL(1, packet_sent_events);
+
+    int num_frames = uart_get_sent_frames(frames);
+    CHECK_EQUAL(1, num_frames);
+    CHECK_EQUAL(LINK_ACKNOWLEDGEMENT_TYPE, frames[0].type);
+    CHECK_EQUAL(1, frames[0].ack_nr);
+
+    // next packet uses seq nr 1 and acknowledges event
+    send_acl_packet(1);
+    uart_complete_writes();
+    num_frames = uart_get_sent_frames(frames);
+    CHECK_EQUAL(1, num_frames);
+    CHECK_EQUAL(1, frames[0].seq_nr);
+    CHECK_EQUAL(1, frames[0].ack_nr);
+}
+
+TEST(H5SlidingWindow, TimeoutResendsUnacknowledgedPackets){
+    send_acl_packet(0);
+    uart_complete_writes();
+    send_acl_packet(1);
+    uart_complete_writes();
+    send_acl_packet(2);
+    uart_complete_writes();
+    uart_get_sent_frames(frames);
+
+    // first packet acknowledged
+    receive_ack(1);
+    uart_complete_writes();
+    CHECK_EQUAL(0, uart_get_sent_frames(frames));
+
+    // resend starts with oldest unacknowledged packet
+    test_run_loop_advance_time(1000);
+    uart_complete_writes();
+    int num_frames = uart_get_sent_frames(frames);
+    CHECK_EQUAL(2, num_frames);
+    CHECK_EQUAL(1, frames[0].seq_nr);
+    CHECK_EQUAL(1, frames[0].payload[4]);
+    CHECK_EQUAL(2, frames[1].seq_nr);
+    CHECK_EQUAL(2, frames[1].payload[4]);
+    CHECK_EQUAL(3, packet_sent_events);
+
+    // acknowledge all, no further resend
+    receive_ack(3);
+    uart_complete_writes();
+    test_run_loop_advance_time(1000);
+    uart_complete_writes();
+    CHECK_EQUAL(0, uart_get_sent_frames(frames));
+    CHECK_EQUAL(3, packet_sent_events);
+    CHECK_EQUAL(1, transport->can_send_packet_now(HCI_ACL_DATA_PACKET));
+}
+
+TEST(H5SlidingWindow, AckOutsideOfWindowIgnored){
+    send_acl_packet(0);
+    uart_complete_writes();
+    receive_ack(5);
+    uart_complete_writes();
+    CHECK_EQUAL(1, packet_sent_events);
+
+    // packet still gets resent
+    uart_get_sent_frames(frames);
+    test_run_loop_advance_time(1000);
+    uart_complete_writes();
+    int num_frames = uart_get_sent_frames(frames);
+    CHECK_EQUAL(1, num_frames);
+    CHECK_EQUAL(0, frames[0].seq_nr);
+}
+
+TEST_GROUP(H5Receive){
+    uint8_t seq_nr;
+
+    void setup(void){
+        h5_open_link();
+        seq_nr = 0;
+    }
+
+    void teardown(void){
+        h5_close_link();
+    }
+
+    // build reliable HCI Event frame with SOF and ESC in payload
+    uint16_t build_event_frame(uint8_t * buffer, uint8_t marker){
+        const uint8_t event[] = { 0x0e, 0x04, SLIP_SOF, SLIP_ESC, marker, SLIP_SOF };
+        return build_frame(buffer, seq_nr++ & 0x07, 0, 1, HCI_EVENT_PACKET, event, sizeof(event));
+    }
+
+    void check_event(uint8_t marker){
+        const uint8_t event[] = { 0x0e, 0x04, SLIP_SOF, SLIP_ESC, marker, SLIP_SOF };
+        CHECK_EQUAL(HCI_EVENT_PACKET, received_packet_type);
+        CHECK_EQUAL(sizeof(event), received_packet_len);
+        MEMCMP_EQUAL(event, received_packet, sizeof(event));
+    }
+};
+
+TEST(H5Receive, FrameSplitAtEveryPosition){
+    uint8_t buffer[2 * (4 + MAX_FRAME_SIZE) + 2];
+    uint16_t len = build_event_frame(buffer, 0);
+    seq_nr = 0;
+    uint16_t split;
+    for (split = 1; split < len; split++){
+        build_event_frame(buffer, (uint8_t) split);
+        received_packets = 0;
+        uart_receive_data(buffer, split, split);
+        CHECK_EQUAL(0, received_packets);
+        uart_receive_data(&buffer[split], len - split, len - split);
+        uart_complete_writes();
+        CHECK_EQUAL(1, received_packets);
+        check_event((uint8_t) split);
+    }
+}
+
+TEST(H5Receive, EscapeAtEndOfChunk){
+    uint8_t buffer[2 * (4 + MAX_FRAME_SIZE) + 2];
+    uint16_t len = build_event_frame(buffer, 0x11);
+    // split after each escape byte
+    uint16_t pos = 0;
+    uint16_t i;
+    for (i = 1; i < len; i++){
+        if (buffer[i - 1] != SLIP_ESC) continue;
+        uart_receive_data(&buffer[pos], i - pos, i - pos);
+        pos = i;
+    }
+    CHECK(pos > 0);
+    CHECK_EQUAL(0, received_packets);
+    uart_receive_data(&buffer[pos], len - pos, len - pos);
+    uart_complete_writes();
+    CHECK_EQUAL(1, received_packets);
+    check_event(0x11);
+}
+
+TEST(H5Receive, SingleByteChunks){
+    uint8_t buffer[2 * (4 + MAX_FRAME_SIZE) + 2];
+    uint16_t len = build_event_frame(buffer, 0x22);
+    uart_receive_data(buffer, len, 1);
+    uart_complete_writes();
+    CHECK_EQUAL(1, received_packets);
+    check_event(0x22);
+}
+
+TEST(H5Receive, SeveralFramesInOneChunk){
+    uint8_t buffer[4 * (2 * (4 + MAX_FRAME_SIZE) + 2)];
+    uint16_t len = 0;
+    // noise before first SOF is skipped
+    buffer[len++] = 0x55;
+    buffer[len++] = SLIP_ESC;
+    uint8_t i;
+    for (i = 0; i < 3; i++){
+        len += build_event_frame(&buffer[len], i);
+    }
+    uart_receive_data(buffer, len, len);
+    uart_complete_writes();
+    CHECK_EQUAL(3, received_packets);
+    check_event(2);
+}
+
+TEST(H5Receive, FramesSplitAcrossChunks){
+    uint8_t buffer[4 * (2 * (4 + MAX_FRAME_SIZE) + 2)];
+    uint16_t len = 0;
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        len += build_event_frame(&buffer[len], i);
+    }
+    // chunks contain end of one frame and start of next
+    uart_receive_data(buffer, len, 7);
+    uart_complete_writes();
+    CHECK_EQUAL(4, received_packets);
+    check_event(3);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(&test_run_loop);
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
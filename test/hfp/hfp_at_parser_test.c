@@ -48,6 +48,7 @@
 #include "classic/hfp_ag.h"
 
 void hfp_parse(hfp_connection_t * context, uint8_t byte, int isHandsFree);
+uint16_t hfp_parse_line(hfp_connection_t * context, const uint8_t * data, uint16_t len, int isHandsFree);
 
 static  hfp_connection_t context;
 static int hfp_ag_indicators_nr = 7;
@@ -78,6 +79,17 @@ static void parse_hf(const char * packet){
     }
 }
 
+static void parse_hf_lines(const char * packet, uint16_t chunk_size){
+    uint16_t len = strlen(packet);
+    uint16_t pos = 0;
+    while (pos < len){
+        uint16_t chunk_end = btstack_min(pos + chunk_size, len);
+        while (pos < chunk_end){
+            pos += hfp_parse_line(&context, (const uint8_t *) &packet[pos], chunk_end - pos, 1);
+        }
+    }
+}
+
 TEST_GROUP(HFPParser){
     char packet[200];
     int pos;
@@ -106,6 +118,13 @@ TEST(HFPParser, HFP_HF_SUPPORTED_FEATURES){
     CHECK_EQUAL(1007, context.remote_supported_features);
 }
 
+TEST(HFPParser, HFP_HF_SUPPORTED_FEATURES_LINES){
+    sprintf(packet, "\r\n%s:1007\r\n\r\nOK\r\n", HFP_SUPPORTED_FEATURES);
+    parse_hf_lines(packet, sizeof(packet));
+    CHECK_EQUAL(HFP_CMD_OK, context.command);
+    CHECK_EQUAL(1007, context.remote_supported_features);
+}
+
 TEST(HFPParser, HFP_CMD_INDICATORS_QUERY){
     sprintf(packet, "\r\nAT%s?\r\n", HFP_INDICATOR);
     parse_ag(packet);
@@ -138,6 +157,27 @@ TEST(HFPParser, HFP_HF_INDICATORS){
     }   
 }
 
+TEST(HFPParser, HFP_HF_INDICATORS_LINES){
+    offset = 0;
+    offset += snprintf(packet, sizeof(packet), "%s:", HFP_INDICATOR);
+    for (pos = 0; pos < hfp_ag_indicators_nr - 1; pos++){
+        offset += snprintf(packet+offset, sizeof(packet)-offset, "(\"%s\", (%d, %d)),", hfp_ag_indicators[pos].name, hfp_ag_indicators[pos].min_range, hfp_ag_indicators[pos].max_range);
+    }
+    offset += snprintf(packet+offset, sizeof(packet)-offset, "(\"%s\", (%d, %d))\r\n\r\nOK\r\n", hfp_ag_indicators[pos].name, hfp_ag_indicators[pos].min_range, hfp_ag_indicators[pos].max_range);
+    context.state = HFP_W4_RETRIEVE_INDICATORS;
+
+    // data split at arbitrary positions, e.g. within quoted strings
+    parse_hf_lines(packet, 7);
+    CHECK_EQUAL(HFP_CMD_OK, context.command);
+    CHECK_EQUAL(hfp_ag_indicators_nr, context.ag_indicators_nr);
+    for (pos = 0; pos < hfp_ag_indicators_nr; pos++){
+        CHECK_EQUAL(hfp_ag_indicators[pos].index, context.ag_indicators[pos].index);
+        STRCMP_EQUAL(hfp_ag_indicators[pos].name, context.ag_indicators[pos].name);
+        CHECK_EQUAL(hfp_ag_indicators[pos].min_range, context.ag_indicators[pos].min_range);
+        CHECK_EQUAL(hfp_ag_indicators[pos].max_range, context.ag_indicators[pos].max_range);
+    }
+}
+
 TEST(HFPParser, HFP_HF_INDICATOR_STATUS){
     // send status
     offset = 0;
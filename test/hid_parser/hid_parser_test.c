@@ -343,6 +343,87 @@ TEST(HID, GetReportSize){
     CHECK_EQUAL(8, report_size);
 }
 
+static btstack_hid_field_t layout_fields[64];
+
+static void expect_layout_matches_parser(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, const uint8_t * hid_report, uint16_t hid_report_len){
+    static btstack_hid_descriptor_layout_t layout;
+    static btstack_hid_parser_t hid_parser;
+    static btstack_hid_parser_t layout_parser;
+    CHECK_EQUAL(1, btstack_hid_descriptor_layout_compile(&layout, hid_descriptor, hid_descriptor_len, layout_fields, sizeof(layout_fields) / sizeof(btstack_hid_field_t)));
+    btstack_hid_parser_init(&hid_parser, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, hid_report, hid_report_len);
+    btstack_hid_parser_init_with_layout(&layout_parser, &layout, HID_REPORT_TYPE_INPUT, hid_report, hid_report_len);
+    while (btstack_hid_parser_has_more(&hid_parser)){
+        uint16_t usage_page;
+        uint16_t usage;
+        int32_t value;
+        btstack_hid_parser_get_field(&hid_parser, &usage_page, &usage, &value);
+        expect_field(&layout_parser, usage_page, usage, value);
+    }
+    CHECK_EQUAL(0, btstack_hid_parser_has_more(&layout_parser));
+    CHECK_EQUAL(hid_parser.report_pos_in_bit, layout_parser.report_pos_in_bit);
+}
+
+TEST(HID, LayoutMatchesParser){
+    expect_layout_matches_parser(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), mouse_report_without_id_positive_xy, sizeof(mouse_report_without_id_positive_xy));
+    expect_layout_matches_parser(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), mouse_report_without_id_negative_xy, sizeof(mouse_report_without_id_negative_xy));
+    expect_layout_matches_parser(mouse_descriptor_with_report_id, sizeof(mouse_descriptor_with_report_id), mouse_report_with_id_1, sizeof(mouse_report_with_id_1));
+    expect_layout_matches_parser(hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), keyboard_report1, sizeof(keyboard_report1));
+    expect_layout_matches_parser(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), combo_report1, sizeof(combo_report1));
+    expect_layout_matches_parser(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), combo_report2, sizeof(combo_report2));
+}
+
+TEST(HID, LayoutExtract){
+    static btstack_hid_descriptor_layout_t layout;
+    int32_t values[16];
+    CHECK_EQUAL(1, btstack_hid_descriptor_layout_compile(&layout, mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), layout_fields, sizeof(layout_fields) / sizeof(btstack_hid_field_t)));
+    const btstack_hid_report_layout_t * report_layout = btstack_hid_descriptor_layout_get_report(&layout, 0, HID_REPORT_TYPE_INPUT);
+    CHECK(report_layout != NULL);
+    CHECK_EQUAL(5, btstack_hid_descriptor_layout_extract(&layout, report_layout, mouse_report_without_id_negative_xy, sizeof(mouse_report_without_id_negative_xy), values, 16));
+    CHECK_EQUAL(1, values[0]);
+    CHECK_EQUAL(1, values[1]);
+    CHECK_EQUAL(0, values[2]);
+    CHECK_EQUAL(-2, values[3]);
+    CHECK_EQUAL(-3, values[4]);
+    // short report reads missing bits as zero
+    CHECK_EQUAL(5, btstack_hid_descriptor_layout_extract(&layout, report_layout, mouse_report_without_id_negative_xy, 2, values, 16));
+    CHECK_EQUAL(-2, values[3]);
+    CHECK_EQUAL(0, values[4]);
+    CHECK_EQUAL(2, btstack_hid_descriptor_layout_extract(&layout, report_layout, mouse_report_without_id_negative_xy, sizeof(mouse_report_without_id_negative_xy), values, 2));
+
+    // fields don't fit
+    CHECK_EQUAL(0, btstack_hid_descriptor_layout_compile(&layout, hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), layout_fields, 4));
+}
+
+TEST(HID, LayoutTooManyFields){
+    static btstack_hid_descriptor_layout_t layout;
+    static btstack_hid_field_t fields[300];
+    // Usage Page, Usage, Report Size 1, Report Count 255, followed by 258 Input items: more than 65535 fields
+    static uint8_t hid_descriptor[8 + 258 * 2] = { 0x05, 0x01, 0x09, 0x01, 0x75, 0x01, 0x95, 0xff };
+    uint16_t pos;
+    for (pos = 8; pos < sizeof(hid_descriptor); pos += 2){
+        hid_descriptor[pos]   = 0x81;
+        hid_descriptor[pos+1] = 0x02;
+    }
+    CHECK_EQUAL(0, btstack_hid_descriptor_layout_compile(&layout, hid_descriptor, sizeof(hid_descriptor), fields, sizeof(fields) / sizeof(btstack_hid_field_t)));
+    // single item fits
+    CHECK_EQUAL(1, btstack_hid_descriptor_layout_compile(&layout, hid_descriptor, 10, fields, sizeof(fields) / sizeof(btstack_hid_field_t)));
+    CHECK_EQUAL(255, layout.num_fields);
+}
+
+TEST(HID, LayoutGetReportSize){
+    static btstack_hid_descriptor_layout_t layout;
+    CHECK_EQUAL(1, btstack_hid_descriptor_layout_compile(&layout, combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), layout_fields, sizeof(layout_fields) / sizeof(btstack_hid_field_t)));
+    CHECK_EQUAL(3, btstack_hid_descriptor_layout_get_report_size(&layout, 1, HID_REPORT_TYPE_INPUT));
+    CHECK_EQUAL(HID_REPORT_ID_VALID,   btstack_hid_descriptor_layout_id_valid(&layout, 1));
+    CHECK_EQUAL(HID_REPORT_ID_VALID,   btstack_hid_descriptor_layout_id_valid(&layout, 2));
+    CHECK_EQUAL(HID_REPORT_ID_INVALID, btstack_hid_descriptor_layout_id_valid(&layout, 5));
+
+    CHECK_EQUAL(1, btstack_hid_descriptor_layout_compile(&layout, hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), layout_fields, sizeof(layout_fields) / sizeof(btstack_hid_field_t)));
+    CHECK_EQUAL(1, btstack_hid_descriptor_layout_get_report_size(&layout, 0, HID_REPORT_TYPE_OUTPUT));
+    CHECK_EQUAL(8, btstack_hid_descriptor_layout_get_report_size(&layout, 0, HID_REPORT_TYPE_INPUT));
+    CHECK_EQUAL(0, btstack_hid_descriptor_layout_get_report_size(&layout, 0, HID_REPORT_TYPE_FEATURE));
+    CHECK_EQUAL(HID_REPORT_ID_UNDECLARED, btstack_hid_descriptor_layout_id_valid(&layout, 0));
+}
 
 int main (int argc, const char * argv[]){
     // hci_dump_open("hci_dump.pklg", HCI_DUMP_PACKETLOGGER);
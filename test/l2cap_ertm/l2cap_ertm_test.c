@@ -0,0 +1,365 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "btstack_event.h"
+#include "bluetooth.h"
+#include "hci.h"
+#include "hci_dump.h"
+#include "hci_transport.h"
+#include "l2cap.h"
+
+// open Classic ACL connection from hci_setup_test_connections_fuzz
+#define TEST_CON_HANDLE        0x0003
+#define TEST_PSM               0x1001
+#define TEST_REMOTE_CID        0x0041
+#define TEST_ACL_PACKET_LEN    HCI_ACL_PAYLOAD_SIZE
+
+// from l2cap.c
+#define CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL 0x04
+#define CONFIG_OPTION_TYPE_FRAME_CHECK_SEQUENCE            0x05
+#define SUPERVISORY_FUNCTION_RR                            0x00
+#define SUPERVISORY_FUNCTION_SREJ                          0x03
+
+#define MAX_OUTGOING_PACKETS   32
+#define MAX_SDUS               4
+
+typedef struct {
+    uint16_t size;
+    uint8_t  buffer[4 + TEST_ACL_PACKET_LEN];
+} acl_packet_t;
+
+typedef struct {
+    uint16_t size;
+    uint8_t  buffer[600];
+} sdu_t;
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static acl_packet_t outgoing_packets[MAX_OUTGOING_PACKETS];
+static int outgoing_packets_num;
+static int outgoing_packets_completed;
+
+static sdu_t received_sdus[MAX_SDUS];
+static int received_sdus_num;
+
+static uint16_t local_cid;
+static int      channel_opened;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static l2cap_ertm_config_t ertm_config = {
+    0,          // ertm mandatory
+    2,          // max transmit
+    2000,
+    12000,
+    500,        // l2cap ertm mtu
+    1,          // num tx buffers
+    2,          // num rx buffers -> tx window of remote
+    0,          // no FCS
+};
+static uint8_t ertm_buffer[1000];
+
+static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+
+static int hci_transport_test_can_send_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return 1;
+}
+
+static int hci_transport_test_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    if (packet_type == HCI_ACL_DATA_PACKET){
+        CHECK_TRUE(outgoing_packets_num < MAX_OUTGOING_PACKETS);
+        acl_packet_t * acl_packet = &outgoing_packets[outgoing_packets_num++];
+        memcpy(acl_packet->buffer, packet, size);
+        acl_packet->size = size;
+    }
+    packet_handler(HCI_EVENT_PACKET, (uint8_t *) &packet_sent_event[0], sizeof(packet_sent_event));
+    return 0;
+}
+
+static void hci_transport_test_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int hci_transport_test_open(void){
+    return 0;
+}
+
+static int hci_transport_test_close(void){
+    return 0;
+}
+
+static void hci_transport_test_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static const hci_transport_t hci_transport_test = {
+        /* const char * name; */                                        "TEST",
+        /* void   (*init) (const void *transport_config); */            &hci_transport_test_init,
+        /* int    (*open)(void); */                                     &hci_transport_test_open,
+        /* int    (*close)(void); */                                    &hci_transport_test_close,
+        /* void   (*register_packet_handler)(void (*handler)(...); */   &hci_transport_test_register_packet_handler,
+        /* int    (*can_send_packet_now)(uint8_t packet_type); */       &hci_transport_test_can_send_now,
+        /* int    (*send_packet)(...); */                               &hci_transport_test_send_packet,
+        /* int    (*set_baudrate)(uint32_t baudrate); */                NULL,
+        /* void   (*reset_link)(void); */                               NULL,
+        /* void   (*set_sco_config)(uint16_t voice_setting, int num_connections); */ NULL,
+        /* int    (*send_packet_vectored)(...); */                      NULL,
+};
+
+static void service_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            CHECK_TRUE(received_sdus_num < MAX_SDUS);
+            CHECK_TRUE(size <= sizeof(received_sdus[0].buffer));
+            memcpy(received_sdus[received_sdus_num].buffer, packet, size);
+            received_sdus[received_sdus_num].size = size;
+            received_sdus_num++;
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_INCOMING_CONNECTION:
+                    l2cap_accept_ertm_connection(l2cap_event_incoming_connection_get_local_cid(packet), &ertm_config, ertm_buffer, sizeof(ertm_buffer));
+                    break;
+                case L2CAP_EVENT_CHANNEL_OPENED:
+                    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_event_channel_opened_get_status(packet));
+                    local_cid = l2cap_event_channel_opened_get_local_cid(packet);
+                    channel_opened = 1;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(packet);
+    UNUSED(size);
+}
+
+// free controller buffers of all ACL packets sent so far
+static void simulate_number_of_completed_packets(void){
+    uint16_t num_packets = outgoing_packets_num - outgoing_packets_completed;
+    if (num_packets == 0) return;
+    outgoing_packets_completed = outgoing_packets_num;
+    uint8_t event[] = { HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS, 5, 1, 0, 0, 0, 0};
+    little_endian_store_16(event, 3, TEST_CON_HANDLE);
+    little_endian_store_16(event, 5, num_packets);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void simulate_disconnection_complete(void){
+    uint8_t event[] = { HCI_EVENT_DISCONNECTION_COMPLETE, 4, 0, 0, 0, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION};
+    little_endian_store_16(event, 3, TEST_CON_HANDLE);
+    packet_handler(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void simulate_l2cap_packet(uint16_t cid, const uint8_t * data, uint16_t len){
+    uint8_t packet[4 + 4 + TEST_ACL_PACKET_LEN];
+    little_endian_store_16(packet, 0, TEST_CON_HANDLE | 0x2000);
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    memcpy(&packet[8], data, len);
+    packet_handler(HCI_ACL_DATA_PACKET, packet, 8 + len);
+    simulate_number_of_completed_packets();
+}
+
+static void simulate_signaling_command(uint8_t code, uint8_t sig_id, const uint8_t * data, uint16_t len){
+    uint8_t command[32];
+    command[0] = code;
+    command[1] = sig_id;
+    little_endian_store_16(command, 2, len);
+    memcpy(&command[4], data, len);
+    simulate_l2cap_packet(L2CAP_CID_SIGNALING, command, 4 + len);
+}
+
+// @returns signaling command sent last with given code or NULL
+static const uint8_t * find_signaling_command(uint8_t code){
+    int i;
+    for (i = outgoing_packets_num - 1; i >= 0; i--){
+        const uint8_t * packet = outgoing_packets[i].buffer;
+        if (little_endian_read_16(packet, 6) != L2CAP_CID_SIGNALING) continue;
+        if (packet[8] != code) continue;
+        return &packet[8];
+    }
+    return NULL;
+}
+
+static uint8_t test_payload_byte(uint8_t tx_seq, uint16_t pos){
+    return (uint8_t) ((tx_seq << 5) + pos);
+}
+
+// I-Frame without FCS: control, [SDU Length], payload
+static void simulate_i_frame(uint8_t tx_seq, l2cap_segmentation_and_reassembly_t sar, uint16_t sdu_length, uint16_t payload_len){
+    uint8_t frame[2 + 2 + 600];
+    uint16_t pos = 0;
+    little_endian_store_16(frame, pos, (uint16_t) ((sar << 14) | (tx_seq << 1)));
+    pos += 2;
+    if (sar == L2CAP_SEGMENTATION_AND_REASSEMBLY_START_OF_L2CAP_SDU){
+        little_endian_store_16(frame, pos, sdu_length);
+        pos += 2;
+    }
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        frame[pos++] = test_payload_byte(tx_seq, i);
+    }
+    simulate_l2cap_packet(local_cid, frame, pos);
+}
+
+// @returns number of S-Frames with given supervisory function and req seq sent to remote
+static int count_s_frames(uint8_t s, uint8_t req_seq){
+    int count = 0;
+    int i;
+    for (i = 0; i < outgoing_packets_num; i++){
+        const uint8_t * packet = outgoing_packets[i].buffer;
+        if (little_endian_read_16(packet, 6) != TEST_REMOTE_CID) continue;
+        uint16_t control = little_endian_read_16(packet, 8);
+        if ((control & 1) == 0) continue;
+        if (((control >> 2) & 0x03) != s) continue;
+        if (((control >> 8) & 0x3f) != req_seq) continue;
+        count++;
+    }
+    return count;
+}
+
+static void check_sdu(int index, uint8_t first_tx_seq, uint16_t first_len, uint8_t second_tx_seq, uint16_t second_len){
+    CHECK_TRUE(index < received_sdus_num);
+    const sdu_t * sdu = &received_sdus[index];
+    CHECK_EQUAL(first_len + second_len, sdu->size);
+    uint16_t i;
+    for (i = 0; i < first_len; i++){
+        CHECK_EQUAL(test_payload_byte(first_tx_seq, i), sdu->buffer[i]);
+    }
+    for (i = 0; i < second_len; i++){
+        CHECK_EQUAL(test_payload_byte(second_tx_seq, i), sdu->buffer[first_len + i]);
+    }
+}
+
+TEST_GROUP(L2CAP_ERTM){
+    uint16_t local_mps;
+
+    void setup(void){
+        outgoing_packets_num = 0;
+        outgoing_packets_completed = 0;
+        received_sdus_num = 0;
+        channel_opened = 0;
+        local_cid = 0;
+
+        btstack_memory_init();
+        hci_init(&hci_transport_test, NULL);
+        hci_event_callback_registration.callback = &hci_event_handler;
+        hci_add_event_handler(&hci_event_callback_registration);
+        l2cap_init();
+        l2cap_register_service(&service_packet_handler, TEST_PSM, 500, LEVEL_0);
+        hci_simulate_working_fuzz();
+        hci_setup_test_connections_fuzz();
+
+        // remote connects, ask for extended features
+        uint8_t connection_request[4];
+        little_endian_store_16(connection_request, 0, TEST_PSM);
+        little_endian_store_16(connection_request, 2, TEST_REMOTE_CID);
+        simulate_signaling_command(CONNECTION_REQUEST, 1, connection_request, sizeof(connection_request));
+        const uint8_t * information_request = find_signaling_command(INFORMATION_REQUEST);
+        CHECK_TRUE(information_request != NULL);
+        const uint8_t information_response[] = { 0x02, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00};
+        simulate_signaling_command(INFORMATION_RESPONSE, information_request[1], information_response, sizeof(information_response));
+
+        // ERTM connection accepted in service packet handler, get local CID from connection response and MPS from config request
+        const uint8_t * connection_response = find_signaling_command(CONNECTION_RESPONSE);
+        CHECK_TRUE(connection_response != NULL);
+        uint16_t destination_cid = little_endian_read_16(connection_response, 4);
+        const uint8_t * configure_request = find_signaling_command(CONFIGURE_REQUEST);
+        CHECK_TRUE(configure_request != NULL);
+        CHECK_EQUAL(CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL, configure_request[8]);
+        local_mps = little_endian_read_16(configure_request, 8 + 2 + 7);
+
+        uint8_t configure_response[6];
+        little_endian_store_16(configure_response, 0, destination_cid);
+        little_endian_store_16(configure_response, 2, 0);
+        little_endian_store_16(configure_response, 4, 0);
+        simulate_signaling_command(CONFIGURE_RESPONSE, configure_request[1], configure_response, sizeof(configure_response));
+
+        // remote requests ERTM without FCS
+        uint8_t remote_configure_request[4 + 11 + 3] = {
+            0, 0, 0, 0,
+            CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL, 9, L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION, 2, 2, 0xd0, 0x07, 0xe0, 0x2e, 0, 0,
+            CONFIG_OPTION_TYPE_FRAME_CHECK_SEQUENCE, 1, 0
+        };
+        little_endian_store_16(remote_configure_request, 0, destination_cid);
+        little_endian_store_16(remote_configure_request, 13, 500);
+        simulate_signaling_command(CONFIGURE_REQUEST, 2, remote_configure_request, sizeof(remote_configure_request));
+        CHECK_TRUE(channel_opened);
+    }
+
+    void teardown(void){
+        simulate_disconnection_complete();
+        hci_free_connections_fuzz();
+        l2cap_unregister_service(TEST_PSM);
+    }
+};
+
+TEST(L2CAP_ERTM, InSequenceFrames){
+    simulate_i_frame(0, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 20);
+    simulate_i_frame(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 30);
+    CHECK_EQUAL(2, received_sdus_num);
+    check_sdu(0, 0, 20, 0, 0);
+    check_sdu(1, 1, 30, 0, 0);
+    CHECK_EQUAL(0, count_s_frames(SUPERVISORY_FUNCTION_SREJ, 0));
+}
+
+TEST(L2CAP_ERTM, SelectiveRejectRecoversLostFrame){
+    simulate_i_frame(0, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 20);
+    CHECK_EQUAL(1, received_sdus_num);
+
+    // frame 1 lost, frame 2 stored and frame 1 requested
+    simulate_i_frame(2, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 40);
+    CHECK_EQUAL(1, received_sdus_num);
+    CHECK_TRUE(count_s_frames(SUPERVISORY_FUNCTION_SREJ, 1) > 0);
+
+    // retransmission delivers frame 1 and stored frame 2 in order
+    simulate_i_frame(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 30);
+    CHECK_EQUAL(3, received_sdus_num);
+    check_sdu(1, 1, 30, 0, 0);
+    check_sdu(2, 2, 40, 0, 0);
+    CHECK_TRUE(count_s_frames(SUPERVISORY_FUNCTION_RR, 3) > 0);
+}
+
+TEST(L2CAP_ERTM, OutOfOrderStartFrameWithFullPayload){
+    // start frame with SDU Length and local MPS bytes stored next to following end frame
+    simulate_i_frame(2, L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU, 0, 10);
+    simulate_i_frame(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_START_OF_L2CAP_SDU, local_mps + 10, local_mps);
+    CHECK_EQUAL(0, received_sdus_num);
+    CHECK_TRUE(count_s_frames(SUPERVISORY_FUNCTION_SREJ, 0) > 0);
+
+    simulate_i_frame(0, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 20);
+    CHECK_EQUAL(2, received_sdus_num);
+    check_sdu(0, 0, 20, 0, 0);
+    check_sdu(1, 1, local_mps, 2, 10);
+    CHECK_TRUE(count_s_frames(SUPERVISORY_FUNCTION_RR, 3) > 0);
+}
+
+TEST(L2CAP_ERTM, OversizedFrameDropped){
+    simulate_i_frame(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU, 0, local_mps + 1);
+    simulate_i_frame(0, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, 0, 20);
+    CHECK_EQUAL(1, received_sdus_num);
+    check_sdu(0, 0, 20, 0, 0);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -44,6 +44,10 @@
 // allow for one NetKey update
 #define MAX_NR_MESH_NETWORK_KEYS      (MAX_NR_MESH_SUBNETS+1)
 
+// network message cache
+#define MESH_NETWORK_CACHE_SIZE       64
+#define MESH_NETWORK_CACHE_TIMEOUT_MS 10000
+
 #define NVM_NUM_LINK_KEYS 2
 
 #endif
@@ -588,6 +588,53 @@ TEST(MessageTest, Message4Send){
     test_send_control_message(netkey_index, ttl, src, dest, message4_upper_transport_pdu, 1, message4_lower_transport_pdus, message4_network_pdus);
 }
 
+static mesh_network_pdu_t * received_network_pdus[2];
+static int received_network_pdus_count;
+
+static void test_receive_order_callback_handler(mesh_network_callback_type_t callback_type, mesh_network_pdu_t * network_pdu){
+    if (callback_type != MESH_NETWORK_PDU_RECEIVED) return;
+    CHECK(received_network_pdus_count < 2);
+    received_network_pdus[received_network_pdus_count++] = network_pdu;
+}
+
+static void test_check_received_network_pdu(mesh_network_pdu_t * network_pdu, char * lower_transport_pdu_hex){
+    transport_pdu_len = strlen(lower_transport_pdu_hex) / 2;
+    btstack_parse_hex(lower_transport_pdu_hex, transport_pdu_len, transport_pdu_data);
+    CHECK_EQUAL(transport_pdu_len, mesh_network_pdu_len(network_pdu));
+    CHECK_EQUAL_ARRAY(transport_pdu_data, mesh_network_pdu_data(network_pdu), transport_pdu_len);
+    mesh_network_pdu_free(network_pdu);
+}
+
+TEST(MessageTest, ReceiveOrderWithNetMicMismatch){
+    // other network key with NID 0x68 is tried first for message 1
+    mesh_network_key_t * network_key = btstack_memory_mesh_network_key_get();
+    network_key->nid = 0x68;
+    network_key->netkey_index = 1;
+    btstack_parse_hex("00112233445566778899aabbccddeeff", 16, network_key->encryption_key);
+    btstack_parse_hex("ffeeddccbbaa99887766554433221100", 16, network_key->privacy_key);
+    mesh_network_key_add(network_key);
+    load_network_key_nid_68();
+    load_network_key_nid_5e();
+    mesh_set_iv_index(0x12345678);
+
+    mesh_network_set_higher_layer_handler(&test_receive_order_callback_handler);
+    received_network_pdus_count = 0;
+
+    // message 4 must not overtake message 1
+    test_network_pdu_len = strlen(message1_network_pdus[0]) / 2;
+    btstack_parse_hex(message1_network_pdus[0], test_network_pdu_len, test_network_pdu_data);
+    mesh_network_received_message(test_network_pdu_data, test_network_pdu_len, 0);
+    test_network_pdu_len = strlen(message4_network_pdus[0]) / 2;
+    btstack_parse_hex(message4_network_pdus[0], test_network_pdu_len, test_network_pdu_data);
+    mesh_network_received_message(test_network_pdu_data, test_network_pdu_len, 0);
+
+    while (received_network_pdus_count < 2){
+        mock_process_hci_cmd();
+    }
+    test_check_received_network_pdu(received_network_pdus[0], message1_lower_transport_pdus[0]);
+    test_check_received_network_pdu(received_network_pdus[1], message4_lower_transport_pdus[0]);
+}
+
 // Message 5
 char * message5_network_pdus[] = {
     (char *) "5eafd6f53c43db5c39da1792b1fee9ec74b786c56d3a9dee",
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2020 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_config.h"
+#include "mesh/mesh_network_cache.h"
+
+#define NUM_NODES   300
+#define NUM_RELAYS    4
+
+static uint32_t mock_time_ms;
+
+extern "C" uint32_t btstack_run_loop_get_time_ms(void){
+    return mock_time_ms;
+}
+
+// simple linear congruential generator for reproducible test runs
+static uint32_t random_state;
+static uint32_t random_next(void){
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+// reference model: last MESH_NETWORK_CACHE_SIZE messages in insertion order
+typedef struct {
+    uint16_t src;
+    uint32_t seq;
+    uint8_t  ivi;
+    uint32_t timestamp_ms;
+} reference_entry_t;
+
+static reference_entry_t reference_entries[MESH_NETWORK_CACHE_SIZE];
+static int reference_oldest;
+static int reference_num_entries;
+
+static int reference_lookup_and_add(uint16_t src, uint32_t seq, uint8_t ivi){
+    // expire
+    while (reference_num_entries > 0){
+        if ((mock_time_ms - reference_entries[reference_oldest].timestamp_ms) < MESH_NETWORK_CACHE_TIMEOUT_MS) break;
+        reference_oldest = (reference_oldest + 1) % MESH_NETWORK_CACHE_SIZE;
+        reference_num_entries--;
+    }
+    // lookup
+    int i;
+    for (i=0;i<reference_num_entries;i++){
+        reference_entry_t * entry = &reference_entries[(reference_oldest + i) % MESH_NETWORK_CACHE_SIZE];
+        if ((entry->src == src) && (entry->seq == seq) && (entry->ivi == ivi)) return 1;
+    }
+    // evict
+    if (reference_num_entries == MESH_NETWORK_CACHE_SIZE){
+        reference_oldest = (reference_oldest + 1) % MESH_NETWORK_CACHE_SIZE;
+        reference_num_entries--;
+    }
+    // add
+    reference_entry_t * entry = &reference_entries[(reference_oldest + reference_num_entries) % MESH_NETWORK_CACHE_SIZE];
+    entry->src = src;
+    entry->seq = seq;
+    entry->ivi = ivi;
+    entry->timestamp_ms = mock_time_ms;
+    reference_num_entries++;
+    return 0;
+}
+
+TEST_GROUP(NetworkCache){
+    void setup(void){
+        mock_time_ms = 0;
+        random_state = 0x12345678;
+        reference_oldest = 0;
+        reference_num_entries = 0;
+        mesh_network_cache_reset();
+    }
+};
+
+TEST(NetworkCache, Duplicate){
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, 0x000001, 0));
+    CHECK_EQUAL(1, mesh_network_cache_lookup_and_add(0x0001, 0x000001, 0));
+    // same SRC and SEQ with different IVI is a different message
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, 0x000001, 1));
+    // SEQ differs only in upper bits
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, 0x800001, 0));
+    CHECK_EQUAL(1, mesh_network_cache_get_hits());
+    CHECK_EQUAL(3, mesh_network_cache_get_misses());
+    CHECK_EQUAL(3, mesh_network_cache_get_num_entries());
+}
+
+TEST(NetworkCache, EvictOldest){
+    int i;
+    for (i=0;i<=MESH_NETWORK_CACHE_SIZE;i++){
+        CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, i, 0));
+    }
+    CHECK_EQUAL(MESH_NETWORK_CACHE_SIZE, mesh_network_cache_get_num_entries());
+    // second oldest still there, oldest got evicted
+    CHECK_EQUAL(1, mesh_network_cache_lookup_and_add(0x0001, 1, 0));
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, 0, 0));
+}
+
+TEST(NetworkCache, Timeout){
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, 1, 0));
+    mock_time_ms = MESH_NETWORK_CACHE_TIMEOUT_MS / 2;
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0002, 1, 0));
+    CHECK_EQUAL(1, mesh_network_cache_lookup_and_add(0x0001, 1, 0));
+    // first message expired
+    mock_time_ms = MESH_NETWORK_CACHE_TIMEOUT_MS;
+    CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(0x0001, 1, 0));
+    CHECK_EQUAL(1, mesh_network_cache_lookup_and_add(0x0002, 1, 0));
+    CHECK_EQUAL(2, mesh_network_cache_get_num_entries());
+}
+
+// every node originates messages, each message is received again from several relays shortly after
+TEST(NetworkCache, Flooding){
+    const int num_rounds = 10;
+    const int max_relay_delay = MESH_NETWORK_CACHE_SIZE / 2;
+    static uint32_t pending_src[NUM_NODES * NUM_RELAYS];
+    static uint32_t pending_seq[NUM_NODES * NUM_RELAYS];
+    static int      pending_due[NUM_NODES * NUM_RELAYS];
+    int num_pending = 0;
+    int num_originated = 0;
+    int round;
+    for (round=0;round<num_rounds;round++){
+        int node;
+        for (node=0;node<NUM_NODES;node++){
+            uint16_t src = (uint16_t) (node + 1);
+            uint32_t seq = (uint32_t) round;
+            // original message
+            CHECK_EQUAL(0, mesh_network_cache_lookup_and_add(src, seq, 0));
+            num_originated++;
+            mock_time_ms++;
+            // schedule relayed copies
+            int relay;
+            for (relay=0;relay<NUM_RELAYS;relay++){
+                pending_src[num_pending] = src;
+                pending_seq[num_pending] = seq;
+                pending_due[num_pending] = num_originated + (int) (random_next() % max_relay_delay);
+                num_pending++;
+            }
+            // deliver relayed copies that are due
+            int i = 0;
+            while (i < num_pending){
+                if (pending_due[i] > num_originated) {
+                    i++;
+                    continue;
+                }
+                CHECK_EQUAL(1, mesh_network_cache_lookup_and_add((uint16_t) pending_src[i], pending_seq[i], 0));
+                num_pending--;
+                pending_src[i] = pending_src[num_pending];
+                pending_seq[i] = pending_seq[num_pending];
+                pending_due[i] = pending_due[num_pending];
+            }
+        }
+    }
+    // deliver remaining copies
+    int i;
+    for (i=0;i<num_pending;i++){
+        CHECK_EQUAL(1, mesh_network_cache_lookup_and_add((uint16_t) pending_src[i], pending_seq[i], 0));
+    }
+    CHECK_EQUAL(NUM_NODES * num_rounds, mesh_network_cache_get_misses());
+    CHECK_EQUAL(NUM_NODES * num_rounds * NUM_RELAYS, mesh_network_cache_get_hits());
+    CHECK_EQUAL(MESH_NETWORK_CACHE_SIZE, mesh_network_cache_get_num_entries());
+}
+
+// random traffic with many collisions compared against linear search in insertion ordered list
+TEST(NetworkCache, ReferenceModel){
+    int i;
+    for (i=0;i<200000;i++){
+        uint16_t src = (uint16_t) (1 + (random_next() % NUM_NODES));
+        uint32_t seq = random_next() % 4;
+        uint8_t  ivi = (uint8_t) (random_next() & 1);
+        mock_time_ms += random_next() % 400;
+        int expected = reference_lookup_and_add(src, seq, ivi);
+        CHECK_EQUAL(expected, mesh_network_cache_lookup_and_add(src, seq, ivi));
+        CHECK_EQUAL(reference_num_entries, mesh_network_cache_get_num_entries());
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -146,6 +146,10 @@ int hci_send_cmd(const hci_cmd_t *cmd, ...){
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
     btstack_linked_list_add_tail(&event_packet_handlers, (btstack_linked_item_t*) callback_handler);
 }
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+    (void) event_codes;
+    hci_add_event_handler(callback_handler);
+}
 
 HCI_STATE hci_get_state(void){
 	return HCI_STATE_WORKING;
@@ -167,6 +171,9 @@ void btstack_run_loop_set_timer_context(btstack_timer_source_t * ts, void * cont
 void * btstack_run_loop_get_timer_context(btstack_timer_source_t * ts){
 	return timer_context;
 }
+uint32_t btstack_run_loop_get_time_ms(void){
+	return 0;
+}
 void hci_halting_defer(void){
 }
 
@@ -0,0 +1,183 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <stdlib.h>
+
+#include "btstack_run_loop_base.h"
+#include "btstack_util.h"
+
+#define NUM_TIMERS 40
+
+static btstack_timer_source_t timers[NUM_TIMERS];
+static btstack_timer_source_t * processed[NUM_TIMERS * 2];
+static int num_processed;
+
+static void timer_handler(btstack_timer_source_t * ts){
+    processed[num_processed++] = ts;
+}
+
+static void timer_handler_readd(btstack_timer_source_t * ts){
+    processed[num_processed++] = ts;
+    btstack_run_loop_base_add_timer(ts);
+}
+
+static void timer_handler_remove_next(btstack_timer_source_t * ts){
+    processed[num_processed++] = ts;
+    CHECK_TRUE(btstack_run_loop_base_remove_timer((btstack_timer_source_t *) ts->context));
+}
+
+static void setup_timer(btstack_timer_source_t * ts, uint32_t timeout){
+    ts->timeout = timeout;
+    ts->process = &timer_handler;
+    ts->context = NULL;
+}
+
+TEST_GROUP(RunLoopBase){
+    void setup(void){
+        btstack_run_loop_base_init();
+        memset(timers, 0, sizeof(timers));
+        memset(processed, 0, sizeof(processed));
+        num_processed = 0;
+    }
+};
+
+TEST(RunLoopBase, NoTimers){
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(0));
+    btstack_run_loop_base_process_timers(1000);
+    CHECK_EQUAL(0, num_processed);
+    CHECK_FALSE(btstack_run_loop_base_remove_timer(&timers[0]));
+}
+
+TEST(RunLoopBase, TimeUntilTimeout){
+    setup_timer(&timers[0], 200);
+    setup_timer(&timers[1], 100);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    CHECK_EQUAL(60, btstack_run_loop_base_get_time_until_timeout(40));
+    CHECK_EQUAL(0, btstack_run_loop_base_get_time_until_timeout(150));
+    btstack_run_loop_base_remove_timer(&timers[1]);
+    CHECK_EQUAL(160, btstack_run_loop_base_get_time_until_timeout(40));
+}
+
+TEST(RunLoopBase, ProcessInOrder){
+    setup_timer(&timers[0], 300);
+    setup_timer(&timers[1], 100);
+    setup_timer(&timers[2], 200);
+    setup_timer(&timers[3], 400);
+    int i;
+    for (i = 0; i < 4; i++){
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    // adding a timer twice is ignored
+    btstack_run_loop_base_add_timer(&timers[2]);
+
+    btstack_run_loop_base_process_timers(99);
+    CHECK_EQUAL(0, num_processed);
+    btstack_run_loop_base_process_timers(300);
+    CHECK_EQUAL(3, num_processed);
+    POINTERS_EQUAL(&timers[1], processed[0]);
+    POINTERS_EQUAL(&timers[2], processed[1]);
+    POINTERS_EQUAL(&timers[0], processed[2]);
+    CHECK_EQUAL(100, btstack_run_loop_base_get_time_until_timeout(300));
+}
+
+TEST(RunLoopBase, RemoveTimer){
+    setup_timer(&timers[0], 100);
+    setup_timer(&timers[1], 200);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[0]));
+    CHECK_FALSE(btstack_run_loop_base_remove_timer(&timers[0]));
+    btstack_run_loop_base_process_timers(500);
+    CHECK_EQUAL(1, num_processed);
+    POINTERS_EQUAL(&timers[1], processed[0]);
+    CHECK_FALSE(btstack_run_loop_base_remove_timer(&timers[1]));
+}
+
+TEST(RunLoopBase, ReAddedTimerProcessedInNextCall){
+    setup_timer(&timers[0], 100);
+    timers[0].process = &timer_handler_readd;
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_process_timers(100);
+    CHECK_EQUAL(1, num_processed);
+    CHECK_EQUAL(0, btstack_run_loop_base_get_time_until_timeout(100));
+    btstack_run_loop_base_process_timers(100);
+    CHECK_EQUAL(2, num_processed);
+}
+
+TEST(RunLoopBase, RemoveExpiredTimerFromHandler){
+    setup_timer(&timers[0], 100);
+    setup_timer(&timers[1], 110);
+    setup_timer(&timers[2], 120);
+    timers[0].process = &timer_handler_remove_next;
+    timers[0].context = &timers[1];
+    int i;
+    for (i = 0; i < 3; i++){
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    btstack_run_loop_base_process_timers(200);
+    CHECK_EQUAL(2, num_processed);
+    POINTERS_EQUAL(&timers[0], processed[0]);
+    POINTERS_EQUAL(&timers[2], processed[1]);
+}
+
+TEST(RunLoopBase, TimeoutWrapAround){
+    setup_timer(&timers[0], 0x00000010);
+    setup_timer(&timers[1], 0xfffffff0);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_add_timer(&timers[1]);
+    CHECK_EQUAL(0x10, btstack_run_loop_base_get_time_until_timeout(0xffffffe0));
+    btstack_run_loop_base_process_timers(0xfffffff8);
+    CHECK_EQUAL(1, num_processed);
+    POINTERS_EQUAL(&timers[1], processed[0]);
+    btstack_run_loop_base_process_timers(0x00000010);
+    CHECK_EQUAL(2, num_processed);
+    POINTERS_EQUAL(&timers[0], processed[1]);
+}
+
+TEST(RunLoopBase, ReAddTimerFromOverflowList){
+    int i;
+    // more timers than fit into timer heap
+    for (i = 0; i < NUM_TIMERS; i++){
+        setup_timer(&timers[i], 100 + (i * 10));
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    // free heap entry, re-add timer with latest timeout, and add timer again
+    CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[0]));
+    btstack_run_loop_base_add_timer(&timers[NUM_TIMERS - 1]);
+    btstack_run_loop_base_add_timer(&timers[NUM_TIMERS - 2]);
+    btstack_run_loop_base_add_timer(&timers[0]);
+    btstack_run_loop_base_process_timers(100 + (NUM_TIMERS * 10));
+    CHECK_EQUAL(NUM_TIMERS, num_processed);
+    for (i = 0; i < NUM_TIMERS; i++){
+        POINTERS_EQUAL(&timers[i], processed[i]);
+    }
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(0));
+}
+
+TEST(RunLoopBase, ManyTimers){
+    int i;
+    srand(0);
+    for (i = 0; i < NUM_TIMERS; i++){
+        setup_timer(&timers[i], 1000 + (rand() % 5000));
+        btstack_run_loop_base_add_timer(&timers[i]);
+    }
+    // remove every third timer
+    for (i = 0; i < NUM_TIMERS; i += 3){
+        CHECK_TRUE(btstack_run_loop_base_remove_timer(&timers[i]));
+    }
+    int expected = NUM_TIMERS - ((NUM_TIMERS + 2) / 3);
+    uint32_t now;
+    for (now = 0; now < 7000; now += 250){
+        btstack_run_loop_base_process_timers(now);
+    }
+    CHECK_EQUAL(expected, num_processed);
+    CHECK_EQUAL(-1, btstack_run_loop_base_get_time_until_timeout(now));
+    for (i = 1; i < num_processed; i++){
+        CHECK_TRUE(btstack_time_delta(processed[i-1]->timeout, processed[i]->timeout) <= 0);
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
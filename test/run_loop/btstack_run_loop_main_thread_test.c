@@ -0,0 +1,149 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+
+#ifdef TEST_RUN_LOOP_EPOLL
+#include "btstack_run_loop_epoll.h"
+#define RUN_LOOP_INSTANCE() btstack_run_loop_epoll_get_instance()
+#else
+#include "btstack_run_loop_posix.h"
+#define RUN_LOOP_INSTANCE() btstack_run_loop_posix_get_instance()
+#endif
+
+#define NUM_CALLBACKS 100
+
+static btstack_context_callback_registration_t callback_registrations[NUM_CALLBACKS];
+static int       callback_order[NUM_CALLBACKS];
+static int       num_callbacks;
+static bool      callbacks_on_main_thread;
+static pthread_t main_thread;
+
+static btstack_timer_source_t timeout_timer;
+static jmp_buf run_loop_exit;
+
+static void main_thread_callback(void * context){
+    if (!pthread_equal(pthread_self(), main_thread)){
+        callbacks_on_main_thread = false;
+    }
+    callback_order[num_callbacks++] = (int) (intptr_t) context;
+    if (num_callbacks == NUM_CALLBACKS){
+        // leave btstack_run_loop_execute
+        longjmp(run_loop_exit, 1);
+    }
+}
+
+static void timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    longjmp(run_loop_exit, 2);
+}
+
+static void * sender_thread(void * arg){
+    UNUSED(arg);
+    int i;
+    for (i = 0; i < NUM_CALLBACKS; i++){
+        callback_registrations[i].callback = &main_thread_callback;
+        callback_registrations[i].context  = (void *) (intptr_t) i;
+        btstack_run_loop_execute_on_main_thread(&callback_registrations[i]);
+    }
+    return NULL;
+}
+
+static void hangup_handler(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    longjmp(run_loop_exit, 3);
+}
+
+static int run_until_exit(uint32_t timeout_ms){
+    btstack_run_loop_set_timer_handler(&timeout_timer, &timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, timeout_ms);
+    btstack_run_loop_add_timer(&timeout_timer);
+    int result = setjmp(run_loop_exit);
+    if (result == 0){
+        btstack_run_loop_execute();
+    }
+    btstack_run_loop_remove_timer(&timeout_timer);
+    return result;
+}
+
+static int next_free_fd(void){
+    int fd = dup(0);
+    close(fd);
+    return fd;
+}
+
+TEST_GROUP(RunLoopMainThread){
+    void setup(void){
+        RUN_LOOP_INSTANCE()->init();
+        main_thread = pthread_self();
+        num_callbacks = 0;
+        callbacks_on_main_thread = true;
+    }
+};
+
+TEST(RunLoopMainThread, ReInitDoesNotLeakFds){
+    int fd_before = next_free_fd();
+    RUN_LOOP_INSTANCE()->init();
+    RUN_LOOP_INSTANCE()->init();
+    CHECK_EQUAL(fd_before, next_free_fd());
+}
+
+TEST(RunLoopMainThread, CallbacksFromOtherThread){
+    btstack_run_loop_set_timer_handler(&timeout_timer, &timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, 5000);
+    btstack_run_loop_add_timer(&timeout_timer);
+
+    pthread_t thread;
+    CHECK_EQUAL(0, pthread_create(&thread, NULL, &sender_thread, NULL));
+    int result = setjmp(run_loop_exit);
+    if (result == 0){
+        btstack_run_loop_execute();
+    }
+    pthread_join(thread, NULL);
+    btstack_run_loop_remove_timer(&timeout_timer);
+
+    CHECK_EQUAL(1, result);
+    CHECK_EQUAL(NUM_CALLBACKS, num_callbacks);
+    CHECK_TRUE(callbacks_on_main_thread);
+    int i;
+    for (i = 0; i < NUM_CALLBACKS; i++){
+        CHECK_EQUAL(i, callback_order[i]);
+    }
+}
+
+TEST(RunLoopMainThread, HungUpFdWithCallbacksDisabled){
+    int fds[2];
+    CHECK_EQUAL(0, pipe(fds));
+    close(fds[1]);
+
+    btstack_data_source_t data_source;
+    memset(&data_source, 0, sizeof(data_source));
+    btstack_run_loop_set_data_source_fd(&data_source, fds[0]);
+    btstack_run_loop_set_data_source_handler(&data_source, &hangup_handler);
+    btstack_run_loop_add_data_source(&data_source);
+
+    // run loop waits for timeout without busy looping on hangup
+    clock_t cpu_start = clock();
+    CHECK_EQUAL(2, run_until_exit(200));
+    clock_t cpu_used_ms = (clock() - cpu_start) * 1000 / CLOCKS_PER_SEC;
+    CHECK_TRUE(cpu_used_ms < 100);
+
+    // hangup is reported after callbacks are enabled
+    btstack_run_loop_enable_data_source_callbacks(&data_source, DATA_SOURCE_CALLBACK_READ);
+    CHECK_EQUAL(3, run_until_exit(1000));
+
+    btstack_run_loop_remove_data_source(&data_source);
+    close(fds[0]);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(RUN_LOOP_INSTANCE());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
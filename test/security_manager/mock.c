@@ -216,6 +216,10 @@ void l2cap_register_fixed_channel(btstack_packet_handler_t packet_handler, uint1
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler){
 	btstack_linked_list_add(&event_packet_handlers, (btstack_linked_item_t *) callback_handler);
 }
+void hci_add_event_handler_for_event_codes(btstack_packet_callback_registration_t * callback_handler, const uint8_t * event_codes){
+	(void) event_codes;
+	hci_add_event_handler(callback_handler);
+}
 
 int l2cap_reserve_packet_buffer(void){
 	printf("l2cap_reserve_packet_buffer\n");
@@ -24,6 +24,7 @@
 #include "hci_dump.h"
 #include "l2cap.h"
 #include "ble/sm.h"
+#include "ble/le_device_db.h"
 
 // test data
 
@@ -106,6 +107,9 @@ bd_addr_t test_device_addr = {0x34, 0xb1, 0xf7, 0xd1, 0x77, 0x9b};
 
 static btstack_packet_callback_registration_t sm_event_callback_registration;
 
+static int identity_resolving_succeeded_count;
+static int identity_resolving_succeeded_index;
+
 void mock_init(void);
 void mock_simulate_hci_state_working(void);
 void mock_simulate_hci_event(uint8_t * packet, uint16_t size);
@@ -116,6 +120,7 @@ void mock_simulate_connected(void);
 uint8_t * mock_packet_buffer(void);
 uint16_t mock_packet_buffer_len(void);
 void mock_clear_packet_buffer(void);
+void aes128_calc_cyphertext(uint8_t key[16], uint8_t plaintext[16], uint8_t cyphertext[16]);
 
 void app_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     uint16_t aHandle;
@@ -148,6 +153,11 @@ void app_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet,
                     sm_authorization_grant(little_endian_read_16(packet, 2));
                     break;
 
+                case SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED:
+                    identity_resolving_succeeded_count++;
+                    identity_resolving_succeeded_index = little_endian_read_16(packet, 18);
+                    break;
+
                 default:
                     break;
             }
@@ -428,6 +438,48 @@ TEST(SecurityManager, MainTest){
 	// expect send LE SMP Code Signing Information Command
     CHECK_ACL_PACKET(test_acl_packet_22);
 }
+TEST(SecurityManager, ResolvablePrivateAddressCache){
+
+    mock_init();
+    mock_simulate_hci_state_working();
+
+    // IRK and DHK generation
+    aes128_report_result();
+    aes128_report_result();
+    mock_clear_packet_buffer();
+
+    // bonded device
+    sm_key_t irk = { 0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b };
+    bd_addr_t identity_address = { 0x00, 0x1b, 0xdc, 0x07, 0x32, 0xef };
+    le_device_db_init();
+    int le_device_index = le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, identity_address, irk);
+
+    // resolvable private address = prand || ah(irk, prand)
+    bd_addr_t rpa = { 0x70, 0x81, 0x94, 0x00, 0x00, 0x00 };
+    sm_key_t r_prime;
+    sm_key_t hash;
+    memset(r_prime, 0, 16);
+    memcpy(&r_prime[13], rpa, 3);
+    aes128_calc_cyphertext(irk, r_prime, hash);
+    memcpy(&rpa[3], &hash[13], 3);
+
+    // resolve by IRK
+    identity_resolving_succeeded_count = 0;
+    sm_address_resolution_lookup(BD_ADDR_TYPE_LE_RANDOM, rpa);
+    int i;
+    for (i = 0; (i < le_device_db_max_count()) && (identity_resolving_succeeded_count == 0); i++){
+        aes128_report_result();
+    }
+    CHECK_EQUAL(1, identity_resolving_succeeded_count);
+    CHECK_EQUAL(le_device_index, identity_resolving_succeeded_index);
+
+    // resolve again from cache without AES calculation
+    mock_clear_packet_buffer();
+    sm_address_resolution_lookup(BD_ADDR_TYPE_LE_RANDOM, rpa);
+    CHECK_EQUAL(2, identity_resolving_succeeded_count);
+    CHECK_EQUAL(le_device_index, identity_resolving_succeeded_index);
+    CHECK_EQUAL(0, mock_packet_buffer()[0]);
+}
 
 int main (int argc, const char * argv[]){
     // hci_dump_open("hci_dump.pklg", HCI_DUMP_STDOUT); // HCI_DUMP_PACKETLOGGER
@@ -9,6 +9,7 @@
 #include "btstack_config.h"
 #include "btstack_debug.h"
 #include <unistd.h>
+#include <sys/stat.h>
 
 #define TEST_DB "/tmp/test.tlv"
 
@@ -28,14 +29,19 @@ TEST_GROUP(BSTACK_TLV){
     void reopen_db(void){
     	log_info("reopen");
     	// close file 
-    	fclose(btstack_tlv_context.file);
+    	btstack_tlv_posix_deinit(&btstack_tlv_context);
     	// reopen
 		btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
     }
     void teardown(void){
     	log_info("teardown");
     	// close file
-    	fclose(btstack_tlv_context.file);
+    	btstack_tlv_posix_deinit(&btstack_tlv_context);
+    }
+    long file_size(void){
+    	struct stat file_stat;
+    	if (stat(TEST_DB, &file_stat) != 0) return -1;
+    	return (long) file_stat.st_size;
     }
 };
 
@@ -181,6 +187,107 @@ TEST(BSTACK_TLV, TestWriteDeleteResetReadDeleteRead){
     CHECK_EQUAL(size, 0);
 }
 
+TEST(BSTACK_TLV, TestManyTags){
+	uint8_t  data[4];
+	uint32_t i;
+	for (i=0;i<200;i++){
+		big_endian_store_32(data, 0, i);
+		btstack_tlv_impl->store_tag(&btstack_tlv_context, TAG('t','a','g',0) + i, data, 4);
+	}
+	for (i=0;i<200;i+=2){
+		btstack_tlv_impl->delete_tag(&btstack_tlv_context, TAG('t','a','g',0) + i);
+	}
+
+	reopen_db();
+
+	for (i=0;i<200;i++){
+		int size = btstack_tlv_impl->get_tag(&btstack_tlv_context, TAG('t','a','g',0) + i, data, 4);
+		if (i & 1){
+			CHECK_EQUAL(4, size);
+			CHECK_EQUAL(i, big_endian_read_32(data, 0));
+		} else {
+			CHECK_EQUAL(0, size);
+		}
+	}
+}
+
+TEST(BSTACK_TLV, TestCompaction){
+	uint32_t tag1 = TAG('a','b','c','d');
+	uint32_t tag2 = TAG('e','f','g','h');
+	uint8_t  data[100];
+	memset(data, 0x55, sizeof(data));
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag2, data, sizeof(data));
+
+	// overwrite same tag many times, file has to be compacted on the way
+	int i;
+	for (i=0;i<1000;i++){
+		data[0] = (uint8_t) i;
+		btstack_tlv_impl->store_tag(&btstack_tlv_context, tag1, data, sizeof(data));
+	}
+	CHECK(file_size() < 8192);
+	CHECK_EQUAL(file_size(), btstack_tlv_context.file_size);
+
+	// stores after compaction are appended to new file
+	data[0] = 0xaa;
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag1, data, sizeof(data));
+
+	reopen_db();
+
+	uint8_t buffer[100];
+	CHECK_EQUAL(100, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag1, buffer, sizeof(buffer)));
+	CHECK_EQUAL(0xaa, buffer[0]);
+	CHECK_EQUAL(100, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag2, buffer, sizeof(buffer)));
+	CHECK_EQUAL(0x55, buffer[0]);
+	CHECK_EQUAL(0x55, buffer[99]);
+}
+
+TEST(BSTACK_TLV, TestCompactionOnOpen){
+	uint32_t tag = TAG('a','b','c','d');
+	uint8_t  data[100];
+	memset(data, 0x55, sizeof(data));
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag, data, sizeof(data));
+	btstack_tlv_posix_deinit(&btstack_tlv_context);
+
+	// append stale entries directly
+	FILE * file = fopen(TEST_DB, "ab");
+	uint8_t entry_header[8];
+	big_endian_store_32(entry_header, 0, tag);
+	big_endian_store_32(entry_header, 4, sizeof(data));
+	int i;
+	for (i=0;i<100;i++){
+		data[0] = (uint8_t) i;
+		fwrite(entry_header, 1, sizeof(entry_header), file);
+		fwrite(data, 1, sizeof(data), file);
+	}
+	fclose(file);
+	CHECK(file_size() > 8192);
+
+	btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
+	CHECK_EQUAL(8 + 8 + 100, file_size());
+
+	uint8_t buffer[100];
+	CHECK_EQUAL(100, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag, buffer, sizeof(buffer)));
+	CHECK_EQUAL(99, buffer[0]);
+}
+
+TEST(BSTACK_TLV, TestTruncatedFile){
+	uint32_t tag1 = TAG('a','b','c','d');
+	uint32_t tag2 = TAG('e','f','g','h');
+	uint8_t  data[8];
+	memcpy(data, "01234567", 8);
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag1, data, 8);
+	btstack_tlv_impl->store_tag(&btstack_tlv_context, tag2, data, 8);
+	btstack_tlv_posix_deinit(&btstack_tlv_context);
+
+	// cut last entry
+	CHECK_EQUAL(0, truncate(TEST_DB, file_size() - 4));
+
+	btstack_tlv_impl = btstack_tlv_posix_init_instance(&btstack_tlv_context, TEST_DB);
+	CHECK_EQUAL(8, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag1, NULL, 0));
+	CHECK_EQUAL(0, btstack_tlv_impl->get_tag(&btstack_tlv_context, tag2, NULL, 0));
+	CHECK_EQUAL(8 + 8 + 8, file_size());
+}
+
 
 int main (int argc, const char * argv[]){
 	hci_dump_open("tlv_test.pklg", HCI_DUMP_PACKETLOGGER);
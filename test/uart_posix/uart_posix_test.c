@@ -0,0 +1,315 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_base.h"
+#include "btstack_uart_block.h"
+#include "btstack_util.h"
+#include "btstack_defines.h"
+
+#define MAX_PACKETS      8
+#define MAX_PACKET_SIZE  300
+
+// fake run loop, data source is processed by test
+
+static uint32_t test_time_ms;
+static btstack_data_source_t * test_data_source;
+static uint16_t test_data_source_callbacks;
+
+static void test_run_loop_add_data_source(btstack_data_source_t * ds){
+    test_data_source = ds;
+}
+
+static bool test_run_loop_remove_data_source(btstack_data_source_t * ds){
+    if (ds != test_data_source) return false;
+    test_data_source = NULL;
+    return true;
+}
+
+static void test_run_loop_enable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callbacks){
+    UNUSED(ds);
+    test_data_source_callbacks |= callbacks;
+}
+
+static void test_run_loop_disable_data_source_callbacks(btstack_data_source_t * ds, uint16_t callbacks){
+    UNUSED(ds);
+    test_data_source_callbacks &= ~callbacks;
+}
+
+static void test_run_loop_set_timer(btstack_timer_source_t * timer, uint32_t timeout_in_ms){
+    timer->timeout = test_time_ms + timeout_in_ms;
+}
+
+static uint32_t test_run_loop_get_time_ms(void){
+    return test_time_ms;
+}
+
+static const btstack_run_loop_t test_run_loop = {
+    &btstack_run_loop_base_init,
+    &test_run_loop_add_data_source,
+    &test_run_loop_remove_data_source,
+    &test_run_loop_enable_data_source_callbacks,
+    &test_run_loop_disable_data_source_callbacks,
+    &test_run_loop_set_timer,
+    &btstack_run_loop_base_add_timer,
+    &btstack_run_loop_base_remove_timer,
+    NULL,
+    &btstack_run_loop_base_dump_timer,
+    &test_run_loop_get_time_ms,
+    NULL,
+};
+
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+static void test_run_loop_process_timers(void){
+    btstack_run_loop_base_process_timers(test_time_ms);
+}
+#endif
+
+// @returns number of processed read callbacks
+static int test_run_loop_process_reads(void){
+    int num_reads = 0;
+    while ((test_data_source != NULL) && ((test_data_source_callbacks & DATA_SOURCE_CALLBACK_READ) != 0u)){
+        struct pollfd pfd = { test_data_source->source.fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) break;
+        test_data_source->process(test_data_source, DATA_SOURCE_CALLBACK_READ);
+        num_reads++;
+    }
+    return num_reads;
+}
+
+// H4 receiver as used by hci_transport_h4
+
+typedef struct {
+    uint16_t size;
+    uint8_t  buffer[MAX_PACKET_SIZE];
+} packet_t;
+
+typedef enum {
+    H4_W4_PACKET_TYPE,
+    H4_W4_HEADER,
+    H4_W4_PAYLOAD,
+} h4_state_t;
+
+static const btstack_uart_block_t * uart;
+static h4_state_t h4_state;
+static uint8_t    h4_packet[MAX_PACKET_SIZE];
+static uint16_t   h4_packet_len;
+static packet_t   received_packets[MAX_PACKETS];
+static int        received_packets_num;
+static int        h4_hold_packets;
+
+static void h4_receive_next(void){
+    switch (h4_state){
+        case H4_W4_PACKET_TYPE:
+            h4_packet_len = 0;
+            uart->receive_block(&h4_packet[0], 1);
+            break;
+        case H4_W4_HEADER:
+            uart->receive_block(&h4_packet[1], (h4_packet[0] == HCI_EVENT_PACKET) ? 2 : 4);
+            break;
+        default:
+            break;
+    }
+}
+
+static void h4_block_received(void){
+    switch (h4_state){
+        case H4_W4_PACKET_TYPE:
+            h4_packet_len = 1;
+            h4_state = H4_W4_HEADER;
+            break;
+        case H4_W4_HEADER: {
+            uint16_t payload_len;
+            if (h4_packet[0] == HCI_EVENT_PACKET){
+                h4_packet_len = 3;
+                payload_len = h4_packet[2];
+            } else {
+                h4_packet_len = 5;
+                payload_len = little_endian_read_16(h4_packet, 3);
+            }
+            if (payload_len > 0u){
+                h4_state = H4_W4_PAYLOAD;
+                uart->receive_block(&h4_packet[h4_packet_len], payload_len);
+                h4_packet_len += payload_len;
+                return;
+            }
+            h4_state = H4_W4_PACKET_TYPE;
+            break;
+        }
+        case H4_W4_PAYLOAD:
+            h4_state = H4_W4_PACKET_TYPE;
+            break;
+        default:
+            break;
+    }
+    if (h4_state == H4_W4_PACKET_TYPE){
+        CHECK(received_packets_num < MAX_PACKETS);
+        received_packets[received_packets_num].size = h4_packet_len;
+        memcpy(received_packets[received_packets_num].buffer, h4_packet, h4_packet_len);
+        received_packets_num++;
+        // test requests next packet
+        if (h4_hold_packets) return;
+    }
+    h4_receive_next();
+}
+
+static uint16_t build_event(uint8_t * buffer, uint8_t marker, uint8_t param_len){
+    buffer[0] = HCI_EVENT_PACKET;
+    buffer[1] = 0xff;
+    buffer[2] = param_len;
+    uint16_t i;
+    for (i = 0; i < param_len; i++){
+        buffer[3 + i] = (uint8_t) (marker + i);
+    }
+    return 3 + param_len;
+}
+
+static uint16_t build_acl_packet(uint8_t * buffer, uint8_t marker, uint16_t payload_len){
+    buffer[0] = HCI_ACL_DATA_PACKET;
+    little_endian_store_16(buffer, 1, 0x2001);
+    little_endian_store_16(buffer, 3, payload_len);
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        buffer[5 + i] = (uint8_t) (marker + i);
+    }
+    return 5 + payload_len;
+}
+
+static void check_packet(int index, const uint8_t * packet, uint16_t size){
+    CHECK(index < received_packets_num);
+    CHECK_EQUAL(size, received_packets[index].size);
+    MEMCMP_EQUAL(packet, received_packets[index].buffer, size);
+}
+
+TEST_GROUP(UART_POSIX){
+    int  pty_master;
+    char pty_name[64];
+    btstack_uart_config_t uart_config;
+
+    void setup(void){
+        test_time_ms = 0;
+        test_data_source = NULL;
+        test_data_source_callbacks = 0;
+        received_packets_num = 0;
+        h4_hold_packets = 0;
+        h4_state = H4_W4_PACKET_TYPE;
+        btstack_run_loop_base_init();
+
+        // controller side of pseudo terminal
+        pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+        CHECK(pty_master >= 0);
+        CHECK_EQUAL(0, grantpt(pty_master));
+        CHECK_EQUAL(0, unlockpt(pty_master));
+        CHECK_EQUAL(0, ptsname_r(pty_master, pty_name, sizeof(pty_name)));
+
+        uart_config.baudrate    = 115200;
+        uart_config.flowcontrol = 0;
+        uart_config.device_name = pty_name;
+        uart = btstack_uart_block_posix_instance();
+        CHECK_EQUAL(0, uart->init(&uart_config));
+        uart->set_block_received(&h4_block_received);
+        CHECK_EQUAL(0, uart->open());
+        h4_receive_next();
+    }
+
+    void teardown(void){
+        uart->close();
+        close(pty_master);
+    }
+
+    void controller_send(const uint8_t * data, uint16_t len){
+        CHECK_EQUAL(len, write(pty_master, data, len));
+    }
+};
+
+TEST(UART_POSIX, PacketSplitAcrossReads){
+    uint8_t packet[3 + 20];
+    uint16_t len = build_event(packet, 0x10, 20);
+    controller_send(packet, 2);
+    test_run_loop_process_reads();
+    CHECK_EQUAL(0, received_packets_num);
+    controller_send(&packet[2], 10);
+    test_run_loop_process_reads();
+    CHECK_EQUAL(0, received_packets_num);
+    controller_send(&packet[12], len - 12);
+    test_run_loop_process_reads();
+    CHECK_EQUAL(1, received_packets_num);
+    check_packet(0, packet, len);
+}
+
+TEST(UART_POSIX, SeveralPacketsInOneRead){
+    uint8_t data[200];
+    uint16_t len = 0;
+    uint16_t offsets[4];
+    uint16_t sizes[4];
+    offsets[0] = len; sizes[0] = build_event(&data[len], 0x20, 4);  len += sizes[0];
+    offsets[1] = len; sizes[1] = build_event(&data[len], 0x30, 0);  len += sizes[1];
+    offsets[2] = len; sizes[2] = build_acl_packet(&data[len], 0x40, 27); len += sizes[2];
+    offsets[3] = len; sizes[3] = build_event(&data[len], 0x50, 6);  len += sizes[3];
+    controller_send(data, len);
+    int num_reads = test_run_loop_process_reads();
+    CHECK_EQUAL(4, received_packets_num);
+    int i;
+    for (i = 0; i < 4; i++){
+        check_packet(i, &data[offsets[i]], sizes[i]);
+    }
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+    // all packets are served from a single read
+    CHECK_EQUAL(1, num_reads);
+#else
+    CHECK(num_reads > 4);
+#endif
+    // waiting for next packet type
+    CHECK(test_data_source_callbacks & DATA_SOURCE_CALLBACK_READ);
+}
+
+TEST(UART_POSIX, PacketsLargerThanReadAheadBuffer){
+    uint8_t data[2 * MAX_PACKET_SIZE];
+    uint16_t len_acl   = build_acl_packet(data, 0x60, 250);
+    uint16_t len_event = build_event(&data[len_acl], 0x70, 100);
+    controller_send(data, len_acl + len_event);
+    test_run_loop_process_reads();
+    CHECK_EQUAL(2, received_packets_num);
+    check_packet(0, data, len_acl);
+    check_packet(1, &data[len_acl], len_event);
+}
+
+TEST(UART_POSIX, BlockRequestedOutsideOfCallback){
+    uint8_t data[100];
+    uint16_t len_first  = build_event(data, 0x80, 5);
+    uint16_t len_second = build_event(&data[len_first], 0x90, 7);
+    controller_send(data, len_first + len_second);
+
+    // first packet received, next block is not requested from callback
+    h4_hold_packets = 1;
+    test_run_loop_process_reads();
+    CHECK_EQUAL(1, received_packets_num);
+    check_packet(0, data, len_first);
+
+    h4_hold_packets = 0;
+    h4_receive_next();
+#ifdef ENABLE_UART_POSIX_READ_AHEAD
+    // buffered data is delivered from run loop, not from within receive_block
+    CHECK_EQUAL(1, received_packets_num);
+    CHECK_FALSE(test_data_source_callbacks & DATA_SOURCE_CALLBACK_READ);
+    test_run_loop_process_timers();
+#else
+    test_run_loop_process_reads();
+#endif
+    CHECK_EQUAL(2, received_packets_num);
+    check_packet(1, &data[len_first], len_second);
+    CHECK(test_data_source_callbacks & DATA_SOURCE_CALLBACK_READ);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(&test_run_loop);
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
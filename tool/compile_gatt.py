@@ -61,6 +61,7 @@ assigned_uuids = {
     'GAP_RECONNECTION_ADDRESS'    : 0x2A03,
     'GAP_PERIPHERAL_PREFERRED_CONNECTION_PARAMETERS' : 0x2A04,
     'GATT_SERVICE_CHANGED' : 0x2a05,
+    'GATT_CLIENT_SUPPORTED_FEATURES' : 0x2b29,
     'GATT_DATABASE_HASH' : 0x2b2a
 }
 